@@ -0,0 +1,117 @@
+#include "ppsspp_config.h"
+
+#ifdef _WIN32
+#include "Common/CommonWindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/MappedFile.h"
+#include "Common/Log.h"
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const Path &path) {
+	Close();
+
+#if PPSSPP_PLATFORM(UWP)
+	// No MapViewOfFile outside of the FromApp variants, and those are picky about locations.
+	return false;
+#elif defined(_WIN32)
+	HANDLE file = CreateFileW(path.ToWString().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+	void *ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!ptr) {
+		WARN_LOG(Log::IO, "MappedFile: Failed to map '%s'", path.c_str());
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle_ = file;
+	mappingHandle_ = mapping;
+	data_ = (const uint8_t *)ptr;
+	size_ = (uint64_t)size.QuadPart;
+	return true;
+#else
+	int fd = path.Type() == PathType::CONTENT_URI ? File::OpenFD(path, File::OPEN_READ) : open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size > (uint64_t)SIZE_MAX) {
+		close(fd);
+		return false;
+	}
+	void *ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping keeps its own reference to the file.
+	close(fd);
+	if (ptr == MAP_FAILED) {
+		WARN_LOG(Log::IO, "MappedFile: Failed to map '%s'", path.c_str());
+		return false;
+	}
+	data_ = (const uint8_t *)ptr;
+	size_ = (uint64_t)st.st_size;
+	return true;
+#endif
+}
+
+void MappedFile::Close() {
+	if (!data_) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+	CloseHandle((HANDLE)mappingHandle_);
+	CloseHandle((HANDLE)fileHandle_);
+	mappingHandle_ = nullptr;
+	fileHandle_ = nullptr;
+#else
+	munmap((void *)data_, (size_t)size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
+
+void MappedFile::Advise(uint64_t offset, uint64_t size, MappedFileAdvice advice) {
+	if (!data_ || offset >= size_) {
+		return;
+	}
+	if (size > size_ - offset) {
+		size = size_ - offset;
+	}
+
+	// TODO: Windows 8+ has PrefetchVirtualMemory for WILLNEED.
+#if !defined(_WIN32)
+	// madvise wants a page aligned start.
+	const uint64_t pageMask = (uint64_t)sysconf(_SC_PAGESIZE) - 1;
+	const uint64_t alignedOffset = offset & ~pageMask;
+	size += offset - alignedOffset;
+
+	int flag = MADV_NORMAL;
+	switch (advice) {
+	case MappedFileAdvice::SEQUENTIAL: flag = MADV_SEQUENTIAL; break;
+	case MappedFileAdvice::RANDOM: flag = MADV_RANDOM; break;
+	case MappedFileAdvice::WILLNEED: flag = MADV_WILLNEED; break;
+	default: break;
+	}
+	madvise((void *)(data_ + alignedOffset), (size_t)size, flag);
+#endif
+}
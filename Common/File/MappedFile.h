@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Common/File/Path.h"
+
+enum class MappedFileAdvice {
+	NORMAL,
+	SEQUENTIAL,
+	RANDOM,
+	WILLNEED,
+};
+
+// Read-only memory mapping of a whole file. Open() fails gracefully where mapping isn't
+// possible (UWP, files too large for the address space, etc), callers should then fall
+// back to regular reads.
+class MappedFile {
+public:
+	MappedFile() {}
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool Open(const Path &path);
+	void Close();
+
+	bool IsOpen() const { return data_ != nullptr; }
+	const uint8_t *Data() const { return data_; }
+	uint64_t Size() const { return size_; }
+
+	// Just a hint, may be ignored by the OS. Range is clamped to the file.
+	void Advise(uint64_t offset, uint64_t size, MappedFileAdvice advice);
+
+private:
+	const uint8_t *data_ = nullptr;
+	uint64_t size_ = 0;
+#ifdef _WIN32
+	void *fileHandle_ = nullptr;
+	void *mappingHandle_ = nullptr;
+#endif
+};
@@ -18,7 +18,7 @@
 #include "android/jni/app-android.h"
 #endif
 
-bool LoadRemoteFileList(const Path &url, const std::string &userAgent, bool *cancel, std::vector<File::FileInfo> &files) {
+bool LoadRemoteFileList(const Path &url, const std::string &userAgent, std::atomic<bool> *cancel, std::vector<File::FileInfo> &files) {
 	_dbg_assert_(url.Type() == PathType::HTTP);
 
 	http::Client http;
@@ -229,7 +229,7 @@ std::string PathBrowser::GetFriendlyPath() const {
 	return path_.ToVisualString();
 }
 
-bool PathBrowser::GetListing(std::vector<File::FileInfo> &fileInfo, const char *extensionFilter, bool *cancel) {
+bool PathBrowser::GetListing(std::vector<File::FileInfo> &fileInfo, const char *extensionFilter, std::atomic<bool> *cancel) {
 	std::unique_lock<std::mutex> guard(pendingLock_);
 	while (!IsListingReady() && (!cancel || !*cancel)) {
 		// In case cancel changes, just sleep. TODO: Replace with condition variable.
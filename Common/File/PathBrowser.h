@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <string>
@@ -26,7 +27,7 @@ class PathBrowser {
 	bool IsListingReady() const {
 		return ready_;
 	}
-	bool GetListing(std::vector<File::FileInfo> &fileInfo, const char *filter = nullptr, bool *cancel = nullptr);
+	bool GetListing(std::vector<File::FileInfo> &fileInfo, const char *filter = nullptr, std::atomic<bool> *cancel = nullptr);
 
 	bool CanNavigateUp();
 	void NavigateUp();
@@ -69,7 +70,7 @@ class PathBrowser {
 	std::mutex pendingLock_;
 	std::thread pendingThread_;
 	bool pendingActive_ = false;
-	bool pendingCancel_ = false;
+	std::atomic<bool> pendingCancel_{};
 	bool pendingStop_ = false;
 	bool ready_ = false;
 	bool success_ = true;
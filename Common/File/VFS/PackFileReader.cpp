@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Common.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/VFS/PackFileReader.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+
+static const char PACK_MAGIC[4] = { 'P', 'P', 'A', 'K' };
+static const uint32_t PACK_VERSION = 1;
+// Keeps file data nicely aligned in the mapping.
+static const uint64_t PACK_DATA_ALIGN = 16;
+
+class PackFileReference : public VFSFileReference {
+public:
+	size_t index;
+};
+
+class PackOpenFile : public VFSOpenFile {
+public:
+	size_t index;
+	uint64_t pos;
+};
+
+static std::string NormalizePackPath(std::string_view path) {
+	std::string lower(path);
+	for (auto &c : lower) {
+		if (c == '\\') {
+			c = '/';
+		} else if (c >= 'A' && c <= 'Z') {
+			c += 'a' - 'A';
+		}
+	}
+	while (!lower.empty() && lower.back() == '/') {
+		lower.pop_back();
+	}
+	return lower;
+}
+
+PackFileReader *PackFileReader::Create(const Path &packFile, bool logErrors) {
+	PackFileReader *reader = new PackFileReader(packFile);
+	std::string error;
+	if (!reader->LoadIndex(&error)) {
+		if (logErrors) {
+			ERROR_LOG(Log::IO, "Failed to open pack file %s: %s", packFile.c_str(), error.c_str());
+		}
+		delete reader;
+		return nullptr;
+	}
+	return reader;
+}
+
+PackFileReader::~PackFileReader() {
+	if (file_) {
+		fclose(file_);
+	}
+}
+
+bool PackFileReader::LoadIndex(std::string *error) {
+	PackFileHeader header;
+	uint64_t fileSize = 0;
+
+	if (mapped_.Open(packPath_)) {
+		fileSize = mapped_.Size();
+		if (fileSize < sizeof(header)) {
+			*error = "Too small";
+			return false;
+		}
+		memcpy(&header, mapped_.Data(), sizeof(header));
+	} else {
+		file_ = File::OpenCFile(packPath_, "rb");
+		if (!file_) {
+			*error = "Could not open";
+			return false;
+		}
+		fileSize = File::GetFileSize(file_);
+		if (fread(&header, sizeof(header), 1, file_) != 1) {
+			*error = "Too small";
+			return false;
+		}
+	}
+
+	if (memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header.version != PACK_VERSION) {
+		*error = "Bad header or unsupported version";
+		return false;
+	}
+
+	const uint64_t indexSize = (uint64_t)header.numEntries * sizeof(PackFileEntry) + header.namesSize;
+	if (sizeof(header) + indexSize > fileSize) {
+		*error = "Truncated index";
+		return false;
+	}
+
+	entries_.resize(header.numEntries);
+	names_.resize(header.namesSize);
+	if (mapped_.IsOpen()) {
+		const uint8_t *ptr = mapped_.Data() + sizeof(header);
+		memcpy(entries_.data(), ptr, entries_.size() * sizeof(PackFileEntry));
+		memcpy(&names_[0], ptr + entries_.size() * sizeof(PackFileEntry), names_.size());
+	} else {
+		bool success = fread(entries_.data(), sizeof(PackFileEntry), entries_.size(), file_) == entries_.size();
+		success = success && fread(&names_[0], 1, names_.size(), file_) == names_.size();
+		if (!success) {
+			*error = "Failed to read index";
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < entries_.size(); i++) {
+		const PackFileEntry &entry = entries_[i];
+		if ((uint64_t)entry.nameOffset + entry.nameLength > names_.size() || entry.offset > fileSize || entry.size > fileSize - entry.offset) {
+			*error = StringFromFormat("Corrupt entry %d", (int)i);
+			return false;
+		}
+		if (i > 0 && !(EntryName(i - 1) < EntryName(i))) {
+			*error = "Index not sorted";
+			return false;
+		}
+	}
+
+	INFO_LOG(Log::IO, "Opened pack file %s: %d files%s", packPath_.c_str(), (int)entries_.size(), mapped_.IsOpen() ? " (mapped)" : "");
+	return true;
+}
+
+size_t PackFileReader::FindEntry(std::string_view lowerPath) const {
+	size_t lo = 0;
+	size_t hi = entries_.size();
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		std::string_view name = EntryName(mid);
+		if (name < lowerPath) {
+			lo = mid + 1;
+		} else if (lowerPath < name) {
+			hi = mid;
+		} else {
+			return mid;
+		}
+	}
+	return entries_.size();
+}
+
+size_t PackFileReader::ReadEntryData(const PackFileEntry &entry, uint64_t pos, void *buffer, size_t length) {
+	if (pos >= entry.size) {
+		return 0;
+	}
+	length = (size_t)std::min((uint64_t)length, entry.size - pos);
+	if (mapped_.IsOpen()) {
+		memcpy(buffer, mapped_.Data() + entry.offset + pos, length);
+		return length;
+	}
+
+	std::lock_guard<std::mutex> guard(fileLock_);
+	if (fseeko(file_, entry.offset + pos, SEEK_SET) != 0) {
+		return 0;
+	}
+	return fread(buffer, 1, length, file_);
+}
+
+uint8_t *PackFileReader::ReadFile(const char *path, size_t *size) {
+	size_t index = FindEntry(NormalizePackPath(path));
+	if (index == entries_.size()) {
+		return nullptr;
+	}
+
+	const PackFileEntry &entry = entries_[index];
+	uint8_t *contents = new uint8_t[entry.size + 1];
+	if (ReadEntryData(entry, 0, contents, (size_t)entry.size) != entry.size) {
+		ERROR_LOG(Log::IO, "Error reading %s from pack file", path);
+		delete[] contents;
+		return nullptr;
+	}
+	contents[entry.size] = 0;
+	*size = (size_t)entry.size;
+	return contents;
+}
+
+VFSFileReference *PackFileReader::GetFile(const char *path) {
+	size_t index = FindEntry(NormalizePackPath(path));
+	if (index == entries_.size()) {
+		return nullptr;
+	}
+	PackFileReference *reference = new PackFileReference();
+	reference->index = index;
+	return reference;
+}
+
+bool PackFileReader::GetFileInfo(VFSFileReference *vfsReference, File::FileInfo *fileInfo) {
+	PackFileReference *reference = (PackFileReference *)vfsReference;
+	const std::string_view name = EntryName(reference->index);
+	*fileInfo = File::FileInfo{};
+	fileInfo->name = std::string(name.substr(name.rfind('/') + 1));
+	fileInfo->fullName = Path(std::string(name));
+	fileInfo->exists = true;
+	fileInfo->size = entries_[reference->index].size;
+	return true;
+}
+
+void PackFileReader::ReleaseFile(VFSFileReference *vfsReference) {
+	delete (PackFileReference *)vfsReference;
+}
+
+VFSOpenFile *PackFileReader::OpenFileForRead(VFSFileReference *vfsReference, size_t *size) {
+	PackFileReference *reference = (PackFileReference *)vfsReference;
+	PackOpenFile *openFile = new PackOpenFile();
+	openFile->index = reference->index;
+	openFile->pos = 0;
+	*size = (size_t)entries_[reference->index].size;
+	return openFile;
+}
+
+void PackFileReader::Rewind(VFSOpenFile *vfsOpenFile) {
+	((PackOpenFile *)vfsOpenFile)->pos = 0;
+}
+
+size_t PackFileReader::Read(VFSOpenFile *vfsOpenFile, void *buffer, size_t length) {
+	PackOpenFile *openFile = (PackOpenFile *)vfsOpenFile;
+	size_t bytesRead = ReadEntryData(entries_[openFile->index], openFile->pos, buffer, length);
+	openFile->pos += bytesRead;
+	return bytesRead;
+}
+
+void PackFileReader::CloseFile(VFSOpenFile *vfsOpenFile) {
+	delete (PackOpenFile *)vfsOpenFile;
+}
+
+bool PackFileReader::GetFileListing(const char *orig_path, std::vector<File::FileInfo> *listing, const char *filter) {
+	std::string prefix = NormalizePackPath(orig_path);
+	if (!prefix.empty()) {
+		prefix.push_back('/');
+	}
+
+	// Everything under the prefix is contiguous in the sorted index.
+	size_t start = std::lower_bound(entries_.begin(), entries_.end(), prefix, [&](const PackFileEntry &entry, const std::string &value) {
+		return std::string_view(names_.data() + entry.nameOffset, entry.nameLength) < value;
+	}) - entries_.begin();
+
+	listing->clear();
+	std::string lastDir;
+	for (size_t i = start; i < entries_.size(); i++) {
+		std::string_view name = EntryName(i);
+		if (!startsWith(name, prefix)) {
+			break;
+		}
+		std::string_view rest = name.substr(prefix.size());
+		size_t slash = rest.find('/');
+
+		File::FileInfo info;
+		info.exists = true;
+		if (slash != std::string_view::npos) {
+			std::string dir(rest.substr(0, slash));
+			if (dir == lastDir) {
+				continue;
+			}
+			lastDir = dir;
+			info.name = dir;
+			info.isDirectory = true;
+		} else {
+			info.name = std::string(rest);
+			info.size = entries_[i].size;
+		}
+		info.fullName = Path(prefix + info.name);
+		listing->push_back(info);
+	}
+
+	if (listing->empty() && !prefix.empty()) {
+		return false;
+	}
+	if (filter) {
+		*listing = File::ApplyFilter(*listing, filter, "");
+	}
+	std::sort(listing->begin(), listing->end());
+	return true;
+}
+
+bool PackFileReader::GetFileInfo(const char *path, File::FileInfo *info) {
+	const std::string lowerPath = NormalizePackPath(path);
+	*info = File::FileInfo{};
+	info->name = lowerPath.substr(lowerPath.rfind('/') + 1);
+	info->fullName = Path(lowerPath);
+
+	size_t index = FindEntry(lowerPath);
+	if (index != entries_.size()) {
+		info->exists = true;
+		info->size = entries_[index].size;
+		return true;
+	}
+
+	// Might be a directory, which only exist implicitly.
+	std::vector<File::FileInfo> listing;
+	if (!lowerPath.empty() && GetFileListing(lowerPath.c_str(), &listing, nullptr)) {
+		info->exists = true;
+		info->isDirectory = true;
+		return true;
+	}
+	return false;
+}
+
+bool PackFileReader::Write(const Path &packFile, const Path &baseDir, const std::vector<std::string> &files, std::string *error) {
+	struct SourceFile {
+		std::string name;
+		Path path;
+		uint64_t size;
+	};
+
+	std::vector<SourceFile> sources;
+	sources.reserve(files.size());
+	for (const auto &file : files) {
+		File::FileInfo info;
+		Path path = baseDir / file;
+		if (!File::GetFileInfo(path, &info) || info.isDirectory) {
+			*error = "Could not stat " + file;
+			return false;
+		}
+		sources.push_back(SourceFile{ NormalizePackPath(file), path, info.size });
+	}
+	std::sort(sources.begin(), sources.end(), [](const SourceFile &a, const SourceFile &b) {
+		return a.name < b.name;
+	});
+	for (size_t i = 1; i < sources.size(); i++) {
+		if (sources[i - 1].name == sources[i].name) {
+			*error = "Duplicate (case insensitive) filename " + sources[i].name;
+			return false;
+		}
+	}
+
+	PackFileHeader header{};
+	memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+	header.version = PACK_VERSION;
+	header.numEntries = (uint32_t)sources.size();
+
+	std::string names;
+	std::vector<PackFileEntry> entries(sources.size());
+	for (size_t i = 0; i < sources.size(); i++) {
+		entries[i].nameOffset = (uint32_t)names.size();
+		entries[i].nameLength = (uint32_t)sources[i].name.size();
+		entries[i].size = sources[i].size;
+		names += sources[i].name;
+	}
+	header.namesSize = (uint32_t)names.size();
+
+	uint64_t offset = sizeof(header) + entries.size() * sizeof(PackFileEntry) + names.size();
+	for (auto &entry : entries) {
+		offset = (offset + PACK_DATA_ALIGN - 1) & ~(PACK_DATA_ALIGN - 1);
+		entry.offset = offset;
+		offset += entry.size;
+	}
+
+	FILE *f = File::OpenCFile(packFile, "wb");
+	if (!f) {
+		*error = "Could not create " + packFile.ToVisualString();
+		return false;
+	}
+
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+	success = success && fwrite(entries.data(), sizeof(PackFileEntry), entries.size(), f) == entries.size();
+	success = success && fwrite(names.data(), 1, names.size(), f) == names.size();
+
+	static const uint8_t padding[PACK_DATA_ALIGN]{};
+	uint64_t pos = sizeof(header) + entries.size() * sizeof(PackFileEntry) + names.size();
+	for (size_t i = 0; success && i < sources.size(); i++) {
+		success = fwrite(padding, 1, (size_t)(entries[i].offset - pos), f) == entries[i].offset - pos;
+
+		size_t size = 0;
+		uint8_t *data = File::ReadLocalFile(sources[i].path, &size);
+		if (!data || size != entries[i].size) {
+			*error = "Could not read " + sources[i].name;
+			success = false;
+		} else {
+			success = success && fwrite(data, 1, size, f) == size;
+		}
+		delete[] data;
+		pos = entries[i].offset + entries[i].size;
+	}
+
+	fclose(f);
+	if (!success) {
+		if (error->empty()) {
+			*error = "Write failed";
+		}
+		File::Delete(packFile);
+		return false;
+	}
+	return true;
+}
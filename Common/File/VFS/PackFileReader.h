@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/File/VFS/VFS.h"
+#include "Common/File/MappedFile.h"
+#include "Common/File/Path.h"
+
+// A simple read-only archive, meant for big texture packs where zip or plain directories get slow:
+// a single file with a sorted name index up front and the file contents stored as-is
+// (texture files are already compressed). The index is loaded in one read, lookups are
+// a binary search, and the data is memory mapped where possible.
+//
+// Layout: PackFileHeader, numEntries * PackFileEntry (sorted by name), names, data.
+// Names are lowercase with '/' separators, lookups are case insensitive like ZipFileReader.
+
+struct PackFileHeader {
+	char magic[4];  // PPAK
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t namesSize;
+};
+
+struct PackFileEntry {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+class PackFileReader : public VFSBackend {
+public:
+	static PackFileReader *Create(const Path &packFile, bool logErrors = true);
+	~PackFileReader();
+
+	// Builds a pack from files (relative to baseDir) on disk.
+	static bool Write(const Path &packFile, const Path &baseDir, const std::vector<std::string> &files, std::string *error);
+
+	// use delete[] on the returned value.
+	uint8_t *ReadFile(const char *path, size_t *size) override;
+
+	VFSFileReference *GetFile(const char *path) override;
+	bool GetFileInfo(VFSFileReference *vfsReference, File::FileInfo *fileInfo) override;
+	void ReleaseFile(VFSFileReference *vfsReference) override;
+
+	VFSOpenFile *OpenFileForRead(VFSFileReference *vfsReference, size_t *size) override;
+	void Rewind(VFSOpenFile *vfsOpenFile) override;
+	size_t Read(VFSOpenFile *vfsOpenFile, void *buffer, size_t length) override;
+	void CloseFile(VFSOpenFile *vfsOpenFile) override;
+
+	bool GetFileListing(const char *path, std::vector<File::FileInfo> *listing, const char *filter) override;
+	bool GetFileInfo(const char *path, File::FileInfo *info) override;
+	std::string toString() const override {
+		return packPath_.ToVisualString();
+	}
+
+	size_t NumFiles() const { return entries_.size(); }
+
+private:
+	explicit PackFileReader(const Path &packPath) : packPath_(packPath) {}
+	bool LoadIndex(std::string *error);
+
+	std::string_view EntryName(size_t index) const {
+		return std::string_view(names_.data() + entries_[index].nameOffset, entries_[index].nameLength);
+	}
+	// Returns entries_.size() if not found.
+	size_t FindEntry(std::string_view lowerPath) const;
+	size_t ReadEntryData(const PackFileEntry &entry, uint64_t pos, void *buffer, size_t length);
+
+	Path packPath_;
+	std::vector<PackFileEntry> entries_;
+	std::string names_;
+
+	MappedFile mapped_;
+	// Only used when mapping isn't possible.
+	FILE *file_ = nullptr;
+	std::mutex fileLock_;
+};
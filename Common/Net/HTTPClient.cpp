@@ -86,7 +86,7 @@ static void FormatAddr(char *addrbuf, size_t bufsize, const addrinfo *info) {
 	}
 }
 
-bool Connection::Connect(int maxTries, double timeout, bool *cancelConnect) {
+bool Connection::Connect(int maxTries, double timeout, std::atomic<bool> *cancelConnect) {
 	if (port_ <= 0) {
 		ERROR_LOG(Log::IO, "Bad port");
 		return false;
@@ -343,7 +343,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, st
 		"Host: %s\r\n"
 		"User-Agent: %s\r\n"
 		"Accept: %s\r\n"
-		"Connection: close\r\n"
+		"Connection: %s\r\n"
 		"%s"
 		"\r\n";
 
@@ -352,6 +352,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, st
 		host_.c_str(),
 		userAgent_.c_str(),
 		req.acceptMime,
+		keepAlive_ ? "keep-alive" : "close",
 		otherHeaders ? otherHeaders : "");
 	buffer.Append(data);
 	bool flushed = buffer.FlushSocket(sock(), dataTimeout_, progress->cancelled);
@@ -423,6 +424,7 @@ int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::stri
 
 	bool gzip = false;
 	bool chunked = false;
+	bool hasContentLength = false;
 	int contentLength = 0;
 	for (std::string line : responseHeaders) {
 		if (startsWithNoCase(line, "Content-Length:")) {
@@ -432,6 +434,7 @@ int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::stri
 			}
 			if (size_pos != line.npos) {
 				contentLength = atoi(&line[size_pos]);
+				hasContentLength = true;
 				chunked = false;
 			}
 		} else if (startsWithNoCase(line, "Content-Encoding:")) {
@@ -453,8 +456,13 @@ int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::stri
 		contentLength = 0;
 	}
 
-	if (!readbuf->ReadAllWithProgress(sock(), contentLength, progress))
+	if (keepAlive_ && hasContentLength && !chunked) {
+		// The connection stays open, so we can't wait for it to close.
+		if (!readbuf->ReadSizeWithProgress(sock(), contentLength, progress))
+			return -1;
+	} else if (!readbuf->ReadAllWithProgress(sock(), contentLength, progress)) {
 		return -1;
+	}
 
 	// output now contains the rest of the reply. Dechunk it.
 	if (!output->IsVoid()) {
@@ -538,7 +546,7 @@ int HTTPRequest::Perform(const std::string &url) {
 	}
 
 	if (!client.Connect(2, 20.0, &cancelled_)) {
-		ERROR_LOG(Log::HTTP, "Failed connecting to server or cancelled (=%d).", cancelled_);
+		ERROR_LOG(Log::HTTP, "Failed connecting to server or cancelled (=%d).", (int)cancelled_);
 		return -1;
 	}
 
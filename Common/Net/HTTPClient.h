@@ -19,7 +19,7 @@ class Connection {
 	// Inits the sockaddr_in.
 	bool Resolve(const char *host, int port, DNSType type = DNSType::ANY);
 
-	bool Connect(int maxTries = 2, double timeout = 20.0f, bool *cancelConnect = nullptr);
+	bool Connect(int maxTries = 2, double timeout = 20.0f, std::atomic<bool> *cancelConnect = nullptr);
 	void Disconnect();
 
 	// Only to be used for bring-up and debugging.
@@ -86,10 +86,17 @@ class Client : public net::Connection {
 		httpVersion_ = version;
 	}
 
+	// Asks the server to keep the connection open, and only reads the response entity up to its
+	// Content-Length, so another request can follow. The server may still close it.
+	void SetKeepAlive(bool keepAlive) {
+		keepAlive_ = keepAlive;
+	}
+
 protected:
 	std::string userAgent_;
 	const char* httpVersion_;
 	double dataTimeout_ = 900.0;
+	bool keepAlive_ = false;
 };
 
 // Really an asynchronous request.
@@ -122,7 +129,7 @@ class HTTPRequest : public Request {
 // This is simply a finished request, that can still be queried like a normal one so users don't know it came from the cache.
 class CachedRequest : public Request {
 public:
-	CachedRequest(RequestMethod method, std::string_view url, std::string_view name, bool *cancelled, RequestFlags flags, std::string_view responseData)
+	CachedRequest(RequestMethod method, std::string_view url, std::string_view name, std::atomic<bool> *cancelled, RequestFlags flags, std::string_view responseData)
 		: Request(method, url, name, cancelled, flags)
 	{
 		buffer_.Append(responseData);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <functional>
 #include <memory>
@@ -26,7 +27,7 @@ ENUM_CLASS_BITOPS(RequestFlags);
 // Abstract request.
 class Request {
 public:
-	Request(RequestMethod method, std::string_view url, std::string_view name, bool *cancelled, RequestFlags mode);
+	Request(RequestMethod method, std::string_view url, std::string_view name, std::atomic<bool> *cancelled, RequestFlags mode);
 	virtual ~Request() {}
 
 	void SetAccept(const char *mime) {
@@ -85,7 +86,7 @@ class Request {
 	std::string userAgent_;
 	Path outfile_;
 	Buffer buffer_;
-	bool cancelled_ = false;
+	std::atomic<bool> cancelled_{};
 	int resultCode_ = 0;
 	std::vector<std::string> responseHeaders_;
 
@@ -27,7 +27,7 @@ void RequestProgress::Update(int64_t downloaded, int64_t totalBytes, bool done)
 	}
 }
 
-bool Buffer::FlushSocket(uintptr_t sock, double timeout, bool *cancelled) {
+bool Buffer::FlushSocket(uintptr_t sock, double timeout, std::atomic<bool> *cancelled) {
 	static constexpr float CANCEL_INTERVAL = 0.25f;
 
 	data_.iterate_blocks([&](const char *data, size_t size) {
@@ -106,6 +106,41 @@ bool Buffer::ReadAllWithProgress(int fd, int knownSize, RequestProgress *progres
 	return true;
 }
 
+bool Buffer::ReadSizeWithProgress(int fd, size_t size, RequestProgress *progress) {
+	static constexpr float CANCEL_INTERVAL = 0.25f;
+	std::vector<char> buf(std::min(std::max(size, (size_t)1024), (size_t)65536));
+
+	double st = time_now_d();
+	const size_t initialSize = this->size();
+	while (this->size() < size) {
+		bool ready = false;
+		while (!ready && progress && progress->cancelled) {
+			if (*progress->cancelled)
+				return false;
+			ready = fd_util::WaitUntilReady(fd, CANCEL_INTERVAL, false);
+		}
+
+		int retval = recv(fd, &buf[0], std::min(buf.size(), size - this->size()), MSG_NOSIGNAL);
+		if (retval == 0) {
+			// Closed before we got it all.
+			return false;
+		} else if (retval < 0) {
+			if (socket_errno != EWOULDBLOCK) {
+				ERROR_LOG(Log::IO, "Error reading from buffer: %i", retval);
+				return false;
+			}
+			continue;
+		}
+		char *p = Append((size_t)retval);
+		memcpy(p, &buf[0], retval);
+		if (progress) {
+			progress->Update(this->size(), size, false);
+			progress->kBps = (float)((this->size() - initialSize) / (time_now_d() - st)) / 1024.0f;
+		}
+	}
+	return true;
+}
+
 int Buffer::Read(int fd, size_t sz) {
 	char buf[4096];
 	int retval;
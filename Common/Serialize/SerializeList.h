@@ -19,6 +19,7 @@
 
 // Templates for save state serialization.  See Serializer.h.
 #include <list>
+#include "Common/Data/Collections/LinkedList.h"
 #include "Common/Serialize/SerializeFuncs.h"
 
 template<class T>
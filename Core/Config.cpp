@@ -289,6 +289,10 @@ static const ConfigSetting generalSettings[] = {
 	ConfigSetting("AutoSaveSymbolMap", &g_Config.bAutoSaveSymbolMap, false, CfgFlag::PER_GAME),
 	ConfigSetting("CompressSymbols", &g_Config.bCompressSymbols, true, CfgFlag::DEFAULT),
 	ConfigSetting("CacheFullIsoInRam", &g_Config.bCacheFullIsoInRam, false, CfgFlag::PER_GAME),
+	ConfigSetting("MemoryMapIso", &g_Config.bMemoryMapIso, true, CfgFlag::DEFAULT),
+	ConfigSetting("DiscPrefetch", &g_Config.bDiscPrefetch, true, CfgFlag::PER_GAME),
+	ConfigSetting("ParallelCSODecompression", &g_Config.bParallelCSODecompression, true, CfgFlag::PER_GAME),
+	ConfigSetting("CHDHunkCacheSize", &g_Config.iCHDHunkCacheSize, 16, CfgFlag::PER_GAME),
 	ConfigSetting("RemoteISOPort", &g_Config.iRemoteISOPort, 0, CfgFlag::DEFAULT),
 	ConfigSetting("LastRemoteISOServer", &g_Config.sLastRemoteISOServer, "", CfgFlag::DEFAULT),
 	ConfigSetting("LastRemoteISOPort", &g_Config.iLastRemoteISOPort, 0, CfgFlag::DEFAULT),
@@ -383,6 +387,7 @@ static const ConfigSetting achievementSettings[] = {
 static const ConfigSetting cpuSettings[] = {
 	ConfigSetting("CPUCore", &g_Config.iCpuCore, &DefaultCpuCore, CfgFlag::PER_GAME | CfgFlag::REPORT),
 	ConfigSetting("SeparateSASThread", &g_Config.bSeparateSASThread, &DefaultSasThread, CfgFlag::PER_GAME | CfgFlag::REPORT),
+	ConfigSetting("SasLookahead", &g_Config.bSasLookahead, false, CfgFlag::PER_GAME | CfgFlag::REPORT),
 	ConfigSetting("IOTimingMethod", &g_Config.iIOTimingMethod, IOTIMING_FAST, CfgFlag::PER_GAME | CfgFlag::REPORT),
 	ConfigSetting("FastMemoryAccess", &g_Config.bFastMemory, true, CfgFlag::PER_GAME),
 	ConfigSetting("FunctionReplacements", &g_Config.bFuncReplacements, true, CfgFlag::PER_GAME | CfgFlag::REPORT),
@@ -717,10 +722,14 @@ static const ConfigSetting graphicsSettings[] = {
 	ConfigSetting("SaveNewTextures", &g_Config.bSaveNewTextures, false, CfgFlag::PER_GAME | CfgFlag::REPORT),
 	ConfigSetting("IgnoreTextureFilenames", &g_Config.bIgnoreTextureFilenames, false, CfgFlag::PER_GAME),
 	ConfigSetting("ReplacementTextureLoadSpeed", &g_Config.iReplacementTextureLoadSpeed, 0, CfgFlag::PER_GAME),
+	ConfigSetting("ReplacementTexturePrefetch", &g_Config.bReplacementTexturePrefetch, true, CfgFlag::PER_GAME),
+	ConfigSetting("ReplacementTexturePrefetchMB", &g_Config.iReplacementTexturePrefetchMB, 256, CfgFlag::DEFAULT),
 
 	ConfigSetting("TexScalingLevel", &g_Config.iTexScalingLevel, 1, CfgFlag::PER_GAME | CfgFlag::REPORT),
 	ConfigSetting("TexScalingType", &g_Config.iTexScalingType, 0, CfgFlag::PER_GAME | CfgFlag::REPORT),
 	ConfigSetting("TexDeposterize", &g_Config.bTexDeposterize, false, CfgFlag::PER_GAME | CfgFlag::REPORT),
+	ConfigSetting("TexScalingDiskCache", &g_Config.bTexScalingDiskCache, false, CfgFlag::PER_GAME),
+	ConfigSetting("TexScalingDiskCacheSizeMB", &g_Config.iTexScalingDiskCacheSizeMB, 256, CfgFlag::DEFAULT),
 	ConfigSetting("TexHardwareScaling", &g_Config.bTexHardwareScaling, false, CfgFlag::PER_GAME | CfgFlag::REPORT),
 	ConfigSetting("VSync", &g_Config.bVSync, &DefaultVSync, CfgFlag::PER_GAME),
 	ConfigSetting("BloomHack", &g_Config.iBloomHack, 0, CfgFlag::PER_GAME | CfgFlag::REPORT),
@@ -778,6 +787,7 @@ static const ConfigSetting soundSettings[] = {
 	ConfigSetting("Enable", &g_Config.bEnableSound, true, CfgFlag::PER_GAME),
 	ConfigSetting("ExtraAudioBuffering", &g_Config.bExtraAudioBuffering, false, CfgFlag::DEFAULT),
 	ConfigSetting("AudioBufferSize", &g_Config.iSDLAudioBufferSize, 256, CfgFlag::DEFAULT),
+	ConfigSetting("AudioResampler", &g_Config.iAudioResampler, (int)AudioResampler::LINEAR, CfgFlag::DEFAULT),
 
 	// Legacy volume settings, these get auto upgraded through default handlers on the new settings. NOTE: Must be before the new ones in the order here.
 	// The default settings here are still relevant, they will get propagated into the new ones.
@@ -798,6 +808,8 @@ static const ConfigSetting soundSettings[] = {
 	ConfigSetting("AudioMixWithOthers", &g_Config.bAudioMixWithOthers, true, CfgFlag::DEFAULT),
 	ConfigSetting("AudioRespectSilentMode", &g_Config.bAudioRespectSilentMode, false, CfgFlag::DEFAULT),
 	ConfigSetting("UseOldAtrac", &g_Config.bUseOldAtrac, false, CfgFlag::DEFAULT),
+	ConfigSetting("AtracPcmCache", &g_Config.bAtracPcmCache, false, CfgFlag::PER_GAME),
+	ConfigSetting("AtracPcmCacheSizeMB", &g_Config.iAtracPcmCacheSizeMB, 512, CfgFlag::DEFAULT),
 };
 
 static bool DefaultShowTouchControls() {
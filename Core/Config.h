@@ -120,11 +120,16 @@ struct Config {
 	bool bDisableHTTPS;
 
 	bool bSeparateSASThread;
+	bool bSasLookahead;
 	int iIOTimingMethod;
 	int iLockedCPUSpeed;
 	bool bAutoSaveSymbolMap;
 	bool bCompressSymbols;
 	bool bCacheFullIsoInRam;
+	bool bMemoryMapIso;
+	bool bDiscPrefetch;  // Record the disc access pattern and replay it ahead of the game on later boots.
+	bool bParallelCSODecompression;
+	int iCHDHunkCacheSize;  // In MB. 0 disables the cache, readahead and parallel decode.
 	int iRemoteISOPort;
 	std::string sLastRemoteISOServer;
 	int iLastRemoteISOPort;
@@ -232,10 +237,14 @@ struct Config {
 	bool bReplaceTextures;
 	bool bSaveNewTextures;
 	int iReplacementTextureLoadSpeed;
+	bool bReplacementTexturePrefetch;
+	int iReplacementTexturePrefetchMB;
 	bool bIgnoreTextureFilenames;
 	int iTexScalingLevel; // 0 = auto, 1 = off, 2 = 2x, ..., 5 = 5x
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
+	bool bTexScalingDiskCache;
+	int iTexScalingDiskCacheSizeMB;
 	bool bTexHardwareScaling;
 	int iFpsLimit1;
 	int iFpsLimit2;
@@ -303,9 +312,12 @@ struct Config {
 	int iAltSpeedVolume;
 
 	bool bExtraAudioBuffering;  // For bluetooth
+	int iAudioResampler;  // AudioResampler
 	std::string sAudioDevice;
 	bool bAutoAudioDevice;
 	bool bUseOldAtrac;
+	bool bAtracPcmCache;
+	int iAtracPcmCacheSizeMB;
 
 	// iOS only for now
 	bool bAudioMixWithOthers;
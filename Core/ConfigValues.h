@@ -150,6 +150,11 @@ enum IOTimingMethods {
 	IOTIMING_UMDSLOWREALISTIC = 3,
 };
 
+enum class AudioResampler {
+	LINEAR = 0,
+	SINC = 1,
+};
+
 enum class AutoLoadSaveState {
 	OFF = 0,
 	OLDEST = 1,
@@ -62,6 +62,9 @@ struct CoreParameter {
 	bool startBreak = false;
 	std::string *collectDebugOutput = nullptr;
 	bool headLess = false;   // Try to avoid messageboxes etc
+	// Run as fast as possible without output: nothing is drawn or presented and audio output is dropped.
+	// The GE still processes every command, transfers and bounding box tests included. Implies fastForward.
+	bool turbo = false;
 
 	// Internal PSP rendering resolution and scale factor.
 	int renderScaleFactor = 1;
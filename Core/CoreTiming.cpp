@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <atomic>
 #include <climits>
 #include <cstdio>
@@ -48,8 +49,25 @@ static std::set<int> usedEventTypes;
 static std::set<int> restoredEventTypes;
 static int nextEventTypeRestoreId = -1;
 
-Event *first;
-Event *eventPool = 0;
+// The scheduled events, as a 4-ary min-heap ordered by time. Events scheduled for the same time run in
+// the order they were scheduled, using seq. The heap holds indices into the events pool, so that events
+// can be removed from the middle, and each event type has a linked list of its events for finding them.
+struct QueuedEvent {
+	s64 time;
+	u64 seq;
+	u64 userdata;
+	int type;
+	int heapIndex;
+	int prevOfType;
+	int nextOfType;
+};
+
+static std::vector<QueuedEvent> events;
+static std::vector<int> freeEvents;
+static std::vector<int> eventHeap;
+// Per event type, the first of its events or -1. Negative (invalid) types share the first list.
+static std::vector<int> firstOfType;
+static u64 nextEventSeq = 0;
 
 // Downcount has been moved to currentMIPS, to save a couple of clocks in every ARM JIT block
 // as we can already reach that structure through a register.
@@ -106,28 +124,123 @@ u64 GetGlobalTimeUs() {
 	return lastGlobalTimeUs + usSinceLast;
 }
 
-const Event *GetFirstEvent() {
-	return first;
-}
-
 const std::vector<EventType> &GetEventTypes() {
 	return event_types;
 }
 
-Event* GetNewEvent()
-{
-	if(!eventPool)
-		return new Event;
+static inline bool EventBefore(int a, int b) {
+	const QueuedEvent &ea = events[a];
+	const QueuedEvent &eb = events[b];
+	return ea.time < eb.time || (ea.time == eb.time && ea.seq < eb.seq);
+}
 
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
+static inline void PlaceInHeap(int pos, int index) {
+	eventHeap[pos] = index;
+	events[index].heapIndex = pos;
 }
 
-void FreeEvent(Event* ev)
-{
-	ev->next = eventPool;
-	eventPool = ev;
+static void SiftUp(int pos) {
+	const int index = eventHeap[pos];
+	while (pos > 0) {
+		const int parent = (pos - 1) / 4;
+		if (!EventBefore(index, eventHeap[parent]))
+			break;
+		PlaceInHeap(pos, eventHeap[parent]);
+		pos = parent;
+	}
+	PlaceInHeap(pos, index);
+}
+
+static void SiftDown(int pos) {
+	const int index = eventHeap[pos];
+	const int size = (int)eventHeap.size();
+	while (true) {
+		const int firstChild = pos * 4 + 1;
+		if (firstChild >= size)
+			break;
+		const int lastChild = std::min(firstChild + 4, size);
+		int best = firstChild;
+		for (int child = firstChild + 1; child < lastChild; child++) {
+			if (EventBefore(eventHeap[child], eventHeap[best]))
+				best = child;
+		}
+		if (!EventBefore(eventHeap[best], index))
+			break;
+		PlaceInHeap(pos, eventHeap[best]);
+		pos = best;
+	}
+	PlaceInHeap(pos, index);
+}
+
+static int &FirstOfType(int type) {
+	const size_t bucket = type < 0 ? 0 : (size_t)type;
+	if (bucket >= firstOfType.size())
+		firstOfType.resize(bucket + 1, -1);
+	return firstOfType[bucket];
+}
+
+static void AddEventToQueue(s64 time, int type, u64 userdata) {
+	int index;
+	if (freeEvents.empty()) {
+		index = (int)events.size();
+		events.push_back(QueuedEvent{});
+	} else {
+		index = freeEvents.back();
+		freeEvents.pop_back();
+	}
+
+	QueuedEvent &ev = events[index];
+	ev.time = time;
+	ev.seq = nextEventSeq++;
+	ev.userdata = userdata;
+	ev.type = type;
+
+	int &first = FirstOfType(type);
+	ev.prevOfType = -1;
+	ev.nextOfType = first;
+	if (first != -1)
+		events[first].prevOfType = index;
+	first = index;
+
+	eventHeap.push_back(index);
+	SiftUp((int)eventHeap.size() - 1);
+}
+
+static void RemoveEventFromQueue(int index) {
+	QueuedEvent &ev = events[index];
+	if (ev.prevOfType != -1)
+		events[ev.prevOfType].nextOfType = ev.nextOfType;
+	else
+		FirstOfType(ev.type) = ev.nextOfType;
+	if (ev.nextOfType != -1)
+		events[ev.nextOfType].prevOfType = ev.prevOfType;
+
+	const int pos = ev.heapIndex;
+	const int last = eventHeap.back();
+	eventHeap.pop_back();
+	if (last != index) {
+		// Move the last one into the hole, it may belong either above or below it.
+		PlaceInHeap(pos, last);
+		if (pos > 0 && EventBefore(last, eventHeap[(pos - 1) / 4]))
+			SiftUp(pos);
+		else
+			SiftDown(pos);
+	}
+
+	ev.heapIndex = -1;
+	freeEvents.push_back(index);
+}
+
+std::vector<BaseEvent> GetScheduledEvents() {
+	std::vector<int> sorted = eventHeap;
+	std::sort(sorted.begin(), sorted.end(), EventBefore);
+
+	std::vector<BaseEvent> result;
+	result.reserve(sorted.size());
+	for (int index : sorted) {
+		result.push_back(BaseEvent{ events[index].time, events[index].userdata, events[index].type });
+	}
+	return result;
 }
 
 int RegisterEvent(const char *name, TimedCallback callback) {
@@ -173,7 +286,7 @@ void RestoreRegisterEvent(int &event_type, const char *name, TimedCallback callb
 }
 
 void UnregisterAllEvents() {
-	_dbg_assert_msg_(first == nullptr, "Unregistering events with events pending - this isn't good.");
+	_dbg_assert_msg_(eventHeap.empty(), "Unregistering events with events pending - this isn't good.");
 	event_types.clear();
 	usedEventTypes.clear();
 	restoredEventTypes.clear();
@@ -196,11 +309,11 @@ void Shutdown()
 	ClearPendingEvents();
 	UnregisterAllEvents();
 
-	while (eventPool) {
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
+	events.clear();
+	events.shrink_to_fit();
+	freeEvents.clear();
+	freeEvents.shrink_to_fit();
+	eventHeap.shrink_to_fit();
 }
  
 u64 GetTicks()
@@ -220,30 +333,11 @@ u64 GetIdleTicks()
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
-}
-
-void AddEventToQueue(Event* ne)
-{
-	Event* prev = NULL;
-	Event** pNext = &first;
-	for(;;)
-	{
-		Event*& next = *pNext;
-		if(!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	events.clear();
+	freeEvents.clear();
+	eventHeap.clear();
+	firstOfType.clear();
+	nextEventSeq = 0;
 }
 
 // This must be run ONLY from within the cpu thread
@@ -251,55 +345,34 @@ void AddEventToQueue(Event* ne)
 // than Advance
 void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = GetTicks() + cyclesIntoFuture;
-	AddEventToQueue(ne);
+	AddEventToQueue(GetTicks() + cyclesIntoFuture, event_type, userdata);
 }
 
 // Returns cycles left in timer.
 s64 UnscheduleEvent(int event_type, u64 userdata)
 {
-	s64 result = 0;
-	if (!first)
-		return result;
-	while(first)
-	{
-		if (first->type == event_type && first->userdata == userdata)
-		{
-			result = first->time - GetTicks();
-
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return result;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type && ptr->userdata == userdata)
-		{
-			result = ptr->time - GetTicks();
-
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
+	// If there are several, this is for the one that would run last.
+	int lastMatch = -1;
+	int index = FirstOfType(event_type);
+	while (index != -1) {
+		const int next = events[index].nextOfType;
+		if (events[index].type == event_type && events[index].userdata == userdata) {
+			if (lastMatch == -1) {
+				lastMatch = index;
+			} else if (EventBefore(lastMatch, index)) {
+				RemoveEventFromQueue(lastMatch);
+				lastMatch = index;
+			} else {
+				RemoveEventFromQueue(index);
+			}
 		}
+		index = next;
 	}
 
+	if (lastMatch == -1)
+		return 0;
+	s64 result = events[lastMatch].time - GetTicks();
+	RemoveEventFromQueue(lastMatch);
 	return result;
 }
 
@@ -309,66 +382,38 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
+	for (int index = FirstOfType(event_type); index != -1; index = events[index].nextOfType) {
+		if (events[index].type == event_type)
 			return true;
-		e = e->next;
 	}
 	return false;
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-	while(first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
+	int index = FirstOfType(event_type);
+	while (index != -1) {
+		const int next = events[index].nextOfType;
+		if (events[index].type == event_type)
+			RemoveEventFromQueue(index);
+		index = next;
 	}
 }
 
 void ProcessEvents() {
-	while (first) {
-		if (first->time <= (s64)GetTicks()) {
-			// INFO_LOG(Log::CPU, "%s (%lld, %lld) ", first->name ? first->name : "?", (u64)GetTicks(), (u64)first->time);
-			Event *evt = first;
-			first = first->next;
-			if (evt->type >= 0 && evt->type < event_types.size()) {
-				event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
+	while (!eventHeap.empty()) {
+		const QueuedEvent &first = events[eventHeap[0]];
+		if (first.time <= (s64)GetTicks()) {
+			// The callback may schedule more events, so copy it out first.
+			const s64 time = first.time;
+			const u64 userdata = first.userdata;
+			const int type = first.type;
+			RemoveEventFromQueue(eventHeap[0]);
+			if (type >= 0 && type < event_types.size()) {
+				event_types[type].callback(userdata, (int)(GetTicks() - time));
 			} else {
-				_dbg_assert_msg_(false, "Bad event type %d", evt->type);
+				_dbg_assert_msg_(false, "Bad event type %d", type);
 			}
-			FreeEvent(evt);
 		} else {
 			// Caught up to the current time.
 			break;
@@ -398,7 +443,7 @@ void Advance() {
 
 	ProcessEvents();
 
-	if (!first) {
+	if (eventHeap.empty()) {
 		// This should never happen in PPSSPP.
 		if (slicelength < 10000) {
 			slicelength += 10000;
@@ -406,7 +451,7 @@ void Advance() {
 		}
 	} else {
 		// Note that events can eat cycles as well.
-		int target = (int)(first->time - globalTimer);
+		int target = (int)(events[eventHeap[0]].time - globalTimer);
 		if (target > MAX_SLICE_LENGTH)
 			target = MAX_SLICE_LENGTH;
 
@@ -417,10 +462,8 @@ void Advance() {
 }
 
 void LogPendingEvents() {
-	Event *ptr = first;
-	while (ptr) {
-		//INFO_LOG(Log::CPU, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
+	for (const BaseEvent &ev : GetScheduledEvents()) {
+		DEBUG_LOG(Log::CPU, "PENDING: Now: %lld Pending: %lld Type: %d", (long long)globalTimer, (long long)ev.time, ev.type);
 	}
 }
 
@@ -429,9 +472,9 @@ void Idle(int maxIdle) {
 	if (maxIdle != 0 && cyclesDown > maxIdle)
 		cyclesDown = maxIdle;
 
-	if (first && cyclesDown > 0) {
+	if (!eventHeap.empty() && cyclesDown > 0) {
 		int cyclesExecuted = slicelength - currentMIPS->downcount;
-		int cyclesNextEvent = (int) (first->time - globalTimer);
+		int cyclesNextEvent = (int) (events[eventHeap[0]].time - globalTimer);
 
 		if (cyclesNextEvent < cyclesExecuted + cyclesDown)
 			cyclesDown = cyclesNextEvent - cyclesExecuted;
@@ -450,23 +493,20 @@ void Idle(int maxIdle) {
 }
 
 std::string GetScheduledEventsSummary() {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr) {
-		unsigned int t = ptr->type;
+	for (const BaseEvent &ev : GetScheduledEvents()) {
+		unsigned int t = ev.type;
 		if (t >= event_types.size()) {
 			_dbg_assert_msg_(false, "Invalid event type %d", t);
-			ptr = ptr->next;
 			continue;
 		}
 		const char *name = event_types[t].name;
 		if (!name)
 			name = "[unknown]";
 		char temp[512];
-		snprintf(temp, sizeof(temp), "%s : %i %08x%08x\n", name, (int)ptr->time, (u32)(ptr->userdata >> 32), (u32)(ptr->userdata));
+		snprintf(temp, sizeof(temp), "%s : %i %08x%08x\n", name, (int)ev.time, (u32)(ev.userdata >> 32), (u32)(ev.userdata));
 		text += temp;
-		ptr = ptr->next;
 	}
 	return text;
 }
@@ -484,6 +524,37 @@ void Event_DoStateOld(PointerWrap &p, BaseEvent *ev) {
 	usedEventTypes.insert(ev->type);
 }
 
+// Stored in order like DoLinkedList() does, which is what the queue used to be.
+template <void (*TDo)(PointerWrap &p, BaseEvent *ev)>
+static void DoEventQueue(PointerWrap &p) {
+	if (p.mode == PointerWrap::MODE_READ) {
+		ClearPendingEvents();
+		while (true) {
+			u8 shouldExist = 0;
+			Do(p, shouldExist);
+			if (shouldExist != 1) {
+				if (shouldExist != 0) {
+					WARN_LOG(Log::SaveState, "Savestate failure: incorrect item marker %d", shouldExist);
+					p.SetError(p.ERROR_FAILURE);
+				}
+				break;
+			}
+			BaseEvent ev{};
+			TDo(p, &ev);
+			// In order, so events at the same time keep their order too.
+			AddEventToQueue(ev.time, ev.type, ev.userdata);
+		}
+	} else {
+		for (BaseEvent ev : GetScheduledEvents()) {
+			u8 shouldExist = 1;
+			Do(p, shouldExist);
+			TDo(p, &ev);
+		}
+		u8 shouldExist = 0;
+		Do(p, shouldExist);
+	}
+}
+
 void DoState(PointerWrap &p) {
 	auto s = p.Section("CoreTiming", 1, 3);
 	if (!s)
@@ -508,11 +579,11 @@ void DoState(PointerWrap &p) {
 	restoredEventTypes.clear();
 
 	if (s >= 3) {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoState>(p, first, (Event **)nullptr);
+		DoEventQueue<Event_DoState>(p);
 		// This is here because we previously stored a second queue of "threadsafe" events. Gone now. Remove in the next section version upgrade.
 		DoIgnoreUnusedLinkedList(p);
 	} else {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoStateOld>(p, first, (Event **)nullptr);
+		DoEventQueue<Event_DoStateOld>(p);
 		DoIgnoreUnusedLinkedList(p);
 	}
 
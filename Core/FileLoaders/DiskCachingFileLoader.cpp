@@ -414,7 +414,7 @@ u32 DiskCachingFileLoaderCache::AllocateBlock(u32 indexPos) {
 	return INVALID_BLOCK;
 }
 
-std::string DiskCachingFileLoaderCache::MakeCacheFilename(const Path &path) {
+std::string DiskCachingFileLoaderCache::MakeCacheFilename(const Path &path, const char *extension) {
 	static const char *const invalidChars = "?*:/\\^|<>\"'";
 	std::string filename = path.ToString();
 	for (size_t i = 0; i < filename.size(); ++i) {
@@ -423,10 +423,10 @@ std::string DiskCachingFileLoaderCache::MakeCacheFilename(const Path &path) {
 			filename[i] = '_';
 		}
 	}
-	return filename + ".ppdc";
+	return filename + extension;
 }
 
-::Path DiskCachingFileLoaderCache::MakeCacheFilePath(const Path &filename) {
+::Path DiskCachingFileLoaderCache::MakeCacheFilePath(const Path &filename, const char *extension) {
 	Path dir = cacheDir_;
 	if (dir.empty()) {
 		dir = GetSysDirectory(DIRECTORY_CACHE);
@@ -436,7 +436,7 @@ ::Path DiskCachingFileLoaderCache::MakeCacheFilePath(const Path &filename) {
 		File::CreateFullPath(dir);
 	}
 
-	return dir / MakeCacheFilename(filename);
+	return dir / MakeCacheFilename(filename, extension);
 }
 
 s64 DiskCachingFileLoaderCache::GetBlockOffset(u32 block) {
@@ -86,6 +86,10 @@ class DiskCachingFileLoaderCache {
 
 	bool HasData() const;
 
+	// Also used for other per-disc files kept alongside the cache, with a different extension.
+	static Path MakeCacheFilePath(const Path &filename, const char *extension = ".ppdc");
+	static std::string MakeCacheFilename(const Path &path, const char *extension = ".ppdc");
+
 private:
 	void InitCache(const Path &path);
 	void ShutdownCache();
@@ -99,8 +103,6 @@ class DiskCachingFileLoaderCache {
 	void WriteIndexData(u32 indexPos, BlockInfo &info);
 	s64 GetBlockOffset(u32 block);
 
-	Path MakeCacheFilePath(const Path &filename);
-	std::string MakeCacheFilename(const Path &path);
 	bool LoadCacheFile(const Path &path);
 	void LoadCacheIndex();
 	void CreateCacheFile(const Path &path);
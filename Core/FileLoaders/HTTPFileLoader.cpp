@@ -16,9 +16,12 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <thread>
 
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/FileLoaders/HTTPFileLoader.h"
 
@@ -51,7 +54,7 @@ void HTTPFileLoader::Prepare() {
 
 					if (url.ToString() == url_.ToString() || url.ToString() == resourceURL.ToString()) {
 						ERROR_LOG(Log::Loader, "HTTP request failed, hit a redirect loop");
-						latestError_ = "Could not connect (redirect loop)";
+						SetError("Could not connect (redirect loop)");
 						return;
 					}
 
@@ -62,14 +65,14 @@ void HTTPFileLoader::Prepare() {
 
 				// No Location header?
 				ERROR_LOG(Log::Loader, "HTTP request failed, invalid redirect");
-				latestError_ = "Could not connect (invalid response)";
+				SetError("Could not connect (invalid response)");
 				return;
 			}
 
 			if (code != 200) {
 				// Leave size at 0, invalid.
 				ERROR_LOG(Log::Loader, "HTTP request failed, got %03d for %s", code, filename_.c_str());
-				latestError_ = "Could not connect (invalid response)";
+				SetError("Could not connect (invalid response)");
 				Disconnect();
 				return;
 			}
@@ -118,13 +121,13 @@ void HTTPFileLoader::Prepare() {
 int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseHeaders) {
 	if (!url.Valid()) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, invalid URL: '%s'", url.ToString().c_str());
-		latestError_ = "Invalid URL";
+		SetError("Invalid URL");
 		return -400;
 	}
 
 	if (!client_.Resolve(url.Host().c_str(), url.Port())) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, unable to resolve: |%s| port %d", url.Host().c_str(), url.Port());
-		latestError_ = "Could not connect (name not resolved)";
+		SetError("Could not connect (name not resolved)");
 		return -400;
 	}
 
@@ -134,7 +137,7 @@ int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseH
 	Connect(10.0);
 	if (!connected_) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, failed to connect: %s port %d (resource: '%s')", url.Host().c_str(), url.Port(), url.Resource().c_str());
-		latestError_ = "Could not connect (refused to connect)";
+		SetError("Could not connect (refused to connect)");
 		return -400;
 	}
 
@@ -142,7 +145,7 @@ int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseH
 	int err = client_.SendRequest("HEAD", req, nullptr, &progress_);
 	if (err < 0) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, failed to send request: %s port %d", url.Host().c_str(), url.Port());
-		latestError_ = "Could not connect (could not request data)";
+		SetError("Could not connect (could not request data)");
 		Disconnect();
 		return -400;
 	}
@@ -153,6 +156,11 @@ int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseH
 
 HTTPFileLoader::~HTTPFileLoader() {
 	Disconnect();
+	for (auto &conn : connections_) {
+		if (conn->connected) {
+			conn->client.Disconnect();
+		}
+	}
 }
 
 bool HTTPFileLoader::Exists() {
@@ -180,7 +188,6 @@ Path HTTPFileLoader::GetPath() const {
 
 size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags) {
 	Prepare();
-	std::lock_guard<std::mutex> guard(readAtMutex_);
 
 	s64 absoluteEnd = std::min(absolutePos + (s64)bytes, filesize_);
 	if (absolutePos >= filesize_ || bytes == 0) {
@@ -188,31 +195,137 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		return 0;
 	}
 
-	Connect(10.0);
-	if (!connected_) {
-		return 0;
+	// Over a slow link, one request at a time mostly waits for the round trip. Bigger reads are
+	// split into range requests that run in parallel on separate connections.
+	const int count = PlanRequests(absoluteEnd - absolutePos);
+	if (count <= 1) {
+		Connection *conn = AcquireConnection();
+		size_t readBytes = ReadRange(conn, absolutePos, absoluteEnd, data);
+		ReleaseConnection(conn);
+		return readBytes;
+	}
+
+	const s64 partSize = ((absoluteEnd - absolutePos) / count + MIN_REQUEST_SIZE - 1) & ~(s64)(MIN_REQUEST_SIZE - 1);
+	std::vector<s64> starts(count + 1);
+	for (int i = 0; i <= count; ++i) {
+		starts[i] = std::min(absolutePos + partSize * i, absoluteEnd);
+	}
+	std::vector<size_t> results(count);
+	auto readPart = [&](int i) {
+		if (starts[i] < starts[i + 1]) {
+			Connection *conn = AcquireConnection();
+			results[i] = ReadRange(conn, starts[i], starts[i + 1], (u8 *)data + (starts[i] - absolutePos));
+			ReleaseConnection(conn);
+		}
+	};
+
+	// Not on the thread pool: we're often called from an IO worker already, and the others may be
+	// waiting for us (behind the file system lock), so there might not be a free worker to run these.
+	// A thread is cheap next to a network round trip.
+	std::vector<std::thread> threads;
+	for (int i = 1; i < count; ++i) {
+		threads.emplace_back([&, i]() {
+			SetCurrentThreadName("HTTPRangeRead");
+			readPart(i);
+		});
+	}
+	readPart(0);
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	// Anything after a short part would leave a hole.
+	size_t readBytes = 0;
+	for (int i = 0; i < count; ++i) {
+		readBytes += results[i];
+		if (results[i] != (size_t)(starts[i + 1] - starts[i])) {
+			break;
+		}
 	}
+	return readBytes;
+}
+
+HTTPFileLoader::Connection *HTTPFileLoader::AcquireConnection() {
+	std::unique_lock<std::mutex> guard(connectionsLock_);
+	while (idleConnections_.empty() && connections_.size() >= MAX_CONNECTIONS) {
+		connectionFree_.wait(guard);
+	}
+	if (!idleConnections_.empty()) {
+		Connection *conn = idleConnections_.back();
+		idleConnections_.pop_back();
+		return conn;
+	}
+
+	connections_.push_back(std::make_unique<Connection>());
+	Connection *conn = connections_.back().get();
+	conn->client.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
+	conn->client.SetKeepAlive(true);
+	return conn;
+}
+
+void HTTPFileLoader::ReleaseConnection(Connection *conn) {
+	std::lock_guard<std::mutex> guard(connectionsLock_);
+	idleConnections_.push_back(conn);
+	connectionFree_.notify_one();
+}
+
+bool HTTPFileLoader::ConnectConnection(Connection *conn) {
+	if (conn->connected) {
+		return true;
+	}
+	if (!conn->client.Resolve(url_.Host().c_str(), url_.Port())) {
+		SetError("Could not connect (name not resolved)");
+		return false;
+	}
+	conn->client.SetDataTimeout(20.0);
+	conn->connected = conn->client.Connect(3, 10.0, &cancel_);
+	return conn->connected;
+}
 
+size_t HTTPFileLoader::ReadRange(Connection *conn, s64 absolutePos, s64 absoluteEnd, void *data) {
 	char requestHeaders[4096];
 	// Note that the Range header is *inclusive*.
 	snprintf(requestHeaders, sizeof(requestHeaders),
 		"Range: bytes=%lld-%lld\r\n", absolutePos, absoluteEnd - 1);
 
 	http::RequestParams req(url_.Resource(), "*/*");
-	int err = client_.SendRequest("GET", req, requestHeaders, &progress_);
-	if (err < 0) {
-		latestError_ = "Invalid response reading data";
-		Disconnect();
+	net::RequestProgress progress(&cancel_);
+	net::Buffer readbuf;
+	std::vector<std::string> responseHeaders;
+	std::string statusLine;
+	int code = -1;
+	double requestTime = 0.0;
+	// The server may have closed a kept-alive connection in the meantime, then we retry once on a new one.
+	for (int attempt = 0; attempt < 2 && code < 0; ++attempt) {
+		const bool reused = conn->connected;
+		if (!ConnectConnection(conn)) {
+			return 0;
+		}
+		requestTime = time_now_d();
+		if (conn->client.SendRequest("GET", req, requestHeaders, &progress) >= 0) {
+			code = conn->client.ReadResponseHeaders(&readbuf, responseHeaders, &progress, &statusLine);
+		}
+		if (code < 0) {
+			conn->client.Disconnect();
+			conn->connected = false;
+			readbuf.clear();
+			responseHeaders.clear();
+			if (!reused) {
+				break;
+			}
+		}
+	}
+	if (code < 0) {
+		SetError("Invalid response reading data");
 		return 0;
 	}
+	const double headersTime = time_now_d();
 
-	net::Buffer readbuf;
-	std::vector<std::string> responseHeaders;
-	int code = client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
 	if (code != 206) {
 		ERROR_LOG(Log::Loader, "HTTP server did not respond with range, received code=%03d", code);
-		latestError_ = "Invalid response reading data";
-		Disconnect();
+		SetError("Invalid response reading data");
+		conn->client.Disconnect();
+		conn->connected = false;
 		return 0;
 	}
 
@@ -239,30 +352,71 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 
 	// TODO: Would be nice to read directly.
 	net::Buffer output;
-	int res = client_.ReadResponseEntity(&readbuf, responseHeaders, &output, &progress_);
+	int res = conn->client.ReadResponseEntity(&readbuf, responseHeaders, &output, &progress);
 	if (res != 0) {
 		ERROR_LOG(Log::Loader, "Unable to read HTTP response entity: %d", res);
 		// Let's take anything we got anyway.  Not worse than returning nothing?
 	}
 
-	// TODO: Keepalive instead.
-	Disconnect();
+	// HTTP/1.1 connections persist unless the server says otherwise, older ones only if it asks for it.
+	std::string connection;
+	http::GetHeaderValue(responseHeaders, "Connection", &connection);
+	bool persistent = startsWith(statusLine, "HTTP/1.1") ? !equalsNoCase(connection, "close") : equalsNoCase(connection, "keep-alive");
+	// Without a Content-Length, or when chunked, we can't be sure where the body ended, so the next
+	// response might start in the middle of it. Don't reuse those.
+	std::string contentLength, transferEncoding;
+	if (!http::GetHeaderValue(responseHeaders, "Content-Length", &contentLength)) {
+		persistent = false;
+	}
+	if (http::GetHeaderValue(responseHeaders, "Transfer-Encoding", &transferEncoding) && containsNoCase(transferEncoding, "chunked")) {
+		persistent = false;
+	}
+	if (res != 0 || !persistent) {
+		conn->client.Disconnect();
+		conn->connected = false;
+	}
 
 	if (!supportedResponse) {
 		ERROR_LOG(Log::Loader, "HTTP server did not respond with the range we wanted.");
-		latestError_ = "Invalid response reading data";
+		SetError("Invalid response reading data");
 		return 0;
 	}
 
-	size_t readBytes = output.size();
+	size_t readBytes = std::min(output.size(), (size_t)(absoluteEnd - absolutePos));
+	UpdateStats(readBytes, headersTime - requestTime, time_now_d() - headersTime);
 	output.Take(readBytes, (char *)data);
-	filepos_ = absolutePos + readBytes;
 	return readBytes;
 }
 
+// Requests smaller than what one connection moves in a round trip are mostly waiting, so that's
+// the smallest part worth splitting off.
+int HTTPFileLoader::PlanRequests(s64 bytes) {
+	std::lock_guard<std::mutex> guard(statsLock_);
+	if (bytesPerSecond_ <= 0.0) {
+		// Nothing measured yet.
+		return 1;
+	}
+	const double minSize = std::max((double)MIN_REQUEST_SIZE, latency_ * bytesPerSecond_);
+	return std::max(1, std::min((int)MAX_CONNECTIONS, (int)(bytes / minSize)));
+}
+
+void HTTPFileLoader::UpdateStats(size_t bytes, double latency, double transferTime) {
+	std::lock_guard<std::mutex> guard(statsLock_);
+	latency_ = latency_ == 0.0 ? latency : latency_ * 0.75 + latency * 0.25;
+	// Small responses arrive with the headers, and don't tell us anything about the rate.
+	if (bytes >= MIN_REQUEST_SIZE && transferTime > 0.001) {
+		const double rate = bytes / transferTime;
+		bytesPerSecond_ = bytesPerSecond_ == 0.0 ? rate : bytesPerSecond_ * 0.75 + rate * 0.25;
+	}
+}
+
 void HTTPFileLoader::Connect(double timeout) {
 	if (!connected_) {
-		cancel_ = false;
 		connected_ = client_.Connect(3, timeout, &cancel_);
 	}
 }
+
+void HTTPFileLoader::SetError(const char *error) {
+	std::lock_guard<std::mutex> guard(errorLock_);
+	latestError_ = error;
+}
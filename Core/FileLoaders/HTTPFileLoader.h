@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -51,11 +54,19 @@ class HTTPFileLoader : public FileLoader {
 	}
 
 	std::string LatestError() const override {
+		std::lock_guard<std::mutex> guard(errorLock_);
 		return latestError_;
 	}
 
 private:
+	// A persistent connection for range requests, kept alive if the server allows it.
+	struct Connection {
+		http::Client client;
+		bool connected = false;
+	};
+
 	void Prepare();
+	void SetError(const char *error);
 	int SendHEAD(const Url &url, std::vector<std::string> &responseHeaders);
 
 	void Connect(double timeout);
@@ -67,16 +78,40 @@ class HTTPFileLoader : public FileLoader {
 		connected_ = false;
 	}
 
+	Connection *AcquireConnection();
+	void ReleaseConnection(Connection *conn);
+	bool ConnectConnection(Connection *conn);
+	size_t ReadRange(Connection *conn, s64 absolutePos, s64 absoluteEnd, void *data);
+	int PlanRequests(s64 bytes);
+	void UpdateStats(size_t bytes, double latency, double transferTime);
+
+	enum {
+		MAX_CONNECTIONS = 4,
+		// Parallel requests are at least this big, and split on multiples of it.
+		MIN_REQUEST_SIZE = 65536,
+	};
+
 	s64 filesize_ = 0;
-	s64 filepos_ = 0;
 	Url url_;
 	http::Client client_;
 	net::RequestProgress progress_;
 	::Path filename_;
 	bool connected_ = false;
-	bool cancel_ = false;
+	// Once set, stays set. Shared by all the connections.
+	std::atomic<bool> cancel_{};
+	// Set from whichever thread ran into the problem.
+	mutable std::mutex errorLock_;
 	const char *latestError_ = "";
 
 	std::once_flag preparedFlag_;
-	std::mutex readAtMutex_;
+
+	std::mutex connectionsLock_;
+	std::condition_variable connectionFree_;
+	std::vector<std::unique_ptr<Connection>> connections_;
+	std::vector<Connection *> idleConnections_;
+
+	std::mutex statsLock_;
+	// Smoothed time from sending a request to its response headers, and transfer rate after that.
+	double latency_ = 0.0;
+	double bytesPerSecond_ = 0.0;
 };
@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Log.h"
+#include "Core/FileLoaders/MappedFileLoader.h"
+
+MappedFileLoader::MappedFileLoader(FileLoader *backend) : ProxiedFileLoader(backend) {
+	if (!backend_->Exists() || backend_->IsDirectory()) {
+		return;
+	}
+	if (!map_.Open(backend_->GetPath())) {
+		INFO_LOG(Log::Loader, "Couldn't map '%s', using regular reads", backend_->GetPath().c_str());
+		return;
+	}
+	if ((s64)map_.Size() != backend_->FileSize()) {
+		// Changed under us, don't trust it.
+		map_.Close();
+	}
+}
+
+size_t MappedFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags) {
+	if (!map_.IsOpen()) {
+		return backend_->ReadAt(absolutePos, bytes, count, data, flags);
+	}
+	if (bytes == 0 || absolutePos < 0 || (u64)absolutePos >= map_.Size()) {
+		return 0;
+	}
+
+	// Like the other loaders, only whole items are counted.
+	const u64 available = map_.Size() - (u64)absolutePos;
+	const size_t total = (size_t)std::min((u64)bytes * count, available);
+	memcpy(data, map_.Data() + absolutePos, total);
+	return total / bytes;
+}
+
+const u8 *MappedFileLoader::MappedPointer(s64 absolutePos, s64 bytes) {
+	if (!map_.IsOpen() || absolutePos < 0 || bytes < 0 || (u64)absolutePos + (u64)bytes > map_.Size()) {
+		return nullptr;
+	}
+	return map_.Data() + absolutePos;
+}
+
+void MappedFileLoader::Advise(s64 absolutePos, s64 bytes, MappedFileAdvice advice) {
+	if (absolutePos >= 0 && bytes > 0) {
+		map_.Advise((u64)absolutePos, (u64)bytes, advice);
+	}
+}
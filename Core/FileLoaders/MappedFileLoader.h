@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Common/CommonTypes.h"
+#include "Common/File/MappedFile.h"
+#include "Core/Loaders.h"
+
+// Serves reads from a read-only memory mapping of the whole file, so they're a memcpy rather
+// than a syscall each, and block devices can hand out pointers into the image (see
+// BlockDevice::GetBlockPointer.) Used for uncompressed ISOs on 64-bit hosts. If the file can't
+// be mapped, everything just goes to the wrapped loader.
+class MappedFileLoader : public ProxiedFileLoader {
+public:
+	MappedFileLoader(FileLoader *backend);
+
+	size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override;
+	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override {
+		return ReadAt(absolutePos, 1, bytes, data, flags);
+	}
+
+	const u8 *MappedPointer(s64 absolutePos, s64 bytes) override;
+	void Advise(s64 absolutePos, s64 bytes, MappedFileAdvice advice) override;
+
+	bool IsMapped() const { return map_.IsOpen(); }
+
+private:
+	MappedFile map_;
+};
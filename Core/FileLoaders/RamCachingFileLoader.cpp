@@ -229,6 +229,9 @@ void RamCachingFileLoader::StartReadAhead(s64 pos) {
 
 		AndroidJNIThreadContext jniContext;
 
+		// Remote loaders pay a round trip per read (and can split big ones into parallel requests),
+		// so read ahead in bigger pieces there.
+		const u32 readAheadBlocks = backend_->IsRemote() ? (u32)MAX_BLOCKS_PER_READ : (u32)BLOCK_READAHEAD;
 		while (aheadRemaining_ != 0 && !aheadCancel_) {
 			// Where should we look?
 			const u32 cacheStartPos = NextAheadBlock();
@@ -236,14 +239,14 @@ void RamCachingFileLoader::StartReadAhead(s64 pos) {
 				// Must be full.
 				break;
 			}
-			u32 cacheEndPos = cacheStartPos + BLOCK_READAHEAD - 1;
+			u32 cacheEndPos = cacheStartPos + readAheadBlocks - 1;
 			if (cacheEndPos >= blocks_.size()) {
 				cacheEndPos = (u32)blocks_.size() - 1;
 			}
 
 			for (u32 i = cacheStartPos; i <= cacheEndPos; ++i) {
 				if (blocks_[i] == 0) {
-					SaveIntoCache((u64)i << BLOCK_SHIFT, BLOCK_SIZE * BLOCK_READAHEAD, Flags::NONE);
+					SaveIntoCache((u64)i << BLOCK_SHIFT, BLOCK_SIZE * readAheadBlocks, Flags::NONE);
 					break;
 				}
 			}
@@ -41,6 +41,14 @@ class RamCachingFileLoader : public ProxiedFileLoader {
 
 	void Cancel() override;
 
+	// Same bytes, so the mapping is still good to use.
+	const u8 *MappedPointer(s64 absolutePos, s64 bytes) override {
+		return backend_->MappedPointer(absolutePos, bytes);
+	}
+	void Advise(s64 absolutePos, s64 bytes, MappedFileAdvice advice) override {
+		backend_->Advise(absolutePos, bytes, advice);
+	}
+
 private:
 	void InitCache();
 	void ShutdownCache();
@@ -1,12 +1,57 @@
+#include <algorithm>
+#include <cstring>
+
 #ifdef SHARED_LIBZIP
 #include <zip.h>
 #else
 #include "ext/libzip/zip.h"
 #endif
 
+#include "zlib.h"
+
+#include "Common/File/FileUtil.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
+#include "Core/FileLoaders/DiskCachingFileLoader.h"
 #include "Core/FileLoaders/LocalFileLoader.h"
 #include "Core/FileLoaders/ZipFileLoader.h"
 
+static const char *const INDEX_EXTENSION = ".ppzi";
+static const char INDEX_MAGIC[4] = { 'P', 'P', 'Z', 'I' };
+
+struct IndexFileHeader {
+	char magic[4];
+	u32_le version;
+	u64_le zipSize;
+	u64_le dataOffset;
+	u64_le compressedSize;
+	u64_le uncompressedSize;
+	u32_le crc;
+	u32_le numPoints;
+};
+
+// Followed by windowSize bytes of zlib compressed window.
+struct IndexFilePoint {
+	u64_le in;
+	u64_le out;
+	u32_le bits;
+	u32_le windowSize;
+};
+
+static u16 Read16(const u8 *p) {
+	return (u16)(p[0] | (p[1] << 8));
+}
+
+static u32 Read32(const u8 *p) {
+	return (u32)Read16(p) | ((u32)Read16(p + 2) << 16);
+}
+
+static u64 Read64(const u8 *p) {
+	return (u64)Read32(p) | ((u64)Read32(p + 4) << 32);
+}
+
 ZipFileLoader::ZipFileLoader(FileLoader *sourceLoader)
 	: ProxiedFileLoader(sourceLoader), zipArchive_(nullptr) {
 	if (!backend_ || !backend_->Exists() || backend_->IsDirectory()) {
@@ -31,6 +76,16 @@ ZipFileLoader::ZipFileLoader(FileLoader *sourceLoader)
 }
 
 ZipFileLoader::~ZipFileLoader() {
+	{
+		std::unique_lock<std::mutex> guard(lock_);
+		stop_ = true;
+		indexProgress_.notify_all();
+		tasksDone_.wait(guard, [&] { return pendingTasks_ == 0; });
+	}
+	if (indexThread_.joinable()) {
+		indexThread_.join();
+	}
+
 	if (dataFile_) {
 		zip_fclose(dataFile_);
 	}
@@ -43,7 +98,7 @@ ZipFileLoader::~ZipFileLoader() {
 }
 
 bool ZipFileLoader::Initialize(int fileIndex) {
-	_dbg_assert_(!data_);
+	_dbg_assert_(mode_ == Mode::NONE);
 
 	struct zip_stat zstat;
 	int retval = zip_stat_index(zipArchive_, fileIndex, ZIP_FL_NOCASE | ZIP_FL_UNCHANGED, &zstat);
@@ -55,35 +110,136 @@ bool ZipFileLoader::Initialize(int fileIndex) {
 
 	_dbg_assert_(zstat.index == fileIndex);
 	dataFileSize_ = zstat.size;
+	crc_ = zstat.crc;
+
+	if (zstat.encryption_method == ZIP_EM_NONE && FindEntryData(fileIndex, zstat)) {
+		if (zstat.comp_method == ZIP_CM_STORE && compressedSize_ == dataFileSize_) {
+			mode_ = Mode::STORED;
+			return true;
+		}
+		if (zstat.comp_method == ZIP_CM_DEFLATE) {
+			mode_ = Mode::INDEXED;
+			StartIndex();
+			return true;
+		}
+	}
+
+	// Let libzip deal with it, from the start.
 	dataFile_ = zip_fopen_index(zipArchive_, zstat.index, ZIP_FL_UNCHANGED);
 	data_ = (u8 *)malloc(dataFileSize_);
-	return data_ != nullptr;
+	if (!dataFile_ || !data_) {
+		return false;
+	}
+	mode_ = Mode::BUFFERED;
+	return true;
+}
+
+// libzip doesn't tell us where the data of an entry starts, so look it up in the central directory.
+bool ZipFileLoader::FindEntryData(int fileIndex, const zip_stat_t &zstat) {
+	const s64 zipSize = backend_->FileSize();
+	// The end of central directory record can be followed by a comment of up to 64 KB,
+	// and preceded by the zip64 locator.
+	const size_t tailSize = (size_t)std::min(zipSize, (s64)(20 + 22 + 65535));
+	std::vector<u8> tail(tailSize);
+	if (tailSize < 22 || backend_->ReadAt(zipSize - tailSize, tailSize, tail.data()) != tailSize) {
+		return false;
+	}
+	size_t eocd = tailSize - 22;
+	while (Read32(&tail[eocd]) != 0x06054b50) {
+		if (eocd-- == 0) {
+			return false;
+		}
+	}
+
+	u64 numEntries = Read16(&tail[eocd + 10]);
+	u64 cdSize = Read32(&tail[eocd + 12]);
+	u64 cdOffset = Read32(&tail[eocd + 16]);
+	if (numEntries == 0xFFFF || cdSize == 0xFFFFFFFF || cdOffset == 0xFFFFFFFF) {
+		if (eocd < 20 || Read32(&tail[eocd - 20]) != 0x07064b50) {
+			return false;
+		}
+		u8 record[56];
+		if (backend_->ReadAt(Read64(&tail[eocd - 20 + 8]), sizeof(record), record) != sizeof(record) || Read32(record) != 0x06064b50) {
+			return false;
+		}
+		numEntries = Read64(record + 32);
+		cdSize = Read64(record + 40);
+		cdOffset = Read64(record + 48);
+	}
+	if ((u64)fileIndex >= numEntries || cdOffset + cdSize > (u64)zipSize) {
+		return false;
+	}
+
+	std::vector<u8> cd((size_t)cdSize);
+	if (backend_->ReadAt(cdOffset, cd.size(), cd.data()) != cd.size()) {
+		return false;
+	}
+	size_t pos = 0;
+	for (int i = 0; ; ++i) {
+		if (pos + 46 > cd.size() || Read32(&cd[pos]) != 0x02014b50) {
+			return false;
+		}
+		const size_t headerSize = 46 + Read16(&cd[pos + 28]) + Read16(&cd[pos + 30]) + Read16(&cd[pos + 32]);
+		if (pos + headerSize > cd.size()) {
+			return false;
+		}
+		if (i == fileIndex) {
+			break;
+		}
+		pos += headerSize;
+	}
+
+	const u8 *entry = &cd[pos];
+	u64 compressedSize = Read32(entry + 20);
+	u64 size = Read32(entry + 24);
+	u64 localOffset = Read32(entry + 42);
+	// The zip64 extra field has the ones that didn't fit, in this order.
+	const u8 *extra = entry + 46 + Read16(entry + 28);
+	const u8 *extraEnd = extra + Read16(entry + 30);
+	while (extra + 4 <= extraEnd) {
+		const u8 *field = extra + 4;
+		const u8 *fieldEnd = std::min(field + Read16(extra + 2), extraEnd);
+		if (Read16(extra) == 0x0001) {
+			for (u64 *value : { &size, &compressedSize, &localOffset }) {
+				if (*value == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+					*value = Read64(field);
+					field += 8;
+				}
+			}
+		}
+		extra = fieldEnd;
+	}
+	// Also makes sure we found the same entry as libzip.
+	if (size != zstat.size || compressedSize != zstat.comp_size) {
+		return false;
+	}
+
+	u8 local[30];
+	if (backend_->ReadAt(localOffset, sizeof(local), local) != sizeof(local) || Read32(local) != 0x04034b50) {
+		return false;
+	}
+	dataOffset_ = (s64)localOffset + sizeof(local) + Read16(local + 26) + Read16(local + 28);
+	compressedSize_ = (s64)compressedSize;
+	return dataOffset_ + compressedSize_ <= zipSize;
 }
 
 size_t ZipFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags) {
-	if (!dataFile_ || absolutePos < 0 || absolutePos >= dataFileSize_) {
+	if (mode_ == Mode::NONE || absolutePos < 0 || absolutePos >= dataFileSize_) {
 		return 0;
 	}
 
 	if (absolutePos + (s64)bytes > dataFileSize_) {
-		// TODO: This could go negative..
-		bytes = dataFileSize_ - absolutePos;
+		bytes = (size_t)(dataFileSize_ - absolutePos);
 	}
 
-	// Decompress until the requested point, filling up data_ as we go. TODO: Do on thread.
-	while (dataReadPos_ < absolutePos + (s64)bytes) {
-		int remaining = BLOCK_SIZE;
-		if (dataReadPos_ + remaining > dataFileSize_) {
-			remaining = (int)(dataFileSize_ - dataReadPos_);
-		}
-		zip_int64_t retval = zip_fread(dataFile_, data_ + dataReadPos_, remaining);
-		_dbg_assert_(retval == remaining);
-		dataReadPos_ += retval;
+	switch (mode_) {
+	case Mode::STORED:
+		return backend_->ReadAt(dataOffset_ + absolutePos, bytes, data, flags);
+	case Mode::INDEXED:
+		return ReadIndexed(absolutePos, bytes, (u8 *)data);
+	default:
+		return ReadBuffered(absolutePos, bytes, (u8 *)data);
 	}
-
-	// Perform the read.
-	memcpy(data, data_ + absolutePos, bytes);
-	return bytes;
 }
 
 zip_int64_t ZipFileLoader::ZipSourceCallback(void *data, zip_uint64_t len, zip_source_cmd_t cmd) {
@@ -154,3 +310,409 @@ zip_int64_t ZipFileLoader::ZipSourceCallback(void *data, zip_uint64_t len, zip_s
 		return -1;
 	}
 }
+
+size_t ZipFileLoader::ReadBuffered(s64 absolutePos, size_t bytes, u8 *data) {
+	std::lock_guard<std::mutex> guard(lock_);
+	// Decompress until the requested point, filling up data_ as we go.
+	while (dataReadPos_ < absolutePos + (s64)bytes) {
+		int remaining = BLOCK_SIZE;
+		if (dataReadPos_ + remaining > dataFileSize_) {
+			remaining = (int)(dataFileSize_ - dataReadPos_);
+		}
+		zip_int64_t retval = zip_fread(dataFile_, data_ + dataReadPos_, remaining);
+		_dbg_assert_(retval == remaining);
+		if (retval <= 0) {
+			return 0;
+		}
+		dataReadPos_ += retval;
+	}
+
+	// Perform the read.
+	memcpy(data, data_ + absolutePos, bytes);
+	return bytes;
+}
+
+size_t ZipFileLoader::ReadIndexed(s64 absolutePos, size_t bytes, u8 *data) {
+	const bool sequential = lastReadEnd_.exchange(absolutePos + (s64)bytes) == absolutePos;
+	size_t done = 0;
+	while (done < bytes) {
+		size_t index;
+		s64 start, end;
+		{
+			std::unique_lock<std::mutex> guard(lock_);
+			// Past the end of the index, the builder is ahead of anything we could do ourselves.
+			indexProgress_.wait(guard, [&] {
+				return FindSpanLocked(absolutePos, &index, &start, &end) || indexComplete_ || indexFailed_ || stop_;
+			});
+			if (!FindSpanLocked(absolutePos, &index, &start, &end)) {
+				break;
+			}
+		}
+
+		SpanPtr span = GetSpan(index, start, end);
+		if (!span) {
+			break;
+		}
+		const size_t n = (size_t)std::min((s64)(bytes - done), end - absolutePos);
+		memcpy(data + done, span->data() + (absolutePos - start), n);
+		done += n;
+		absolutePos += n;
+		if (sequential && absolutePos - start >= (end - start) / 2) {
+			PrefetchSpan(index + 1);
+		}
+	}
+	return done;
+}
+
+// Lock must be held.
+bool ZipFileLoader::FindSpanLocked(s64 pos, size_t *index, s64 *start, s64 *end) const {
+	auto it = std::upper_bound(points_.begin(), points_.end(), pos, [](s64 pos, const SeekPoint &point) {
+		return pos < point.out;
+	});
+	if (it == points_.begin()) {
+		return false;
+	}
+	*index = it - points_.begin() - 1;
+	*start = points_[*index].out;
+	if (it != points_.end()) {
+		*end = it->out;
+		return true;
+	}
+	// The last span only ends once the whole stream has been walked.
+	*end = dataFileSize_;
+	return indexComplete_;
+}
+
+ZipFileLoader::SpanPtr ZipFileLoader::GetSpan(size_t index, s64 start, s64 end) {
+	{
+		std::unique_lock<std::mutex> guard(lock_);
+		// If it's being prefetched, that's further along than we'd be.
+		tasksDone_.wait(guard, [&] { return prefetchingSpan_ != index; });
+		SpanPtr span = FindCachedSpanLocked(index);
+		if (span) {
+			return span;
+		}
+	}
+
+	SpanPtr span = DecompressSpan(index, start, end);
+	if (span) {
+		std::lock_guard<std::mutex> guard(lock_);
+		CacheSpanLocked(index, span);
+	}
+	return span;
+}
+
+ZipFileLoader::SpanPtr ZipFileLoader::DecompressSpan(size_t index, s64 start, s64 end) {
+	SeekPoint point;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		point = points_[index];
+	}
+
+	auto span = std::make_shared<std::vector<u8>>();
+	if (!InflateSpan(point, end - start, span.get())) {
+		ERROR_LOG(Log::IO, "Failed to inflate zip data at %lld", (long long)start);
+		return nullptr;
+	}
+	return span;
+}
+
+bool ZipFileLoader::InflateSpan(const SeekPoint &point, s64 size, std::vector<u8> *out) {
+	z_stream strm{};
+	if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+		return false;
+	}
+
+	bool success = true;
+	if (point.bits != 0) {
+		u8 partial;
+		success = backend_->ReadAt(dataOffset_ + point.in - 1, 1, &partial) == 1;
+		inflatePrime(&strm, point.bits, partial >> (8 - point.bits));
+	}
+	if (!point.window.empty()) {
+		inflateSetDictionary(&strm, point.window.data(), (uInt)point.window.size());
+	}
+
+	std::vector<u8> input(INFLATE_CHUNK);
+	s64 readPos = point.in;
+	out->resize((size_t)size);
+	strm.next_out = out->data();
+	strm.avail_out = (uInt)size;
+	while (success && strm.avail_out != 0) {
+		if (strm.avail_in == 0 && readPos < compressedSize_) {
+			const size_t chunk = (size_t)std::min((s64)INFLATE_CHUNK, compressedSize_ - readPos);
+			if (backend_->ReadAt(dataOffset_ + readPos, chunk, input.data()) != chunk) {
+				success = false;
+				break;
+			}
+			readPos += chunk;
+			strm.next_in = input.data();
+			strm.avail_in = (uInt)chunk;
+		}
+		// Once all the input is in, a Z_BUF_ERROR means it was cut short.
+		int ret = inflate(&strm, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END) {
+			break;
+		}
+		success = ret == Z_OK || (ret == Z_BUF_ERROR && strm.avail_in == 0 && readPos < compressedSize_);
+	}
+	success = success && strm.avail_out == 0;
+	inflateEnd(&strm);
+	return success;
+}
+
+// Lock must be held.
+ZipFileLoader::SpanPtr ZipFileLoader::FindCachedSpanLocked(size_t index) {
+	for (CachedSpan &cached : spanCache_) {
+		if (cached.index == index) {
+			cached.lastUse = ++spanUseCounter_;
+			return cached.data;
+		}
+	}
+	return nullptr;
+}
+
+// Lock must be held.
+void ZipFileLoader::CacheSpanLocked(size_t index, const SpanPtr &data) {
+	if (FindCachedSpanLocked(index)) {
+		return;
+	}
+	if (spanCache_.size() < MAX_CACHED_SPANS) {
+		spanCache_.push_back(CachedSpan{ index, data, ++spanUseCounter_ });
+		return;
+	}
+	auto oldest = std::min_element(spanCache_.begin(), spanCache_.end(), [](const CachedSpan &a, const CachedSpan &b) {
+		return a.lastUse < b.lastUse;
+	});
+	*oldest = CachedSpan{ index, data, ++spanUseCounter_ };
+}
+
+// When the game reads sequentially, inflate the next span on another core while it uses this one.
+void ZipFileLoader::PrefetchSpan(size_t index) {
+	if (!g_threadManager.IsInitialized()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	if (stop_ || index >= points_.size() || prefetchingSpan_ == index) {
+		return;
+	}
+	for (const CachedSpan &cached : spanCache_) {
+		if (cached.index == index) {
+			return;
+		}
+	}
+	const s64 start = points_[index].out;
+	s64 end;
+	if (index + 1 < points_.size()) {
+		end = points_[index + 1].out;
+	} else if (indexComplete_) {
+		end = dataFileSize_;
+	} else {
+		return;
+	}
+
+	prefetchingSpan_ = index;
+	pendingTasks_++;
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [this, index, start, end]() {
+		SpanPtr span = DecompressSpan(index, start, end);
+		std::lock_guard<std::mutex> guard(lock_);
+		if (span) {
+			CacheSpanLocked(index, span);
+		}
+		prefetchingSpan_ = (size_t)-1;
+		pendingTasks_--;
+		tasksDone_.notify_all();
+	}));
+}
+
+void ZipFileLoader::StartIndex() {
+	indexPath_ = DiskCachingFileLoaderCache::MakeCacheFilePath(GetPath(), INDEX_EXTENSION);
+	if (LoadIndex()) {
+		return;
+	}
+
+	points_.push_back(SeekPoint{ 0, 0, 0 });
+	indexThread_ = std::thread([this] {
+		SetCurrentThreadName("ZipIndex");
+		AndroidJNIThreadContext jniContext;
+		BuildIndex();
+	});
+}
+
+// Walks the whole stream once, adding a seek point at the first block boundary after every SPAN_SIZE
+// bytes of output. Reads only wait for this when they're past the last point so far.
+void ZipFileLoader::BuildIndex() {
+	const double startTime = time_now_d();
+	z_stream strm{};
+	if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+		std::lock_guard<std::mutex> guard(lock_);
+		indexFailed_ = true;
+		indexProgress_.notify_all();
+		return;
+	}
+
+	std::vector<u8> input(INFLATE_CHUNK);
+	s64 readPos = 0;
+	auto span = std::make_shared<std::vector<u8>>(SPAN_SIZE + INFLATE_CHUNK);
+	s64 spanStart = 0;
+	size_t spanUsed = 0;
+	int ret = Z_OK;
+	while (ret != Z_STREAM_END && !stop_) {
+		if (strm.avail_in == 0 && readPos < compressedSize_) {
+			const size_t chunk = (size_t)std::min((s64)INFLATE_CHUNK, compressedSize_ - readPos);
+			if (backend_->ReadAt(dataOffset_ + readPos, chunk, input.data()) != chunk) {
+				ret = Z_ERRNO;
+				break;
+			}
+			readPos += chunk;
+			strm.next_in = input.data();
+			strm.avail_in = (uInt)chunk;
+		}
+		if (spanUsed == span->size()) {
+			span->resize(span->size() + INFLATE_CHUNK);
+		}
+		strm.next_out = span->data() + spanUsed;
+		strm.avail_out = (uInt)(span->size() - spanUsed);
+		const uInt availOut = strm.avail_out;
+
+		// Z_BLOCK stops at the end of each deflate block, which is where we can resume later.
+		ret = inflate(&strm, Z_BLOCK);
+		if (ret != Z_OK && ret != Z_STREAM_END && (ret != Z_BUF_ERROR || readPos == compressedSize_)) {
+			break;
+		}
+		spanUsed += availOut - strm.avail_out;
+
+		const bool blockBoundary = (strm.data_type & 128) != 0 && (strm.data_type & 64) == 0;
+		if (ret != Z_STREAM_END && blockBoundary && spanUsed >= SPAN_SIZE) {
+			SeekPoint point{ readPos - strm.avail_in, spanStart + (s64)spanUsed, strm.data_type & 7 };
+			point.window.assign(span->data() + spanUsed - WINDOW_SIZE, span->data() + spanUsed);
+			span->resize(spanUsed);
+
+			std::lock_guard<std::mutex> guard(lock_);
+			points_.push_back(std::move(point));
+			// We have it anyway, and early reads are likely to be near the start.
+			if (spanCache_.size() < MAX_CACHED_SPANS) {
+				CacheSpanLocked(points_.size() - 2, span);
+			}
+			indexProgress_.notify_all();
+
+			span = std::make_shared<std::vector<u8>>(SPAN_SIZE + INFLATE_CHUNK);
+			spanStart = points_.back().out;
+			spanUsed = 0;
+		}
+	}
+	inflateEnd(&strm);
+
+	std::unique_lock<std::mutex> guard(lock_);
+	if (ret == Z_STREAM_END && spanStart + (s64)spanUsed == dataFileSize_) {
+		span->resize(spanUsed);
+		if (spanCache_.size() < MAX_CACHED_SPANS) {
+			CacheSpanLocked(points_.size() - 1, span);
+		}
+		indexComplete_ = true;
+		indexProgress_.notify_all();
+		guard.unlock();
+
+		INFO_LOG(Log::IO, "Indexed zip entry of '%s' in %0.2f seconds, %d seek points", GetPath().ToVisualString().c_str(), time_now_d() - startTime, (int)points_.size());
+		// Nothing changes points_ anymore.
+		SaveIndex();
+	} else if (!stop_) {
+		ERROR_LOG(Log::IO, "Failed to index zip entry of '%s' (%d), reads past %lld will fail", GetPath().ToVisualString().c_str(), ret, (long long)spanStart);
+		indexFailed_ = true;
+		indexProgress_.notify_all();
+	}
+}
+
+bool ZipFileLoader::LoadIndex() {
+	std::string data;
+	if (!File::Exists(indexPath_) || !File::ReadBinaryFileToString(indexPath_, &data)) {
+		return false;
+	}
+
+	IndexFileHeader header;
+	if (data.size() < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 || header.version != INDEX_VERSION) {
+		WARN_LOG(Log::IO, "Ignoring zip index '%s' with the wrong magic or version", indexPath_.ToVisualString().c_str());
+		return false;
+	}
+	if (header.zipSize != (u64)backend_->FileSize() || header.dataOffset != (u64)dataOffset_ || header.compressedSize != (u64)compressedSize_ ||
+		header.uncompressedSize != (u64)dataFileSize_ || header.crc != crc_ || header.numPoints == 0) {
+		// Most likely the zip was replaced, it'll be indexed again.
+		WARN_LOG(Log::IO, "Ignoring mismatching zip index '%s'", indexPath_.ToVisualString().c_str());
+		return false;
+	}
+
+	std::vector<SeekPoint> points;
+	size_t pos = sizeof(header);
+	for (u32 i = 0; i < header.numPoints; ++i) {
+		IndexFilePoint filePoint;
+		if (pos + sizeof(filePoint) > data.size()) {
+			return false;
+		}
+		memcpy(&filePoint, data.data() + pos, sizeof(filePoint));
+		pos += sizeof(filePoint);
+
+		SeekPoint point{ (s64)filePoint.in, (s64)filePoint.out, (int)filePoint.bits };
+		if (point.bits > 7 || point.in > compressedSize_ || point.out >= std::max(dataFileSize_, (s64)1) || (!points.empty() && point.out <= points.back().out)) {
+			return false;
+		}
+		if (filePoint.windowSize != 0) {
+			if (pos + filePoint.windowSize > data.size()) {
+				return false;
+			}
+			point.window.resize(WINDOW_SIZE);
+			uLongf windowSize = WINDOW_SIZE;
+			if (uncompress(point.window.data(), &windowSize, (const Bytef *)data.data() + pos, filePoint.windowSize) != Z_OK || windowSize != WINDOW_SIZE) {
+				return false;
+			}
+			pos += filePoint.windowSize;
+		}
+		points.push_back(std::move(point));
+	}
+
+	points_ = std::move(points);
+	indexComplete_ = true;
+	INFO_LOG(Log::IO, "Loaded zip index '%s', %d seek points", indexPath_.ToVisualString().c_str(), (int)points_.size());
+	return true;
+}
+
+void ZipFileLoader::SaveIndex() {
+	IndexFileHeader header{};
+	memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+	header.version = INDEX_VERSION;
+	header.zipSize = backend_->FileSize();
+	header.dataOffset = dataOffset_;
+	header.compressedSize = compressedSize_;
+	header.uncompressedSize = dataFileSize_;
+	header.crc = crc_;
+	header.numPoints = (u32)points_.size();
+
+	std::string data;
+	data.append((const char *)&header, sizeof(header));
+	std::vector<u8> window(compressBound(WINDOW_SIZE));
+	for (const SeekPoint &point : points_) {
+		uLongf windowSize = 0;
+		if (!point.window.empty()) {
+			windowSize = (uLongf)window.size();
+			if (compress2(window.data(), &windowSize, point.window.data(), (uLong)point.window.size(), Z_BEST_SPEED) != Z_OK) {
+				return;
+			}
+		}
+
+		IndexFilePoint filePoint{};
+		filePoint.in = point.in;
+		filePoint.out = point.out;
+		filePoint.bits = point.bits;
+		filePoint.windowSize = (u32)windowSize;
+		data.append((const char *)&filePoint, sizeof(filePoint));
+		data.append((const char *)window.data(), windowSize);
+	}
+
+	if (!File::WriteDataToFile(false, data.data(), data.size(), indexPath_)) {
+		WARN_LOG(Log::IO, "Failed to write zip index '%s'", indexPath_.ToVisualString().c_str());
+	}
+}
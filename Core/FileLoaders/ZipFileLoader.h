@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #ifdef SHARED_LIBZIP
 #include <zip.h>
@@ -16,6 +21,12 @@
 
 // Exposes a single (chosen) file from a zip file as another file loader.
 // Useful in a bunch of possible chains.
+//
+// Stored entries are read straight from the zip. For deflated entries, a background thread walks
+// the stream once and records seek points (zran style: the bit position and the last 32 KB of
+// output at a block boundary) every few MB, so random reads only inflate from the nearest one.
+// The index is saved next to the disk cache files, so later boots skip the walk. Recently used
+// spans are kept decompressed. Other compression methods fall back to decompressing from the start.
 class ZipFileLoader : public ProxiedFileLoader {
 public:
 	ZipFileLoader(FileLoader *sourceLoader);
@@ -28,7 +39,7 @@ class ZipFileLoader : public ProxiedFileLoader {
 	bool Initialize(int fileIndex);
 
 	bool Exists() override {
-		return dataFile_ != nullptr;
+		return mode_ != Mode::NONE;
 	}
 
 	bool IsDirectory() override {
@@ -53,17 +64,86 @@ class ZipFileLoader : public ProxiedFileLoader {
 	}
 
 private:
+	enum class Mode {
+		NONE,
+		// Decompressed by libzip from the start into data_.
+		BUFFERED,
+		STORED,
+		INDEXED,
+	};
+
+	struct SeekPoint {
+		// Offset in the compressed data of the first full byte after the block boundary.
+		s64 in;
+		s64 out;
+		// Bits of the previous byte that belong to the next block.
+		int bits;
+		// Last 32 KB of output before out, empty for the start of the stream.
+		std::vector<u8> window;
+	};
+	typedef std::shared_ptr<const std::vector<u8>> SpanPtr;
+	struct CachedSpan {
+		size_t index;
+		SpanPtr data;
+		u64 lastUse;
+	};
+
 	zip_int64_t ZipSourceCallback(void* data, zip_uint64_t len, zip_source_cmd_t cmd);
+	bool FindEntryData(int fileIndex, const zip_stat_t &zstat);
+
+	size_t ReadBuffered(s64 absolutePos, size_t bytes, u8 *data);
+	size_t ReadIndexed(s64 absolutePos, size_t bytes, u8 *data);
+
+	void StartIndex();
+	void BuildIndex();
+	bool LoadIndex();
+	void SaveIndex();
+	bool FindSpanLocked(s64 pos, size_t *index, s64 *start, s64 *end) const;
+	SpanPtr GetSpan(size_t index, s64 start, s64 end);
+	SpanPtr DecompressSpan(size_t index, s64 start, s64 end);
+	bool InflateSpan(const SeekPoint &point, s64 size, std::vector<u8> *out);
+	SpanPtr FindCachedSpanLocked(size_t index);
+	void CacheSpanLocked(size_t index, const SpanPtr &data);
+	void PrefetchSpan(size_t index);
 
 	enum {
 		BLOCK_SIZE = 65536,
+		INDEX_VERSION = 1,
+		// Output between seek points. A random read inflates half of this on average.
+		SPAN_SIZE = 4 * 1024 * 1024,
+		WINDOW_SIZE = 32768,
+		INFLATE_CHUNK = 256 * 1024,
+		MAX_CACHED_SPANS = 8,
 	};
 	zip_t *zipArchive_ = nullptr;
 	s64 zipReadPos_ = 0;
 
+	Mode mode_ = Mode::NONE;
+	std::mutex lock_;
 	zip_file_t *dataFile_ = nullptr;
 	uint8_t *data_ = nullptr;  // malloc/free
 	s64 dataReadPos_ = 0;
 	s64 dataFileSize_ = 0;
 	std::string fileExtension_;
+
+	// Where the entry's data starts in the zip, for STORED and INDEXED.
+	s64 dataOffset_ = 0;
+	s64 compressedSize_ = 0;
+	u32 crc_ = 0;
+
+	// The rest is for INDEXED, guarded by lock_.
+	Path indexPath_;
+	std::vector<SeekPoint> points_;
+	bool indexComplete_ = false;
+	bool indexFailed_ = false;
+	std::condition_variable indexProgress_;
+	std::atomic<bool> stop_{};
+	std::thread indexThread_;
+
+	std::vector<CachedSpan> spanCache_;
+	u64 spanUseCounter_ = 0;
+	std::atomic<s64> lastReadEnd_{};
+	size_t prefetchingSpan_ = (size_t)-1;
+	std::condition_variable tasksDone_;
+	int pendingTasks_ = 0;
 };
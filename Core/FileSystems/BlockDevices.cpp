@@ -25,6 +25,10 @@
 #include "Common/File/FileUtil.h"
 #include "Common/File/DirListing.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/Config.h"
 #include "Core/Loaders.h"
 #include "Core/FileSystems/BlockDevices.h"
 #include "libchdr/chd.h"
@@ -32,6 +36,7 @@
 extern "C"
 {
 #include "zlib.h"
+#include "zstd.h"
 #include "ext/libkirk/amctrl.h"
 #include "ext/libkirk/kirk_engine.h"
 };
@@ -68,6 +73,8 @@ BlockDevice *ConstructBlockDevice(FileLoader *fileLoader, std::string *errorStri
 			device = new NPDRMDemoBlockDevice(fileLoader);
 	} else if (!memcmp(buffer, "MComprHD", 8)) {
 		device = new CHDFileBlockDevice(fileLoader);
+	} else if (!memcmp(buffer, "PSZI", 4)) {
+		device = new ZstdFileBlockDevice(fileLoader);
 	}
 
 	// No check above passed, should be just a regular ISO file. Let's open it as a plain block device and let the other systems take over.
@@ -118,6 +125,23 @@ bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	return true;
 }
 
+const u8 *FileBlockDevice::GetBlockPointer(u32 minBlock, u32 count) {
+	return fileLoader_->MappedPointer((s64)minBlock * GetBlockSize(), (s64)count * GetBlockSize());
+}
+
+void FileBlockDevice::Advise(u32 minBlock, u32 count, MappedFileAdvice advice) {
+	fileLoader_->Advise((s64)minBlock * GetBlockSize(), (s64)count * GetBlockSize(), advice);
+}
+
+bool FileBlockDevice::GetFileRange(u32 minBlock, u32 count, s64 *offset, s64 *size) const {
+	if (minBlock >= GetNumBlocks()) {
+		return false;
+	}
+	*offset = (s64)minBlock * GetBlockSize();
+	*size = (s64)std::min(count, GetNumBlocks() - minBlock) * GetBlockSize();
+	return true;
+}
+
 // .CSO format
 
 // compressed ISO(9660) header format
@@ -147,6 +171,10 @@ typedef struct ciso_header
 // TODO: Need much better error handling.
 
 static const u32 CSO_READ_BUFFER_SIZE = 256 * 1024;
+// Parallel mode only. The cache covers a bit more than typical streaming reads, so that nearby
+// seeks (like between adjacent files) don't decompress again.
+static const u32 CSO_FRAME_CACHE_SIZE = 4 * 1024 * 1024;
+static const u32 CSO_PREFETCH_SIZE = 256 * 1024;
 
 CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	: BlockDevice(fileLoader)
@@ -227,12 +255,24 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 		return;
 	}
 
+	parallel_ = g_Config.bParallelCSODecompression;
+	maxCachedFrames_ = std::max(CSO_FRAME_CACHE_SIZE / frameSize, 8U);
+
 	// all ok.
 	_dbg_assert_(errorString_.empty());
 }
 
 CISOFileBlockDevice::~CISOFileBlockDevice()
 {
+	{
+		// Background decompression references this.
+		std::unique_lock<std::mutex> guard(frameCacheLock_);
+		frameReady_.wait(guard, [&] { return pendingTasks_ == 0; });
+	}
+	if (cacheHits_ + cacheMisses_ > 0) {
+		INFO_LOG(Log::Loader, "CSO frame cache: %d hits, %d misses", cacheHits_, cacheMisses_);
+	}
+
 	delete [] index;
 	delete [] readBuffer;
 	delete [] zlibBuffer;
@@ -269,6 +309,8 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 	} else if (zlibBufferFrame == frameNumber) {
 		// We already have it.  Just apply the offset and copy.
 		memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
+	} else if (parallel_ && CopyFromFrameCache(frameNumber, compressedOffset, GetBlockSize(), outPtr)) {
+		// Decompressed earlier, or in the background.
 	} else {
 		const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer, flags);
 
@@ -306,6 +348,13 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 			zlibBufferFrame = frameNumber;
 			memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
 		}
+		if (parallel_) {
+			AddToFrameCache(frameNumber, frameSize == (u32)GetBlockSize() ? outPtr : zlibBuffer);
+		}
+	}
+
+	if (parallel_) {
+		NotifySequentialRead(blockNumber, blockNumber);
 	}
 	return true;
 }
@@ -314,6 +363,9 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	if (count == 1) {
 		return ReadBlock(minBlock, outPtr);
 	}
+	if (parallel_) {
+		return ReadBlocksParallel(minBlock, count, outPtr);
+	}
 	if (minBlock >= numBlocks) {
 		memset(outPtr, 0, GetBlockSize() * count);
 		return false;
@@ -400,6 +452,440 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	return true;
 }
 
+bool CISOFileBlockDevice::GetFileRange(u32 minBlock, u32 count, s64 *offset, s64 *size) const {
+	if (minBlock >= numBlocks || count == 0) {
+		return false;
+	}
+	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
+	*offset = (s64)FramePos(minBlock >> blockShift);
+	*size = (s64)FramePos((lastBlock >> blockShift) + 1) - *offset;
+	return true;
+}
+
+bool CISOFileBlockDevice::IsPlainFrame(u32 frame) const {
+	if (ver_ >= 2) {
+		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
+		return FramePos(frame + 1) - FramePos(frame) >= frameSize;
+	}
+	return (index[frame] & 0x80000000) != 0;
+}
+
+bool CISOFileBlockDevice::InflateFrame(const u8 *src, u32 srcSize, u8 *dest) const {
+	z_stream z{};
+	if (inflateInit2(&z, -15) != Z_OK) {
+		return false;
+	}
+	z.next_in = (Bytef *)src;
+	z.avail_in = srcSize;
+	z.next_out = dest;
+	z.avail_out = frameSize;
+	int status = inflate(&z, Z_FINISH);
+	bool success = status == Z_STREAM_END && z.total_out == frameSize;
+	inflateEnd(&z);
+	return success;
+}
+
+bool CISOFileBlockDevice::ReadBlocksParallel(u32 minBlock, int count, u8 *outPtr) {
+	const u32 blockSize = GetBlockSize();
+	if (minBlock >= numBlocks) {
+		memset(outPtr, 0, blockSize * count);
+		return false;
+	}
+
+	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
+	const u32 validBlocks = lastBlock + 1 - minBlock;
+	if (validBlocks < (u32)count) {
+		memset(outPtr + validBlocks * blockSize, 0, (count - validBlocks) * blockSize);
+	}
+
+	struct FrameRead {
+		u32 frame;
+		u32 offset;
+		u32 size;
+		u8 *dest;
+		bool plain;
+		bool success;
+	};
+	std::vector<FrameRead> reads;
+
+	const u32 blocksPerFrame = 1 << blockShift;
+	u32 block = minBlock;
+	u8 *dest = outPtr;
+	while (block <= lastBlock) {
+		const u32 frame = block >> blockShift;
+		const u32 frameBlockOffset = block & (blocksPerFrame - 1);
+		const u32 frameBlocks = std::min(lastBlock - block + 1, blocksPerFrame - frameBlockOffset);
+		const u32 offset = frameBlockOffset * blockSize;
+		const u32 size = frameBlocks * blockSize;
+		const bool plain = IsPlainFrame(frame);
+		if (plain || !CopyFromFrameCache(frame, offset, size, dest)) {
+			reads.push_back(FrameRead{ frame, offset, size, dest, plain, false });
+		}
+		block += frameBlocks;
+		dest += size;
+	}
+
+	if (!reads.empty()) {
+		// A single read for everything, even if it includes a few cached frames.
+		const u64 rawStart = FramePos(reads.front().frame);
+		std::vector<u8> raw((size_t)(FramePos(reads.back().frame + 1) - rawStart));
+		const size_t readSize = fileLoader_->ReadAt(rawStart, 1, raw.size(), raw.data());
+		if (readSize < raw.size()) {
+			memset(raw.data() + readSize, 0, raw.size() - readSize);
+		}
+
+		auto process = [&](int lower, int upper) {
+			std::vector<u8> frameBuffer;
+			for (int i = lower; i < upper; i++) {
+				FrameRead &r = reads[i];
+				const u8 *src = raw.data() + (FramePos(r.frame) - rawStart);
+				const u32 srcSize = (u32)(FramePos(r.frame + 1) - FramePos(r.frame));
+				if (r.plain) {
+					memcpy(r.dest, src + r.offset, r.size);
+					r.success = true;
+				} else if (r.size == frameSize) {
+					r.success = InflateFrame(src, srcSize, r.dest);
+					if (r.success) {
+						AddToFrameCache(r.frame, r.dest);
+					}
+				} else {
+					frameBuffer.resize(frameSize);
+					r.success = InflateFrame(src, srcSize, frameBuffer.data());
+					if (r.success) {
+						memcpy(r.dest, frameBuffer.data() + r.offset, r.size);
+						AddToFrameCache(r.frame, frameBuffer.data());
+					}
+				}
+			}
+		};
+
+		// Small frames aren't worth a task each.
+		const int minFramesPerTask = std::max(1, (int)(64 * 1024 / frameSize));
+		if ((int)reads.size() > minFramesPerTask) {
+			ParallelRangeLoop(&g_threadManager, process, 0, (int)reads.size(), minFramesPerTask);
+		} else {
+			process(0, (int)reads.size());
+		}
+
+		for (const FrameRead &r : reads) {
+			if (!r.success) {
+				ERROR_LOG(Log::Loader, "Inflate frame %d failed", r.frame);
+				NotifyReadError();
+				memset(r.dest, 0, r.size);
+			}
+		}
+	}
+
+	NotifySequentialRead(minBlock, lastBlock);
+	return true;
+}
+
+bool CISOFileBlockDevice::CopyFromFrameCache(u32 frame, u32 offset, u32 size, u8 *dest) {
+	std::unique_lock<std::mutex> guard(frameCacheLock_);
+	// If it's being decompressed in the background, it'll be quicker to wait for that.
+	frameReady_.wait(guard, [&] { return pendingFrames_.find(frame) == pendingFrames_.end(); });
+
+	auto it = frameCache_.find(frame);
+	if (it == frameCache_.end()) {
+		cacheMisses_++;
+		return false;
+	}
+	frameLRU_.splice(frameLRU_.begin(), frameLRU_, it->second.lruPos);
+	memcpy(dest, it->second.data.data() + offset, size);
+	cacheHits_++;
+	return true;
+}
+
+void CISOFileBlockDevice::AddToFrameCache(u32 frame, const u8 *data) {
+	std::lock_guard<std::mutex> guard(frameCacheLock_);
+	auto it = frameCache_.find(frame);
+	if (it != frameCache_.end()) {
+		frameLRU_.splice(frameLRU_.begin(), frameLRU_, it->second.lruPos);
+		return;
+	}
+
+	std::vector<u8> buffer;
+	if (frameCache_.size() >= maxCachedFrames_) {
+		// Recycle the least recently used frame's buffer.
+		auto oldest = frameCache_.find(frameLRU_.back());
+		buffer = std::move(oldest->second.data);
+		frameCache_.erase(oldest);
+		frameLRU_.pop_back();
+	}
+	buffer.assign(data, data + frameSize);
+	frameLRU_.push_front(frame);
+	frameCache_[frame] = CachedFrame{ std::move(buffer), frameLRU_.begin() };
+}
+
+void CISOFileBlockDevice::NotifySequentialRead(u32 minBlock, u32 lastBlock) {
+	const bool sequential = minBlock == nextSequentialBlock_;
+	nextSequentialBlock_ = lastBlock + 1;
+	if (!sequential) {
+		return;
+	}
+
+	const u32 firstFrame = (lastBlock >> blockShift) + 1;
+	const u32 prefetchFrames = std::max(CSO_PREFETCH_SIZE / frameSize, 1U);
+	// Top it up once the reader is half way through what we already queued.
+	if (prefetchEnd_ > firstFrame && prefetchEnd_ - firstFrame > prefetchFrames / 2) {
+		return;
+	}
+	const u32 endFrame = std::min(firstFrame + prefetchFrames, numFrames);
+	PrefetchFrames(std::max(firstFrame, prefetchEnd_ > firstFrame ? prefetchEnd_ : 0), endFrame);
+	prefetchEnd_ = endFrame;
+}
+
+void CISOFileBlockDevice::PrefetchFrames(u32 firstFrame, u32 endFrame) {
+	std::vector<u32> frames;
+	{
+		std::lock_guard<std::mutex> guard(frameCacheLock_);
+		for (u32 frame = firstFrame; frame < endFrame; ++frame) {
+			if (!IsPlainFrame(frame) && frameCache_.find(frame) == frameCache_.end() && pendingFrames_.find(frame) == pendingFrames_.end()) {
+				frames.push_back(frame);
+				pendingFrames_.insert(frame);
+			}
+		}
+		if (frames.empty()) {
+			return;
+		}
+		pendingTasks_++;
+	}
+
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [this, frames = std::move(frames)]() {
+		const u64 rawStart = FramePos(frames.front());
+		std::vector<u8> raw((size_t)(FramePos(frames.back() + 1) - rawStart));
+		const size_t readSize = fileLoader_->ReadAt(rawStart, 1, raw.size(), raw.data());
+
+		std::vector<u8> frameBuffer(frameSize);
+		for (u32 frame : frames) {
+			const u64 pos = FramePos(frame) - rawStart;
+			const u32 srcSize = (u32)(FramePos(frame + 1) - FramePos(frame));
+			// Failures are left for the actual read to report.
+			if (pos + srcSize <= readSize && InflateFrame(raw.data() + pos, srcSize, frameBuffer.data())) {
+				AddToFrameCache(frame, frameBuffer.data());
+			}
+			std::lock_guard<std::mutex> guard(frameCacheLock_);
+			pendingFrames_.erase(frame);
+			frameReady_.notify_all();
+		}
+
+		std::lock_guard<std::mutex> guard(frameCacheLock_);
+		pendingTasks_--;
+		frameReady_.notify_all();
+	}));
+}
+
+// .PSZ format (seekable zstd), see PSZHeader.
+
+// Sanity limit, the converter defaults to much smaller frames.
+static const u32 PSZ_MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+ZstdFileBlockDevice::ZstdFileBlockDevice(FileLoader *fileLoader)
+	: BlockDevice(fileLoader) {
+	PSZHeader header;
+	if (fileLoader_->ReadAt(0, sizeof(header), 1, &header) != 1 || memcmp(header.magic, "PSZI", 4) != 0) {
+		errorString_ = "Invalid PSZ!";
+		return;
+	}
+	if (header.version != PSZ_VERSION) {
+		errorString_ = StringFromFormat("PSZ version %d unsupported", (int)header.version);
+		return;
+	}
+	frameSize_ = header.frameSize;
+	if (frameSize_ == 0 || frameSize_ > PSZ_MAX_FRAME_SIZE || (frameSize_ % GetBlockSize()) != 0) {
+		errorString_ = StringFromFormat("PSZ frame size %d unsupported, must be a multiple of the sector size", frameSize_);
+		return;
+	}
+
+	totalBytes_ = header.totalBytes;
+	numFrames_ = header.numFrames;
+	if (numFrames_ != (totalBytes_ + frameSize_ - 1) / frameSize_) {
+		errorString_ = StringFromFormat("PSZ has %d frames, expected %lld", numFrames_, (long long)((totalBytes_ + frameSize_ - 1) / frameSize_));
+		return;
+	}
+
+	std::vector<u64_le> rawIndex(numFrames_ + 1);
+	const u64 indexPos = sizeof(header);
+	if (fileLoader_->ReadAt(indexPos, sizeof(u64_le), rawIndex.size(), rawIndex.data()) != rawIndex.size()) {
+		errorString_ = "Failed to read PSZ index";
+		return;
+	}
+	index_.assign(rawIndex.begin(), rawIndex.end());
+
+	const u64 dictPos = indexPos + index_.size() * sizeof(u64_le);
+	const u64 fileSize = fileLoader_->FileSize();
+	for (u32 i = 0; i < numFrames_; ++i) {
+		if (index_[i] > index_[i + 1] || index_[i] < dictPos + header.dictSize) {
+			errorString_ = StringFromFormat("Corrupt PSZ index at frame %d", i);
+			return;
+		}
+	}
+	if (index_[numFrames_] > fileSize) {
+		errorString_ = StringFromFormat("Expected PSZ to at least be %lld bytes, but file is %lld bytes", (long long)index_[numFrames_], (long long)fileSize);
+		return;
+	}
+
+	if (header.dictSize != 0) {
+		std::vector<u8> dict(header.dictSize);
+		if (fileLoader_->ReadAt(dictPos, 1, dict.size(), dict.data()) != dict.size()) {
+			errorString_ = "Failed to read PSZ dictionary";
+			return;
+		}
+		ddict_ = ZSTD_createDDict(dict.data(), dict.size());
+		if (!ddict_) {
+			errorString_ = "Invalid PSZ dictionary";
+			return;
+		}
+	}
+
+	dctx_ = ZSTD_createDCtx();
+	frameBuffer_.resize(frameSize_);
+	blocksPerFrame_ = frameSize_ / GetBlockSize();
+	numBlocks_ = (u32)(totalBytes_ / GetBlockSize());
+
+	// all ok.
+	_dbg_assert_(errorString_.empty());
+}
+
+ZstdFileBlockDevice::~ZstdFileBlockDevice() {
+	ZSTD_freeDCtx(dctx_);
+	ZSTD_freeDDict(ddict_);
+}
+
+bool ZstdFileBlockDevice::GetFileRange(u32 minBlock, u32 count, s64 *offset, s64 *size) const {
+	if (minBlock >= numBlocks_ || count == 0) {
+		return false;
+	}
+	const u32 lastBlock = std::min(minBlock + count, numBlocks_) - 1;
+	*offset = (s64)index_[minBlock / blocksPerFrame_];
+	*size = (s64)index_[lastBlock / blocksPerFrame_ + 1] - *offset;
+	return true;
+}
+
+u32 ZstdFileBlockDevice::FrameBytes(u32 frame) const {
+	// Only the last frame can be short.
+	return (u32)std::min((u64)frameSize_, totalBytes_ - (u64)frame * frameSize_);
+}
+
+bool ZstdFileBlockDevice::DecompressFrame(u32 frame, const u8 *src, u8 *dest) {
+	const size_t srcSize = (size_t)(index_[frame + 1] - index_[frame]);
+	const u32 frameBytes = FrameBytes(frame);
+	if (srcSize == frameBytes) {
+		memcpy(dest, src, frameBytes);
+		return true;
+	}
+
+	size_t result;
+	if (ddict_) {
+		result = ZSTD_decompress_usingDDict(dctx_, dest, frameBytes, src, srcSize, ddict_);
+	} else {
+		result = ZSTD_decompressDCtx(dctx_, dest, frameBytes, src, srcSize);
+	}
+	if (ZSTD_isError(result) || result != frameBytes) {
+		ERROR_LOG(Log::Loader, "PSZ frame %d: %s", frame, ZSTD_isError(result) ? ZSTD_getErrorName(result) : "size mismatch");
+		return false;
+	}
+	return true;
+}
+
+bool ZstdFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
+	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
+	if ((u32)blockNumber >= numBlocks_) {
+		memset(outPtr, 0, GetBlockSize());
+		return false;
+	}
+
+	const u32 frame = blockNumber / blocksPerFrame_;
+	const u32 offset = (blockNumber % blocksPerFrame_) * GetBlockSize();
+	if (frame != frameBufferFrame_) {
+		const size_t srcSize = (size_t)(index_[frame + 1] - index_[frame]);
+		if (srcSize == FrameBytes(frame)) {
+			// Stored, no need to read the whole frame.
+			size_t readSize = fileLoader_->ReadAt(index_[frame] + offset, 1, GetBlockSize(), outPtr, flags);
+			if (readSize < (size_t)GetBlockSize()) {
+				memset(outPtr + readSize, 0, GetBlockSize() - readSize);
+			}
+			return true;
+		}
+
+		if (readBuffer_.size() < srcSize) {
+			readBuffer_.resize(srcSize);
+		}
+		frameBufferFrame_ = 0xFFFFFFFF;
+		if (fileLoader_->ReadAt(index_[frame], 1, srcSize, readBuffer_.data(), flags) != srcSize || !DecompressFrame(frame, readBuffer_.data(), frameBuffer_.data())) {
+			NotifyReadError();
+			memset(outPtr, 0, GetBlockSize());
+			return false;
+		}
+		frameBufferFrame_ = frame;
+	}
+
+	memcpy(outPtr, frameBuffer_.data() + offset, GetBlockSize());
+	return true;
+}
+
+bool ZstdFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	if (count == 1) {
+		return ReadBlock(minBlock, outPtr);
+	}
+	const u32 blockSize = GetBlockSize();
+	if (minBlock >= numBlocks_) {
+		memset(outPtr, 0, blockSize * count);
+		return false;
+	}
+
+	const u32 lastBlock = std::min(minBlock + count, numBlocks_) - 1;
+	const u32 validBlocks = lastBlock + 1 - minBlock;
+	if (validBlocks < (u32)count) {
+		memset(outPtr + validBlocks * blockSize, 0, (count - validBlocks) * blockSize);
+	}
+
+	// Read all the frames at once, then decompress them one by one.
+	const u32 firstFrame = minBlock / blocksPerFrame_;
+	const u32 lastFrame = lastBlock / blocksPerFrame_;
+	const u64 rawStart = index_[firstFrame];
+	const size_t rawSize = (size_t)(index_[lastFrame + 1] - rawStart);
+	if (readBuffer_.size() < rawSize) {
+		readBuffer_.resize(rawSize);
+	}
+	const size_t readSize = fileLoader_->ReadAt(rawStart, 1, rawSize, readBuffer_.data());
+	if (readSize < rawSize) {
+		memset(readBuffer_.data() + readSize, 0, rawSize - readSize);
+	}
+
+	u32 block = minBlock;
+	u8 *dest = outPtr;
+	for (u32 frame = firstFrame; frame <= lastFrame; ++frame) {
+		const u32 frameFirstBlock = frame * blocksPerFrame_;
+		const u32 endBlock = std::min(frameFirstBlock + blocksPerFrame_, lastBlock + 1);
+		const u32 offset = (block - frameFirstBlock) * blockSize;
+		const u32 size = (endBlock - block) * blockSize;
+		const u8 *src = readBuffer_.data() + (index_[frame] - rawStart);
+
+		bool success = true;
+		if (frame == frameBufferFrame_) {
+			memcpy(dest, frameBuffer_.data() + offset, size);
+		} else if (size == FrameBytes(frame)) {
+			success = DecompressFrame(frame, src, dest);
+		} else {
+			frameBufferFrame_ = 0xFFFFFFFF;
+			success = DecompressFrame(frame, src, frameBuffer_.data());
+			if (success) {
+				frameBufferFrame_ = frame;
+				memcpy(dest, frameBuffer_.data() + offset, size);
+			}
+		}
+		if (!success) {
+			NotifyReadError();
+			memset(dest, 0, size);
+		}
+
+		block = endBlock;
+		dest += size;
+	}
+	return true;
+}
+
 NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
 	: BlockDevice(fileLoader)
 {
@@ -570,29 +1056,129 @@ bool NPDRMDemoBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 
 // static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
 
-struct CHDImpl {
-	chd_file *chd = nullptr;
-	const chd_header *header = nullptr;
-};
+// Decoders beyond the main one, used for parallel decode and readahead. Each is a full libchdr
+// handle with its own copy of the hunk map, so keep this modest.
+static const int CHD_MAX_DECODERS = 4;
+static const u32 CHD_READAHEAD_SIZE = 256 * 1024;
 
 struct ExtendedCoreFile {
 	core_file core;  // Must be the first struct member, for some tricky pointer casts.
 	uint64_t seekPos;
 };
 
-CHDFileBlockDevice::CHDFileBlockDevice(FileLoader *fileLoader)
-	: BlockDevice(fileLoader), impl_(new CHDImpl()) {
-	Path paths[8];
-	paths[0] = fileLoader->GetPath();
-	int depth = 0;
+static ExtendedCoreFile *CreateCoreFile(FileLoader *fileLoader);
+
+struct CHDImpl {
+	chd_file *chd = nullptr;
+	const chd_header *header = nullptr;
+
+	// The rest is only used with the hunk cache enabled (g_Config.iCHDHunkCacheSize.)
+	// libchdr handles can't be shared between threads, so each concurrent decode gets its own.
+	chd_file *AcquireDecoder(FileLoader *fileLoader);
+	void ReleaseDecoder(chd_file *decoder);
+	bool CopyFromCache(u32 hunk, u8 *dest);
+	void AddToCache(u32 hunk, const u8 *data);
+
+	struct CachedHunk {
+		std::vector<u8> data;
+		std::list<u32>::iterator lruPos;
+	};
+
+	std::mutex lock;
+	// Signalled when a hunk is decoded, a decoder is released or a task finishes.
+	std::condition_variable cond;
+	std::unordered_map<u32, CachedHunk> hunks;
+	std::list<u32> lru;  // Front is most recently used.
+	std::unordered_set<u32> pendingHunks;
+	u32 maxHunks = 0;
+
+	std::vector<chd_file *> extraDecoders;
+	std::vector<chd_file *> idleDecoders;
+	int numDecoders = 0;
+	int pendingTasks = 0;
+
+	u32 nextSequentialBlock = 0;
+	u32 readaheadEnd = 0;
+	int hits = 0;
+	int misses = 0;
+};
+
+chd_file *CHDImpl::AcquireDecoder(FileLoader *fileLoader) {
+	std::unique_lock<std::mutex> guard(lock);
+	while (idleDecoders.empty()) {
+		if (numDecoders < CHD_MAX_DECODERS) {
+			numDecoders++;
+			guard.unlock();
+			chd_file *decoder = nullptr;
+			chd_error err = chd_open_core_file(&CreateCoreFile(fileLoader)->core, CHD_OPEN_READ, NULL, &decoder);
+			guard.lock();
+			if (err == CHDERR_NONE) {
+				extraDecoders.push_back(decoder);
+				return decoder;
+			}
+			// Shouldn't happen since the main one opened fine. Make do with what we have.
+			WARN_LOG(Log::Loader, "Failed to open extra CHD decoder: %s", chd_error_string(err));
+			numDecoders = CHD_MAX_DECODERS;
+			continue;
+		}
+		cond.wait(guard);
+	}
+	chd_file *decoder = idleDecoders.back();
+	idleDecoders.pop_back();
+	return decoder;
+}
+
+void CHDImpl::ReleaseDecoder(chd_file *decoder) {
+	std::lock_guard<std::mutex> guard(lock);
+	idleDecoders.push_back(decoder);
+	cond.notify_all();
+}
+
+bool CHDImpl::CopyFromCache(u32 hunk, u8 *dest) {
+	std::unique_lock<std::mutex> guard(lock);
+	// If readahead is on it already, waiting is cheaper than decoding it twice.
+	cond.wait(guard, [&] { return pendingHunks.find(hunk) == pendingHunks.end(); });
+
+	auto it = hunks.find(hunk);
+	if (it == hunks.end()) {
+		misses++;
+		return false;
+	}
+	lru.splice(lru.begin(), lru, it->second.lruPos);
+	memcpy(dest, it->second.data.data(), header->hunkbytes);
+	hits++;
+	return true;
+}
+
+void CHDImpl::AddToCache(u32 hunk, const u8 *data) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = hunks.find(hunk);
+	if (it != hunks.end()) {
+		lru.splice(lru.begin(), lru, it->second.lruPos);
+		return;
+	}
 
-	core_file_ = new ExtendedCoreFile();
-	core_file_->core.argp = fileLoader;
-	core_file_->core.fsize = [](core_file *file) -> uint64_t {
+	std::vector<u8> buffer;
+	if (hunks.size() >= maxHunks) {
+		// Recycle the least recently used hunk's buffer.
+		auto oldest = hunks.find(lru.back());
+		buffer = std::move(oldest->second.data);
+		hunks.erase(oldest);
+		lru.pop_back();
+	}
+	buffer.assign(data, data + header->hunkbytes);
+	lru.push_front(hunk);
+	hunks[hunk] = CachedHunk{ std::move(buffer), lru.begin() };
+}
+
+static ExtendedCoreFile *CreateCoreFile(FileLoader *fileLoader) {
+	ExtendedCoreFile *coreFile = new ExtendedCoreFile();
+	coreFile->core.argp = fileLoader;
+	coreFile->core.fsize = [](core_file *file) -> uint64_t {
 		FileLoader *loader = (FileLoader *)file->argp;
 		return loader->FileSize();
 	};
-	core_file_->core.fseek = [](core_file *file, int64_t offset, int seekType) -> int {
+	coreFile->core.fseek = [](core_file *file, int64_t offset, int seekType) -> int {
 		ExtendedCoreFile *coreFile = (ExtendedCoreFile *)file;
 		switch (seekType) {
 		case SEEK_SET:
@@ -612,7 +1198,7 @@ CHDFileBlockDevice::CHDFileBlockDevice(FileLoader *fileLoader)
 		}
 		return 0;
 	};
-	core_file_->core.fread = [](void *out_data, size_t size, size_t count, core_file *file) {
+	coreFile->core.fread = [](void *out_data, size_t size, size_t count, core_file *file) {
 		ExtendedCoreFile *coreFile = (ExtendedCoreFile *)file;
 		FileLoader *loader = (FileLoader *)file->argp;
 		uint64_t totalSize = size * count;
@@ -620,11 +1206,21 @@ CHDFileBlockDevice::CHDFileBlockDevice(FileLoader *fileLoader)
 		coreFile->seekPos += totalSize;
 		return size * count;
 	};
-	core_file_->core.fclose = [](core_file *file) {
+	coreFile->core.fclose = [](core_file *file) {
 		ExtendedCoreFile *coreFile = (ExtendedCoreFile *)file;
 		delete coreFile;
 		return 0;
 	};
+	return coreFile;
+}
+
+CHDFileBlockDevice::CHDFileBlockDevice(FileLoader *fileLoader)
+	: BlockDevice(fileLoader), impl_(new CHDImpl()) {
+	Path paths[8];
+	paths[0] = fileLoader->GetPath();
+	int depth = 0;
+
+	core_file_ = CreateCoreFile(fileLoader);
 
 	/*
 	// TODO: Support parent/child CHD files.
@@ -691,16 +1287,108 @@ CHDFileBlockDevice::CHDFileBlockDevice(FileLoader *fileLoader)
 	blocksPerHunk = impl_->header->hunkbytes / impl_->header->unitbytes;
 	numBlocks = impl_->header->unitcount;
 
+	if (g_Config.iCHDHunkCacheSize > 0) {
+		impl_->maxHunks = std::max((u32)g_Config.iCHDHunkCacheSize * 1024 * 1024 / impl_->header->hunkbytes, 8U);
+		impl_->idleDecoders.push_back(impl_->chd);
+		impl_->numDecoders = 1;
+	}
+
 	_dbg_assert_(errorString_.empty());
 }
 
 CHDFileBlockDevice::~CHDFileBlockDevice() {
 	if (impl_->chd) {
+		{
+			// Readahead uses the decoders.
+			std::unique_lock<std::mutex> guard(impl_->lock);
+			impl_->cond.wait(guard, [&] { return impl_->pendingTasks == 0; });
+		}
+		if (impl_->hits + impl_->misses > 0) {
+			INFO_LOG(Log::Loader, "CHD hunk cache: %d hits, %d misses (%0.1f%% hit rate), %d decoders", impl_->hits, impl_->misses,
+				100.0 * impl_->hits / (impl_->hits + impl_->misses), impl_->numDecoders);
+		}
+		for (chd_file *decoder : impl_->extraDecoders) {
+			chd_close(decoder);
+		}
 		chd_close(impl_->chd);
 		delete[] readBuffer;
 	}
 }
 
+// The hunk map of V5 CHDs, as libchdr decodes it into chd_header::rawmap. Compressed images have
+// 12 byte entries: the compression type, a 24-bit length and a 48-bit file offset (big endian.)
+// Uncompressed ones have 4 byte entries with the offset in hunks.
+enum {
+	CHD_V5_COMPRESSED_ENTRY_BYTES = 12,
+	CHD_V5_COMPRESSION_NONE = 4,  // After the four codecs.
+	CHD_V5_COMPRESSION_SELF = 5,
+	CHD_V5_COMPRESSION_PARENT = 6,
+};
+
+bool CHDFileBlockDevice::GetFileRange(u32 minBlock, u32 count, s64 *offset, s64 *size) const {
+	const chd_header *header = impl_->header;
+	if (!header || header->version < 5 || !header->rawmap || minBlock >= numBlocks || count == 0) {
+		return false;
+	}
+
+	// chdman writes the hunks in order, so the ones we need are close together.
+	const u32 firstHunk = minBlock / blocksPerHunk;
+	const u32 lastHunk = (std::min(minBlock + count, numBlocks) - 1) / blocksPerHunk;
+	u64 start = (u64)-1;
+	u64 end = 0;
+	for (u32 hunk = firstHunk; hunk <= lastHunk; ++hunk) {
+		const u8 *entry = header->rawmap + (size_t)header->mapentrybytes * hunk;
+		u64 entryStart = 0;
+		u64 entryBytes = header->hunkbytes;
+		if (header->mapentrybytes == CHD_V5_COMPRESSED_ENTRY_BYTES) {
+			// Copies of other hunks and hunks in a parent image aren't stored here.
+			if (entry[0] == CHD_V5_COMPRESSION_SELF || entry[0] == CHD_V5_COMPRESSION_PARENT) {
+				continue;
+			}
+			if (entry[0] != CHD_V5_COMPRESSION_NONE) {
+				entryBytes = ((u32)entry[1] << 16) | ((u32)entry[2] << 8) | entry[3];
+			}
+			for (int i = 4; i < 10; ++i) {
+				entryStart = (entryStart << 8) | entry[i];
+			}
+		} else {
+			entryStart = (u64)(((u32)entry[0] << 24) | ((u32)entry[1] << 16) | ((u32)entry[2] << 8) | entry[3]) * header->hunkbytes;
+			// Zero means the hunk is all zeroes, or in a parent image.
+			if (entryStart == 0) {
+				continue;
+			}
+		}
+		start = std::min(start, entryStart);
+		end = std::max(end, entryStart + entryBytes);
+	}
+
+	*offset = start < end ? (s64)start : 0;
+	*size = start < end ? (s64)(end - start) : 0;
+	return true;
+}
+
+bool CHDFileBlockDevice::DecodeHunk(u32 hunk, u8 *dest) {
+	chd_error err;
+	if (impl_->maxHunks == 0) {
+		err = chd_read(impl_->chd, hunk, dest);
+	} else if (impl_->CopyFromCache(hunk, dest)) {
+		return true;
+	} else {
+		chd_file *decoder = impl_->AcquireDecoder(fileLoader_);
+		err = chd_read(decoder, hunk, dest);
+		impl_->ReleaseDecoder(decoder);
+		if (err == CHDERR_NONE) {
+			impl_->AddToCache(hunk, dest);
+		}
+	}
+
+	if (err != CHDERR_NONE) {
+		ERROR_LOG(Log::Loader, "CHD read failed: hunk %d %s", hunk, chd_error_string(err));
+		return false;
+	}
+	return true;
+}
+
 bool CHDFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
 	if (!impl_->chd) {
 		ERROR_LOG(Log::Loader, "ReadBlock: CHD not open. %s", fileLoader_->GetPath().c_str());
@@ -714,14 +1402,16 @@ bool CHDFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
 	u32 blockInHunk = blockNumber % blocksPerHunk;
 
 	if (currentHunk != hunk) {
-		chd_error err = chd_read(impl_->chd, hunk, readBuffer);
-		if (err != CHDERR_NONE) {
-			ERROR_LOG(Log::Loader, "CHD read failed: %d %d %s", blockNumber, hunk, chd_error_string(err));
+		if (!DecodeHunk(hunk, readBuffer)) {
 			NotifyReadError();
 		}
 		currentHunk = hunk;
 	}
 	memcpy(outPtr, readBuffer + blockInHunk * impl_->header->unitbytes, GetBlockSize());
+
+	if (impl_->maxHunks != 0) {
+		NotifySequentialRead(blockNumber, blockNumber);
+	}
 	return true;
 }
 
@@ -731,10 +1421,131 @@ bool CHDFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 		return false;
 	}
 
-	for (int i = 0; i < count; i++) {
-		if (!ReadBlock(minBlock + i, outPtr + i * GetBlockSize())) {
-			return false;
+	if (impl_->maxHunks == 0 || count == 1) {
+		for (int i = 0; i < count; i++) {
+			if (!ReadBlock(minBlock + i, outPtr + i * GetBlockSize())) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const u32 blockSize = GetBlockSize();
+	const u32 unitBytes = impl_->header->unitbytes;
+	const u32 hunkBytes = impl_->header->hunkbytes;
+	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
+	const u32 validBlocks = lastBlock + 1 - minBlock;
+	if (validBlocks < (u32)count) {
+		memset(outPtr + validBlocks * blockSize, 0, (count - validBlocks) * blockSize);
+	}
+
+	// Gather whole hunks first, then pick the blocks out of them.
+	const u32 firstHunk = minBlock / blocksPerHunk;
+	const u32 lastHunk = lastBlock / blocksPerHunk;
+	std::vector<u8> hunkData((size_t)(lastHunk - firstHunk + 1) * hunkBytes);
+	auto hunkPtr = [&](u32 hunk) {
+		return hunkData.data() + (size_t)(hunk - firstHunk) * hunkBytes;
+	};
+
+	std::vector<u32> toDecode;
+	for (u32 hunk = firstHunk; hunk <= lastHunk; ++hunk) {
+		if (hunk == currentHunk) {
+			memcpy(hunkPtr(hunk), readBuffer, hunkBytes);
+		} else if (!impl_->CopyFromCache(hunk, hunkPtr(hunk))) {
+			toDecode.push_back(hunk);
 		}
 	}
+
+	// Hunks are independent, so they can be decoded in parallel, each thread with its own decoder.
+	std::vector<u8> failed(toDecode.size());
+	auto decode = [&](int lower, int upper) {
+		chd_file *decoder = impl_->AcquireDecoder(fileLoader_);
+		for (int i = lower; i < upper; i++) {
+			const u32 hunk = toDecode[i];
+			chd_error err = chd_read(decoder, hunk, hunkPtr(hunk));
+			if (err != CHDERR_NONE) {
+				ERROR_LOG(Log::Loader, "CHD read failed: hunk %d %s", hunk, chd_error_string(err));
+				memset(hunkPtr(hunk), 0, hunkBytes);
+				failed[i] = 1;
+			} else {
+				impl_->AddToCache(hunk, hunkPtr(hunk));
+			}
+		}
+		impl_->ReleaseDecoder(decoder);
+	};
+
+	// Small hunks aren't worth a task each.
+	const int minHunksPerTask = std::max(1, (int)(64 * 1024 / hunkBytes));
+	if ((int)toDecode.size() > minHunksPerTask) {
+		ParallelRangeLoop(&g_threadManager, decode, 0, (int)toDecode.size(), minHunksPerTask);
+	} else if (!toDecode.empty()) {
+		decode(0, (int)toDecode.size());
+	}
+	if (std::find(failed.begin(), failed.end(), 1) != failed.end()) {
+		NotifyReadError();
+	}
+
+	for (u32 block = minBlock; block <= lastBlock; ++block) {
+		const u32 hunk = block / blocksPerHunk;
+		memcpy(outPtr + (block - minBlock) * blockSize, hunkPtr(hunk) + (block % blocksPerHunk) * unitBytes, blockSize);
+	}
+
+	NotifySequentialRead(minBlock, lastBlock);
 	return true;
 }
+
+void CHDFileBlockDevice::NotifySequentialRead(u32 minBlock, u32 lastBlock) {
+	const bool sequential = minBlock == impl_->nextSequentialBlock;
+	impl_->nextSequentialBlock = lastBlock + 1;
+	if (!sequential) {
+		return;
+	}
+
+	const u32 totalHunks = impl_->header->totalhunks;
+	const u32 firstHunk = lastBlock / blocksPerHunk + 1;
+	const u32 readaheadHunks = std::max(CHD_READAHEAD_SIZE / impl_->header->hunkbytes, 1U);
+	// Top it up once the reader is half way through what we already queued.
+	if (impl_->readaheadEnd > firstHunk && impl_->readaheadEnd - firstHunk > readaheadHunks / 2) {
+		return;
+	}
+	const u32 endHunk = std::min(firstHunk + readaheadHunks, totalHunks);
+	ReadaheadHunks(std::max(firstHunk, impl_->readaheadEnd > firstHunk ? impl_->readaheadEnd : 0), endHunk);
+	impl_->readaheadEnd = endHunk;
+}
+
+void CHDFileBlockDevice::ReadaheadHunks(u32 firstHunk, u32 endHunk) {
+	std::vector<u32> hunks;
+	{
+		std::lock_guard<std::mutex> guard(impl_->lock);
+		for (u32 hunk = firstHunk; hunk < endHunk; ++hunk) {
+			if (hunk != currentHunk && impl_->hunks.find(hunk) == impl_->hunks.end() && impl_->pendingHunks.find(hunk) == impl_->pendingHunks.end()) {
+				hunks.push_back(hunk);
+				impl_->pendingHunks.insert(hunk);
+			}
+		}
+		if (hunks.empty()) {
+			return;
+		}
+		impl_->pendingTasks++;
+	}
+
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [this, hunks = std::move(hunks)]() {
+		CHDImpl *impl = impl_.get();
+		std::vector<u8> buffer(impl->header->hunkbytes);
+		chd_file *decoder = impl->AcquireDecoder(fileLoader_);
+		for (u32 hunk : hunks) {
+			// Failures are left for the actual read to report.
+			if (chd_read(decoder, hunk, buffer.data()) == CHDERR_NONE) {
+				impl->AddToCache(hunk, buffer.data());
+			}
+			std::lock_guard<std::mutex> guard(impl->lock);
+			impl->pendingHunks.erase(hunk);
+			impl->cond.notify_all();
+		}
+		impl->ReleaseDecoder(decoder);
+
+		std::lock_guard<std::mutex> guard(impl->lock);
+		impl->pendingTasks--;
+		impl->cond.notify_all();
+	}));
+}
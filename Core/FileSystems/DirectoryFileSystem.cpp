@@ -81,6 +81,8 @@ DirectoryFileSystem::DirectoryFileSystem(IHandleAllocator *_hAlloc, const Path &
 
 	INFO_LOG(Log::IO, "Is file system case sensitive? %s (base: '%s') (checkOK: %d)", (flags & FileSystemFlags::CASE_SENSITIVE) ? "yes" : "no", _basePath.c_str(), checkSucceeded);
 
+	dirCache_.reset(new HostDirectoryCache(basePath, (flags & FileSystemFlags::CASE_SENSITIVE) != 0));
+
 	hAlloc = _hAlloc;
 }
 
@@ -108,9 +110,9 @@ Path DirectoryFileHandle::GetLocalPath(const Path &basePath, std::string localPa
 	return basePath / localPath;
 }
 
-Path DirectoryFileSystem::GetLocalPath(std::string internalPath) const {
+std::string DirectoryFileSystem::GetRelativePath(std::string internalPath) const {
 	if (internalPath.empty())
-		return basePath;
+		return internalPath;
 
 	if (internalPath[0] == '/')
 		internalPath.erase(0, 1);
@@ -123,7 +125,13 @@ Path DirectoryFileSystem::GetLocalPath(std::string internalPath) const {
 		}
 	}
 
-	return basePath / internalPath;
+	return internalPath;
+}
+
+Path DirectoryFileSystem::GetLocalPath(std::string internalPath) const {
+	if (internalPath.empty())
+		return basePath;
+	return basePath / GetRelativePath(internalPath);
 }
 
 bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, FileAccess access, u32 &error) {
@@ -457,9 +465,14 @@ void DirectoryFileHandle::Close() {
 }
 
 void DirectoryFileSystem::CloseAll() {
+	std::lock_guard<std::mutex> guard(entriesLock_);
 	for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
 		INFO_LOG(Log::FileSystem, "DirectoryFileSystem::CloseAll(): Force closing %d (%s)", (int)iter->first, iter->second.guestFilename.c_str());
+		const bool changed = iter->second.written || iter->second.hFile.needsTrunc_ != -1;
 		iter->second.hFile.Close();
+		if (changed) {
+			dirCache_->InvalidateFileInfo(GetRelativePath(iter->second.guestFilename));
+		}
 	}
 	entries.clear();
 }
@@ -478,6 +491,7 @@ bool DirectoryFileSystem::MkDir(const std::string &dirname) {
 	} else {
 		result = File::CreateFullPath(GetLocalPath(dirname));
 	}
+	dirCache_->InvalidateAll();
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::MKDIR, result, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -488,6 +502,7 @@ bool DirectoryFileSystem::RmDir(const std::string &dirname) {
 	if (flags & FileSystemFlags::CASE_SENSITIVE) {
 		// Maybe we're lucky?
 		if (File::DeleteDirRecursively(fullName)) {
+			dirCache_->InvalidateAll();
 			MemoryStick_NotifyWrite();
 			return (bool)ReplayApplyDisk(ReplayAction::RMDIR, true, CoreTiming::GetGlobalTimeUs());
 		}
@@ -501,6 +516,7 @@ bool DirectoryFileSystem::RmDir(const std::string &dirname) {
 	}
 
 	bool result = File::DeleteDirRecursively(fullName);
+	dirCache_->InvalidateAll();
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::RMDIR, result, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -548,6 +564,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 
 	// TODO: Better error codes.
 	int result = retValue ? 0 : (int)SCE_KERNEL_ERROR_ERRNO_FILE_ALREADY_EXISTS;
+	dirCache_->InvalidateAll();
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::FILE_RENAME, result, CoreTiming::GetGlobalTimeUs());
 }
@@ -569,6 +586,7 @@ bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
 		}
 	}
 
+	dirCache_->Invalidate(GetRelativePath(filename));
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::FILE_REMOVE, retValue, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -604,11 +622,16 @@ int DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const
 		}
 #endif
 
+		if (access & (FILEACCESS_WRITE | FILEACCESS_APPEND | FILEACCESS_CREATE | FILEACCESS_TRUNCATE)) {
+			dirCache_->Invalidate(GetRelativePath(filename));
+		}
+
 		u32 newHandle = hAlloc->GetNewHandle();
 
 		entry.guestFilename = filename;
 		entry.access = (FileAccess)(access & FILEACCESS_PSP_FLAGS);
 
+		std::lock_guard<std::mutex> guard(entriesLock_);
 		entries[newHandle] = entry;
 
 		return newHandle;
@@ -616,10 +639,15 @@ int DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const
 }
 
 void DirectoryFileSystem::CloseFile(u32 handle) {
+	std::lock_guard<std::mutex> guard(entriesLock_);
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		hAlloc->FreeHandle(handle);
+		const bool changed = iter->second.written || iter->second.hFile.needsTrunc_ != -1;
 		iter->second.hFile.Close();
+		if (changed) {
+			dirCache_->InvalidateFileInfo(GetRelativePath(iter->second.guestFilename));
+		}
 		entries.erase(iter);
 	} else {
 		//This shouldn't happen...
@@ -646,8 +674,11 @@ size_t DirectoryFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size) {
 }
 
 size_t DirectoryFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
+	std::unique_lock<std::mutex> guard(entriesLock_);
 	EntryMap::iterator iter = entries.find(handle);
-	if (iter != entries.end()) {
+	const bool found = iter != entries.end();
+	guard.unlock();
+	if (found) {
 		if (size < 0) {
 			ERROR_LOG(Log::FileSystem, "Invalid read for %lld bytes from disk %s", size, iter->second.guestFilename.c_str());
 			return 0;
@@ -668,9 +699,17 @@ size_t DirectoryFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size) {
 }
 
 size_t DirectoryFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec) {
+	std::unique_lock<std::mutex> guard(entriesLock_);
 	EntryMap::iterator iter = entries.find(handle);
-	if (iter != entries.end()) {
+	const bool found = iter != entries.end();
+	guard.unlock();
+	if (found) {
 		size_t bytesWritten = iter->second.hFile.Write(pointer,size);
+		if (bytesWritten > 0 && !iter->second.written) {
+			// GetFileInfo() checks this to skip the cache.
+			guard.lock();
+			iter->second.written = true;
+		}
 		return bytesWritten;
 	} else {
 		//This shouldn't happen...
@@ -690,24 +729,40 @@ size_t DirectoryFileSystem::SeekFile(u32 handle, s32 position, FileMove type) {
 	}
 }
 
+bool DirectoryFileSystem::IsBeingWritten(const std::string &relPath) {
+	std::lock_guard<std::mutex> guard(entriesLock_);
+	for (const auto &iter : entries) {
+		const OpenFileEntry &entry = iter.second;
+		if ((entry.written || entry.hFile.needsTrunc_ != -1) && equalsNoCase(GetRelativePath(entry.guestFilename), relPath))
+			return true;
+	}
+	return false;
+}
+
+bool DirectoryFileSystem::GetHostFileInfo(std::string filename, File::FileInfo *info) {
+	if ((flags & FileSystemFlags::CASE_SENSITIVE) && !FixPathCase(basePath, filename, FPC_FILE_MUST_EXIST))
+		return false;
+	return File::GetFileInfo(GetLocalPath(filename), info);
+}
+
 PSPFileInfo DirectoryFileSystem::GetFileInfo(std::string filename) {
 	PSPFileInfo x;
 	x.name = filename;
 
 	File::FileInfo info;
-	Path fullName = GetLocalPath(filename);
-	if (!File::GetFileInfo(fullName, &info)) {
-		if (flags & FileSystemFlags::CASE_SENSITIVE) {
-			if (!FixPathCase(basePath, filename, FPC_FILE_MUST_EXIST))
-				return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
-			fullName = GetLocalPath(filename);
-
-			if (!File::GetFileInfo(fullName, &info))
-				return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
-		} else {
-			return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
-		}
+	const std::string relPath = GetRelativePath(filename);
+	bool found;
+	if (IsBeingWritten(relPath)) {
+		// The cache only gets the new size and time when the file is closed.
+		found = GetHostFileInfo(filename, &info);
+	} else {
+		found = dirCache_->GetFileInfo(relPath, &info);
+		// The cache already looks past case differences, except for paths it can't handle.
+		if (!found && (flags & FileSystemFlags::CASE_SENSITIVE) && !HostDirectoryCache::CanCache(relPath))
+			found = GetHostFileInfo(filename, &info);
 	}
+	if (!found)
+		return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
 
 	x.type = info.isDirectory ? FILETYPE_DIRECTORY : FILETYPE_NORMAL;
 	x.exists = true;
@@ -821,18 +876,17 @@ std::vector<PSPFileInfo> DirectoryFileSystem::GetDirListing(const std::string &p
 	std::vector<PSPFileInfo> myVector;
 
 	std::vector<File::FileInfo> files;
-	Path localPath = GetLocalPath(path);
-	const int flags = File::GETFILES_GETHIDDEN | File::GETFILES_GET_NAVIGATION_ENTRIES;
-	bool success = File::GetFilesInDir(localPath, &files, nullptr, flags);
+	const std::string relPath = GetRelativePath(path);
+	bool success = dirCache_->GetFilesInDir(relPath, &files);
 
-	if (this->flags & FileSystemFlags::CASE_SENSITIVE) {
+	if ((flags & FileSystemFlags::CASE_SENSITIVE) && !HostDirectoryCache::CanCache(relPath)) {
 		if (!success) {
 			// TODO: Case sensitivity should be checked on a file system basis, right?
 			std::string fixedPath = path;
 			if (FixPathCase(basePath, fixedPath, FPC_FILE_MUST_EXIST)) {
 				// May have failed due to case sensitivity, try again
-				localPath = GetLocalPath(fixedPath);
-				success = File::GetFilesInDir(localPath, &files, nullptr, flags);
+				const int getFilesFlags = File::GETFILES_GETHIDDEN | File::GETFILES_GET_NAVIGATION_ENTRIES;
+				success = File::GetFilesInDir(GetLocalPath(fixedPath), &files, nullptr, getFilesFlags);
 			}
 		}
 	}
@@ -854,7 +908,7 @@ std::vector<PSPFileInfo> DirectoryFileSystem::GetDirListing(const std::string &p
 			entry.name = file.name;
 		}
 		if (hideISOFiles) {
-			if (endsWithNoCase(entry.name, ".cso") || endsWithNoCase(entry.name, ".iso") || endsWithNoCase(entry.name, ".chd")) {  // chd not really necessary, but let's hide them too.
+			if (endsWithNoCase(entry.name, ".cso") || endsWithNoCase(entry.name, ".iso") || endsWithNoCase(entry.name, ".chd") || endsWithNoCase(entry.name, ".psz")) {  // chd not really necessary, but let's hide them too.
 				// Workaround for DJ Max Portable, see compat.ini.
 				continue;
 			} else if (file.isDirectory) {
@@ -947,6 +1001,8 @@ void DirectoryFileSystem::DoState(PointerWrap &p) {
 
 	if (p.mode == p.MODE_READ) {
 		CloseAll();
+		// The files may have been changed since the state was saved.
+		dirCache_->InvalidateAll();
 		u32 key;
 		OpenFileEntry entry;
 		entry.hFile.fileSystemFlags_ = flags;
@@ -972,6 +1028,7 @@ void DirectoryFileSystem::DoState(PointerWrap &p) {
 			// Let's hope that things don't go that badly with the file mysteriously auto-closed.
 			// Better than not loading the save state at all, hopefully.
 			if (!brokenFile) {
+				std::lock_guard<std::mutex> guard(entriesLock_);
 				entries[key] = entry;
 			}
 		}
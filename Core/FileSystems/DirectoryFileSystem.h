@@ -20,9 +20,12 @@
 // TODO: Remove the Windows-specific code, FILE is fine there too.
 
 #include <map>
+#include <memory>
+#include <mutex>
 
 #include "Common/File/Path.h"
 #include "Core/FileSystems/FileSystem.h"
+#include "Core/FileSystems/HostDirectoryCache.h"
 
 #ifdef _WIN32
 typedef void * HANDLE;
@@ -88,21 +91,33 @@ class DirectoryFileSystem : public IFileSystem {
 
 	bool ComputeRecursiveDirSizeIfFast(const std::string &path, int64_t *size) override;
 	void Describe(char *buf, size_t size) const override { snprintf(buf, size, "Dir: %s", basePath.c_str()); }
+	bool SupportsConcurrentIO() const override { return true; }
 
 private:
 	struct OpenFileEntry {
 		DirectoryFileHandle hFile;
 		std::string guestFilename;
 		FileAccess access = FILEACCESS_NONE;
+		// The cached size and time are updated on close, until then GetFileInfo asks the host.
+		// Only set with entriesLock_ held.
+		bool written = false;
 	};
 
 	typedef std::map<u32, OpenFileEntry> EntryMap;
 	EntryMap entries;
+	// Reads and writes look up entries without MetaFileSystem's lock, so changes to it need this.
+	// Each handle has its own host file, the IO itself doesn't.
+	std::mutex entriesLock_;
 	Path basePath;
 	IHandleAllocator *hAlloc;
 	FileSystemFlags flags;
+	std::unique_ptr<HostDirectoryCache> dirCache_;
 
+	std::string GetRelativePath(std::string internalPath) const;
 	Path GetLocalPath(std::string internalPath) const;
+	// Whether an open handle has written to or truncated the file, so the cached info is stale.
+	bool IsBeingWritten(const std::string &relPath);
+	bool GetHostFileInfo(std::string filename, File::FileInfo *info);
 };
 
 // VFSFileSystem: Ability to map in Android APK paths as well! Does not support all features, only meant for fonts.
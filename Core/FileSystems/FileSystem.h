@@ -155,6 +155,9 @@ class IFileSystem {
 	virtual u64      FreeDiskSpace(const std::string &path) = 0;
 	virtual bool     ComputeRecursiveDirSizeIfFast(const std::string &path, int64_t *size) = 0;
 	virtual void     Describe(char *buf, size_t size) const = 0;
+	// If true, ReadFile and WriteFile may be called without MetaFileSystem's lock, at the same time
+	// as calls on other handles.
+	virtual bool     SupportsConcurrentIO() const { return false; }
 };
 
 
@@ -0,0 +1,389 @@
+#include "ppsspp_config.h"
+
+#if PPSSPP_PLATFORM(LINUX) && !defined(HAVE_LIBRETRO_VFS)
+#define HOST_DIRECTORY_INOTIFY 1
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
+#include "Core/FileSystems/HostDirectoryCache.h"
+
+// How long listings are trusted when nothing tells us about changes.
+static const double UNWATCHED_MAX_AGE = 2.0;
+
+HostDirectoryCache::HostDirectoryCache(const Path &basePath, bool caseSensitive)
+	: basePath_(basePath), caseSensitive_(caseSensitive) {
+#ifdef HOST_DIRECTORY_INOTIFY
+	if (basePath_.Type() == PathType::NATIVE) {
+		watchFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (watchFd_ >= 0 && pipe2(wakePipe_, O_CLOEXEC) == 0) {
+			watchThread_ = std::thread([this] {
+				SetCurrentThreadName("HostDirWatch");
+				WatchThread();
+			});
+		} else if (watchFd_ >= 0) {
+			close(watchFd_);
+			watchFd_ = -1;
+		}
+	}
+#endif
+}
+
+HostDirectoryCache::~HostDirectoryCache() {
+	{
+		std::unique_lock<std::mutex> guard(lock_);
+		tasksDone_.wait(guard, [&] { return pendingTasks_ == 0; });
+	}
+
+#ifdef HOST_DIRECTORY_INOTIFY
+	if (watchThread_.joinable()) {
+		char c = 0;
+		if (write(wakePipe_[1], &c, 1) != 1) {
+			ERROR_LOG(Log::FileSystem, "Failed to wake the host directory watcher");
+		}
+		watchThread_.join();
+		close(wakePipe_[0]);
+		close(wakePipe_[1]);
+	}
+	if (watchFd_ >= 0) {
+		close(watchFd_);
+	}
+#endif
+
+	if (hits_ + misses_ > 0) {
+		INFO_LOG(Log::FileSystem, "Host directory cache for '%s': %d hits, %d misses", basePath_.ToVisualString().c_str(), hits_, misses_);
+	}
+}
+
+bool HostDirectoryCache::SplitPath(const std::string &relPath, std::vector<std::string> *components) {
+	size_t start = 0;
+	while (start <= relPath.size()) {
+		size_t end = relPath.find('/', start);
+		if (end == relPath.npos)
+			end = relPath.size();
+		if (end > start) {
+			std::string component = relPath.substr(start, end - start);
+			if (component == "." || component == "..")
+				return false;
+			components->push_back(std::move(component));
+		}
+		start = end + 1;
+	}
+	return true;
+}
+
+bool HostDirectoryCache::CanCache(const std::string &relPath) {
+	std::vector<std::string> components;
+	return SplitPath(relPath, &components);
+}
+
+std::string HostDirectoryCache::Fold(const std::string &str) {
+	std::string folded = str;
+	for (char &c : folded) {
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+	}
+	return folded;
+}
+
+bool HostDirectoryCache::GetFileInfo(const std::string &relPath, File::FileInfo *info) {
+	std::vector<std::string> components;
+	if (!SplitPath(relPath, &components) || components.empty()) {
+		return File::GetFileInfo(basePath_ / relPath, info);
+	}
+
+	ListingPtr dir = ResolveDirectory(components, components.size() - 1, false);
+	const File::FileInfo *file = dir ? Find(*dir, components.back()) : nullptr;
+	if (!file) {
+		return false;
+	}
+	*info = *file;
+	return true;
+}
+
+bool HostDirectoryCache::GetFilesInDir(const std::string &relPath, std::vector<File::FileInfo> *files) {
+	std::vector<std::string> components;
+	if (!SplitPath(relPath, &components)) {
+		return File::GetFilesInDir(basePath_ / relPath, files, nullptr, File::GETFILES_GETHIDDEN | File::GETFILES_GET_NAVIGATION_ENTRIES);
+	}
+
+	ListingPtr dir = ResolveDirectory(components, components.size(), true);
+	if (!dir) {
+		return false;
+	}
+	*files = dir->files;
+	return true;
+}
+
+HostDirectoryCache::ListingPtr HostDirectoryCache::ResolveDirectory(const std::vector<std::string> &components, size_t count, bool prefetchSubdirs) {
+	std::string key;
+	ListingPtr listing = GetListing(key, prefetchSubdirs && count == 0);
+	for (size_t i = 0; i < count && listing; ++i) {
+		const File::FileInfo *entry = Find(*listing, components[i]);
+		if (!entry || !entry->isDirectory) {
+			return nullptr;
+		}
+		// Use the name as it is on the host, so all spellings share the listing.
+		key = key.empty() ? entry->name : key + "/" + entry->name;
+		listing = GetListing(key, prefetchSubdirs && i + 1 == count);
+	}
+	return listing;
+}
+
+const File::FileInfo *HostDirectoryCache::Find(const Listing &listing, const std::string &name) const {
+	auto it = listing.byFoldedName.find(Fold(name));
+	if (it == listing.byFoldedName.end()) {
+		return nullptr;
+	}
+	const File::FileInfo *file = &listing.files[it->second];
+	if (caseSensitive_ && file->name != name) {
+		// There might be several that only differ in case, an exact match wins.
+		for (const File::FileInfo &other : listing.files) {
+			if (other.name == name)
+				return &other;
+		}
+	}
+	return file;
+}
+
+HostDirectoryCache::ListingPtr HostDirectoryCache::GetListing(const std::string &key, bool prefetchSubdirs) {
+	u64 generation;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = listings_.find(key);
+		if (it != listings_.end() && (it->second->wd >= 0 || time_now_d() - it->second->time < UNWATCHED_MAX_AGE)) {
+			hits_++;
+			return it->second;
+		}
+		misses_++;
+		generation = generation_;
+	}
+
+	// Watch before reading, so that no change can slip in between.
+	auto listing = std::make_shared<Listing>();
+	listing->wd = AddWatch(key);
+	listing->time = time_now_d();
+	const Path dir = key.empty() ? basePath_ : basePath_ / key;
+	if (!File::GetFilesInDir(dir, &listing->files, nullptr, File::GETFILES_GETHIDDEN | File::GETFILES_GET_NAVIGATION_ENTRIES)) {
+		std::lock_guard<std::mutex> guard(lock_);
+		RemoveWatchLocked(listing->wd);
+		return nullptr;
+	}
+	for (size_t i = 0; i < listing->files.size(); ++i) {
+		listing->byFoldedName.emplace(Fold(listing->files[i].name), i);
+	}
+	listing->foldedKey = Fold(key);
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (generation == generation_) {
+			if (listings_.size() >= MAX_LISTINGS) {
+				ClearListingsLocked();
+			}
+			listings_[key] = listing;
+		}
+		// Otherwise, the watch is left alone. Another read of the same directory might be using it,
+		// and reading the directory again gets the same one.
+	}
+
+	if (prefetchSubdirs) {
+		PrefetchSubdirectories(key, *listing);
+	}
+	return listing;
+}
+
+// Games that list a directory usually go on to look inside each subdirectory (save data especially),
+// so read those listings in parallel in the background.
+void HostDirectoryCache::PrefetchSubdirectories(const std::string &key, const Listing &listing) {
+	if (!g_threadManager.IsInitialized()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	int count = 0;
+	for (const File::FileInfo &file : listing.files) {
+		if (!file.isDirectory || file.name == "." || file.name == "..") {
+			continue;
+		}
+		std::string subKey = key.empty() ? file.name : key + "/" + file.name;
+		if (listings_.find(subKey) != listings_.end()) {
+			continue;
+		}
+		if (++count > MAX_PREFETCH_SUBDIRS) {
+			break;
+		}
+
+		pendingTasks_++;
+		g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [this, subKey]() {
+			GetListing(subKey, false);
+			std::lock_guard<std::mutex> guard(lock_);
+			pendingTasks_--;
+			tasksDone_.notify_all();
+		}));
+	}
+}
+
+bool HostDirectoryCache::SplitAndFold(const std::string &relPath, std::string *folded) {
+	std::vector<std::string> components;
+	if (!SplitPath(relPath, &components)) {
+		return false;
+	}
+	for (const std::string &component : components) {
+		*folded += folded->empty() ? Fold(component) : "/" + Fold(component);
+	}
+	return true;
+}
+
+void HostDirectoryCache::Invalidate(const std::string &relPath) {
+	std::string folded;
+	if (!SplitAndFold(relPath, &folded)) {
+		InvalidateAll();
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	for (int i = 0; i < 3; ++i) {
+		InvalidateFoldedLocked(folded);
+		if (folded.empty()) {
+			break;
+		}
+		size_t slash = folded.rfind('/');
+		folded = slash == folded.npos ? "" : folded.substr(0, slash);
+	}
+}
+
+void HostDirectoryCache::InvalidateFileInfo(const std::string &relPath) {
+	std::string folded;
+	if (!SplitAndFold(relPath, &folded)) {
+		InvalidateAll();
+		return;
+	}
+
+	size_t slash = folded.rfind('/');
+	std::lock_guard<std::mutex> guard(lock_);
+	InvalidateFoldedLocked(slash == folded.npos ? "" : folded.substr(0, slash));
+}
+
+void HostDirectoryCache::InvalidateAll() {
+	std::lock_guard<std::mutex> guard(lock_);
+	ClearListingsLocked();
+}
+
+// Lock must be held.
+void HostDirectoryCache::ClearListingsLocked() {
+	std::vector<int> wds;
+	for (const auto &item : listings_) {
+		wds.push_back(item.second->wd);
+	}
+	listings_.clear();
+	// Reads in progress may have added the same watches, don't let them store their listings.
+	generation_++;
+	for (int wd : wds) {
+		RemoveWatchLocked(wd);
+	}
+}
+
+// Lock must be held.
+void HostDirectoryCache::InvalidateFoldedLocked(const std::string &foldedKey) {
+	generation_++;
+	for (auto it = listings_.begin(); it != listings_.end(); ) {
+		if (it->second->foldedKey == foldedKey) {
+			const int wd = it->second->wd;
+			it = listings_.erase(it);
+			RemoveWatchLocked(wd);
+		} else {
+			++it;
+		}
+	}
+}
+
+int HostDirectoryCache::AddWatch(const std::string &key) {
+#ifdef HOST_DIRECTORY_INOTIFY
+	if (watchFd_ < 0) {
+		return -1;
+	}
+	const Path dir = key.empty() ? basePath_ : basePath_ / key;
+	const u32 mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+	int wd = inotify_add_watch(watchFd_, dir.c_str(), mask);
+	if (wd < 0) {
+		// Likely out of watches (fs.inotify.max_user_watches), fall back to expiry.
+		return -1;
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	watches_[wd] = key;
+	return wd;
+#else
+	return -1;
+#endif
+}
+
+// Lock must be held. Removes the watch, unless another listing still uses it (the same directory
+// reached through a link gets the same descriptor.)
+void HostDirectoryCache::RemoveWatchLocked(int wd) {
+#ifdef HOST_DIRECTORY_INOTIFY
+	if (wd < 0) {
+		return;
+	}
+	for (const auto &item : listings_) {
+		if (item.second->wd == wd) {
+			return;
+		}
+	}
+	if (watches_.erase(wd) != 0) {
+		inotify_rm_watch(watchFd_, wd);
+	}
+#endif
+}
+
+void HostDirectoryCache::WatchThread() {
+#ifdef HOST_DIRECTORY_INOTIFY
+	alignas(struct inotify_event) char buffer[4096];
+	while (true) {
+		struct pollfd fds[2] = { { watchFd_, POLLIN, 0 }, { wakePipe_[0], POLLIN, 0 } };
+		if (poll(fds, 2, -1) < 0) {
+			continue;
+		}
+		if (fds[1].revents != 0) {
+			break;
+		}
+
+		ssize_t len;
+		while ((len = read(watchFd_, buffer, sizeof(buffer))) > 0) {
+			std::lock_guard<std::mutex> guard(lock_);
+			for (ssize_t pos = 0; pos < len; ) {
+				const struct inotify_event *event = (const struct inotify_event *)(buffer + pos);
+				pos += sizeof(struct inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW) {
+					ClearListingsLocked();
+					continue;
+				}
+				auto it = watches_.find(event->wd);
+				if (it == watches_.end()) {
+					continue;
+				}
+				const std::string folded = Fold(it->second);
+				if (event->mask & IN_IGNORED) {
+					// The watch is already gone.
+					watches_.erase(it);
+				}
+				// The directory itself, and its parent which shows its modification time.
+				// Dropping the listing also removes the watch, until the directory is read again.
+				InvalidateFoldedLocked(folded);
+				if (!folded.empty()) {
+					size_t slash = folded.rfind('/');
+					InvalidateFoldedLocked(slash == folded.npos ? "" : folded.substr(0, slash));
+				}
+			}
+		}
+	}
+#endif
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/DirListing.h"
+#include "Common/File/Path.h"
+
+// In-memory cache of host directory listings for DirectoryFileSystem, so that games scanning
+// ms0: (save data utilities, homebrew menus) don't hit the host file system on every
+// GetFileInfo / GetDirListing. File info is served from the listing of the parent directory.
+//
+// Paths are relative to the base path, and resolved component by component through the cached
+// listings, case-insensitively on case sensitive hosts (like FixPathCase, but without the syscalls.)
+//
+// Writes through the owning file system must call Invalidate. Changes from elsewhere are picked
+// up through inotify on Linux and Android. Where that's not available, listings expire after a
+// couple of seconds instead.
+class HostDirectoryCache {
+public:
+	HostDirectoryCache(const Path &basePath, bool caseSensitive);
+	~HostDirectoryCache();
+
+	// Paths that can't be cached, like ones with "." or ".." components, go straight to the host.
+	static bool CanCache(const std::string &relPath);
+
+	bool GetFileInfo(const std::string &relPath, File::FileInfo *info);
+	// Includes hidden files and "." / "..", as DirectoryFileSystem wants them.
+	bool GetFilesInDir(const std::string &relPath, std::vector<File::FileInfo> *files);
+
+	// Drops the listings affected by a change to relPath: its own, its parent's and the grandparent's
+	// (where the parent's modification time is shown.)
+	void Invalidate(const std::string &relPath);
+	// Only drops the parent's listing, which has the size and time of the file. For changes to the
+	// contents of a file, which don't affect any directory.
+	void InvalidateFileInfo(const std::string &relPath);
+	void InvalidateAll();
+
+private:
+	struct Listing {
+		std::vector<File::FileInfo> files;
+		// Lowercased name -> index in files.
+		std::unordered_map<std::string, size_t> byFoldedName;
+		std::string foldedKey;
+		double time = 0.0;
+		// inotify watch descriptor, if watched.
+		int wd = -1;
+	};
+	typedef std::shared_ptr<const Listing> ListingPtr;
+
+	static bool SplitPath(const std::string &relPath, std::vector<std::string> *components);
+	static std::string Fold(const std::string &str);
+
+	ListingPtr GetListing(const std::string &key, bool prefetchSubdirs);
+	ListingPtr ResolveDirectory(const std::vector<std::string> &components, size_t count, bool prefetchSubdirs);
+	const File::FileInfo *Find(const Listing &listing, const std::string &name) const;
+	void PrefetchSubdirectories(const std::string &key, const Listing &listing);
+
+	bool SplitAndFold(const std::string &relPath, std::string *folded);
+	int AddWatch(const std::string &key);
+	void RemoveWatchLocked(int wd);
+	void ClearListingsLocked();
+	void InvalidateFoldedLocked(const std::string &foldedKey);
+	void WatchThread();
+
+	enum {
+		MAX_LISTINGS = 256,
+		MAX_PREFETCH_SUBDIRS = 32,
+	};
+
+	Path basePath_;
+	bool caseSensitive_;
+
+	std::mutex lock_;
+	std::unordered_map<std::string, ListingPtr> listings_;
+	// Bumped on every invalidation, so listings read from the host meanwhile aren't stored.
+	u64 generation_ = 0;
+	int hits_ = 0;
+	int misses_ = 0;
+
+	std::condition_variable tasksDone_;
+	int pendingTasks_ = 0;
+
+	// inotify, if available.
+	int watchFd_ = -1;
+	int wakePipe_[2] = { -1, -1 };
+	std::unordered_map<int, std::string> watches_;
+	std::thread watchThread_;
+};
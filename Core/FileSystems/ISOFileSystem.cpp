@@ -20,6 +20,7 @@
 #include <cstdio>
 
 #include "Common/CommonTypes.h"
+#include "Common/StringUtils.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Core/FileSystems/ISOFileSystem.h"
@@ -29,6 +30,23 @@
 
 const int sectorSize = 2048;
 
+// Access pattern hints (see ISOFileSystem::AdviseRead.) These mostly matter for memory mapped
+// ISOs, where the OS can then read ahead instead of faulting pages in one at a time.
+static const s64 SMALL_FILE_SIZE = 256 * 1024;
+static const u32 READAHEAD_SECTORS = 1024 * 1024 / sectorSize;
+// Games may build a new "/sce_lbn" path for every read, don't let the cache grow forever.
+static const size_t MAX_CACHED_LBNS = 1024;
+
+// Case folding for the path index. ISO 9660 names are plain ASCII.
+static std::string IndexKey(const std::string &path, size_t start) {
+	std::string key = path.substr(start);
+	for (char &c : key) {
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+	}
+	return key;
+}
+
 bool parseLBN(const std::string &filename, u32 *sectorStart, u32 *readSize) {
 	// The format of this is: "/sce_lbn" "0x"? HEX* ANY* "_size" "0x"? HEX* ANY*
 	// That means that "/sce_lbn/_size1/" is perfectly valid.
@@ -185,19 +203,37 @@ std::string ISOFileSystem::TreeEntry::BuildPath() {
 }
 
 void ISOFileSystem::ReadDirectory(TreeEntry *root) {
+	// The key of root, for indexing the children. BuildPath() starts with a slash, except for the root itself.
+	std::string rootKey = IndexKey(root->BuildPath(), root == treeroot ? 0 : 1);
+	// If the folded path of this directory is ambiguous (see below), so are the paths of its children.
+	bool indexChildren = root == treeroot;
+	if (!indexChildren) {
+		auto it = pathIndex_.find(rootKey);
+		indexChildren = it != pathIndex_.end() && it->second == root;
+	}
+	if (!rootKey.empty())
+		rootKey.push_back('/');
+
 	for (u32 secnum = root->startsector, endsector = root->startsector + (root->dirsize + 2047) / 2048; secnum < endsector; ++secnum) {
 		u8 theSector[2048];
-		if (!blockDevice->ReadBlock(secnum, theSector)) {
-			blockDevice->NotifyReadError();
-			ERROR_LOG(Log::FileSystem, "Error reading block for directory '%s' in sector %d - skipping", root->name.c_str(), secnum);
-			root->valid = true;  // Prevents re-reading
-			return;
+		std::unique_lock<std::mutex> guard(lock_);
+		// Parse in place if the image is memory mapped.
+		const u8 *sector = blockDevice->GetBlockPointer(secnum, 1);
+		if (!sector) {
+			if (!blockDevice->ReadBlock(secnum, theSector)) {
+				blockDevice->NotifyReadError();
+				ERROR_LOG(Log::FileSystem, "Error reading block for directory '%s' in sector %d - skipping", root->name.c_str(), secnum);
+				root->valid = true;  // Prevents re-reading
+				return;
+			}
+			sector = theSector;
 		}
 		lastReadBlock_ = secnum;  // Hm, this could affect timing... but lazy loading is probably more realistic.
+		guard.unlock();
 
 		for (int offset = 0; offset < 2048; ) {
-			DirectoryEntry &dir = *(DirectoryEntry *)&theSector[offset];
-			u8 sz = theSector[offset];
+			const DirectoryEntry &dir = *(const DirectoryEntry *)&sector[offset];
+			u8 sz = sector[offset];
 
 			// Nothing left in this sector.  There might be more in the next one.
 			if (sz == 0)
@@ -250,6 +286,12 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 				}
 			}
 			root->children.push_back(entry);
+			if (!relative && indexChildren) {
+				// Names that only differ in case are left to WalkPath, which prefers an exact match.
+				auto result = pathIndex_.emplace(rootKey + IndexKey(entry->name, 0), entry);
+				if (!result.second)
+					result.first->second = nullptr;
+			}
 		}
 	}
 	root->valid = true;
@@ -276,6 +318,44 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 	if (pathLength <= pathIndex)
 		return treeroot;
 
+	std::string key = IndexKey(path, pathIndex);
+	if (key.back() == '/')
+		key.pop_back();
+
+	auto it = pathIndex_.find(key);
+	if (it != pathIndex_.end() && !it->second)
+		return WalkPath(path, pathIndex, catchError);
+	if (it != pathIndex_.end()) {
+		TreeEntry *entry = it->second;
+		if (!entry->valid)
+			ReadDirectory(entry);
+		return entry;
+	}
+
+	// If the parent directory has already been read, the file simply isn't there.
+	// Paths with relative components aren't indexed, those always take the slow path.
+	const size_t lastSlash = key.find_last_of('/');
+	const std::string lastComponent = lastSlash == key.npos ? key : key.substr(lastSlash + 1);
+	if (lastComponent != "." && lastComponent != "..") {
+		TreeEntry *parent = treeroot;
+		if (lastSlash != key.npos) {
+			auto parentIt = pathIndex_.find(key.substr(0, lastSlash));
+			parent = parentIt != pathIndex_.end() ? parentIt->second : nullptr;
+		}
+		if (parent && parent->valid && parent->isDirectory) {
+			if (catchError)
+				ERROR_LOG(Log::FileSystem, "File '%s' not found", path.c_str());
+			return nullptr;
+		}
+	}
+
+	// Reads the directories along the way, which adds them to the index for next time.
+	return WalkPath(path, pathIndex, catchError);
+}
+
+ISOFileSystem::TreeEntry *ISOFileSystem::WalkPath(const std::string &path, size_t pathIndex, bool catchError) {
+	const size_t pathLength = path.length();
+
 	TreeEntry *entry = treeroot;
 	while (true) {
 		if (!entry->valid) {
@@ -296,6 +376,10 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 					nextEntry = entry->children[i];
 					name = n;
 					break;
+				} else if (!nextEntry && equalsNoCase(firstPathComponent, n)) {
+					// Keep looking for an exact match.
+					nextEntry = entry->children[i];
+					name = n;
 				}
 			}
 		}
@@ -319,6 +403,21 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 	}
 }
 
+void ISOFileSystem::ParseLBNCached(const std::string &filename, u32 *sectorStart, u32 *readSize) {
+	auto it = lbnCache_.find(filename);
+	if (it != lbnCache_.end()) {
+		*sectorStart = it->second.sectorStart;
+		*readSize = it->second.readSize;
+		return;
+	}
+
+	if (parseLBN(filename, sectorStart, readSize)) {
+		if (lbnCache_.size() >= MAX_CACHED_LBNS)
+			lbnCache_.clear();
+		lbnCache_[filename] = LBNRange{ *sectorStart, *readSize };
+	}
+}
+
 int ISOFileSystem::OpenFile(std::string filename, FileAccess access, const char *devicename) {
 	OpenFileEntry entry;
 	entry.isRawSector = false;
@@ -332,7 +431,7 @@ int ISOFileSystem::OpenFile(std::string filename, FileAccess access, const char
 	if (filename.compare(0, 8, "/sce_lbn") == 0) {
 		// Raw sector read.
 		u32 sectorStart = 0xFFFFFFFF, readSize = 0xFFFFFFFF;
-		parseLBN(filename, &sectorStart, &readSize);
+		ParseLBNCached(filename, &sectorStart, &readSize);
 		if (sectorStart > blockDevice->GetNumBlocks()) {
 			WARN_LOG(Log::FileSystem, "Unable to open raw sector, out of range: '%s', sector %08x, max %08x", filename.c_str(), sectorStart, blockDevice->GetNumBlocks());
 			return SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
@@ -349,11 +448,13 @@ int ISOFileSystem::OpenFile(std::string filename, FileAccess access, const char
 		entry.isRawSector = true;
 		entry.sectorStart = sectorStart;
 		entry.openSize = readSize;
+		entry.lastReadEnd = sectorStart;
 		// when open as "umd1:/sce_lbn0x0_size0x6B49D200", that mean open umd1 as a block device.
 		// the param in sceIoLseek and sceIoRead is lba mode. we must mark it.
 		if (strncmp(devicename, "umd0:", 5) == 0 || strncmp(devicename, "umd1:", 5) == 0)
 			entry.isBlockSectorMode = true;
 
+		std::lock_guard<std::mutex> guard(lock_);
 		entries[newHandle] = entry;
 		return newHandle;
 	}
@@ -368,13 +469,41 @@ int ISOFileSystem::OpenFile(std::string filename, FileAccess access, const char
 		entry.isBlockSectorMode = true;
 
 	entry.seekPos = 0;
+	entry.lastReadEnd = entry.file->startsector;
+	if (!entry.isBlockSectorMode && !entry.file->isDirectory && entry.file->size <= SMALL_FILE_SIZE) {
+		// Small files (modules, PARAM.SFO, ...) are almost always read whole right after opening.
+		blockDevice->Advise(entry.file->startsector, (u32)((entry.file->size + 2047) / 2048), MappedFileAdvice::WILLNEED);
+	}
 
 	u32 newHandle = hAlloc->GetNewHandle();
+	std::lock_guard<std::mutex> guard(lock_);
 	entries[newHandle] = entry;
 	return newHandle;
 }
 
+void ISOFileSystem::AdviseRead(OpenFileEntry &e, u32 firstSector, u32 endSector, u32 fileEndSector) {
+	const bool sequential = firstSector == e.lastReadEnd;
+	e.lastReadEnd = endSector;
+	if (!sequential || endSector >= fileEndSector) {
+		return;
+	}
+	// Keep at least half the readahead window hinted ahead of the reader.
+	if (e.hintedEnd >= endSector + READAHEAD_SECTORS / 2) {
+		return;
+	}
+
+	if (e.hintedEnd == 0) {
+		// First sign of streaming, let the OS know about the rest of the file.
+		blockDevice->Advise(endSector, fileEndSector - endSector, MappedFileAdvice::SEQUENTIAL);
+	}
+	const u32 start = std::max(endSector, e.hintedEnd);
+	const u32 end = std::min(endSector + READAHEAD_SECTORS, fileEndSector);
+	blockDevice->Advise(start, end - start, MappedFileAdvice::WILLNEED);
+	e.hintedEnd = end;
+}
+
 void ISOFileSystem::CloseFile(u32 handle) {
+	std::lock_guard<std::mutex> guard(lock_);
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		//CloseHandle((*iter).second.hFile);
@@ -414,7 +543,10 @@ int ISOFileSystem::Ioctl(u32 handle, u32 cmd, u32 indataPtr, u32 inlen, u32 outd
 		}
 
 		INFO_LOG(Log::sceIo, "sceIoIoctl: reading ISO9660 volume descriptor read");
-		blockDevice->ReadBlock(16, Memory::GetPointerWriteUnchecked(outdataPtr));
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			blockDevice->ReadBlock(16, Memory::GetPointerWriteUnchecked(outdataPtr));
+		}
 		return 0;
 
 	// Get ISO9660 path table (from open ISO9660 file.)
@@ -424,6 +556,7 @@ int ISOFileSystem::Ioctl(u32 handle, u32 cmd, u32 indataPtr, u32 inlen, u32 outd
 			return SCE_KERNEL_ERROR_ERRNO_FUNCTION_NOT_SUPPORTED;
 		}
 
+		std::lock_guard<std::mutex> guard(lock_);
 		VolDescriptor desc;
 		blockDevice->ReadBlock(16, (u8 *)&desc);
 		if (outlen < (u32)desc.pathTableLength) {
@@ -473,6 +606,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 }
 
 size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
+	std::unique_lock<std::mutex> guard(lock_);
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		OpenFileEntry &e = iter->second;
@@ -484,6 +618,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 		
 		if (e.isBlockSectorMode) {
 			// Whole sectors! Shortcut to this simple code.
+			AdviseRead(e, e.seekPos, e.seekPos + (u32)size, blockDevice->GetNumBlocks());
 			blockDevice->ReadBlocks(e.seekPos, (int)size, pointer);
 			if (abs((int)lastReadBlock_ - (int)e.seekPos) > 100) {
 				// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
@@ -536,8 +671,24 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 			ERROR_LOG(Log::FileSystem, "Remaining size should be aligned");
 		}
 
+		const u32 endSecNum = (u32)((positionOnIso + size + 2047) / 2048);
+		AdviseRead(e, secNum, endSecNum, (u32)((positionOnIso - e.seekPos + fileSize + 2047) / 2048));
+
 		const u8 *const start = pointer;
-		if (firstBlockSize > 0) {
+		const u8 *mapped = size > 0 ? blockDevice->GetBlockPointer(secNum, endSecNum - secNum) : nullptr;
+		if (mapped) {
+			// Straight from the image, no need to stage partial sectors. Other reads can go on meanwhile,
+			// nothing else touches this handle while it's being read.
+			if (abs((int)lastReadBlock_ - (int)endSecNum) > 100) {
+				usec = 100000;
+			}
+			lastReadBlock_ = endSecNum;
+			guard.unlock();
+
+			memcpy(pointer, mapped + firstBlockOffset, (size_t)size);
+			e.seekPos += (unsigned int)size;
+			return (size_t)size;
+		} else if (firstBlockSize > 0) {
 			blockDevice->ReadBlock(secNum++, theSector);
 			memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
 			pointer += firstBlockSize;
@@ -609,7 +760,7 @@ size_t ISOFileSystem::SeekFile(u32 handle, s32 position, FileMove type) {
 PSPFileInfo ISOFileSystem::GetFileInfo(std::string filename) {
 	if (filename.compare(0,8,"/sce_lbn") == 0) {
 		u32 sectorStart = 0xFFFFFFFF, readSize = 0xFFFFFFFF;
-		parseLBN(filename, &sectorStart, &readSize);
+		ParseLBNCached(filename, &sectorStart, &readSize);
 
 		PSPFileInfo fileInfo;
 		fileInfo.name = filename;
@@ -736,7 +887,10 @@ void ISOFileSystem::DoState(PointerWrap &p) {
 	Do(p, n);
 
 	if (p.mode == p.MODE_READ) {
-		entries.clear();
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			entries.clear();
+		}
 		for (int i = 0; i < n; ++i) {
 			u32 fd = 0;
 			OpenFileEntry of;
@@ -758,6 +912,7 @@ void ISOFileSystem::DoState(PointerWrap &p) {
 				of.file = NULL;
 			}
 
+			std::lock_guard<std::mutex> guard(lock_);
 			entries[fd] = of;
 		}
 	} else {
@@ -19,6 +19,8 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "FileSystem.h"
 
@@ -56,6 +58,7 @@ class ISOFileSystem : public IFileSystem {
 
 	bool ComputeRecursiveDirSizeIfFast(const std::string &path, int64_t *size) override { return false; }
 	void Describe(char *buf, size_t size) const override { snprintf(buf, size, "ISO"); }  // TODO: Ask the fileLoader about the origins
+	bool SupportsConcurrentIO() const override { return true; }
 
 private:
 	struct TreeEntry {
@@ -86,6 +89,14 @@ class ISOFileSystem : public IFileSystem {
 		bool isBlockSectorMode;  // "umd:" mode: all sizes and offsets are in 2048 byte chunks
 		u32 sectorStart;
 		u32 openSize;
+		// For access pattern hints, not saved in states.
+		u32 lastReadEnd = 0;  // Sector after the previous read.
+		u32 hintedEnd = 0;  // Sector up to which readahead has been hinted.
+	};
+
+	struct LBNRange {
+		u32 sectorStart;
+		u32 readSize;
 	};
 
 	typedef std::map<u32, OpenFileEntry> EntryMap;
@@ -94,10 +105,22 @@ class ISOFileSystem : public IFileSystem {
 	TreeEntry *treeroot;
 	BlockDevice *blockDevice;
 	u32 lastReadBlock_;
+	// Reads run outside MetaFileSystem's lock, so changes to entries and block device reads
+	// (most devices aren't thread safe) also need this. Mapped images are copied without it.
+	std::mutex lock_;
 
 	TreeEntry entireISO;
 
+	// Lowercased full paths (without the leading slash) of every entry in the directories read so far.
+	// Null for paths that are ambiguous, because of names that only differ in case.
+	std::unordered_map<std::string, TreeEntry *> pathIndex_;
+	// Parsed "/sce_lbn" pseudo-paths, games tend to reuse the same few.
+	std::unordered_map<std::string, LBNRange> lbnCache_;
+
 	void ReadDirectory(TreeEntry *root);
+	TreeEntry *WalkPath(const std::string &path, size_t pathIndex, bool catchError);
+	void ParseLBNCached(const std::string &filename, u32 *sectorStart, u32 *readSize);
+	void AdviseRead(OpenFileEntry &e, u32 firstSector, u32 endSector, u32 fileEndSector);
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
 	std::string EntryFullPath(TreeEntry *e);
 };
@@ -150,6 +173,7 @@ class ISOBlockSystem : public IFileSystem {
 		return isoFileSystem_->DevType(handle);
 	}
 	FileSystemFlags Flags() const override { return isoFileSystem_->Flags(); }
+	bool SupportsConcurrentIO() const override { return isoFileSystem_->SupportsConcurrentIO(); }
 	u64      FreeDiskSpace(const std::string &path) override { return isoFileSystem_->FreeDiskSpace(path); }
 
 	size_t WriteFile(u32 handle, const u8 *pointer, s64 size) override {
@@ -175,6 +175,20 @@ IFileSystem *MetaFileSystem::GetHandleOwner(u32 handle) const
 	return nullptr;
 }
 
+// Keeps the file system alive while it's used outside the lock.
+std::shared_ptr<IFileSystem> MetaFileSystem::GetHandleOwnerRef(u32 handle) const
+{
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	for (size_t i = 0; i < fileSystems.size(); i++)
+	{
+		if (fileSystems[i].system->OwnsHandle(handle))
+			return fileSystems[i].system;
+	}
+
+	// Not found
+	return nullptr;
+}
+
 int MetaFileSystem::MapFilePath(const std::string &_inpath, std::string &outpath, MountPoint **system)
 {
 	int error = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
@@ -529,42 +543,46 @@ void MetaFileSystem::CloseFile(u32 handle)
 
 size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
-		return sys->ReadFile(handle, pointer, size);
-	else
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	std::shared_ptr<IFileSystem> sys = GetHandleOwnerRef(handle);
+	if (!sys)
 		return 0;
+	if (sys->SupportsConcurrentIO())
+		guard.unlock();
+	return sys->ReadFile(handle, pointer, size);
 }
 
 size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
-		return sys->WriteFile(handle, pointer, size);
-	else
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	std::shared_ptr<IFileSystem> sys = GetHandleOwnerRef(handle);
+	if (!sys)
 		return 0;
+	if (sys->SupportsConcurrentIO())
+		guard.unlock();
+	return sys->WriteFile(handle, pointer, size);
 }
 
 size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
-		return sys->ReadFile(handle, pointer, size, usec);
-	else
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	std::shared_ptr<IFileSystem> sys = GetHandleOwnerRef(handle);
+	if (!sys)
 		return 0;
+	if (sys->SupportsConcurrentIO())
+		guard.unlock();
+	return sys->ReadFile(handle, pointer, size, usec);
 }
 
 size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
-		return sys->WriteFile(handle, pointer, size, usec);
-	else
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	std::shared_ptr<IFileSystem> sys = GetHandleOwnerRef(handle);
+	if (!sys)
 		return 0;
+	if (sys->SupportsConcurrentIO())
+		guard.unlock();
+	return sys->WriteFile(handle, pointer, size, usec);
 }
 
 size_t MetaFileSystem::SeekFile(u32 handle, s32 position, FileMove type)
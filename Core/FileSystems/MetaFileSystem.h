@@ -73,6 +73,7 @@ class MetaFileSystem : public IHandleAllocator, public IFileSystem {
 	IFileSystem *GetSystem(const std::string &prefix);
 	IFileSystem *GetSystemFromFilename(const std::string &filename);
 	IFileSystem *GetHandleOwner(u32 handle) const;
+	std::shared_ptr<IFileSystem> GetHandleOwnerRef(u32 handle) const;
 	FileSystemFlags FlagsFromFilename(const std::string &filename) {
 		IFileSystem *sys = GetSystemFromFilename(filename);
 		return sys ? sys->Flags() : FileSystemFlags::NONE;
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cstring>
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Core/FileLoaders/DiskCachingFileLoader.h"
+#include "Core/FileSystems/TracingBlockDevice.h"
+
+static const char *const TRACE_EXTENSION = ".ppat";
+static const char TRACE_MAGIC[4] = { 'P', 'P', 'A', 'T' };
+
+struct TraceFileHeader {
+	char magic[4];
+	u32_le version;
+	u32_le numBlocks;
+	u32_le numRanges;
+};
+
+TracingBlockDevice::TracingBlockDevice(BlockDevice *device, FileLoader *fileLoader)
+	: BlockDevice(fileLoader), device_(device) {
+	errorString_ = device_->ErrorString();
+	tracePath_ = DiskCachingFileLoaderCache::MakeCacheFilePath(fileLoader->GetPath(), TRACE_EXTENSION);
+	seen_.resize(device_->GetNumBlocks());
+
+	if (LoadTrace()) {
+		std::string error;
+		prefetchDevice_ = ConstructBlockDevice(fileLoader, &error);
+	}
+	if (prefetchDevice_) {
+		thread_ = std::thread([this] {
+			SetCurrentThreadName("DiscPrefetch");
+			AndroidJNIThreadContext jniContext;
+			PrefetchThread();
+		});
+	}
+}
+
+TracingBlockDevice::~TracingBlockDevice() {
+	{
+		std::lock_guard<std::mutex> guard(traceLock_);
+		stop_ = true;
+		cursorMoved_.notify_one();
+	}
+	{
+		std::lock_guard<std::mutex> guard(demandLock_);
+		demandDone_.notify_one();
+	}
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+
+	if (!trace_.empty()) {
+		INFO_LOG(Log::FileSystem, "Disc prefetch: replayed %d of %d ranges, game followed the trace to %d", prefetchedRanges_, (int)trace_.size(), (int)cursor_);
+	}
+	SaveTrace();
+	delete prefetchDevice_;
+	delete device_;
+}
+
+bool TracingBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
+	Record(blockNumber, 1);
+	BeginDemandRead();
+	bool result = device_->ReadBlock(blockNumber, outPtr, uncached);
+	EndDemandRead();
+	return result;
+}
+
+bool TracingBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	Record(minBlock, count);
+	BeginDemandRead();
+	bool result = device_->ReadBlocks(minBlock, count, outPtr);
+	EndDemandRead();
+	return result;
+}
+
+const u8 *TracingBlockDevice::GetBlockPointer(u32 minBlock, u32 count) {
+	Record(minBlock, count);
+	return device_->GetBlockPointer(minBlock, count);
+}
+
+void TracingBlockDevice::Advise(u32 minBlock, u32 count, MappedFileAdvice advice) {
+	device_->Advise(minBlock, count, advice);
+}
+
+void TracingBlockDevice::BeginDemandRead() {
+	std::lock_guard<std::mutex> guard(demandLock_);
+	demandReads_++;
+}
+
+void TracingBlockDevice::EndDemandRead() {
+	std::lock_guard<std::mutex> guard(demandLock_);
+	if (--demandReads_ == 0) {
+		demandDone_.notify_one();
+	}
+}
+
+void TracingBlockDevice::WaitForDemandReads() {
+	// Let the game go first.
+	std::unique_lock<std::mutex> demandGuard(demandLock_);
+	demandDone_.wait(demandGuard, [&] { return demandReads_ == 0 || stop_; });
+}
+
+void TracingBlockDevice::Record(u32 minBlock, u32 count) {
+	std::lock_guard<std::mutex> guard(traceLock_);
+	UpdateCursor(minBlock);
+	if (recorded_.size() >= MAX_RANGES) {
+		return;
+	}
+
+	const u32 endBlock = std::min(minBlock + count, (u32)seen_.size());
+	for (u32 block = minBlock; block < endBlock; ++block) {
+		if (seen_[block]) {
+			continue;
+		}
+		seen_[block] = true;
+		if (!recorded_.empty() && recorded_.back().block + recorded_.back().count == block) {
+			recorded_.back().count = recorded_.back().count + 1;
+		} else if (recorded_.size() < MAX_RANGES) {
+			recorded_.push_back(Range{ block, 1 });
+		}
+	}
+}
+
+// traceLock_ must be held.
+void TracingBlockDevice::UpdateCursor(u32 minBlock) {
+	auto contains = [&](size_t i) {
+		return minBlock >= trace_[i].block && minBlock < trace_[i].block + trace_[i].count;
+	};
+
+	// Usually the game is just a little further along.
+	size_t found = trace_.size();
+	const size_t end = std::min(trace_.size(), cursor_ + CURSOR_SEARCH);
+	for (size_t i = cursor_; i < end; ++i) {
+		if (contains(i)) {
+			found = i;
+			break;
+		}
+	}
+	if (found == trace_.size()) {
+		// Otherwise it went back, or skipped ahead, like when returning to a menu.
+		auto it = std::upper_bound(byBlock_.begin(), byBlock_.end(), std::make_pair(minBlock, (u32)0xFFFFFFFF));
+		if (it == byBlock_.begin() || !contains((--it)->second)) {
+			return;
+		}
+		found = it->second;
+	}
+
+	if (found != cursor_) {
+		// When going back, what came after may have been flushed from the caches since, so replay it again.
+		// Going forward, no point in reading what the game just read.
+		next_ = found < cursor_ ? found + 1 : std::max(next_, found + 1);
+		cursor_ = found;
+		cursorMoved_.notify_one();
+	}
+}
+
+bool TracingBlockDevice::LoadTrace() {
+	std::string data;
+	if (!File::Exists(tracePath_) || !File::ReadBinaryFileToString(tracePath_, &data)) {
+		return false;
+	}
+
+	TraceFileHeader header;
+	if (data.size() < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != TRACE_VERSION) {
+		WARN_LOG(Log::FileSystem, "Ignoring disc access trace '%s' with the wrong magic or version", tracePath_.ToVisualString().c_str());
+		return false;
+	}
+	if (header.numBlocks != device_->GetNumBlocks() || data.size() - sizeof(header) != (size_t)header.numRanges * sizeof(Range)) {
+		// Most likely the image was replaced, the trace will be rerecorded.
+		WARN_LOG(Log::FileSystem, "Ignoring mismatching disc access trace '%s'", tracePath_.ToVisualString().c_str());
+		return false;
+	}
+
+	trace_.resize(header.numRanges);
+	memcpy(trace_.data(), data.data() + sizeof(header), data.size() - sizeof(header));
+	prefix_.resize(trace_.size() + 1);
+	prefix_[0] = 0;
+	for (size_t i = 0; i < trace_.size(); ++i) {
+		prefix_[i + 1] = prefix_[i] + trace_[i].count;
+	}
+	byBlock_.reserve(trace_.size());
+	for (size_t i = 0; i < trace_.size(); ++i) {
+		byBlock_.emplace_back(trace_[i].block, (u32)i);
+	}
+	std::sort(byBlock_.begin(), byBlock_.end());
+
+	INFO_LOG(Log::FileSystem, "Disc prefetch: loaded %d ranges (%lld bytes) from '%s'", (int)trace_.size(), (long long)prefix_.back() * GetBlockSize(), tracePath_.ToVisualString().c_str());
+	return !trace_.empty();
+}
+
+void TracingBlockDevice::SaveTrace() {
+	// If the game was quit early, keep the longer trace from a previous session.
+	if (recorded_.empty() || recorded_.size() < trace_.size()) {
+		return;
+	}
+
+	TraceFileHeader header{};
+	memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+	header.version = TRACE_VERSION;
+	header.numBlocks = device_->GetNumBlocks();
+	header.numRanges = (u32)recorded_.size();
+
+	std::string data;
+	data.append((const char *)&header, sizeof(header));
+	data.append((const char *)recorded_.data(), recorded_.size() * sizeof(Range));
+	if (!File::WriteDataToFile(false, data.data(), data.size(), tracePath_)) {
+		WARN_LOG(Log::FileSystem, "Failed to write disc access trace '%s'", tracePath_.ToVisualString().c_str());
+	}
+}
+
+void TracingBlockDevice::PrefetchThread() {
+	std::vector<u8> buffer(PREFETCH_CHUNK * GetBlockSize());
+	const u32 numBlocks = prefetchDevice_->GetNumBlocks();
+
+	std::unique_lock<std::mutex> guard(traceLock_);
+	while (!stop_) {
+		if (next_ >= trace_.size() || prefix_[next_] - prefix_[cursor_] >= PREFETCH_WINDOW) {
+			// Wait for the game to catch up (or to go back.)
+			cursorMoved_.wait(guard);
+			continue;
+		}
+
+		const Range range = trace_[next_++];
+		prefetchedRanges_++;
+		guard.unlock();
+
+		const u32 endBlock = std::min((u32)range.block + (u32)range.count, numBlocks);
+		s64 offset = 0, size = 0;
+		if (range.block < endBlock && prefetchDevice_->GetBlockPointer(range.block, endBlock - range.block)) {
+			// Mapped, so the OS can do it for us.
+			prefetchDevice_->Advise(range.block, endBlock - range.block, MappedFileAdvice::WILLNEED);
+		} else if (range.block < endBlock && prefetchDevice_->GetFileRange(range.block, endBlock - range.block, &offset, &size)) {
+			// Just the bytes of the file the game's reads will need. For compressed images, decompressing
+			// them here would only cost time, the game's device decompresses them again anyway.
+			const s64 end = offset + size;
+			for (s64 pos = offset; pos < end && !stop_; pos += buffer.size()) {
+				WaitForDemandReads();
+				fileLoader_->ReadAt(pos, (size_t)std::min((s64)buffer.size(), end - pos), buffer.data());
+			}
+		} else {
+			for (u32 block = range.block; block < endBlock && !stop_; block += PREFETCH_CHUNK) {
+				WaitForDemandReads();
+				prefetchDevice_->ReadBlocks(block, std::min((u32)PREFETCH_CHUNK, endBlock - block), buffer.data());
+			}
+		}
+
+		guard.lock();
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+#include "Core/FileSystems/BlockDevices.h"
+
+// Wraps the block device of the running game, and records which block ranges it reads,
+// in the order they are first read. The trace is saved next to the disk cache files on shutdown.
+//
+// On later boots, the saved trace is replayed on a background thread, a limited distance ahead of
+// where the game currently is in it. The data itself isn't kept here - the point is to pull it
+// through the layers below (disk/RAM caching loaders, the OS page cache) before the game asks
+// for it, which matters a lot on slow storage like SD cards and network mounts. The replay reads
+// the bytes of the image file that the game's reads will need, still compressed for CSO/CHD/PSZ.
+// It uses its own block device to find them, so it doesn't disturb the read-ahead and caches of
+// the game's device.
+class TracingBlockDevice : public BlockDevice {
+public:
+	// Takes ownership of device, which must read from fileLoader.
+	TracingBlockDevice(BlockDevice *device, FileLoader *fileLoader);
+	~TracingBlockDevice();
+
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
+	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	u32 GetNumBlocks() const override { return device_->GetNumBlocks(); }
+	u64 GetUncompressedSize() const override { return device_->GetUncompressedSize(); }
+	bool IsDisc() const override { return device_->IsDisc(); }
+	const u8 *GetBlockPointer(u32 minBlock, u32 count) override;
+	void Advise(u32 minBlock, u32 count, MappedFileAdvice advice) override;
+
+private:
+	struct Range {
+		u32_le block;
+		u32_le count;
+	};
+
+	void Record(u32 minBlock, u32 count);
+	void UpdateCursor(u32 minBlock);
+	void BeginDemandRead();
+	void EndDemandRead();
+	void WaitForDemandReads();
+	bool LoadTrace();
+	void SaveTrace();
+	void PrefetchThread();
+
+	enum {
+		TRACE_VERSION = 1,
+		// Once the game leaves the trace, there's no point in keeping on recording.
+		MAX_RANGES = 65536,
+		// How far to search forward for the current read when following the trace.
+		CURSOR_SEARCH = 256,
+		// How far ahead of the game to replay, in blocks (8 MB.) Keeps the RAM caching
+		// loader from being flushed before the data is used.
+		PREFETCH_WINDOW = 4096,
+		PREFETCH_CHUNK = 64,
+	};
+
+	BlockDevice *device_;
+	// Only used by the prefetch thread.
+	BlockDevice *prefetchDevice_ = nullptr;
+	Path tracePath_;
+
+	// The prefetch thread waits while the game is reading.
+	std::mutex demandLock_;
+	std::condition_variable demandDone_;
+	int demandReads_ = 0;
+
+	std::mutex traceLock_;
+	std::condition_variable cursorMoved_;
+	std::vector<Range> recorded_;
+	std::vector<bool> seen_;
+	std::vector<Range> trace_;
+	// prefix_[i] is the number of blocks in trace_[0, i), to measure the prefetch distance.
+	std::vector<u64> prefix_;
+	// (first block, index in trace_), sorted by block, to find where the game is when it jumps around.
+	std::vector<std::pair<u32, u32>> byBlock_;
+	size_t cursor_ = 0;
+	size_t next_ = 0;
+	std::atomic<bool> stop_{};
+	int prefetchedRanges_ = 0;
+	std::thread thread_;
+};
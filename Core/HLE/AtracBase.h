@@ -168,6 +168,10 @@ struct InputBuffer {
 };
 
 class AudioDecoder;
+
+// A fresh decoder for the codec, as used by the contexts.
+AudioDecoder *CreateAtracDecoder(int codecType, int bytesPerFrame, int channels);
+
 class PointerWrap;
 struct Track;
 
@@ -301,11 +301,7 @@ void Atrac::CalculateStreamInfo(u32 *outReadOffset) {
 	}
 }
 
-void AtracBase::CreateDecoder(int codecType, int bytesPerFrame, int channels) {
-	if (decoder_) {
-		delete decoder_;
-	}
-
+AudioDecoder *CreateAtracDecoder(int codecType, int bytesPerFrame, int channels) {
 	// First, init the standalone decoder.
 	if (codecType == PSP_CODEC_AT3) {
 		// TODO: This is maybe not entirely reliable? Mui Mui house in LocoRoco 2 fails. Although also fails
@@ -320,10 +316,17 @@ void AtracBase::CreateDecoder(int codecType, int bytesPerFrame, int channels) {
 		extraData[6] = jointStereo;
 		extraData[8] = jointStereo;
 		extraData[10] = 1;
-		decoder_ = CreateAtrac3Audio(channels, bytesPerFrame, extraData, sizeof(extraData));
+		return CreateAtrac3Audio(channels, bytesPerFrame, extraData, sizeof(extraData));
 	} else {
-		decoder_ = CreateAtrac3PlusAudio(channels, bytesPerFrame);
+		return CreateAtrac3PlusAudio(channels, bytesPerFrame);
+	}
+}
+
+void AtracBase::CreateDecoder(int codecType, int bytesPerFrame, int channels) {
+	if (decoder_) {
+		delete decoder_;
 	}
+	decoder_ = CreateAtracDecoder(codecType, bytesPerFrame, channels);
 }
 
 int Atrac::GetBufferInfoForResetting(AtracResetBufferInfo *bufferInfo, int sample, bool *delay) {
@@ -294,6 +294,7 @@ int Atrac2::RemainingFrames() const {
 }
 
 Atrac2::Atrac2(u32 contextAddr, int codecType) {
+	pcmHistory_.Reset();
 	if (contextAddr) {
 		context_ = PSPPointer<SceAtracContext>::Create(contextAddr);
 		// First-time initialization. The rest is initialized in SetData.
@@ -312,6 +313,7 @@ Atrac2::Atrac2(u32 contextAddr, int codecType) {
 
 Atrac2::~Atrac2() {
 	DumpBufferToFile();
+	ReleasePcmCache();
 	// Nothing else to do here, the context is freed by the HLE.
 }
 
@@ -355,7 +357,10 @@ void Atrac2::DoState(PointerWrap &p) {
 
 	const SceAtracIdInfo &info = context_->info;
 	if (p.mode == p.MODE_READ && info.state != ATRAC_STATUS_NO_DATA) {
+		ReleasePcmCache();
 		CreateDecoder(info.codec, info.sampleSize, info.numChan);
+		pcmHistory_.Reset();
+		StartPcmCache();
 	}
 }
 
@@ -643,6 +648,7 @@ int Atrac2::AddStreamData(u32 bytesToAdd) {
 		const int newFileOffset = info.streamDataByte + info.dataOff + bytesToAdd;
 		if (newFileOffset == info.fileDataEnd) {
 			info.state = ATRAC_STATUS_ALL_DATA_LOADED;
+			StartPcmCache();
 		} else if (newFileOffset > info.fileDataEnd) {
 			return SCE_ERROR_ATRAC_ADD_DATA_IS_TOO_BIG;
 		}
@@ -868,9 +874,25 @@ u32 Atrac2::DecodeInternal(u32 outbufAddr, int *SamplesNum, int *finish) {
 		return SCE_ERROR_ATRAC_API_FAIL;
 	}
 
+	const u8 *packet = Memory::GetPointerUnchecked(inAddr);
+	const int packetOffset = info.curFileOff - info.dataOff;
 	int bytesConsumed = 0;
 	int outSamples = 0;
-	if (!decoder_->Decode(Memory::GetPointerUnchecked(inAddr), info.sampleSize, &bytesConsumed, outputChannels_, outPtr, &outSamples)) {
+	bool decoded;
+	if (pcmCache_ && DecodeFromPcmCache(packetOffset, packet, outPtr)) {
+		bytesConsumed = info.sampleSize;
+		decoded = true;
+	} else {
+		CatchUpDecoder();
+		decoded = decoder_->Decode(packet, info.sampleSize, &bytesConsumed, outputChannels_, outPtr, &outSamples);
+		if (decoded && pcmCache_ && outPtr && outSamples == info.SamplesPerFrame()) {
+			// Likely the first time through after a loop jump, the next ones will hit.
+			pcmCache_->Add(packetOffset, pcmHistory_, outPtr);
+		}
+	}
+	pcmHistory_.Push(packetOffset);
+
+	if (!decoded) {
 		// Decode failed.
 		*finish = 0;
 		// TODO: The error code here varies based on what the problem is, but not sure of the right values.
@@ -984,9 +1006,12 @@ int Atrac2::SetData(const Track &track, u32 bufferAddr, u32 readSize, u32 buffer
 
 	SceAtracIdInfo &info = context_->info;
 
+	ReleasePcmCache();
 	CreateDecoder(info.codec, info.sampleSize, info.numChan);
+	pcmHistory_.Reset();
 
 	outputChannels_ = outputChannels;
+	StartPcmCache();
 
 	INFO_LOG(Log::Atrac,
 		"Atrac: sampleSize: %d buffer: %08x bufferByte: %d firstValidSample: %d\n"
@@ -1040,6 +1065,68 @@ void Atrac2::WrapLastPacket() {
 	}
 }
 
+void Atrac2::StartPcmCache() {
+	const SceAtracIdInfo &info = context_->info;
+	if (!g_Config.bAtracPcmCache || pcmCache_ || info.state != ATRAC_STATUS_ALL_DATA_LOADED || info.fileDataEnd <= info.dataOff) {
+		return;
+	}
+	const u32 size = info.fileDataEnd - info.dataOff;
+	const u8 *data = Memory::GetPointerRange(info.buffer + info.dataOff, size);
+	if (data) {
+		pcmCache_ = AtracPcmCache::Get(info.codec, info.sampleSize, info.numChan, outputChannels_, info.SamplesPerFrame(), data, size);
+	}
+}
+
+// The decoder must not be behind when calling this (see CatchUpDecoder), unless it's about to be recreated.
+void Atrac2::ReleasePcmCache() {
+	if (pcmCache_) {
+		pcmCache_->SaveIfChanged();
+		pcmCache_.reset();
+	}
+	decoderBehind_ = false;
+}
+
+// Uses the cached frame for the packet, if there's one for the current decoder history. Without an
+// output buffer (skipped frames), nothing needs to be read, as long as the packet decodes.
+bool Atrac2::DecodeFromPcmCache(int packetOffset, const u8 *packet, int16_t *outPtr) {
+	// Seeking to the start can read a packet before the data.
+	if (!pcmCache_->Ready() || !pcmCache_->InRange(packetOffset)) {
+		return false;
+	}
+	if (!pcmCache_->SamePacket(packetOffset, packet)) {
+		WARN_LOG(Log::Atrac, "Atrac data changed at %08x, no longer using the PCM cache", packetOffset);
+		CatchUpDecoder();
+		ReleasePcmCache();
+		return false;
+	}
+	if (outPtr ? !pcmCache_->Read(packetOffset, pcmHistory_, outPtr) : !pcmCache_->HasFrame(packetOffset)) {
+		return false;
+	}
+	decoderBehind_ = true;
+	return true;
+}
+
+// Recreates the decoder and feeds it the last few packets again, which gets it into the same state as
+// if it had decoded everything the cache served (AtracPcmCache checks that for every track.)
+void Atrac2::CatchUpDecoder() {
+	if (!decoderBehind_) {
+		return;
+	}
+	const SceAtracIdInfo &info = context_->info;
+	CreateDecoder(info.codec, info.sampleSize, info.numChan);
+	for (int i = 0; i < AtracPacketHistory::SIZE; i++) {
+		const int offset = pcmHistory_.offsets[i];
+		if (offset == AtracPacketHistory::NONE) {
+			continue;
+		}
+		const u8 *packet = pcmCache_->InRange(offset) ? pcmCache_->Packet(offset) : Memory::GetPointerRange(info.buffer + info.dataOff + offset, info.sampleSize);
+		if (packet) {
+			decoder_->Decode(packet, info.sampleSize, nullptr, outputChannels_, nullptr, nullptr);
+		}
+	}
+	decoderBehind_ = false;
+}
+
 u32 Atrac2::SkipFrames(int *skipCount) {
 	SceAtracIdInfo &info = context_->info;
 	*skipCount = 0;
@@ -1119,7 +1206,9 @@ void Atrac2::InitLowLevel(const Atrac3LowLevelParams &params, int codecType) {
 	info.dataOff = 0;
 	info.decodePos = 0;
 	info.state = ATRAC_STATUS_LOW_LEVEL;
+	ReleasePcmCache();
 	CreateDecoder(codecType, info.sampleSize, info.numChan);
+	pcmHistory_.Reset();
 }
 
 int Atrac2::DecodeLowLevel(const u8 *srcData, int *bytesConsumed, s16 *dstData, int *bytesWritten) {
@@ -1144,6 +1233,9 @@ int Atrac2::DecodeLowLevel(const u8 *srcData, int *bytesConsumed, s16 *dstData,
 
 void Atrac2::CheckForSas() {
 	SceAtracIdInfo &info = context_->info;
+	// Sas decodes on its own, so the decoder has to be where the skipped frames left it.
+	CatchUpDecoder();
+	ReleasePcmCache();
 	if (info.numChan != 1) {
 		WARN_LOG(Log::Atrac, "Caller forgot to set channels to 1");
 	}
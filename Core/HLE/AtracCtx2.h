@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 
 #include "Core/HLE/AtracBase.h"
+#include "Core/HLE/AtracPcmCache.h"
 
 class Atrac2 : public AtracBase {
 public:
@@ -68,6 +70,11 @@ class Atrac2 : public AtracBase {
 
 	void DumpBufferToFile();
 
+	void StartPcmCache();
+	void ReleasePcmCache();
+	bool DecodeFromPcmCache(int packetOffset, const u8 *packet, int16_t *outPtr);
+	void CatchUpDecoder();
+
 	// Just the current decoded frame, in order to be able to cut off the first part of it
 	// to write the initial partial frame.
 	// Does not need to be saved.
@@ -79,4 +86,11 @@ class Atrac2 : public AtracBase {
 
 	std::vector<u8> dumpBuffer_;  // Used for dumping audio data to files.
 	bool dumped_ = false;  // Whether we already dumped the audio data to a file.
+
+	// Decoded frames of the whole track, if enabled (see AtracPcmCache.h.) Not saved, recreated on load.
+	std::shared_ptr<AtracPcmCache> pcmCache_;
+	// The packets decoder_ would have seen since it was created, whether or not they came from the cache.
+	AtracPacketHistory pcmHistory_;
+	// Set when frames were served from the cache, decoder_ then needs CatchUpDecoder before use.
+	bool decoderBehind_ = false;
 };
@@ -0,0 +1,334 @@
+#include <algorithm>
+#include <cstring>
+#include <list>
+
+#include <zstd.h>
+
+#include "ext/xxhash.h"
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
+#include "Core/Config.h"
+#include "Core/HLE/AtracBase.h"
+#include "Core/HLE/AtracPcmCache.h"
+#include "Core/HW/SimpleAudioDec.h"
+#include "Core/System.h"
+
+static const char *const CACHE_EXTENSION = ".apcm";
+static const u32 CACHE_MAGIC = 0x4D435041;  // "APCM"
+static const u32 CACHE_VERSION = 1;
+// PCM doesn't compress much whatever the level, so go for speed.
+static const int CACHE_ZSTD_LEVEL = 1;
+// Frames added on top of the straight decode, for loop jumps and seeks.
+static const size_t MAX_ADDED_FRAMES = 256;
+// Tracks kept in memory after the last context using them is gone, since games tend to set the
+// same BGM again (on every scene change, for example.)
+static const size_t MAX_IDLE_BYTES = 64 * 1024 * 1024;
+// How many places of each decoded track are checked for the decoder state reaching further back than
+// AtracPacketHistory::SIZE packets.
+static const int HISTORY_CHECKS = 8;
+
+struct AtracPcmFileHeader {
+	u32 magic;
+	u32 version;
+	u32 samplesPerFrame;
+	u32 numFrames;
+};
+
+static std::mutex g_cachesLock;
+// Most recently used first.
+static std::list<std::shared_ptr<AtracPcmCache>> g_caches;
+
+static Path CacheDirectory() {
+	return GetSysDirectory(DIRECTORY_APP_CACHE) / "atracpcm";
+}
+
+// Deletes the least recently used tracks over the size limit, but never the one just written.
+static void TrimCacheDirectory(const Path &dir, const std::string &keep, u64 maxBytes) {
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(dir, &files, "apcm:");
+	std::sort(files.begin(), files.end(), [](const File::FileInfo &a, const File::FileInfo &b) {
+		return a.mtime > b.mtime;
+	});
+
+	u64 totalBytes = 0;
+	for (const File::FileInfo &file : files) {
+		if (file.isDirectory) {
+			continue;
+		}
+		totalBytes += file.size;
+		if (totalBytes > maxBytes && file.name != keep) {
+			File::Delete(file.fullName);
+		}
+	}
+}
+
+std::shared_ptr<AtracPcmCache> AtracPcmCache::Get(int codecType, int bytesPerFrame, int channels, int outputChannels, int samplesPerFrame, const u8 *data, u32 size) {
+	if (!g_threadManager.IsInitialized() || bytesPerFrame <= 0 || size < (u32)bytesPerFrame) {
+		return nullptr;
+	}
+
+	const u64 hash = XXH3_64bits(data, size);
+	std::lock_guard<std::mutex> guard(g_cachesLock);
+	for (auto it = g_caches.begin(); it != g_caches.end(); ++it) {
+		const AtracPcmCache &cache = **it;
+		if (cache.hash_ == hash && cache.data_.size() == size && cache.codecType_ == codecType && cache.bytesPerFrame_ == bytesPerFrame &&
+			cache.channels_ == channels && cache.outputChannels_ == outputChannels && cache.samplesPerFrame_ == samplesPerFrame) {
+			g_caches.splice(g_caches.begin(), g_caches, it);
+			return g_caches.front();
+		}
+	}
+
+	auto cache = std::make_shared<AtracPcmCache>(codecType, bytesPerFrame, channels, outputChannels, samplesPerFrame, hash, data, size);
+	g_caches.push_front(cache);
+
+	size_t idleBytes = 0;
+	for (auto it = g_caches.begin(); it != g_caches.end(); ) {
+		// Anything still being built is referenced by its task.
+		if (it->use_count() == 1) {
+			std::lock_guard<std::mutex> cacheGuard((*it)->lock_);
+			idleBytes += (*it)->pcm_.size() * sizeof(s16) + (*it)->data_.size();
+			if (idleBytes > MAX_IDLE_BYTES) {
+				it = g_caches.erase(it);
+				continue;
+			}
+		}
+		++it;
+	}
+
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::CPU_COMPUTE, TaskPriority::LOW, [cache]() {
+		cache->Build();
+	}));
+	return cache;
+}
+
+AtracPcmCache::AtracPcmCache(int codecType, int bytesPerFrame, int channels, int outputChannels, int samplesPerFrame, u64 hash, const u8 *data, u32 size)
+	: codecType_(codecType), bytesPerFrame_(bytesPerFrame), channels_(channels), outputChannels_(outputChannels), samplesPerFrame_(samplesPerFrame),
+	hash_(hash), data_(data, data + size) {
+	maxFrames_ = size / bytesPerFrame + MAX_ADDED_FRAMES;
+}
+
+std::string AtracPcmCache::Filename() const {
+	return StringFromFormat("%016llx_%d_%d_%d_%d%s", (unsigned long long)hash_, codecType_, bytesPerFrame_, channels_, outputChannels_, CACHE_EXTENSION);
+}
+
+void AtracPcmCache::Build() {
+	double st = time_now_d();
+	if (Load()) {
+		INFO_LOG(Log::Atrac, "Atrac PCM cache: loaded %d frames of '%s' in %0.1f ms", (int)frames_.size(), Filename().c_str(), (time_now_d() - st) * 1000.0);
+		ready_ = true;
+	} else if (Decode()) {
+		INFO_LOG(Log::Atrac, "Atrac PCM cache: decoded %d frames of '%s' in %0.1f ms", (int)frames_.size(), Filename().c_str(), (time_now_d() - st) * 1000.0);
+		dirty_ = true;
+		ready_ = true;
+		SaveIfChanged();
+	}
+}
+
+bool AtracPcmCache::Load() {
+	const Path path = CacheDirectory() / Filename();
+	std::string data;
+	if (!File::Exists(path) || !File::ReadBinaryFileToString(path, &data) || data.size() < sizeof(AtracPcmFileHeader)) {
+		return false;
+	}
+
+	AtracPcmFileHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.samplesPerFrame != (u32)samplesPerFrame_ || header.numFrames > maxFrames_) {
+		WARN_LOG(Log::Atrac, "Atrac PCM cache: ignoring mismatching file '%s'", path.ToVisualString().c_str());
+		return false;
+	}
+
+	const size_t frameValues = (size_t)samplesPerFrame_ * outputChannels_;
+	const size_t infoSize = header.numFrames * sizeof(FrameInfo);
+	std::vector<u8> raw(infoSize + header.numFrames * frameValues * sizeof(s16));
+	size_t result = ZSTD_decompress(raw.data(), raw.size(), data.data() + sizeof(header), data.size() - sizeof(header));
+	if (ZSTD_isError(result) || result != raw.size()) {
+		WARN_LOG(Log::Atrac, "Atrac PCM cache: failed to decompress '%s'", path.ToVisualString().c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	frames_.resize(header.numFrames);
+	memcpy(frames_.data(), raw.data(), infoSize);
+	pcm_.resize(header.numFrames * frameValues);
+	memcpy(pcm_.data(), raw.data() + infoSize, pcm_.size() * sizeof(s16));
+	for (u32 i = 0; i < header.numFrames; i++) {
+		const s32 offset = frames_[i].offset;
+		if (!InRange(offset) || offset % bytesPerFrame_ != 0) {
+			WARN_LOG(Log::Atrac, "Atrac PCM cache: bad frame in '%s'", path.ToVisualString().c_str());
+			Clear();
+			return false;
+		}
+		index_.emplace(offset, i);
+	}
+
+	File::ChangeMTime(path, (time_t)time_now_unix_utc());
+	return true;
+}
+
+bool AtracPcmCache::Decode() {
+	const int numPackets = (int)(data_.size() / bytesPerFrame_);
+	const int historySize = AtracPacketHistory::SIZE;
+	const size_t frameValues = (size_t)samplesPerFrame_ * outputChannels_;
+	std::vector<s16> frame(frameValues);
+
+	std::lock_guard<std::mutex> guard(lock_);
+	frames_.reserve(numPackets);
+	pcm_.reserve(numPackets * frameValues);
+
+	std::unique_ptr<AudioDecoder> decoder(CreateAtracDecoder(codecType_, bytesPerFrame_, channels_));
+	AtracPacketHistory history;
+	history.Reset();
+	for (int i = 0; i < numPackets; i++) {
+		const int offset = i * bytesPerFrame_;
+		int outSamples = 0;
+		// Packets that fail to decode are left out, and will fail the same way in the context.
+		if (decoder->Decode(&data_[offset], bytesPerFrame_, nullptr, outputChannels_, frame.data(), &outSamples) && outSamples == samplesPerFrame_) {
+			AddLocked(offset, history, frame.data());
+		}
+		history.Push(offset);
+	}
+
+	// The whole scheme relies on the decoder only depending on the last few packets. Check that decoding
+	// from a fresh decoder that many packets back gives exactly the same frame, in a few places.
+	for (int check = 1; check <= HISTORY_CHECKS && numPackets > historySize; check++) {
+		const int packet = historySize + (int)((s64)(numPackets - 1 - historySize) * check / HISTORY_CHECKS);
+		decoder.reset(CreateAtracDecoder(codecType_, bytesPerFrame_, channels_));
+		for (int i = packet - historySize; i < packet; i++) {
+			decoder->Decode(&data_[i * bytesPerFrame_], bytesPerFrame_, nullptr, outputChannels_, nullptr, nullptr);
+			history.Push(i * bytesPerFrame_);
+		}
+
+		int outSamples = 0;
+		decoder->Decode(&data_[packet * bytesPerFrame_], bytesPerFrame_, nullptr, outputChannels_, frame.data(), &outSamples);
+		auto range = index_.equal_range(packet * bytesPerFrame_);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (frames_[it->second].history == history && memcmp(&pcm_[it->second * frameValues], frame.data(), frameValues * sizeof(s16)) != 0) {
+				WARN_LOG(Log::Atrac, "Atrac PCM cache: decoder state reaches back further than %d packets in '%s', not caching", historySize, Filename().c_str());
+				Clear();
+				return false;
+			}
+		}
+	}
+
+	return !frames_.empty();
+}
+
+bool AtracPcmCache::Save() {
+	const u64 maxBytes = (u64)std::max(g_Config.iAtracPcmCacheSizeMB, 1) * 1024 * 1024;
+	AtracPcmFileHeader header{ CACHE_MAGIC, CACHE_VERSION, (u32)samplesPerFrame_, 0 };
+	std::vector<u8> raw;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		header.numFrames = (u32)frames_.size();
+		const size_t infoSize = frames_.size() * sizeof(FrameInfo);
+		raw.resize(infoSize + pcm_.size() * sizeof(s16));
+		memcpy(raw.data(), frames_.data(), infoSize);
+		memcpy(raw.data() + infoSize, pcm_.data(), pcm_.size() * sizeof(s16));
+	}
+
+	std::vector<u8> buffer(sizeof(header) + ZSTD_compressBound(raw.size()));
+	memcpy(buffer.data(), &header, sizeof(header));
+	size_t compressed = ZSTD_compress(buffer.data() + sizeof(header), buffer.size() - sizeof(header), raw.data(), raw.size(), CACHE_ZSTD_LEVEL);
+
+	const Path dir = CacheDirectory();
+	const std::string filename = Filename();
+	bool success = false;
+	if (!ZSTD_isError(compressed) && (File::Exists(dir) || File::CreateFullPath(dir))) {
+		buffer.resize(sizeof(header) + compressed);
+		success = File::WriteDataToFile(false, buffer.data(), buffer.size(), dir / filename);
+	}
+	if (success) {
+		TrimCacheDirectory(dir, filename, maxBytes);
+	} else {
+		WARN_LOG(Log::Atrac, "Atrac PCM cache: failed to write '%s'", filename.c_str());
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	saving_ = false;
+	return success;
+}
+
+void AtracPcmCache::SaveIfChanged() {
+	// Don't wait for a decode in progress.
+	if (!ready_) {
+		return;
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!dirty_ || saving_) {
+		return;
+	}
+	// Frames added while saving will make it dirty again, for the next call.
+	dirty_ = false;
+	saving_ = true;
+	std::shared_ptr<AtracPcmCache> self = shared_from_this();
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [self]() {
+		self->Save();
+	}));
+}
+
+bool AtracPcmCache::SamePacket(int offset, const u8 *packet) const {
+	return InRange(offset) && memcmp(&data_[offset], packet, bytesPerFrame_) == 0;
+}
+
+bool AtracPcmCache::HasFrame(int offset) {
+	if (!ready_) {
+		return false;
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	return index_.find(offset) != index_.end();
+}
+
+bool AtracPcmCache::Read(int offset, const AtracPacketHistory &history, s16 *out) {
+	if (!ready_) {
+		return false;
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	auto range = index_.equal_range(offset);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (frames_[it->second].history == history) {
+			const size_t frameValues = (size_t)samplesPerFrame_ * outputChannels_;
+			memcpy(out, &pcm_[it->second * frameValues], frameValues * sizeof(s16));
+			return true;
+		}
+	}
+	return false;
+}
+
+void AtracPcmCache::Add(int offset, const AtracPacketHistory &history, const s16 *pcm) {
+	if (!ready_ || !InRange(offset)) {
+		return;
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	if (frames_.size() >= maxFrames_) {
+		return;
+	}
+	auto range = index_.equal_range(offset);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (frames_[it->second].history == history) {
+			return;
+		}
+	}
+	AddLocked(offset, history, pcm);
+	dirty_ = true;
+}
+
+// Lock must be held.
+void AtracPcmCache::AddLocked(int offset, const AtracPacketHistory &history, const s16 *pcm) {
+	const size_t frameValues = (size_t)samplesPerFrame_ * outputChannels_;
+	index_.emplace(offset, (u32)frames_.size());
+	frames_.push_back(FrameInfo{ offset, history });
+	pcm_.insert(pcm_.end(), pcm, pcm + frameValues);
+}
+
+// Lock must be held.
+void AtracPcmCache::Clear() {
+	frames_.clear();
+	pcm_.clear();
+	index_.clear();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Ahead-of-time decoded PCM of whole Atrac tracks, so that Atrac2 can serve the frames of (usually
+// looping BGM) tracks with a memcpy instead of running the decoder on every loop iteration.
+//
+// The decoder isn't stateless: the output for a packet depends on the packets decoded just before
+// it (IMDCT overlap, gain control and filter bank histories.) So each decoded frame is stored along
+// with the packets that preceded it since the decoder was created, and is only used when the
+// context's own history matches exactly. This keeps loop points and seeks sample-accurate.
+//
+// A background task decodes the whole track straight through. The frames right after a loop jump or
+// a seek have a different history, those are decoded normally the first time and then added, so the
+// following loop iterations hit too. Everything is stored zstd compressed on disk, keyed by a hash of
+// the track data, so the next session doesn't need to decode anything.
+//
+// Only tracks that are completely in memory (ATRAC_STATUS_ALL_DATA_LOADED) are cached, since the whole
+// file is needed to decode ahead.
+
+// Offsets (from the start of the track data) of the last packets fed to a decoder, oldest first.
+// NONE means nothing, the decoder was fresh before that.
+struct AtracPacketHistory {
+	// The decoder state only reaches two packets back for both Atrac3 and Atrac3+, this has some margin.
+	// Checked on every track when it's decoded.
+	enum { SIZE = 4 };
+	// Packet offsets are multiples of the packet size, so this can't be one.
+	enum { NONE = -1 };
+
+	s32 offsets[SIZE];
+
+	void Reset() {
+		for (int i = 0; i < SIZE; i++)
+			offsets[i] = NONE;
+	}
+	void Push(int offset) {
+		for (int i = 0; i < SIZE - 1; i++)
+			offsets[i] = offsets[i + 1];
+		offsets[SIZE - 1] = offset;
+	}
+	bool operator ==(const AtracPacketHistory &other) const {
+		for (int i = 0; i < SIZE; i++) {
+			if (offsets[i] != other.offsets[i])
+				return false;
+		}
+		return true;
+	}
+};
+
+class AtracPcmCache : public std::enable_shared_from_this<AtracPcmCache> {
+public:
+	// Returns the cache for the track, shared with other contexts playing it. It isn't Ready() until
+	// it's been loaded from disk or decoded in the background. data is copied.
+	static std::shared_ptr<AtracPcmCache> Get(int codecType, int bytesPerFrame, int channels, int outputChannels, int samplesPerFrame, const u8 *data, u32 size);
+
+	AtracPcmCache(int codecType, int bytesPerFrame, int channels, int outputChannels, int samplesPerFrame, u64 hash, const u8 *data, u32 size);
+
+	bool Ready() const {
+		return ready_;
+	}
+
+	bool InRange(int offset) const {
+		return offset >= 0 && offset + bytesPerFrame_ <= (int)data_.size();
+	}
+	// The packet data as it was when the cache was created. Used to catch a decoder up.
+	const u8 *Packet(int offset) const {
+		return &data_[offset];
+	}
+	bool SamePacket(int offset, const u8 *packet) const;
+	// Whether the packet decoded successfully, that doesn't depend on history.
+	bool HasFrame(int offset);
+
+	// Copies out the frame decoded from the packet at offset after the packets in history, if known.
+	bool Read(int offset, const AtracPacketHistory &history, s16 *out);
+	// Adds a frame decoded outside the cache, like after a loop jump.
+	void Add(int offset, const AtracPacketHistory &history, const s16 *pcm);
+
+	// Writes out the added frames in the background, if there are any. Call when done with the track.
+	void SaveIfChanged();
+
+private:
+	struct FrameInfo {
+		s32 offset;
+		AtracPacketHistory history;
+	};
+
+	std::string Filename() const;
+	void Build();
+	bool Load();
+	bool Decode();
+	bool Save();
+	void AddLocked(int offset, const AtracPacketHistory &history, const s16 *pcm);
+	void Clear();
+
+	int codecType_;
+	int bytesPerFrame_;
+	int channels_;
+	int outputChannels_;
+	int samplesPerFrame_;
+	u64 hash_;
+	std::vector<u8> data_;
+
+	std::atomic<bool> ready_{};
+	std::mutex lock_;
+	std::vector<FrameInfo> frames_;
+	std::vector<s16> pcm_;
+	// Packet offset -> indices in frames_.
+	std::unordered_multimap<s32, u32> index_;
+	size_t maxFrames_ = 0;
+	bool dirty_ = false;
+	bool saving_ = false;
+};
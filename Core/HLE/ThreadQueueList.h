@@ -17,166 +17,139 @@
 
 #pragma once
 
+#include <cstring>
+#include <vector>
+
 #include "Core/HLE/sceKernel.h"
+#include "Common/BitSet.h"
 #include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
 
+// The ready queue: a FIFO of thread ids per priority level, with a bitmap of the non-empty levels.
+// Thread ids are kernel object handles, so the links live in a flat array indexed by them, and
+// everything here is O(1).
 struct ThreadQueueList {
 	// Number of queues (number of priority levels starting at 0.)
 	static const int NUM_QUEUES = 128;
-	// Initial number of threads a single queue can handle.
+	// Only used for the save state format, which stored the size of each queue's array.
 	static const int INITIAL_CAPACITY = 32;
-
-	struct Queue {
-		// Next ever-been-used queue (worse priority.)
-		Queue *next;
-		// First valid item in data.
-		int first;
-		// One after last valid item in data.
-		int end;
-		// A too-large array with room on the front and end.
-		SceUID *data;
-		// Size of data array.
-		int capacity;
-
-		inline int size() const {
-			return end - first;
-		}
-		inline bool empty() const {
-			return first == end;
-		}
-		inline int full() const {
-			return end == capacity;
-		}
-	};
+	static const int MAX_THREADS = KernelObjectPool::maxCount;
 
 	ThreadQueueList() {
-		memset(queues, 0, sizeof(queues));
-		first = invalid();
-	}
-
-	~ThreadQueueList() {
 		clear();
 	}
 
 	// Only for debugging, returns priority level.
-	int contains(const SceUID uid) {
-		for (int i = 0; i < NUM_QUEUES; ++i) {
-			if (queues[i].data == nullptr)
-				continue;
-
-			Queue *cur = &queues[i];
-			for (int j = cur->first; j < cur->end; ++j) {
-				if (cur->data[j] == uid)
-					return i;
-			}
-		}
-
-		return -1;
+	int contains(const SceUID uid) const {
+		const int index = indexOf(uid);
+		if (index < 0 || !nodes[index].queued)
+			return -1;
+		return nodes[index].priority;
 	}
 
 	inline SceUID pop_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
+		const int priority = firstPriority();
+		if (priority < 0) {
+			_dbg_assert_msg_(false, "ThreadQueueList should not be empty.");
+			return 0;
 		}
-
-		_dbg_assert_msg_(false, "ThreadQueueList should not be empty.");
-		return 0;
+		return pop(priority);
 	}
 
 	inline SceUID pop_first_better(u32 priority) {
-		Queue *cur = first;
 		// Don't bother looking past (worse than) this priority.
-		Queue *stop = &queues[priority];
-		while (cur < stop) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
-
-		return 0;
+		const int best = firstPriority();
+		if (best < 0 || best >= (int)priority)
+			return 0;
+		return pop(best);
 	}
 
-	inline SceUID peek_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first];
-			cur = cur->next;
-		}
-
-		return 0;
+	inline SceUID peek_first() const {
+		const int priority = firstPriority();
+		if (priority < 0)
+			return 0;
+		return uidOf(queues[priority].head);
 	}
 
 	inline void push_front(u32 priority, const SceUID threadID) {
-		Queue *cur = &queues[priority];
-		cur->data[--cur->first] = threadID;
-		// If we ran out of room toward the front, add more room for next time.
-		if (cur->first == 0)
-			rebalance(priority);
+		const int index = unlinkForPush(threadID);
+		if (index < 0)
+			return;
+		Queue &cur = queues[priority];
+		Node &node = nodes[index];
+		node.priority = priority;
+		node.queued = true;
+		node.prev = -1;
+		node.next = cur.head;
+		if (cur.head != -1)
+			nodes[cur.head].prev = index;
+		else
+			cur.tail = index;
+		cur.head = index;
+		markUsed(priority);
 	}
 
 	inline void push_back(u32 priority, const SceUID threadID) {
-		Queue *cur = &queues[priority];
-		cur->data[cur->end++] = threadID;
-		if (cur->full())
-			rebalance(priority);
+		const int index = unlinkForPush(threadID);
+		if (index < 0)
+			return;
+		Queue &cur = queues[priority];
+		Node &node = nodes[index];
+		node.priority = priority;
+		node.queued = true;
+		node.next = -1;
+		node.prev = cur.tail;
+		if (cur.tail != -1)
+			nodes[cur.tail].next = index;
+		else
+			cur.head = index;
+		cur.tail = index;
+		markUsed(priority);
 	}
 
 	inline void remove(u32 priority, const SceUID threadID) {
-		Queue *cur = &queues[priority];
-		_dbg_assert_msg_(cur->next != nullptr, "ThreadQueueList::Queue should already be linked up.");
-
-		for (int i = cur->first; i < cur->end; ++i) {
-			if (cur->data[i] == threadID) {
-				// How many more after this one?
-				int remaining = cur->end - i;
-				// If there are more, move them into place.
-				if (remaining > 0)
-					memmove(&cur->data[i], &cur->data[i + 1], remaining * sizeof(SceUID));
-
-				// Now we're one shorter.
-				--cur->end;
-				return;
-			}
-		}
-
-		// Wasn't there.
+		const int index = indexOf(threadID);
+		// Only if it's in that queue, like before.
+		if (index >= 0 && nodes[index].queued && nodes[index].priority == priority)
+			unlink(index);
 	}
 
 	inline void rotate(u32 priority) {
-		Queue *cur = &queues[priority];
-		_dbg_assert_msg_(cur->next != nullptr, "ThreadQueueList::Queue should already be linked up.");
-
-		if (cur->size() > 1) {
+		Queue &cur = queues[priority];
+		if (cur.head != cur.tail) {
 			// Grab the front and push it on the end.
-			cur->data[cur->end++] = cur->data[cur->first++];
-			if (cur->full())
-				rebalance(priority);
+			const int index = cur.head;
+			cur.head = nodes[index].next;
+			nodes[cur.head].prev = -1;
+			nodes[index].prev = cur.tail;
+			nodes[index].next = -1;
+			nodes[cur.tail].next = index;
+			cur.tail = index;
 		}
 	}
 
 	inline void clear() {
 		for (int i = 0; i < NUM_QUEUES; ++i) {
-			free(queues[i].data);
+			queues[i].head = -1;
+			queues[i].tail = -1;
+		}
+		for (int i = 0; i < MAX_THREADS; ++i) {
+			nodes[i].queued = false;
 		}
-		memset(queues, 0, sizeof(queues));
-		first = invalid();
+		memset(nonEmpty, 0, sizeof(nonEmpty));
+		memset(prepared, 0, sizeof(prepared));
 	}
 
 	inline bool empty(u32 priority) const {
-		const Queue *cur = &queues[priority];
-		return cur->empty();
+		return queues[priority].head == -1;
 	}
 
 	inline void prepare(u32 priority) {
-		Queue *cur = &queues[priority];
-		if (cur->next == nullptr)
-			link(priority, INITIAL_CAPACITY);
+		// Nothing to allocate, but the save state records which levels have been used.
+		prepared[priority >> 6] |= 1ULL << (priority & 63);
 	}
 
+	// Same format as when this was an array per priority level, so states load both ways.
 	void DoState(PointerWrap &p) {
 		auto s = p.Section("ThreadQueueList", 1);
 		if (!s)
@@ -193,96 +166,121 @@ struct ThreadQueueList {
 		if (p.mode == p.MODE_READ)
 			clear();
 
+		std::vector<SceUID> data;
 		for (int i = 0; i < NUM_QUEUES; ++i) {
-			Queue *cur = &queues[i];
-			int size = cur->size();
+			data.clear();
+			for (int index = queues[i].head; index != -1; index = nodes[index].next)
+				data.push_back(uidOf(index));
+
+			int size = (int)data.size();
 			Do(p, size);
-			int capacity = cur->capacity;
+			// Older versions need an array for every level that has been used, with room to spare.
+			int capacity = 0;
+			if (size != 0 || (prepared[i >> 6] & (1ULL << (i & 63))) != 0) {
+				capacity = INITIAL_CAPACITY;
+				while (capacity < size + 2)
+					capacity *= 2;
+			}
 			Do(p, capacity);
 
 			if (capacity == 0)
 				continue;
 
 			if (p.mode == p.MODE_READ) {
-				link(i, capacity);
-				cur->first = (cur->capacity - size) / 2;
-				cur->end = cur->first + size;
+				if (size < 0 || size > capacity) {
+					p.SetError(p.ERROR_FAILURE);
+					ERROR_LOG(Log::sceKernel, "Savestate loading error: invalid data");
+					return;
+				}
+				prepare(i);
+				data.resize(size);
 			}
 
 			if (size != 0)
-				DoArray(p, &cur->data[cur->first], size);
+				DoArray(p, &data[0], size);
+
+			if (p.mode == p.MODE_READ) {
+				for (SceUID uid : data)
+					push_back(i, uid);
+			}
 		}
 	}
 
 private:
-	Queue *invalid() const {
-		return (Queue *)-1;
+	struct Queue {
+		// Node indices, -1 if empty.
+		int head;
+		int tail;
+	};
+
+	struct Node {
+		int prev;
+		int next;
+		u32 priority;
+		bool queued;
+	};
+
+	static int indexOf(SceUID uid) {
+		const int index = uid - KernelObjectPool::handleOffset;
+		if (index < 0 || index >= MAX_THREADS)
+			return -1;
+		return index;
 	}
 
-	// Initialize a priority level and link to other queues.
-	void link(u32 priority, int size) {
-		_dbg_assert_msg_(queues[priority].data == nullptr, "ThreadQueueList::Queue should only be initialized once.");
-
-		// Make sure we stay a multiple of INITIAL_CAPACITY.
-		if (size <= INITIAL_CAPACITY)
-			size = INITIAL_CAPACITY;
-		else {
-			int goal = size;
-			size = INITIAL_CAPACITY;
-			while (size < goal)
-				size *= 2;
-		}
+	static SceUID uidOf(int index) {
+		return index + KernelObjectPool::handleOffset;
+	}
 
-		// Allocate the queue.
-		Queue *cur = &queues[priority];
-		cur->data = (SceUID *)malloc(sizeof(SceUID) * size);
-		cur->capacity = size;
-		// Start smack in the middle so it can move both directions.
-		cur->first = size / 2;
-		cur->end = size / 2;
-
-		for (int i = (int)priority - 1; i >= 0; --i) {
-			// This queue is before ours, and points past us.
-			// We'll have it point to our new queue, inserting into the chain.
-			if (queues[i].next != nullptr) {
-				cur->next = queues[i].next;
-				queues[i].next = cur;
-				return;
-			}
-		}
+	int firstPriority() const {
+		if (nonEmpty[0] != 0)
+			return LeastSignificantSetBit(nonEmpty[0]);
+		if (nonEmpty[1] != 0)
+			return 64 + LeastSignificantSetBit(nonEmpty[1]);
+		return -1;
+	}
 
-		// Never found above - that means there's no better queue yet.
-		// The new one is now first, and whoever was first is after it.
-		cur->next = first;
-		first = cur;
+	void markUsed(u32 priority) {
+		nonEmpty[priority >> 6] |= 1ULL << (priority & 63);
+		prepared[priority >> 6] |= 1ULL << (priority & 63);
 	}
 
-	// Move or allocate as necessary to maintain free space on both sides.
-	void rebalance(u32 priority) {
-		Queue *cur = &queues[priority];
-		int size = cur->size();
-		// Basically full.  Time for a larger queue?
-		if (size >= cur->capacity - 2) {
-			int new_capacity = cur->capacity * 2;
-			SceUID *new_data = (SceUID *)realloc(cur->data, new_capacity * sizeof(SceUID));
-			if (new_data != nullptr) {
-				// Success, it's bigger now.
-				cur->capacity = new_capacity;
-				cur->data = new_data;
-			}
+	// A thread can only be queued once. If it already is, it moves.
+	int unlinkForPush(SceUID uid) {
+		const int index = indexOf(uid);
+		if (index < 0) {
+			_dbg_assert_msg_(false, "ThreadQueueList: invalid thread id %08x", uid);
+			return -1;
 		}
+		if (nodes[index].queued)
+			unlink(index);
+		return index;
+	}
 
-		// If we center all the items, it should start here.
-		int newFirst = (cur->capacity - size) / 2;
-		if (newFirst != cur->first) {
-			memmove(&cur->data[newFirst], &cur->data[cur->first], size * sizeof(SceUID));
-			cur->first = newFirst;
-			cur->end = newFirst + size;
-		}
+	void unlink(int index) {
+		Node &node = nodes[index];
+		Queue &cur = queues[node.priority];
+		if (node.prev != -1)
+			nodes[node.prev].next = node.next;
+		else
+			cur.head = node.next;
+		if (node.next != -1)
+			nodes[node.next].prev = node.prev;
+		else
+			cur.tail = node.prev;
+		node.queued = false;
+		if (cur.head == -1)
+			nonEmpty[node.priority >> 6] &= ~(1ULL << (node.priority & 63));
+	}
+
+	SceUID pop(int priority) {
+		const int index = queues[priority].head;
+		unlink(index);
+		return uidOf(index);
 	}
 
-	// The first queue that's ever been used.
-	Queue *first;
-	// The priority level queues of thread ids.
+	// Bit per priority level: has threads, or has ever been used.
+	u64 nonEmpty[NUM_QUEUES / 64];
+	u64 prepared[NUM_QUEUES / 64];
 	Queue queues[NUM_QUEUES];
+	Node nodes[MAX_THREADS];
 };
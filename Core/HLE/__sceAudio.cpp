@@ -425,7 +425,8 @@ void __AudioUpdate(bool resetRecording) {
 		memset(mixBuffer, 0, hwBlockSize * 2 * sizeof(s32));
 	}
 
-	if (g_Config.bEnableSound) {
+	// In turbo mode, the game still gets its audio timing but the output is dropped.
+	if (g_Config.bEnableSound && !PSP_CoreParameter().turbo) {
 		float multiplier = Volume100ToMultiplier(std::clamp(g_Config.iGameVolume, 0, VOLUMEHI_FULL));
 		if (PSP_CoreParameter().fpsLimit != FPSLimit::NORMAL || PSP_CoreParameter().fastForward) {
 			if (g_Config.iAltSpeedVolume != -1) {
@@ -370,7 +370,7 @@ static int FrameTimingLimit() {
 	};
 
 	// Note: Fast-forward is OK in hardcore mode.
-	if (PSP_CoreParameter().fastForward)
+	if (PSP_CoreParameter().fastForward || PSP_CoreParameter().turbo)
 		return 0;
 	// Can't slow down in hardcore mode.
 	if (PSP_CoreParameter().fpsLimit == FPSLimit::CUSTOM1)
@@ -574,6 +574,19 @@ void __DisplayFlip(int cyclesLate) {
 	__DisplaySetFramerate();
 
 	flippedThisFrame = true;
+
+	if (PSP_CoreParameter().turbo) {
+		// Nothing is shown, so skip all drawing and don't present or wait for anything.
+		DisplayFireFlip();
+		if (gpu->FramebufferDirty()) {
+			gpuStats.numFlips++;
+		}
+		gstate_c.skipDrawReason |= SKIPDRAW_SKIPFRAME;
+		CoreTiming::ScheduleEvent(0 - cyclesLate, afterFlipEvent, 0);
+		numVBlanksSinceFlip = 0;
+		return;
+	}
+
 	// We flip only if the framebuffer was dirty. This eliminates flicker when using
 	// non-buffered rendering. The interaction with frame skipping seems to need
 	// some work.
@@ -257,7 +257,7 @@ class HTTPRequest : public HTTPConnection {
 
 	u32 headerAddr_ = 0;
 	u32 headerSize_ = 0;
-	bool cancelled_ = false;
+	std::atomic<bool> cancelled_{};
 	int responseCode_ = -1;
 	int entityLength_ = -1;
 
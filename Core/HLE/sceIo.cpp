@@ -51,6 +51,7 @@
 #include "Core/HW/MemoryStick.h"
 #include "Core/HW/AsyncIOManager.h"
 #include "Core/CoreTiming.h"
+#include "Core/Replay.h"
 #include "Core/Reporting.h"
 
 #include "Core/FileSystems/FileSystem.h"
@@ -146,6 +147,8 @@ static std::thread ioManagerThread;
 // TODO: Is it better to just put all on the thread?
 // Let's try. (was 256)
 const int IO_THREAD_MIN_DATA_SIZE = 0;
+// Reads and writes on different files that can be in flight at once.
+const int IO_MAX_IN_FLIGHT = 4;
 
 #define SCE_STM_FDIR 0x1000
 #define SCE_STM_FREG 0x2000
@@ -348,6 +351,14 @@ static int GetIOTimingMethod() {
 	}
 }
 
+// Unless the order matters: realistic timing models a single drive head, and replays record
+// disk access in sequence.
+static void __IoScheduleOperation(const AsyncIOEvent &ev) {
+	const bool ordered = GetIOTimingMethod() == IOTIMING_REALISTIC || ReplayIsExecuting() || ReplayIsSaving();
+	ioManager.SetMaxInFlight(ordered ? 1 : IO_MAX_IN_FLIGHT);
+	ioManager.ScheduleOperation(ev);
+}
+
 static void TellFsThreadEnded (SceUID threadID) {
 	pspFileSystem.ThreadEnded(threadID);
 }
@@ -1098,7 +1109,7 @@ static bool __IoRead(int &result, int id, u32 data_addr, int size, int &us) {
 				ev.buf = data;
 				ev.bytes = validSize;
 				ev.invalidateAddr = data_addr;
-				ioManager.ScheduleOperation(ev);
+				__IoScheduleOperation(ev);
 				return false;
 			} else {
 				if (GetIOTimingMethod() != IOTIMING_REALISTIC) {
@@ -1248,7 +1259,7 @@ static bool __IoWrite(int &result, int id, u32 data_addr, int size, int &us) {
 			ev.buf = (u8 *) data_ptr;
 			ev.bytes = validSize;
 			ev.invalidateAddr = 0;
-			ioManager.ScheduleOperation(ev);
+			__IoScheduleOperation(ev);
 			return false;
 		} else {
 			if (GetIOTimingMethod() != IOTIMING_REALISTIC) {
@@ -68,6 +68,8 @@ struct SasThreadParams {
 	u32 inAddr;
 	int leftVol;
 	int rightVol;
+	// The voices were already mixed ahead, only effects and output are left.
+	bool finishOnly;
 };
 
 static std::thread g_sasThread;
@@ -79,12 +81,69 @@ static volatile int sasThreadState = SasThreadState::DISABLED;
 static SasThreadParams sasThreadParams;
 static int sasMixEvent = -1;
 
+// With bSasLookahead, the SAS thread goes on to mix the voices of the next grain on a copy of the
+// instance, assuming the game won't change anything before its next sceSasCore call. That call then
+// only uses the result if the voices are exactly as they were, and the sample data it read still
+// matches memory, so it's the same as mixing then. Otherwise it's thrown away.
+// All of this is protected by sasWakeMutex, which the thread holds while mixing.
+static SasInstance *sasLookahead;
+static bool sasLookaheadReady = false;
+static std::vector<u8> sasLookaheadState;
+static SasInputCapture sasLookaheadCapture;
+static int sasLookaheadHits = 0;
+static int sasLookaheadMisses = 0;
+
 static bool g_sasMuteFlag = false;
 
 bool *__SasGetGlobalMuteFlag() {
 	return &g_sasMuteFlag;
 }
 
+// Called on the SAS thread before it reports the mix done, so nothing can change the voices meanwhile.
+static bool __SasPrepareLookahead() {
+	sasLookaheadReady = false;
+	if (!sasLookahead) {
+		return false;
+	}
+	for (const SasVoice &voice : sas->voices) {
+		// Mixing these advances the Atrac context, which we can't undo.
+		if (voice.type == VOICETYPE_ATRAC3) {
+			return false;
+		}
+	}
+	sas->SaveMixState(&sasLookaheadState);
+	sasLookahead->LoadMixState(sasLookaheadState);
+	const int grainSize = sasLookahead->GetGrainSize();
+	if (grainSize > 0) {
+		// Might be left over from a mix that wasn't used.
+		memset(sasLookahead->mixBuffer, 0, grainSize * sizeof(int) * 2);
+		memset(sasLookahead->sendBuffer, 0, grainSize * sizeof(int) * 2);
+	}
+	return true;
+}
+
+static bool __SasUseLookahead() {
+	if (!sasLookaheadReady) {
+		return false;
+	}
+	sasLookaheadReady = false;
+
+	std::vector<u8> state;
+	sas->SaveMixState(&state);
+	if (state != sasLookaheadState || !sasLookaheadCapture.MatchesMemory()) {
+		sasLookaheadMisses++;
+		return false;
+	}
+
+	// Take over the voices and the mixed samples.
+	sasLookahead->SaveMixState(&state);
+	sas->LoadMixState(state);
+	std::swap(sas->mixBuffer, sasLookahead->mixBuffer);
+	std::swap(sas->sendBuffer, sasLookahead->sendBuffer);
+	sasLookaheadHits++;
+	return true;
+}
+
 int __SasThread() {
 	SetCurrentThreadName("SAS");
 
@@ -93,10 +152,24 @@ int __SasThread() {
 		sasWake.wait(guard);
 		if (sasThreadState == SasThreadState::QUEUED) {
 			const bool mute = g_sasMuteFlag;
-			sas->Mix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol, mute);
-			std::lock_guard<std::mutex> doneGuard(sasDoneMutex);
-			sasThreadState = SasThreadState::READY;
-			sasDone.notify_one();
+			if (sasThreadParams.finishOnly) {
+				sas->FinishMix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol, mute);
+			} else {
+				sas->Mix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol, mute);
+			}
+			const bool lookahead = __SasPrepareLookahead();
+			{
+				std::lock_guard<std::mutex> doneGuard(sasDoneMutex);
+				sasThreadState = SasThreadState::READY;
+				sasDone.notify_one();
+			}
+
+			if (lookahead) {
+				// Still holding sasWakeMutex, so the next mix waits for this.
+				sasLookaheadCapture.Clear();
+				sasLookahead->MixVoices(&sasLookaheadCapture);
+				sasLookaheadReady = true;
+			}
 		}
 	}
 	return 0;
@@ -121,18 +194,27 @@ static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int ri
 		__SasDrain();
 	}
 
+	// This also waits for any lookahead mixing to finish.
+	std::lock_guard<std::mutex> guard(sasWakeMutex);
+
 	// We're safe to write, since it can't be processing now anymore.
 	// No other thread enqueues.
 	sasThreadParams.outAddr = outAddr;
 	sasThreadParams.inAddr = inAddr;
 	sasThreadParams.leftVol = leftVol;
 	sasThreadParams.rightVol = rightVol;
+	sasThreadParams.finishOnly = __SasUseLookahead();
 
 	// And now, notify.
-	sasWakeMutex.lock();
 	sasThreadState = SasThreadState::QUEUED;
 	sasWake.notify_one();
-	sasWakeMutex.unlock();
+}
+
+static void __SasDiscardLookahead() {
+	if (sasLookahead) {
+		std::lock_guard<std::mutex> guard(sasWakeMutex);
+		sasLookaheadReady = false;
+	}
 }
 
 static void __SasDisableThread() {
@@ -145,6 +227,15 @@ static void __SasDisableThread() {
 			g_sasThread.join();
 		}
 	}
+
+	if (sasLookahead) {
+		if (sasLookaheadHits + sasLookaheadMisses > 0) {
+			INFO_LOG(Log::sceSas, "SAS lookahead: %d grains used, %d discarded", sasLookaheadHits, sasLookaheadMisses);
+		}
+		delete sasLookahead;
+		sasLookahead = nullptr;
+		sasLookaheadReady = false;
+	}
 }
 
 static void sasMixFinish(u64 userdata, int cycleslate) {
@@ -174,6 +265,11 @@ void __SasInit() {
 	sasMixEvent = CoreTiming::RegisterEvent("SasMix", sasMixFinish);
 
 	if (g_Config.bSeparateSASThread) {
+		if (g_Config.bSasLookahead) {
+			sasLookahead = new SasInstance();
+			sasLookaheadHits = 0;
+			sasLookaheadMisses = 0;
+		}
 		sasThreadState = SasThreadState::READY;
 		g_sasThread = std::thread(__SasThread);
 	} else {
@@ -190,6 +286,9 @@ void __SasDoState(PointerWrap &p) {
 		// Wait for the queue to drain.  Don't want to save the wrong stuff.
 		__SasDrain();
 	}
+	if (p.mode == p.MODE_READ) {
+		__SasDiscardLookahead();
+	}
 
 	DoClass(p, sas);
 
@@ -232,6 +331,7 @@ static u32 sceSasInit(u32 core, u32 grainSize, u32 maxVoices, u32 outputMode, u3
 		return hleNoLog(SCE_SAS_ERROR_INVALID_SAMPLE_RATE);
 	}
 
+	__SasDrain();
 	sas->SetGrainSize(grainSize);
 	// Seems like the maxVoices param is actually ignored for all intents and purposes.
 	sas->maxVoices = PSP_SAS_VOICES_MAX;
@@ -22,6 +22,8 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeMap.h"
 #include "Common/Serialize/SerializeSet.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
 #include "Core/HW/AsyncIOManager.h"
@@ -39,16 +41,19 @@ bool AsyncIOManager::HasOperation(u32 handle) {
 }
 
 void AsyncIOManager::ScheduleOperation(const AsyncIOEvent &ev) {
+	AsyncIOEvent scheduled = ev;
+	scheduled.startTicks = CoreTiming::GetTicks();
 	{
 		std::lock_guard<std::mutex> guard(resultsLock_);
 		if (!resultsPending_.insert(ev.handle).second) {
 			ERROR_LOG_REPORT(Log::sceIo, "Scheduling operation for file %d while one is pending (type %d)", ev.handle, ev.type);
 		}
 	}
-	ScheduleEvent(ev);
+	ScheduleEvent(scheduled);
 }
 
 void AsyncIOManager::Shutdown() {
+	WaitInFlight();
 	std::lock_guard<std::mutex> guard(resultsLock_);
 	resultsPending_.clear();
 	results_.clear();
@@ -118,11 +123,11 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
 	switch (ev.type) {
 	case IO_EVENT_READ:
-		Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr);
+		Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr, ev.startTicks);
 		break;
 
 	case IO_EVENT_WRITE:
-		Write(ev.handle, ev.buf, ev.bytes);
+		Write(ev.handle, ev.buf, ev.bytes, ev.startTicks);
 		break;
 
 	default:
@@ -130,16 +135,45 @@ void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
 	}
 }
 
-void AsyncIOManager::Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr) {
+// Only one operation per handle is ever pending, so operations in flight at the same time are on
+// different files. The results are picked up at CoreTiming events, the same way regardless of the
+// order they finish in on the host.
+bool AsyncIOManager::CanProcessInParallel(const AsyncIOEvent &ev) const {
+	if (ev.type != IO_EVENT_READ && ev.type != IO_EVENT_WRITE) {
+		return false;
+	}
+	return maxInFlight_ > 1 && g_threadManager.IsInitialized();
+}
+
+void AsyncIOManager::ProcessEventInParallel(const AsyncIOEvent &ev) {
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::HIGH, [this, ev]() {
+		ProcessEvent(ev);
+
+		std::lock_guard<std::recursive_mutex> guard(eventsLock_);
+		inFlight_--;
+		// Wakes the IO thread if it's waiting for a free slot, and anyone waiting on SyncThread.
+		eventsWait_.notify_one();
+		eventsDrain_.notify_all();
+	}));
+}
+
+void AsyncIOManager::WaitInFlight() {
+	std::unique_lock<std::recursive_mutex> guard(eventsLock_);
+	while (inFlight_ > 0) {
+		eventsDrain_.wait(guard);
+	}
+}
+
+void AsyncIOManager::Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr, u64 startTicks) {
 	int usec = 0;
 	s64 result = pspFileSystem.ReadFile(handle, buf, bytes, usec);
-	EventResult(handle, AsyncIOResult(result, usec, invalidateAddr));
+	EventResult(handle, AsyncIOResult(result, startTicks, usec, invalidateAddr));
 }
 
-void AsyncIOManager::Write(u32 handle, const u8 *buf, size_t bytes) {
+void AsyncIOManager::Write(u32 handle, const u8 *buf, size_t bytes, u64 startTicks) {
 	int usec = 0;
 	s64 result = pspFileSystem.WriteFile(handle, buf, bytes, usec);
-	EventResult(handle, AsyncIOResult(result, usec));
+	EventResult(handle, AsyncIOResult(result, startTicks, usec));
 }
 
 void AsyncIOManager::EventResult(u32 handle, const AsyncIOResult &result) {
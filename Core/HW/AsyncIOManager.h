@@ -43,6 +43,8 @@ struct AsyncIOEvent {
 	u8 *buf;
 	size_t bytes;
 	u32 invalidateAddr;
+	// When it was scheduled, so timing doesn't depend on when a worker gets to it.
+	u64 startTicks = 0;
 
 	operator AsyncIOEventType() const {
 		return type;
@@ -54,8 +56,8 @@ struct AsyncIOResult {
 
 	explicit AsyncIOResult(s64 r) : result(r), finishTicks(0), invalidateAddr(0) {}
 
-	AsyncIOResult(s64 r, int usec, u32 addr = 0) : result(r), invalidateAddr(addr) {
-		finishTicks = CoreTiming::GetTicks() + usToCycles(usec);
+	AsyncIOResult(s64 r, u64 startTicks, int usec, u32 addr = 0) : result(r), invalidateAddr(addr) {
+		finishTicks = startTicks + usToCycles(usec);
 	}
 
 	void DoState(PointerWrap &p) {
@@ -97,6 +99,13 @@ class AsyncIOManager {
 		return threadEnabled_;
 	}
 
+	// Reads and writes on different handles are handed to IO worker threads, up to this many at a time.
+	// 1 processes them one by one on the IO thread, in order.
+	void SetMaxInFlight(int maxInFlight) {
+		std::lock_guard<std::recursive_mutex> guard(eventsLock_);
+		maxInFlight_ = maxInFlight;
+	}
+
 	void ScheduleEvent(AsyncIOEvent ev) {
 		if (threadEnabled_) {
 			std::lock_guard<std::recursive_mutex> guard(eventsLock_);
@@ -114,7 +123,7 @@ class AsyncIOManager {
 	bool HasEvents() {
 		if (threadEnabled_) {
 			std::lock_guard<std::recursive_mutex> guard(eventsLock_);
-			return !events_.empty();
+			return !events_.empty() || inFlight_ > 0;
 		} else {
 			return !events_.empty();
 		}
@@ -173,6 +182,20 @@ class AsyncIOManager {
 			}
 
 			for (AsyncIOEvent ev = GetNextEvent(); AsyncIOEventType(ev) != IO_EVENT_INVALID; ev = GetNextEvent()) {
+				if (CanProcessInParallel(ev)) {
+					while (inFlight_ >= maxInFlight_) {
+						eventsWait_.wait(guard);
+					}
+					inFlight_++;
+					guard.unlock();
+					ProcessEventInParallel(ev);
+					guard.lock();
+					continue;
+				}
+				// Keeps the order when going back to one at a time.
+				while (inFlight_ > 0) {
+					eventsWait_.wait(guard);
+				}
 				guard.unlock();
 				ProcessEventIfApplicable(ev, globalticks);
 				guard.lock();
@@ -238,6 +261,9 @@ class AsyncIOManager {
 
 protected:
 	void ProcessEvent(AsyncIOEvent ref);
+	bool CanProcessInParallel(const AsyncIOEvent &ev) const;
+	void ProcessEventInParallel(const AsyncIOEvent &ev);
+	void WaitInFlight();
 	
 	inline void ProcessEventIfApplicable(AsyncIOEvent &ev, u64 &globalticks) {
 		switch (AsyncIOEventType(ev)) {
@@ -258,8 +284,8 @@ class AsyncIOManager {
 private:
 	bool PopResult(u32 handle, AsyncIOResult &result);
 	bool ReadResult(u32 handle, AsyncIOResult &result);
-	void Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr);
-	void Write(u32 handle, const u8 *buf, size_t bytes);
+	void Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr, u64 startTicks);
+	void Write(u32 handle, const u8 *buf, size_t bytes, u64 startTicks);
 
 	void EventResult(u32 handle, const AsyncIOResult &result);
 
@@ -270,6 +296,8 @@ class AsyncIOManager {
 	std::recursive_mutex eventsLock_;  // TODO: Should really make this non-recursive - condition_variable_any is dangerous
 	std::condition_variable_any eventsWait_;
 	std::condition_variable_any eventsDrain_;
+	int maxInFlight_ = 1;
+	int inFlight_ = 0;
 
 	std::mutex resultsLock_;
 	std::condition_variable resultsWait_;
@@ -18,9 +18,11 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Math/SIMDHeaders.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Core/System.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/HW/MediaEngine.h"
+#include "Core/HW/VideoConvert.h"
 #include "Core/MemMap.h"
 #include "Core/Reporting.h"
 #include "GPU/GPUState.h"  // Used by TextureDecoder.h when templates get instanced
@@ -108,6 +110,23 @@ bool InitFFmpeg() {
 }
 #endif
 
+#ifdef USE_FFMPEG
+// The usual case: YUV 4:2:0 at the size of the video. Instead of swscale, this converts with our own
+// SIMD code, split across threads. That only does limited range, full range (JPEG) frames go
+// through swscale.
+static bool convertFrameToPSP(const AVFrame *frame, AVFrame *frameRGB, int width, int height, int videoPixelMode) {
+	if (frame->format != AV_PIX_FMT_YUV420P || frame->color_range == AVCOL_RANGE_JPEG)
+		return false;
+	if (frame->width != width || frame->height != height || width > VIDEO_CONVERT_MAX_WIDTH)
+		return false;
+
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		ConvertYUV420ToPSP(frameRGB->data[0], frameRGB->linesize[0], frame->data, frame->linesize, width, l, h, videoPixelMode);
+	}, 0, height, 32);
+	return true;
+}
+#endif
+
 static int getPixelFormatBytes(int pspFormat)
 {
 	switch (pspFormat)
@@ -704,8 +723,10 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 					// Update the linesize for the new format too.  We started with the largest size, so it should fit.
 					m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
 
-					sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
-						m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+					if (!convertFrameToPSP(m_pFrame, m_pFrameRGB, m_desWidth, m_desHeight, videoPixelMode)) {
+						sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
+							m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+					}
 				}
 
 #if LIBAVUTIL_VERSION_MAJOR >= 59
@@ -15,8 +15,12 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "ppsspp_config.h"
+
 #include <algorithm>
+#include <cstring>
 
+#include "Common/Math/SIMDHeaders.h"
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/Serialize/SerializeFuncs.h"
@@ -116,20 +120,40 @@ void VagDecoder::DecodeBlock(const u8 *&read_pointer) {
 	read_pointer = readp;
 }
 
-void VagDecoder::GetSamples(s16 *outSamples, int numSamples) {
+void SasInputCapture::Add(u32 addr, const void *data, u32 size) {
+	ranges_.push_back(Range{ addr, size, data_.size() });
+	data_.insert(data_.end(), (const u8 *)data, (const u8 *)data + size);
+}
+
+bool SasInputCapture::MatchesMemory() const {
+	if (failed_) {
+		return false;
+	}
+	for (const Range &range : ranges_) {
+		if (!Memory::IsValidRange(range.addr, range.size) || memcmp(Memory::GetPointerUnchecked(range.addr), &data_[range.offset], range.size) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void VagDecoder::GetSamples(s16 *outSamples, int numSamples, SasInputCapture *capture) {
 	if (end_) {
 		memset(outSamples, 0, numSamples * sizeof(s16));
 		return;
 	}
 	if (!Memory::IsValidRange(read_, numBlocks_ * 16)) {
 		WARN_LOG_REPORT(Log::SasMix, "Bad VAG samples address? %08x / %d", read_, numBlocks_);
+		if (capture) {
+			capture->Fail();
+		}
 		return;
 	}
 
 	const u8 *readp = Memory::GetPointerUnchecked(read_);
 	const u8 *origp = readp;
 
-	for (int i = 0; i < numSamples; i++) {
+	for (int i = 0; i < numSamples; ) {
 		if (curSample == 28) {
 			if (loopAtNextBlock_) {
 				VERBOSE_LOG(Log::SasMix, "Looping VAG from block %d/%d to %d", curBlock_, numBlocks_, loopStartBlock_);
@@ -140,7 +164,17 @@ void VagDecoder::GetSamples(s16 *outSamples, int numSamples) {
 				curBlock_ = loopStartBlock_;
 				loopAtNextBlock_ = false;
 			}
-			DecodeBlock(readp);
+			if (capture) {
+				// Decode from the copy, so what we decoded is exactly what was recorded.
+				u8 block[16];
+				memcpy(block, readp, sizeof(block));
+				capture->Add(read_ + (u32)(readp - origp), block, sizeof(block));
+				const u8 *blockp = block;
+				DecodeBlock(blockp);
+				readp += blockp - block;
+			} else {
+				DecodeBlock(readp);
+			}
 			if (end_) {
 				// Clear the rest of the buffer and return.
 				memset(&outSamples[i], 0, (numSamples - i) * sizeof(s16));
@@ -148,7 +182,11 @@ void VagDecoder::GetSamples(s16 *outSamples, int numSamples) {
 			}
 		}
 		_dbg_assert_(curSample < 28);
-		outSamples[i] = samples[curSample++];
+		// Copy out as much of the decoded block as we can at once.
+		const int count = std::min(28 - curSample, numSamples - i);
+		memcpy(&outSamples[i], &samples[curSample], count * sizeof(s16));
+		curSample += count;
+		i += count;
 	}
 
 	if (readp > origp) {
@@ -467,11 +505,11 @@ int SasInstance::EstimateMixUs() {
 	return std::min(cycles, 1200);
 }
 
-void SasVoice::ReadSamples(s16 *output, int numSamples) {
+void SasVoice::ReadSamples(s16 *output, int numSamples, SasInputCapture *capture) {
 	// Read N samples into the resample buffer. Could do either PCM or VAG here.
 	switch (type) {
 	case VOICETYPE_VAG:
-		vag.GetSamples(output, numSamples);
+		vag.GetSamples(output, numSamples, capture);
 		break;
 	case VOICETYPE_PCM:
 		{
@@ -484,6 +522,9 @@ void SasVoice::ReadSamples(s16 *output, int numSamples) {
 					break;
 				}
 				Memory::Memcpy(out, pcmAddr + pcmIndex * sizeof(s16), size * sizeof(s16), "SasVoicePCM");
+				if (capture) {
+					capture->Add(pcmAddr + pcmIndex * sizeof(s16), out, size * sizeof(s16));
+				}
 				pcmIndex += size;
 				needed -= size;
 				out += size;
@@ -525,7 +566,114 @@ bool SasVoice::HaveSamplesEnded() const {
 	}
 }
 
-void SasInstance::MixVoice(SasVoice &voice) {
+void SasMixResampledSamples(int *mixBuffer, int *sendBuffer, const s16 *src, u32 sampleFrac, int pitch, bool interpolate, const int *envelope, int count, int volumeLeft, int volumeRight, int effectLeft, int effectRight) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i mask = _mm_set1_epi32(PSP_SAS_PITCH_MASK);
+	const __m128i round = _mm_set1_epi32(1 << 14);
+	const __m128i volumes = _mm_setr_epi32(volumeLeft, volumeRight, volumeLeft, volumeRight);
+	const __m128i effects = _mm_setr_epi32(effectLeft, effectRight, effectLeft, effectRight);
+	const __m128i fracStep = _mm_set1_epi32(pitch * 4);
+	__m128i fracs = _mm_setr_epi32(sampleFrac, sampleFrac + pitch, sampleFrac + pitch * 2, sampleFrac + pitch * 3);
+	for (; i + 4 <= count; i += 4) {
+		__m128i sample;
+		if (interpolate) {
+			// Gather the sample pairs, the weights (MASK - f, f) go in the matching halves for madd.
+			u32 pairs[4];
+			for (int j = 0; j < 4; j++) {
+				memcpy(&pairs[j], src + ((sampleFrac + pitch * j) >> PSP_SAS_PITCH_BASE_SHIFT), sizeof(u32));
+			}
+			const __m128i frac = _mm_and_si128(fracs, mask);
+			const __m128i weights = _mm_or_si128(_mm_sub_epi32(mask, frac), _mm_slli_epi32(frac, 16));
+			sample = _mm_srai_epi32(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)pairs), weights), PSP_SAS_PITCH_BASE_SHIFT);
+		} else {
+			const __m128i samples16 = _mm_loadl_epi64((const __m128i *)(src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT)));
+			sample = _mm_srai_epi32(_mm_unpacklo_epi16(samples16, samples16), 16);
+		}
+		sampleFrac += pitch * 4;
+		fracs = _mm_add_epi32(fracs, fracStep);
+
+		const __m128i env = _mm_loadu_si128((const __m128i *)(envelope + i));
+		sample = _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32_SSE2(sample, env), round), 15);
+
+		// Duplicate each sample for the left and right channels.
+		const __m128i sample01 = _mm_unpacklo_epi32(sample, sample);
+		const __m128i sample23 = _mm_unpackhi_epi32(sample, sample);
+		__m128i *mix = (__m128i *)(mixBuffer + i * 2);
+		__m128i *send = (__m128i *)(sendBuffer + i * 2);
+		_mm_storeu_si128(mix, _mm_add_epi32(_mm_loadu_si128(mix), _mm_srai_epi32(_mm_mullo_epi32_SSE2(sample01, volumes), 12)));
+		_mm_storeu_si128(mix + 1, _mm_add_epi32(_mm_loadu_si128(mix + 1), _mm_srai_epi32(_mm_mullo_epi32_SSE2(sample23, volumes), 12)));
+		_mm_storeu_si128(send, _mm_add_epi32(_mm_loadu_si128(send), _mm_srai_epi32(_mm_mullo_epi32_SSE2(sample01, effects), 12)));
+		_mm_storeu_si128(send + 1, _mm_add_epi32(_mm_loadu_si128(send + 1), _mm_srai_epi32(_mm_mullo_epi32_SSE2(sample23, effects), 12)));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const int32x4_t mask = vdupq_n_s32(PSP_SAS_PITCH_MASK);
+	const int32x4_t round = vdupq_n_s32(1 << 14);
+	const int32_t volumeArray[4] = { volumeLeft, volumeRight, volumeLeft, volumeRight };
+	const int32_t effectArray[4] = { effectLeft, effectRight, effectLeft, effectRight };
+	const int32x4_t volumes = vld1q_s32(volumeArray);
+	const int32x4_t effects = vld1q_s32(effectArray);
+	const int32x4_t fracStep = vdupq_n_s32(pitch * 4);
+	const int32_t fracArray[4] = { (int32_t)sampleFrac, (int32_t)(sampleFrac + pitch), (int32_t)(sampleFrac + pitch * 2), (int32_t)(sampleFrac + pitch * 3) };
+	int32x4_t fracs = vld1q_s32(fracArray);
+	for (; i + 4 <= count; i += 4) {
+		int32x4_t sample;
+		if (interpolate) {
+			s16 s0[4], s1[4];
+			for (int j = 0; j < 4; j++) {
+				const s16 *s = src + ((sampleFrac + pitch * j) >> PSP_SAS_PITCH_BASE_SHIFT);
+				s0[j] = s[0];
+				s1[j] = s[1];
+			}
+			const int32x4_t frac = vandq_s32(fracs, mask);
+			const int32x4_t interp = vmlal_s16(vmull_s16(vld1_s16(s0), vmovn_s32(vsubq_s32(mask, frac))), vld1_s16(s1), vmovn_s32(frac));
+			sample = vshrq_n_s32(interp, PSP_SAS_PITCH_BASE_SHIFT);
+		} else {
+			sample = vmovl_s16(vld1_s16(src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT)));
+		}
+		sampleFrac += pitch * 4;
+		fracs = vaddq_s32(fracs, fracStep);
+
+		sample = vshrq_n_s32(vaddq_s32(vmulq_s32(sample, vld1q_s32(envelope + i)), round), 15);
+
+		// Duplicate each sample for the left and right channels.
+		const int32x4x2_t samples = vzipq_s32(sample, sample);
+		int *mix = mixBuffer + i * 2;
+		int *send = sendBuffer + i * 2;
+		vst1q_s32(mix, vaddq_s32(vld1q_s32(mix), vshrq_n_s32(vmulq_s32(samples.val[0], volumes), 12)));
+		vst1q_s32(mix + 4, vaddq_s32(vld1q_s32(mix + 4), vshrq_n_s32(vmulq_s32(samples.val[1], volumes), 12)));
+		vst1q_s32(send, vaddq_s32(vld1q_s32(send), vshrq_n_s32(vmulq_s32(samples.val[0], effects), 12)));
+		vst1q_s32(send + 4, vaddq_s32(vld1q_s32(send + 4), vshrq_n_s32(vmulq_s32(samples.val[1], effects), 12)));
+	}
+#endif
+
+	// This does the remainder if SIMD was used, otherwise it does it all.
+	for (; i < count; i++) {
+		const int16_t *s = src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+
+		// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
+		int sample = s[0];
+		if (interpolate) {
+			int f = sampleFrac & PSP_SAS_PITCH_MASK;
+			sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+		}
+		sampleFrac += pitch;
+
+		// We just scale by the envelope before we scale by volumes.
+		// Again, we round up by adding (1 << 14) first (*after* multiplying.)
+		sample = ((sample * envelope[i]) + (1 << 14)) >> 15;
+
+		// We mix into this 32-bit temp buffer and clip in a second loop
+		// Ideally, the shift right should be there too but for now I'm concerned about
+		// not overflowing.
+		mixBuffer[i * 2] += (sample * volumeLeft) >> 12;
+		mixBuffer[i * 2 + 1] += (sample * volumeRight) >> 12;
+		sendBuffer[i * 2] += sample * effectLeft >> 12;
+		sendBuffer[i * 2 + 1] += sample * effectRight >> 12;
+	}
+}
+
+void SasInstance::MixVoice(SasVoice &voice, SasInputCapture *capture) {
 	switch (voice.type) {
 	case VOICETYPE_VAG:
 		if (voice.type == VOICETYPE_VAG && !voice.vagAddr)
@@ -568,7 +716,7 @@ void SasInstance::MixVoice(SasVoice &voice) {
 			readPos = 0;
 			samplesToRead += 2;
 		}
-		voice.ReadSamples(&mixTemp_[readPos], samplesToRead);
+		voice.ReadSamples(&mixTemp_[readPos], samplesToRead, capture);
 		int tempPos = readPos + samplesToRead;
 
 		for (int i = 0; i < delay; ++i) {
@@ -577,35 +725,21 @@ void SasInstance::MixVoice(SasVoice &voice) {
 			voice.envelope.Step();
 		}
 
-		const bool needsInterp = voicePitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
+		// The envelope is a state machine, so walk it for the whole grain first. The rest doesn't
+		// depend on it and can be done several samples at a time.
 		for (int i = delay; i < grainSize; i++) {
-			const int16_t *s = mixTemp_ + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
-
-			// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
-			int sample = s[0];
-			if (needsInterp) {
-				int f = sampleFrac & PSP_SAS_PITCH_MASK;
-				sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
-			}
-			sampleFrac += voicePitch;
-
 			// The maximum envelope height (PSP_SAS_ENVELOPE_HEIGHT_MAX) is (1 << 30) - 1.
 			// Reduce it to 14 bits, by shifting off 15.  Round up by adding (1 << 14) first.
 			int envelopeValue = voice.envelope.GetHeight();
 			voice.envelope.Step();
-			envelopeValue = (envelopeValue + (1 << 14)) >> 15;
-
-			// We just scale by the envelope before we scale by volumes.
-			// Again, we round up by adding (1 << 14) first (*after* multiplying.)
-			sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
-
-			// We mix into this 32-bit temp buffer and clip in a second loop
-			// Ideally, the shift right should be there too but for now I'm concerned about
-			// not overflowing.
-			mixBuffer[i * 2] += (sample * voice.volumeLeft) >> 12;
-			mixBuffer[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
-			sendBuffer[i * 2] += sample * voice.effectLeft >> 12;
-			sendBuffer[i * 2 + 1] += sample * voice.effectRight >> 12;
+			envelopeTemp_[i] = (envelopeValue + (1 << 14)) >> 15;
+		}
+
+		if (delay < grainSize) {
+			const bool needsInterp = voicePitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
+			SasMixResampledSamples(mixBuffer + delay * 2, sendBuffer + delay * 2, mixTemp_, sampleFrac, voicePitch, needsInterp, envelopeTemp_ + delay, grainSize - delay,
+				voice.volumeLeft, voice.volumeRight, voice.effectLeft, voice.effectRight);
+			sampleFrac += voicePitch * (grainSize - delay);
 		}
 
 		voice.resampleHist[0] = mixTemp_[tempPos - 2];
@@ -624,13 +758,20 @@ void SasInstance::MixVoice(SasVoice &voice) {
 }
 
 void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol, bool mute) {
+	MixVoices();
+	FinishMix(outAddr, inAddr, leftVol, rightVol, mute);
+}
+
+void SasInstance::MixVoices(SasInputCapture *capture) {
 	for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
 		SasVoice &voice = voices[v];
 		if (!voice.playing || voice.paused)
 			continue;
-		MixVoice(voice);
+		MixVoice(voice, capture);
 	}
+}
 
+void SasInstance::FinishMix(u32 outAddr, u32 inAddr, int leftVol, int rightVol, bool mute) {
 	// Apply mute if needed (note: we try to keep everything else identical to the non-muted case).
 	if (mute) {
 		memset(mixBuffer, 0, grainSize * sizeof(int) * 2);
@@ -791,6 +932,31 @@ void SasInstance::DoState(PointerWrap &p) {
 	}
 }
 
+void SasInstance::DoMixState(PointerWrap &p) {
+	int grain = grainSize;
+	Do(p, grain);
+	if (p.mode == p.MODE_READ && grain != grainSize) {
+		SetGrainSize(grain);
+	}
+	DoArray(p, voices, ARRAY_SIZE(voices));
+}
+
+void SasInstance::SaveMixState(std::vector<u8> *data) {
+	u8 *ptr = nullptr;
+	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	DoMixState(p);
+	data->resize(p.Offset());
+	p.RewindForWrite(data->data());
+	DoMixState(p);
+	_dbg_assert_(p.CheckAfterWrite());
+}
+
+void SasInstance::LoadMixState(const std::vector<u8> &data) {
+	u8 *ptr = (u8 *)data.data();
+	PointerWrap p(&ptr, PointerWrap::MODE_READ);
+	DoMixState(p);
+}
+
 void SasVoice::Reset() {
 	resampleHist[0] = 0;
 	resampleHist[1] = 0;
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Core/HW/BufferQueue.h"
 #include "Core/HW/SasReverb.h"
@@ -98,6 +100,33 @@ enum VoiceType {
 	VOICETYPE_ATRAC3,
 };
 
+// Records the guest memory a mix read its samples from, so that a mix done ahead of time can
+// be checked against what the same mix would read now.
+class SasInputCapture {
+public:
+	void Clear() {
+		ranges_.clear();
+		data_.clear();
+		failed_ = false;
+	}
+	void Add(u32 addr, const void *data, u32 size);
+	// For reads that didn't happen, the samples aren't reproducible then.
+	void Fail() {
+		failed_ = true;
+	}
+	bool MatchesMemory() const;
+
+private:
+	struct Range {
+		u32 addr;
+		u32 size;
+		size_t offset;
+	};
+	std::vector<Range> ranges_;
+	std::vector<u8> data_;
+	bool failed_ = false;
+};
+
 // VAG is a Sony ADPCM audio compression format, which goes all the way back to the PSX.
 // It compresses 28 16-bit samples into a block of 16 bytes.
 class VagDecoder {
@@ -107,7 +136,8 @@ class VagDecoder {
 	}
 	void Start(u32 dataPtr, u32 vagSize, bool loopEnabled);
 
-	void GetSamples(s16 *outSamples, int numSamples);
+	// If capture is set, the blocks are copied into it before being decoded.
+	void GetSamples(s16 *outSamples, int numSamples, SasInputCapture *capture = nullptr);
 
 	void DecodeBlock(const u8 *&readp);
 	bool End() const { return end_; }
@@ -247,7 +277,7 @@ struct SasVoice {
 
 	void DoState(PointerWrap &p);
 
-	void ReadSamples(s16 *output, int numSamples);
+	void ReadSamples(s16 *output, int numSamples, SasInputCapture *capture = nullptr);
 	bool HaveSamplesEnded() const;
 
 	// For debugging.
@@ -316,7 +346,15 @@ class SasInstance {
 	FILE *audioDump = nullptr;
 
 	void Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol, bool mute);
-	void MixVoice(SasVoice &voice);
+	// Mix is these two. MixVoices only touches the voices and the mix buffers, not the effects or the output.
+	void MixVoices(SasInputCapture *capture = nullptr);
+	void FinishMix(u32 outAddr, u32 inAddr, int leftVol, int rightVol, bool mute);
+	void MixVoice(SasVoice &voice, SasInputCapture *capture = nullptr);
+
+	// The grain size and voices, which is what MixVoices depends on and changes. Used to mix ahead
+	// on a copy of the instance.
+	void SaveMixState(std::vector<u8> *data);
+	void LoadMixState(const std::vector<u8> &data);
 
 	// Applies reverb to send buffer, according to waveformEffect.
 	void ApplyWaveformEffect();
@@ -331,9 +369,17 @@ class SasInstance {
 	WaveformEffect waveformEffect;
 
 private:
+	void DoMixState(PointerWrap &p);
+
 	SasReverb reverb_;
 	int grainSize = 0;
 	int16_t mixTemp_[PSP_SAS_MAX_GRAIN * 4 + 2 + 16];  // some extra margin for very high pitches.
+	int envelopeTemp_[PSP_SAS_MAX_GRAIN];
 };
 
 const char *ADSRCurveModeAsString(SasADSRCurveMode mode);
+
+// Resamples count samples from src starting at sampleFrac (20.12 fixed point), scales them by the
+// precomputed envelope values and accumulates them into the interleaved stereo mix and send buffers.
+// Uses SSE2 / NEON where available, the results are identical to the scalar path.
+void SasMixResampledSamples(int *mixBuffer, int *sendBuffer, const s16 *src, u32 sampleFrac, int pitch, bool interpolate, const int *envelope, int count, int volumeLeft, int volumeRight, int effectLeft, int effectRight);
@@ -32,8 +32,24 @@
 #define CONTROL_FACTOR  0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG     32.0f
 
+// AudioResampler::SINC: a Kaiser windowed sinc, with linear interpolation between the phases.
+#define SINC_TAPS        32
+#define SINC_PHASE_SHIFT 9  // of the 16-bit fraction, leaving 128 phases
+#define SINC_PHASES      (1 << (16 - SINC_PHASE_SHIFT))
+#define SINC_PHASE_MASK  ((1 << SINC_PHASE_SHIFT) - 1)
+#define SINC_KAISER_BETA 8.0
+#define SINC_CUTOFF      0.9  // of the lower of the two Nyquist frequencies
+
+// Rate control for AudioResampler::SINC, relative to the input sample rate. The buffer fill error
+// is relative to the target size, and the integral is per second.
+#define PLL_KP           0.008f
+#define PLL_KI           0.004f
+#define PLL_MAX_INTEGRAL 0.01f
+#define PLL_MAX_SHIFT    (MAX_FREQ_SHIFT / 44100.0f)
+
 #include "ppsspp_config.h"
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <atomic>
 
@@ -159,6 +175,79 @@ inline int16_t MixSingleSample(int16_t s1, int16_t s2, uint16_t frac) {
 		return (int16_t)value;
 }
 
+// Like a PLL: the buffer fill level is the phase error, and the integral term takes out the constant
+// drift between the emulated and the output clock. With just a proportional term like the linear
+// path has, the fill level settles off the target by however much it takes to correct the drift.
+float StereoResampler::UpdateRateControl(float numLeft, unsigned int numSamples, int sampleRate) {
+	const float error = (numLeft - (float)targetBufsize_) / (float)targetBufsize_;
+	// Don't wind up while the buffer runs empty or full, like when the emulator can't keep up.
+	if (fabsf(error) < 0.5f) {
+		const float dt = (float)numSamples / (float)sampleRate;
+		rateIntegral_ = std::clamp(rateIntegral_ + error * PLL_KI * dt, -PLL_MAX_INTEGRAL, PLL_MAX_INTEGRAL);
+	}
+	return std::clamp(error * PLL_KP + rateIntegral_, -PLL_MAX_SHIFT, PLL_MAX_SHIFT);
+}
+
+static double BesselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32 && term > sum * 1e-12; k++) {
+		const double t = x / (2.0 * k);
+		term *= t * t;
+		sum += term;
+	}
+	return sum;
+}
+
+void StereoResampler::UpdateSincFilter(int sampleRate) {
+	// Under the output Nyquist frequency when downsampling, otherwise under the input one.
+	const double cutoff = std::min(1.0, (double)sampleRate / (double)inputSampleRateHz_) * SINC_CUTOFF;
+	const double PI = 3.14159265358979323846;
+	auto computePhase = [&](int phase, double *coefs) {
+		// The output position is between taps SINC_TAPS / 2 - 1 and SINC_TAPS / 2.
+		const double f = (double)phase / SINC_PHASES;
+		double sum = 0.0;
+		for (int k = 0; k < SINC_TAPS; k++) {
+			const double x = k - (SINC_TAPS / 2 - 1) - f;
+			const double w = x / (SINC_TAPS / 2);
+			const double window = fabs(w) >= 1.0 ? 0.0 : BesselI0(SINC_KAISER_BETA * sqrt(1.0 - w * w)) / BesselI0(SINC_KAISER_BETA);
+			const double sinc = x == 0.0 ? 1.0 : sin(PI * cutoff * x) / (PI * cutoff * x);
+			coefs[k] = sinc * window;
+			sum += coefs[k];
+		}
+		// Unity gain at DC for every phase, or the interpolation adds a tone at the phase rate.
+		for (int k = 0; k < SINC_TAPS; k++)
+			coefs[k] /= sum;
+	};
+
+	sincFilter_.resize(SINC_PHASES * SINC_TAPS * 4);
+	double coefs[SINC_TAPS], next[SINC_TAPS];
+	computePhase(0, next);
+	for (int phase = 0; phase < SINC_PHASES; phase++) {
+		memcpy(coefs, next, sizeof(coefs));
+		computePhase(phase + 1, next);
+		float *out = &sincFilter_[phase * SINC_TAPS * 4];
+		for (int k = 0; k < SINC_TAPS; k++) {
+			out[k * 2] = out[k * 2 + 1] = (float)coefs[k];
+			out[SINC_TAPS * 2 + k * 2] = out[SINC_TAPS * 2 + k * 2 + 1] = (float)(next[k] - coefs[k]);
+		}
+	}
+	sincFilterRate_ = sampleRate;
+}
+
+// One stereo output sample from SINC_TAPS interleaved stereo input samples, at t between phase and the next.
+static inline void SincFilterSample(s16 *out, const s16 *in, const float *phase, float t) {
+	const Vec4F32 tv = Vec4F32::Splat(t);
+	Vec4F32 acc = Vec4F32::Zero();
+	for (int i = 0; i < SINC_TAPS * 2; i += 4) {
+		const Vec4F32 coefs = Vec4F32::Load(phase + i) + Vec4F32::Load(phase + SINC_TAPS * 2 + i) * tv;
+		acc += Vec4F32::LoadConvertS16(in + i) * coefs;
+	}
+	float sums[4];
+	acc.Store(sums);
+	out[0] = clamp_s16((int)lrintf(sums[0] + sums[2]));
+	out[1] = clamp_s16((int)lrintf(sums[1] + sums[3]));
+}
+
 // Executed from sound stream thread, pulling sound out of the buffer.
 void StereoResampler::Mix(s16 *samples, unsigned int numSamples, bool consider_framelimit, int sample_rate) {
 	if (!samples)
@@ -197,34 +286,68 @@ void StereoResampler::Mix(s16 *samples, unsigned int numSamples, bool consider_f
 	// Note that the speed of adjustment here does not take the buffer size into
 	// account. Since this is called once per "output frame", the frame size
 	// will affect how fast this algorithm reacts, which can't be a good thing.
-	float offset = (numLeftI_ - (float)targetBufsize_) * CONTROL_FACTOR;
-	if (offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
-	if (offset < -MAX_FREQ_SHIFT) offset = -MAX_FREQ_SHIFT;
+	const bool sinc = g_Config.iAudioResampler == (int)AudioResampler::SINC;
+	float offset;
+	if (sinc) {
+		rateCorrection_ = UpdateRateControl(numLeftI_, numSamples, sample_rate);
+		offset = rateCorrection_ * (float)inputSampleRateHz_;
+	} else {
+		offset = (numLeftI_ - (float)targetBufsize_) * CONTROL_FACTOR;
+		if (offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
+		if (offset < -MAX_FREQ_SHIFT) offset = -MAX_FREQ_SHIFT;
+		rateCorrection_ = offset / (float)inputSampleRateHz_;
+		rateIntegral_ = 0.0f;
+	}
 
 	outputSampleRateHz_ = (float)(inputSampleRateHz_ + offset);
 	const u32 ratio = (u32)(65536.0 * outputSampleRateHz_ / (double)sample_rate);
 	ratio_ = ratio;
-	// TODO: consider a higher-quality resampling algorithm.
 	// TODO: Add a fast path for 1:1.
 	u32 frac = frac_;
-	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
-		if (((indexW - indexR) & INDEX_MASK) <= 2) {
-			// Ran out!
-			// int missing = numSamples * 2 - currentSample;
-			// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
-			underrunCount_++;
-			break;
+	if (sinc) {
+		if (sincFilterRate_ != sample_rate)
+			UpdateSincFilter(sample_rate);
+		// The ring buffer always has room for a whole window, so only its end can wrap around.
+		const u32 INDEX_SIZE = maxBufsize_ * 2;
+		s16 wrapped[SINC_TAPS * 2];
+		for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
+			if (((indexW - indexR) & INDEX_MASK) <= SINC_TAPS * 2) {
+				underrunCount_++;
+				break;
+			}
+			const u32 pos = indexR & INDEX_MASK;
+			const s16 *window = &buffer_[pos];
+			if (pos + SINC_TAPS * 2 > INDEX_SIZE) {
+				for (int i = 0; i < SINC_TAPS * 2; i++)
+					wrapped[i] = buffer_[(pos + i) & INDEX_MASK];
+				window = wrapped;
+			}
+			const float *phase = &sincFilter_[(frac >> SINC_PHASE_SHIFT) * SINC_TAPS * 4];
+			SincFilterSample(&samples[currentSample], window, phase, (float)(frac & SINC_PHASE_MASK) * (1.0f / (SINC_PHASE_MASK + 1)));
+			frac += ratio;
+			indexR += 2 * (frac >> 16);
+			frac &= 0xffff;
+		}
+	} else {
+		for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
+			if (((indexW - indexR) & INDEX_MASK) <= 2) {
+				// Ran out!
+				// int missing = numSamples * 2 - currentSample;
+				// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
+				underrunCount_++;
+				break;
+			}
+			u32 indexR2 = indexR + 2; //next sample
+			s16 l1 = buffer_[indexR & INDEX_MASK]; //current
+			s16 r1 = buffer_[(indexR + 1) & INDEX_MASK]; //current
+			s16 l2 = buffer_[indexR2 & INDEX_MASK]; //next
+			s16 r2 = buffer_[(indexR2 + 1) & INDEX_MASK]; //next
+			samples[currentSample] = MixSingleSample(l1, l2, (u16)frac);
+			samples[currentSample + 1] = MixSingleSample(r1, r2, (u16)frac);
+			frac += ratio;
+			indexR += 2 * (frac >> 16);
+			frac &= 0xffff;
 		}
-		u32 indexR2 = indexR + 2; //next sample
-		s16 l1 = buffer_[indexR & INDEX_MASK]; //current
-		s16 r1 = buffer_[(indexR + 1) & INDEX_MASK]; //current
-		s16 l2 = buffer_[indexR2 & INDEX_MASK]; //next
-		s16 r2 = buffer_[(indexR2 + 1) & INDEX_MASK]; //next
-		samples[currentSample] = MixSingleSample(l1, l2, (u16)frac);
-		samples[currentSample + 1] = MixSingleSample(r1, r2, (u16)frac);
-		frac += ratio;
-		indexR += 2 * (frac >> 16);
-		frac &= 0xffff;
 	}
 	frac_ = frac;
 
@@ -232,9 +355,10 @@ void StereoResampler::Mix(s16 *samples, unsigned int numSamples, bool consider_f
 	outputSampleCount_ += currentSample / 2;
 
 	// Padding with the last value to reduce clicking
+	const u32 padIndex = sinc ? indexR + SINC_TAPS : indexR;
 	short s[2];
-	s[0] = clamp_s16(buffer_[(indexR - 1) & INDEX_MASK]);
-	s[1] = clamp_s16(buffer_[(indexR - 2) & INDEX_MASK]);
+	s[0] = clamp_s16(buffer_[(padIndex - 1) & INDEX_MASK]);
+	s[1] = clamp_s16(buffer_[(padIndex - 2) & INDEX_MASK]);
 	for (; currentSample < numSamples * 2; currentSample += 2) {
 		samples[currentSample] = s[0];
 		samples[currentSample + 1] = s[1];
@@ -294,9 +418,13 @@ void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 	double effective_output_sample_rate = (double)outputSampleCount_ / elapsed;
 
 	double bufferLatencyMs = 1000.0 * (double)lastBufSize_ / (double)inputSampleRateHz_;
+	double filteredLatencyMs = 1000.0 * (double)numLeftI_ / (double)inputSampleRateHz_;
+	const bool sinc = g_Config.iAudioResampler == (int)AudioResampler::SINC;
 	snprintf(buf, bufSize,
 		"Audio buffer: %d/%d (%0.1fms, target: %d)\n"
-		"Filtered: %0.2f\n"
+		"Filtered: %0.2f (%0.1fms)\n"
+		"Resampler: %s\n"
+		"Drift correction: %+0.0f ppm (integral: %+0.0f ppm)\n"
 		"Underruns: %d\n"
 		"Overruns: %d\n"
 		"Sample rate: %d (input: %d)\n"
@@ -309,6 +437,10 @@ void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 		bufferLatencyMs,
 		targetBufsize_,
 		numLeftI_,
+		filteredLatencyMs,
+		sinc ? "Sinc" : "Linear",
+		rateCorrection_ * 1000000.0f,
+		rateIntegral_ * 1000000.0f,
 		underrunCountTotal_,
 		overrunCountTotal_,
 		(int)outputSampleRateHz_,
@@ -21,6 +21,7 @@
 
 #include <cstdint>
 #include <atomic>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 
@@ -46,6 +47,8 @@ class StereoResampler {
 
 private:
 	void UpdateBufferSize();
+	float UpdateRateControl(float numLeft, unsigned int numSamples, int sampleRate);
+	void UpdateSincFilter(int sampleRate);
 
 	int maxBufsize_;
 	int targetBufsize_;
@@ -64,6 +67,14 @@ class StereoResampler {
 	int lastPushSize_ = 0;
 	u32 ratio_ = 0;
 
+	// AudioResampler::SINC. Per phase, the coefficients and the differences to the next phase's,
+	// each duplicated to match the interleaved stereo samples.
+	std::vector<float> sincFilter_;
+	int sincFilterRate_ = 0;
+	// Rate control for the above, relative to the input sample rate.
+	float rateIntegral_ = 0.0f;
+	float rateCorrection_ = 0.0f;
+
 	int underrunCount_ = 0;
 	int overrunCount_ = 0;
 	int underrunCountTotal_ = 0;
@@ -0,0 +1,241 @@
+#include "ppsspp_config.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Math/SIMDHeaders.h"
+#include "Core/HW/VideoConvert.h"
+#include "GPU/ge_constants.h"
+
+// Limited range BT.601 to full range RGB. The inputs are shifted up by 7 bits and multiplied by these,
+// keeping the top 16 bits, which leaves 3 fractional bits. That fits 16-bit lanes without overflow.
+enum {
+	COEF_Y = 4769,   // 255 / 219
+	COEF_VR = 6538,  // 1.402 * 255 / 224
+	COEF_UG = 1605,  // 0.344 * 255 / 224
+	COEF_VG = 3330,  // 0.714 * 255 / 224
+	COEF_UB = 8263,  // 1.772 * 255 / 224
+};
+
+// The ordered dither swscale uses for 16-bit output.
+static const u8 dither2x2_4[2][2] = { { 1, 3 }, { 2, 0 } };
+static const u8 dither2x2_8[2][2] = { { 6, 2 }, { 0, 4 } };
+static const u8 dither4x4_16[4][4] = {
+	{ 8, 4, 11, 7 },
+	{ 2, 14, 1, 13 },
+	{ 10, 6, 9, 5 },
+	{ 0, 12, 3, 15 },
+};
+
+// The dither added to each channel in a row, repeated so it lines up with any multiple of 4 pixels.
+struct RowDither {
+	alignas(16) u8 r[16];
+	alignas(16) u8 g[16];
+	alignas(16) u8 b[16];
+};
+
+static void SetupDither(RowDither &d, int y, int pspFormat) {
+	for (int x = 0; x < 16; x++) {
+		switch (pspFormat) {
+		case GE_CMODE_16BIT_BGR5650:
+			d.r[x] = dither2x2_8[y & 1][x & 1];
+			d.g[x] = dither2x2_4[y & 1][x & 1];
+			d.b[x] = dither2x2_8[(y & 1) ^ 1][x & 1];
+			break;
+		case GE_CMODE_16BIT_ABGR5551:
+			d.r[x] = dither2x2_8[y & 1][x & 1];
+			d.g[x] = dither2x2_8[y & 1][x & 1];
+			d.b[x] = dither2x2_8[(y & 1) ^ 1][x & 1];
+			break;
+		default:
+			d.r[x] = d.g[x] = d.b[x] = dither4x4_16[y & 3][x & 3];
+			break;
+		}
+	}
+}
+
+static inline int MulHi16(int a, int b) {
+	return (a * b) >> 16;
+}
+
+static inline u8 ClampU8(int v) {
+	return v < 0 ? 0 : (v > 255 ? 255 : (u8)v);
+}
+
+static void ConvertRowToRGB(u8 *r, u8 *g, u8 *b, const u8 *ySrc, const u8 *uSrc, const u8 *vSrc, int width) {
+	int x = 0;
+#if PPSSPP_ARCH(SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i offsetY = _mm_set1_epi16(16);
+	const __m128i offsetUV = _mm_set1_epi16(128);
+	const __m128i round = _mm_set1_epi16(4);
+	for (; x + 8 <= width; x += 8) {
+		u32 u4, v4;
+		memcpy(&u4, uSrc + x / 2, 4);
+		memcpy(&v4, vSrc + x / 2, 4);
+		// Each chroma sample covers two pixels.
+		__m128i u = _mm_cvtsi32_si128(u4);
+		__m128i v = _mm_cvtsi32_si128(v4);
+		u = _mm_unpacklo_epi8(_mm_unpacklo_epi8(u, u), zero);
+		v = _mm_unpacklo_epi8(_mm_unpacklo_epi8(v, v), zero);
+		__m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(ySrc + x)), zero);
+
+		y = _mm_slli_epi16(_mm_sub_epi16(y, offsetY), 7);
+		u = _mm_slli_epi16(_mm_sub_epi16(u, offsetUV), 7);
+		v = _mm_slli_epi16(_mm_sub_epi16(v, offsetUV), 7);
+		y = _mm_mulhi_epi16(y, _mm_set1_epi16(COEF_Y));
+
+		__m128i rv = _mm_add_epi16(y, _mm_mulhi_epi16(v, _mm_set1_epi16(COEF_VR)));
+		__m128i gv = _mm_sub_epi16(_mm_sub_epi16(y, _mm_mulhi_epi16(u, _mm_set1_epi16(COEF_UG))), _mm_mulhi_epi16(v, _mm_set1_epi16(COEF_VG)));
+		__m128i bv = _mm_add_epi16(y, _mm_mulhi_epi16(u, _mm_set1_epi16(COEF_UB)));
+		rv = _mm_srai_epi16(_mm_add_epi16(rv, round), 3);
+		gv = _mm_srai_epi16(_mm_add_epi16(gv, round), 3);
+		bv = _mm_srai_epi16(_mm_add_epi16(bv, round), 3);
+		_mm_storel_epi64((__m128i *)(r + x), _mm_packus_epi16(rv, rv));
+		_mm_storel_epi64((__m128i *)(g + x), _mm_packus_epi16(gv, gv));
+		_mm_storel_epi64((__m128i *)(b + x), _mm_packus_epi16(bv, bv));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	auto mulhi = [](int16x8_t a, int16_t c) {
+		const int16x4_t cv = vdup_n_s16(c);
+		return vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(a), cv), 16), vshrn_n_s32(vmull_s16(vget_high_s16(a), cv), 16));
+	};
+	const int16x8_t offsetY = vdupq_n_s16(16);
+	const int16x8_t offsetUV = vdupq_n_s16(128);
+	for (; x + 8 <= width; x += 8) {
+		u32 u4, v4;
+		memcpy(&u4, uSrc + x / 2, 4);
+		memcpy(&v4, vSrc + x / 2, 4);
+		// Each chroma sample covers two pixels.
+		const uint8x8_t u8x4 = vcreate_u8(u4);
+		const uint8x8_t v8x4 = vcreate_u8(v4);
+		int16x8_t u = vreinterpretq_s16_u16(vmovl_u8(vzip_u8(u8x4, u8x4).val[0]));
+		int16x8_t v = vreinterpretq_s16_u16(vmovl_u8(vzip_u8(v8x4, v8x4).val[0]));
+		int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(ySrc + x)));
+
+		y = vshlq_n_s16(vsubq_s16(y, offsetY), 7);
+		u = vshlq_n_s16(vsubq_s16(u, offsetUV), 7);
+		v = vshlq_n_s16(vsubq_s16(v, offsetUV), 7);
+		y = mulhi(y, COEF_Y);
+
+		int16x8_t rv = vaddq_s16(y, mulhi(v, COEF_VR));
+		int16x8_t gv = vsubq_s16(vsubq_s16(y, mulhi(u, COEF_UG)), mulhi(v, COEF_VG));
+		int16x8_t bv = vaddq_s16(y, mulhi(u, COEF_UB));
+		vst1_u8(r + x, vqmovun_s16(vrshrq_n_s16(rv, 3)));
+		vst1_u8(g + x, vqmovun_s16(vrshrq_n_s16(gv, 3)));
+		vst1_u8(b + x, vqmovun_s16(vrshrq_n_s16(bv, 3)));
+	}
+#endif
+	for (; x < width; x++) {
+		const int y = MulHi16((ySrc[x] - 16) << 7, COEF_Y);
+		const int u = (uSrc[x >> 1] - 128) << 7;
+		const int v = (vSrc[x >> 1] - 128) << 7;
+		r[x] = ClampU8((y + MulHi16(v, COEF_VR) + 4) >> 3);
+		g[x] = ClampU8((y - MulHi16(u, COEF_UG) - MulHi16(v, COEF_VG) + 4) >> 3);
+		b[x] = ClampU8((y + MulHi16(u, COEF_UB) + 4) >> 3);
+	}
+}
+
+static void PackRowRGBA(u8 *dst, const u8 *r, const u8 *g, const u8 *b, int width) {
+	int x = 0;
+#if PPSSPP_ARCH(SSE2)
+	const __m128i alpha = _mm_set1_epi8((char)0xFF);
+	for (; x + 16 <= width; x += 16) {
+		const __m128i rv = _mm_loadu_si128((const __m128i *)(r + x));
+		const __m128i gv = _mm_loadu_si128((const __m128i *)(g + x));
+		const __m128i bv = _mm_loadu_si128((const __m128i *)(b + x));
+		const __m128i rgLo = _mm_unpacklo_epi8(rv, gv);
+		const __m128i rgHi = _mm_unpackhi_epi8(rv, gv);
+		const __m128i baLo = _mm_unpacklo_epi8(bv, alpha);
+		const __m128i baHi = _mm_unpackhi_epi8(bv, alpha);
+		__m128i *out = (__m128i *)(dst + x * 4);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(rgLo, baLo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLo, baLo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHi, baHi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHi, baHi));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; x + 8 <= width; x += 8) {
+		uint8x8x4_t pixels;
+		pixels.val[0] = vld1_u8(r + x);
+		pixels.val[1] = vld1_u8(g + x);
+		pixels.val[2] = vld1_u8(b + x);
+		pixels.val[3] = vdup_n_u8(0xFF);
+		vst4_u8(dst + x * 4, pixels);
+	}
+#endif
+	for (; x < width; x++) {
+		dst[x * 4 + 0] = r[x];
+		dst[x * 4 + 1] = g[x];
+		dst[x * 4 + 2] = b[x];
+		dst[x * 4 + 3] = 0xFF;
+	}
+}
+
+// Dithers, then keeps the top bits of each channel: red at the bottom, then green at GP and blue at BP.
+template <int RS, int GS, int BS, int GP, int BP>
+static void PackRow16(u16 *dst, const u8 *r, const u8 *g, const u8 *b, const RowDither &d, int width) {
+	int x = 0;
+#if PPSSPP_ARCH(SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i dr = _mm_loadl_epi64((const __m128i *)d.r);
+	const __m128i dg = _mm_loadl_epi64((const __m128i *)d.g);
+	const __m128i db = _mm_loadl_epi64((const __m128i *)d.b);
+	for (; x + 8 <= width; x += 8) {
+		const __m128i rv = _mm_unpacklo_epi8(_mm_adds_epu8(_mm_loadl_epi64((const __m128i *)(r + x)), dr), zero);
+		const __m128i gv = _mm_unpacklo_epi8(_mm_adds_epu8(_mm_loadl_epi64((const __m128i *)(g + x)), dg), zero);
+		const __m128i bv = _mm_unpacklo_epi8(_mm_adds_epu8(_mm_loadl_epi64((const __m128i *)(b + x)), db), zero);
+		__m128i pixels = _mm_srli_epi16(rv, RS);
+		pixels = _mm_or_si128(pixels, _mm_slli_epi16(_mm_srli_epi16(gv, GS), GP));
+		pixels = _mm_or_si128(pixels, _mm_slli_epi16(_mm_srli_epi16(bv, BS), BP));
+		_mm_storeu_si128((__m128i *)(dst + x), pixels);
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint8x8_t dr = vld1_u8(d.r);
+	const uint8x8_t dg = vld1_u8(d.g);
+	const uint8x8_t db = vld1_u8(d.b);
+	for (; x + 8 <= width; x += 8) {
+		const uint16x8_t rv = vmovl_u8(vqadd_u8(vld1_u8(r + x), dr));
+		const uint16x8_t gv = vmovl_u8(vqadd_u8(vld1_u8(g + x), dg));
+		const uint16x8_t bv = vmovl_u8(vqadd_u8(vld1_u8(b + x), db));
+		uint16x8_t pixels = vshrq_n_u16(rv, RS);
+		pixels = vorrq_u16(pixels, vshlq_n_u16(vshrq_n_u16(gv, GS), GP));
+		pixels = vorrq_u16(pixels, vshlq_n_u16(vshrq_n_u16(bv, BS), BP));
+		vst1q_u16(dst + x, pixels);
+	}
+#endif
+	for (; x < width; x++) {
+		const int rd = std::min(r[x] + d.r[x & 15], 255);
+		const int gd = std::min(g[x] + d.g[x & 15], 255);
+		const int bd = std::min(b[x] + d.b[x & 15], 255);
+		dst[x] = (u16)((rd >> RS) | ((gd >> GS) << GP) | ((bd >> BS) << BP));
+	}
+}
+
+void ConvertYUV420ToPSP(u8 *dst, int dstStride, const u8 *const src[3], const int srcStride[3], int width, int yStart, int yEnd, int pspFormat) {
+	alignas(16) u8 r[VIDEO_CONVERT_MAX_WIDTH];
+	alignas(16) u8 g[VIDEO_CONVERT_MAX_WIDTH];
+	alignas(16) u8 b[VIDEO_CONVERT_MAX_WIDTH];
+	RowDither dither;
+	for (int y = yStart; y < yEnd; y++) {
+		ConvertRowToRGB(r, g, b, src[0] + y * srcStride[0], src[1] + (y >> 1) * srcStride[1], src[2] + (y >> 1) * srcStride[2], width);
+
+		u8 *out = dst + y * dstStride;
+		if (pspFormat != GE_CMODE_32BIT_ABGR8888)
+			SetupDither(dither, y, pspFormat);
+		switch (pspFormat) {
+		case GE_CMODE_32BIT_ABGR8888:
+			PackRowRGBA(out, r, g, b, width);
+			break;
+		case GE_CMODE_16BIT_BGR5650:
+			PackRow16<3, 2, 3, 5, 11>((u16 *)out, r, g, b, dither, width);
+			break;
+		case GE_CMODE_16BIT_ABGR5551:
+			PackRow16<3, 3, 3, 5, 10>((u16 *)out, r, g, b, dither, width);
+			break;
+		case GE_CMODE_16BIT_ABGR4444:
+			PackRow16<4, 4, 4, 4, 8>((u16 *)out, r, g, b, dither, width);
+			break;
+		}
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Frames wider than this go through swscale instead.
+enum { VIDEO_CONVERT_MAX_WIDTH = 2048 };
+
+// Converts rows [yStart, yEnd) of a YUV 4:2:0 frame (limited range BT.601, like the PSP's decoder) to
+// a PSP pixel format (GE_CMODE_*). This is what swscale did for MediaEngine: chroma isn't
+// interpolated, 16-bit formats get the same kind of ordered dither, alpha is opaque in 8888 and zero
+// in the 16-bit formats. dst and src point at the first row of the whole frame.
+void ConvertYUV420ToPSP(u8 *dst, int dstStride, const u8 *const src[3], const int srcStride[3], int width, int yStart, int yEnd, int pspFormat);
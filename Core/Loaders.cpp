@@ -17,6 +17,8 @@
 
 #include <algorithm>
 
+#include "ppsspp_config.h"
+
 #include "Common/File/FileUtil.h"
 #include "Common/File/Path.h"
 #include "Common/StringUtils.h"
@@ -25,12 +27,14 @@
 #include "Core/FileLoaders/DiskCachingFileLoader.h"
 #include "Core/FileLoaders/HTTPFileLoader.h"
 #include "Core/FileLoaders/LocalFileLoader.h"
+#include "Core/FileLoaders/MappedFileLoader.h"
 #include "Core/FileLoaders/RetryingFileLoader.h"
 #include "Core/FileLoaders/ZipFileLoader.h"
 #include "Core/FileSystems/MetaFileSystem.h"
 #include "Core/PSPLoaders.h"
 #include "Core/MemMap.h"
 #include "Core/Loaders.h"
+#include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/System.h"
 #include "Core/ELF/PBPReader.h"
@@ -46,6 +50,12 @@ FileLoader *ConstructFileLoader(const Path &filename) {
 		}
 		return new CachingFileLoader(baseLoader);
 	}
+#if PPSSPP_ARCH(64BIT) && !defined(HAVE_LIBRETRO_VFS)
+	// Plenty of address space to map a whole ISO. Compressed images wouldn't gain much.
+	if (g_Config.bMemoryMapIso && filename.GetFileExtension() == ".iso") {
+		return new MappedFileLoader(new LocalFileLoader(filename));
+	}
+#endif
 	return new LocalFileLoader(filename);
 }
 
@@ -83,7 +93,7 @@ IdentifiedFileType Identify_File(FileLoader *fileLoader, std::string *errorStrin
 			// maybe it also just happened to have that size, let's assume it's a PSP ISO and error out later if it's not.
 		}
 		return IdentifiedFileType::PSP_ISO;
-	} else if (extension == ".cso" || extension == ".chd") {
+	} else if (extension == ".cso" || extension == ".chd" || extension == ".psz") {
 		return IdentifiedFileType::PSP_ISO;
 	} else if (extension == ".ppst") {
 		return IdentifiedFileType::PPSSPP_SAVESTATE;
@@ -159,6 +169,8 @@ IdentifiedFileType Identify_File(FileLoader *fileLoader, std::string *errorStrin
 		// CISO are not used for many other kinds of ISO so let's just guess it's a PSP one and let it
 		// fail later...
 		return IdentifiedFileType::PSP_ISO;
+	} else if (!memcmp(&_id, "PSZI", 4)) {
+		return IdentifiedFileType::PSP_ISO;
 	} else if (!memcmp(&_id, "MCom", 4)) {
 		size_t readSize = fileLoader->ReadAt(4, 4, 1, &_id);
 		if (!memcmp(&_id, "prHD", 4)) {
@@ -460,7 +472,7 @@ void DetectZipFileContents(struct zip *z, ZipFileInfo *info) {
 				INFO_LOG(Log::HLE, "Wrong number of slashes (%i) in '%s'", slashCount, fn);
 			}
 			// TODO: Extract icon and param.sfo from the pbp to be able to display it on the install screen.
-		} else if (endsWith(zippedName, ".iso") || endsWith(zippedName, ".cso") || endsWith(zippedName, ".chd")) {
+		} else if (endsWith(zippedName, ".iso") || endsWith(zippedName, ".cso") || endsWith(zippedName, ".chd") || endsWith(zippedName, ".psz")) {
 			if (slashCount <= 1) {
 				// We only do this if the ISO file is in the root or one level down.
 				isZippedISO = true;
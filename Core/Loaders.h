@@ -26,6 +26,7 @@
 #include "ext/libzip/zip.h"
 #endif
 #include "Common/CommonTypes.h"
+#include "Common/File/MappedFile.h"
 #include "Common/File/Path.h"
 
 enum class IdentifiedFileType {
@@ -97,6 +98,14 @@ class FileLoader {
 	virtual std::string LatestError() const {
 		return "";
 	}
+
+	// Direct access to the file's bytes, if the range is memory mapped (see MappedFileLoader.)
+	// Otherwise nullptr, use ReadAt.
+	virtual const u8 *MappedPointer(s64 absolutePos, s64 bytes) {
+		return nullptr;
+	}
+	// Access pattern hint, ignored by loaders that can't use it.
+	virtual void Advise(s64 absolutePos, s64 bytes, MappedFileAdvice advice) {}
 };
 
 class ProxiedFileLoader : public FileLoader {
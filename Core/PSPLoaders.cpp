@@ -33,6 +33,7 @@
 #include "Core/FileSystems/DirectoryFileSystem.h"
 #include "Core/FileSystems/ISOFileSystem.h"
 #include "Core/FileSystems/MetaFileSystem.h"
+#include "Core/FileSystems/TracingBlockDevice.h"
 #include "Core/FileSystems/VirtualDiscFileSystem.h"
 
 #include "Core/Loaders.h"
@@ -73,6 +74,10 @@ bool MountGameISO(FileLoader *fileLoader, std::string *errorString) {
 			// Can only fail if the ISO is bad.
 			return false;
 		}
+		// Headless is usually running tests, no need to leave traces around.
+		if (g_Config.bDiscPrefetch && !PSP_CoreParameter().headLess) {
+			bd = new TracingBlockDevice(bd, fileLoader);
+		}
 
 		auto iso = std::make_shared<ISOFileSystem>(&pspFileSystem, bd);
 		fileSystem = iso;
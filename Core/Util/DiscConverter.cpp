@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <zstd.h>
+#include <zdict.h>
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/FileSystems/BlockDevices.h"
+#include "Core/Util/DiscConverter.h"
+
+// How much to read and compress per step.
+static const u32 BATCH_BYTES = 8 * 1024 * 1024;
+static const u32 MAX_FRAME_SIZE = 1024 * 1024;
+// zstd recommends around 100x the dictionary size in samples.
+static const u32 DICT_SAMPLE_FACTOR = 100;
+
+static bool ReadFrames(BlockDevice *source, u32 frameSize, u32 firstFrame, u32 count, u8 *dest) {
+	const u32 blocksPerFrame = frameSize / source->GetBlockSize();
+	const u32 minBlock = firstFrame * blocksPerFrame;
+	const u32 endBlock = std::min(minBlock + count * blocksPerFrame, source->GetNumBlocks());
+	return source->ReadBlocks(minBlock, endBlock - minBlock, dest);
+}
+
+static std::vector<u8> TrainDictionary(BlockDevice *source, const PSZOptions &options, u32 numFrames) {
+	const u32 frameSize = options.frameSize;
+	const u32 numSamples = std::min(numFrames, std::max(1U, (u32)((u64)options.dictSize * DICT_SAMPLE_FACTOR / frameSize)));
+
+	// Spread the samples over the whole image, a disc tends to be grouped by kind of data.
+	std::vector<u8> samples((size_t)numSamples * frameSize);
+	std::vector<size_t> sampleSizes;
+	size_t pos = 0;
+	for (u32 i = 0; i < numSamples; ++i) {
+		const u32 frame = (u32)((u64)i * numFrames / numSamples);
+		if (frame == numFrames - 1) {
+			// Might be short, just skip it.
+			continue;
+		}
+		if (!ReadFrames(source, frameSize, frame, 1, samples.data() + pos)) {
+			continue;
+		}
+		sampleSizes.push_back(frameSize);
+		pos += frameSize;
+	}
+
+	std::vector<u8> dict(options.dictSize);
+	size_t result = ZDICT_trainFromBuffer(dict.data(), dict.size(), samples.data(), sampleSizes.data(), (unsigned)sampleSizes.size());
+	if (ZDICT_isError(result)) {
+		WARN_LOG(Log::Loader, "PSZ: dictionary training failed (%s), compressing without", ZDICT_getErrorName(result));
+		return std::vector<u8>();
+	}
+	dict.resize(result);
+	return dict;
+}
+
+bool ConvertToPSZ(BlockDevice *source, const Path &outFile, const PSZOptions &options, std::string *error, std::function<void(float)> progress) {
+	const u32 blockSize = source->GetBlockSize();
+	const u32 frameSize = options.frameSize;
+	if (frameSize == 0 || frameSize > MAX_FRAME_SIZE || (frameSize % blockSize) != 0) {
+		*error = StringFromFormat("Frame size %d unsupported, must be a multiple of %d up to %d", frameSize, blockSize, MAX_FRAME_SIZE);
+		return false;
+	}
+
+	const u64 totalBytes = (u64)source->GetNumBlocks() * blockSize;
+	const u32 numFrames = (u32)((totalBytes + frameSize - 1) / frameSize);
+	auto frameBytes = [&](u32 frame) {
+		return (u32)std::min((u64)frameSize, totalBytes - (u64)frame * frameSize);
+	};
+
+	std::vector<u8> dict;
+	if (options.dictionary && numFrames > 1) {
+		dict = TrainDictionary(source, options, numFrames);
+	}
+
+	File::IOFile out(outFile, "wb");
+	if (!out.IsOpen()) {
+		*error = StringFromFormat("Could not open %s for writing", outFile.ToVisualString().c_str());
+		return false;
+	}
+
+	PSZHeader header{};
+	memcpy(header.magic, "PSZI", 4);
+	header.version = PSZ_VERSION;
+	header.totalBytes = totalBytes;
+	header.frameSize = frameSize;
+	header.numFrames = numFrames;
+	header.dictSize = (u32)dict.size();
+
+	// The index is filled in at the end.
+	std::vector<u64_le> index(numFrames + 1);
+	out.WriteBytes(&header, sizeof(header));
+	out.WriteArray(index.data(), index.size());
+	if (!dict.empty()) {
+		out.WriteBytes(dict.data(), dict.size());
+	}
+	u64 pos = sizeof(header) + index.size() * sizeof(u64_le) + dict.size();
+
+	ZSTD_CDict *cdict = dict.empty() ? nullptr : ZSTD_createCDict(dict.data(), dict.size(), options.level);
+
+	const u32 batchFrames = std::max(BATCH_BYTES / frameSize, 16U);
+	std::vector<u8> input((size_t)batchFrames * frameSize);
+	std::vector<std::vector<u8>> output(batchFrames);
+	bool success = true;
+	for (u32 batch = 0; batch < numFrames && success; batch += batchFrames) {
+		const u32 count = std::min(batchFrames, numFrames - batch);
+		if (!ReadFrames(source, frameSize, batch, count, input.data())) {
+			*error = StringFromFormat("Read error in frames %d-%d of the source image", batch, batch + count - 1);
+			success = false;
+			break;
+		}
+
+		ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+			ZSTD_CCtx *cctx = ZSTD_createCCtx();
+			for (int i = lower; i < upper; ++i) {
+				const u32 bytes = frameBytes(batch + i);
+				const u8 *src = input.data() + (size_t)i * frameSize;
+				std::vector<u8> &dst = output[i];
+				dst.resize(ZSTD_compressBound(bytes));
+
+				size_t result;
+				if (cdict) {
+					result = ZSTD_compress_usingCDict(cctx, dst.data(), dst.size(), src, bytes, cdict);
+				} else {
+					result = ZSTD_compressCCtx(cctx, dst.data(), dst.size(), src, bytes, options.level);
+				}
+				if (ZSTD_isError(result) || result >= bytes) {
+					// Incompressible (or failed), store it. The reader tells by the size.
+					dst.assign(src, src + bytes);
+				} else {
+					dst.resize(result);
+				}
+			}
+			ZSTD_freeCCtx(cctx);
+		}, 0, (int)count, 1);
+
+		for (u32 i = 0; i < count; ++i) {
+			index[batch + i] = pos;
+			out.WriteBytes(output[i].data(), output[i].size());
+			pos += output[i].size();
+		}
+		if (progress) {
+			progress((float)(batch + count) / (float)numFrames);
+		}
+	}
+	index[numFrames] = pos;
+	ZSTD_freeCDict(cdict);
+
+	if (success) {
+		out.Seek(sizeof(header), SEEK_SET);
+		out.WriteArray(index.data(), index.size());
+		if (!out.IsGood()) {
+			*error = StringFromFormat("Failed writing %s", outFile.ToVisualString().c_str());
+			success = false;
+		}
+	}
+	out.Close();
+
+	if (!success) {
+		File::Delete(outFile);
+		return false;
+	}
+	INFO_LOG(Log::Loader, "PSZ: wrote %s, %lld -> %lld bytes in %d frames", outFile.ToVisualString().c_str(), (long long)totalBytes, (long long)pos, numFrames);
+	return true;
+}
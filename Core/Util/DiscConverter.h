@@ -0,0 +1,24 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+class BlockDevice;
+class Path;
+
+struct PSZOptions {
+	// Uncompressed bytes per frame, a multiple of 2048. Larger frames compress better, but a
+	// random read has to decompress a whole frame.
+	u32 frameSize = 32 * 1024;
+	int level = 12;
+	// Trains a zstd dictionary on the image's own frames. Mostly helps with small frames.
+	bool dictionary = false;
+	u32 dictSize = 112 * 1024;
+};
+
+// Writes a seekable zstd image (.psz, see PSZHeader) from anything that can be opened as a
+// BlockDevice, so ISO, CSO and CHD all work. Frames are compressed on the thread pool.
+// progress, if set, is called on the calling thread with values from 0 to 1.
+bool ConvertToPSZ(BlockDevice *source, const Path &outFile, const PSZOptions &options, std::string *error, std::function<void(float)> progress = nullptr);
@@ -77,7 +77,7 @@ static ServerStatus RetrieveStatus() {
 static bool RegisterServer(int port) {
 	bool success = false;
 	http::Client http;
-	bool cancelled = false;
+	std::atomic<bool> cancelled{};
 	net::RequestProgress progress(&cancelled);
 	Buffer theVoid = Buffer::Void();
 
@@ -126,7 +126,7 @@ static bool RegisterServer(int port) {
 
 bool RemoteISOFileSupported(const std::string &filename) {
 	// Disc-like files.
-	if (endsWithNoCase(filename, ".cso") || endsWithNoCase(filename, ".iso") || endsWithNoCase(filename, ".chd")) {
+	if (endsWithNoCase(filename, ".cso") || endsWithNoCase(filename, ".iso") || endsWithNoCase(filename, ".chd") || endsWithNoCase(filename, ".psz")) {
 		return true;
 	}
 	// May work - but won't have supporting files.
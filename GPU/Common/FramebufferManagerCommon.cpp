@@ -44,6 +44,88 @@ static size_t FormatFramebufferName(const VirtualFramebuffer *vfb, char *tag, si
 	return snprintf(tag, len, "FB_%08x_%08x_%dx%d_%s", vfb->fb_address, vfb->z_address, vfb->bufferWidth, vfb->bufferHeight, GeBufferFormatToString(vfb->fb_format));
 }
 
+static inline int DirtyTileIndex(int px) {
+	return std::min(std::max(px, 0) >> FramebufferDirtyTiles::TILE_SHIFT, FramebufferDirtyTiles::MAX_TILES - 1);
+}
+
+static inline u16 DirtyTileMask(int t1, int t2) {
+	return (u16)(((1 << (t2 + 1)) - 1) & ~((1 << t1) - 1));
+}
+
+void FramebufferDirtyTiles::Mark(int x, int y, int w, int h) {
+	if (w <= 0 || h <= 0) {
+		return;
+	}
+	const u16 mask = DirtyTileMask(DirtyTileIndex(x), DirtyTileIndex(x + w - 1));
+	for (int ty = DirtyTileIndex(y); ty <= DirtyTileIndex(y + h - 1); ty++) {
+		syncedRows[ty] &= ~mask;
+	}
+}
+
+void FramebufferDirtyTiles::MarkSynced(int x, int y, int w, int h, int limitW, int limitH) {
+	const int x2 = std::min(x + w, limitW);
+	const int y2 = std::min(y + h, limitH);
+	if (x2 <= x || y2 <= y) {
+		return;
+	}
+
+	// A tile is only synced if the rect covers all of the part of it that's inside the framebuffer.
+	u16 mask = 0;
+	for (int tx = DirtyTileIndex(x); tx <= DirtyTileIndex(x2 - 1); tx++) {
+		const int start = tx << TILE_SHIFT;
+		const int end = tx == MAX_TILES - 1 ? limitW : std::min((tx + 1) << TILE_SHIFT, limitW);
+		if (x <= start && x2 >= end) {
+			mask |= 1 << tx;
+		}
+	}
+	for (int ty = DirtyTileIndex(y); ty <= DirtyTileIndex(y2 - 1); ty++) {
+		const int start = ty << TILE_SHIFT;
+		const int end = ty == MAX_TILES - 1 ? limitH : std::min((ty + 1) << TILE_SHIFT, limitH);
+		if (y <= start && y2 >= end) {
+			syncedRows[ty] |= mask;
+		}
+	}
+}
+
+bool FramebufferDirtyTiles::ClipToDirty(int *x, int *y, int *w, int *h) const {
+	if (*w <= 0 || *h <= 0) {
+		return false;
+	}
+
+	const int tx1 = DirtyTileIndex(*x);
+	const int tx2 = DirtyTileIndex(*x + *w - 1);
+	const u16 mask = DirtyTileMask(tx1, tx2);
+	int minTX = MAX_TILES, maxTX = -1, minTY = MAX_TILES, maxTY = -1;
+	for (int ty = DirtyTileIndex(*y); ty <= DirtyTileIndex(*y + *h - 1); ty++) {
+		const u16 dirty = ~syncedRows[ty] & mask;
+		if (!dirty) {
+			continue;
+		}
+		minTY = std::min(minTY, ty);
+		maxTY = ty;
+		for (int tx = tx1; tx <= tx2; tx++) {
+			if (dirty & (1 << tx)) {
+				minTX = std::min(minTX, tx);
+				maxTX = std::max(maxTX, tx);
+			}
+		}
+	}
+	if (maxTY < 0) {
+		return false;
+	}
+
+	// The last tile extends to infinity, so don't cut anything off there.
+	const int x1 = std::max(*x, minTX << TILE_SHIFT);
+	const int y1 = std::max(*y, minTY << TILE_SHIFT);
+	const int x2 = maxTX == MAX_TILES - 1 ? *x + *w : std::min(*x + *w, (maxTX + 1) << TILE_SHIFT);
+	const int y2 = maxTY == MAX_TILES - 1 ? *y + *h : std::min(*y + *h, (maxTY + 1) << TILE_SHIFT);
+	*x = x1;
+	*y = y1;
+	*w = x2 - x1;
+	*h = y2 - y1;
+	return true;
+}
+
 FramebufferManagerCommon::FramebufferManagerCommon(Draw::DrawContext *draw)
 	: draw_(draw), draw2D_(draw_) {
 	presentation_ = new PresentationCommon(draw);
@@ -766,6 +848,7 @@ static const char *reinterpretStrings[4][4] = {
 
 // Call this after the target has been bound for rendering. For color, raster is probably always going to win over blits/copies.
 void FramebufferManagerCommon::CopyToColorFromOverlappingFramebuffers(VirtualFramebuffer *dst) {
+	dst->dirtyTiles.MarkAll();
 	if (!useBufferedRendering_) {
 		return;
 	}
@@ -1172,8 +1255,17 @@ void FramebufferManagerCommon::UpdateFromMemory(u32 addr, int size) {
 					// TODO: This doesn't seem quite right anymore.
 					fmt = displayFormat_;
 				}
-				DrawPixels(vfb, 0, 0, Memory::GetPointerUnchecked(addr), fmt, vfb->fb_stride, vfb->width, vfb->height, RASTER_COLOR, "UpdateFromMemory_DrawPixels");
-				SetColorUpdated(vfb, gstate_c.skipDrawReason);
+				// Only upload the rows that were actually written.
+				const int bpp = BufferFormatBytesPerPixel(fmt);
+				const int strideBytes = vfb->fb_stride * bpp;
+				int rows = vfb->height;
+				if (size > 0 && strideBytes > 0) {
+					rows = std::min(rows, (size + strideBytes - 1) / strideBytes);
+					gpuStats.numUploadBytesSkipped += (vfb->height - rows) * vfb->width * bpp;
+				}
+				DrawPixels(vfb, 0, 0, Memory::GetPointerUnchecked(addr), fmt, vfb->fb_stride, vfb->width, rows, RASTER_COLOR, "UpdateFromMemory_DrawPixels");
+				SetColorUpdated(vfb, gstate_c.skipDrawReason, 0, 0, vfb->width, rows);
+				vfb->dirtyTiles.MarkSynced(0, 0, vfb->width, rows, vfb->width, vfb->height);
 			} else {
 				INFO_LOG(Log::FrameBuf, "Invalidating FBO for %08x (%dx%d %s)", vfb->fb_address, vfb->width, vfb->height, GeBufferFormatToString(vfb->fb_format));
 				DestroyFramebuf(vfb);
@@ -1189,6 +1281,10 @@ void FramebufferManagerCommon::UpdateFromMemory(u32 addr, int size) {
 }
 
 void FramebufferManagerCommon::DrawPixels(VirtualFramebuffer *vfb, int dstX, int dstY, const u8 *srcPixels, GEBufferFormat srcPixelFormat, int srcStride, int width, int height, RasterChannel channel, const char *tag) {
+	if (vfb && channel == RASTER_COLOR) {
+		// Callers uploading the framebuffer's own memory mark this synced afterwards.
+		vfb->dirtyTiles.Mark(dstX, dstY, width, height);
+	}
 	textureCache_->ForgetLastTexture();
 	shaderManager_->DirtyLastShader();
 	float u0 = 0.0f, u1 = 1.0f;
@@ -1895,6 +1991,8 @@ void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w,
 	}
 	DiscardFramebufferCopy();
 	currentRenderVfb_ = vfb;
+	// The new FBO was cleared (and maybe partially copied into), so no longer matches RAM.
+	vfb->dirtyTiles.MarkAll();
 
 	if (!vfb->fbo) {
 		ERROR_LOG(Log::FrameBuf, "Error creating FBO during resize! %dx%d", vfb->renderWidth, vfb->renderHeight);
@@ -2668,7 +2766,7 @@ bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dst
 			// Some backends can handle blitting within a framebuffer. Others will just have to deal with it or ignore it, apparently.
 			BlitFramebuffer(dstRect.vfb, dstX, dstY, srcRect.vfb, srcX, srcY, dstRect.w_bytes / bpp, dstRect.h, bpp, dstRect.channel, "Blit_IntraBufferBlockTransfer");
 			RebindFramebuffer("rebind after intra block transfer");
-			SetColorUpdated(dstRect.vfb, skipDrawReason);
+			SetColorUpdated(dstRect.vfb, skipDrawReason, dstX, dstY, dstRect.w_bytes / bpp, dstRect.h);
 			return true;  // Skip the memory copy.
 		}
 
@@ -2690,7 +2788,7 @@ bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dst
 			FlushBeforeCopy();
 			BlitFramebuffer(dstRect.vfb, dstRect.x_bytes / bpp, dstRect.y, srcRect.vfb, srcRect.x_bytes / bpp, srcRect.y, srcRect.w_bytes / bpp, height, bpp, srcRect.channel, "Blit_InterBufferBlockTransfer");
 			RebindFramebuffer("RebindFramebuffer - Inter-buffer block transfer");
-			SetColorUpdated(dstRect.vfb, skipDrawReason);
+			SetColorUpdated(dstRect.vfb, skipDrawReason, dstRect.x_bytes / bpp, dstRect.y, srcRect.w_bytes / bpp, height);
 			return true;
 		}
 
@@ -2805,13 +2903,26 @@ void FramebufferManagerCommon::NotifyBlockTransferAfter(u32 dstBasePtr, int dstS
 				// Resizing may change the viewport/etc.
 				gstate_c.Dirty(DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_CULLRANGE);
 			}
-			DrawPixels(dstRect.vfb, static_cast<int>(dstX * dstXFactor), dstY, srcBase, dstRect.vfb->fb_format, static_cast<int>(srcStride * dstXFactor), static_cast<int>(dstRect.w_bytes / bpp * dstXFactor), dstRect.h, RASTER_COLOR, "BlockTransferCopy_DrawPixels");
-			SetColorUpdated(dstRect.vfb, skipDrawReason);
+			const int uploadX = static_cast<int>(dstX * dstXFactor);
+			const int uploadW = static_cast<int>(dstRect.w_bytes / bpp * dstXFactor);
+			DrawPixels(dstRect.vfb, uploadX, dstY, srcBase, dstRect.vfb->fb_format, static_cast<int>(srcStride * dstXFactor), uploadW, dstRect.h, RASTER_COLOR, "BlockTransferCopy_DrawPixels");
+			SetColorUpdated(dstRect.vfb, skipDrawReason, uploadX, dstY, uploadW, dstRect.h);
+			// RAM got the same data by the memory copy, so this area is in sync.
+			dstRect.vfb->dirtyTiles.MarkSynced(uploadX, dstY, uploadW, dstRect.h, dstRect.vfb->width, dstRect.vfb->height);
 			RebindFramebuffer("RebindFramebuffer - NotifyBlockTransferAfter");
 		}
 	}
 }
 
+void FramebufferManagerCommon::SetColorUpdated(int skipDrawReason) {
+	if (currentRenderVfb_) {
+		// Nothing can be drawn outside the scissor, so that's a good enough bound for dirty tracking.
+		const int x1 = gstate.getScissorX1();
+		const int y1 = gstate.getScissorY1();
+		SetColorUpdated(currentRenderVfb_, skipDrawReason, x1, y1, gstate.getScissorX2() + 1 - x1, gstate.getScissorY2() + 1 - y1);
+	}
+}
+
 void FramebufferManagerCommon::SetSafeSize(u16 w, u16 h) {
 	VirtualFramebuffer *vfb = currentRenderVfb_;
 	if (vfb) {
@@ -3223,9 +3334,24 @@ void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb,
 		}
 	}
 
+	if (channel == RASTER_COLOR && w > 0 && h > 0) {
+		// Skip anything that hasn't been drawn to since it was last read back or uploaded.
+		const int bpp = BufferFormatBytesPerPixel(vfb->fb_format);
+		const int fullPixels = w * h;
+		if (!vfb->dirtyTiles.ClipToDirty(&x, &y, &w, &h)) {
+			gpuStats.numReadbackBytesSkipped += fullPixels * bpp;
+			return;
+		}
+		gpuStats.numReadbackBytesSkipped += (fullPixels - w * h) * bpp;
+	}
+
 	// This handles any required stretching internally.
 	ReadbackFramebuffer(vfb, x, y, w, h, channel, mode);
 
+	if (channel == RASTER_COLOR) {
+		vfb->dirtyTiles.MarkSynced(x, y, w, h, vfb->width, vfb->height);
+	}
+
 	draw_->Invalidate(InvalidationFlags::CACHED_RENDER_STATE);
 	textureCache_->ForgetLastTexture();
 	RebindFramebuffer("RebindFramebuffer - ReadFramebufferToMemory");
@@ -3418,6 +3544,10 @@ void FramebufferManagerCommon::BlitFramebuffer(VirtualFramebuffer *dst, int dstX
 		return;
 	}
 
+	if (channel == RASTER_COLOR) {
+		dst->dirtyTiles.Mark(dstX, dstY, w, h);
+	}
+
 	// Perform a little bit of clipping first.
 	// Block transfer coords are unsigned so I don't think we need to clip on the left side.. Although there are
 	// other uses for BlitFramebuffer.
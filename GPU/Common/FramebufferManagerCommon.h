@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <cstring>
 #include <vector>
 #include <unordered_map>
 
@@ -62,6 +63,25 @@ namespace Draw {
 class VulkanFBO;
 class ShaderWriter;
 
+// Coarse tracking of which parts of a framebuffer's color have been drawn to since they were last
+// read back to, or uploaded from, RAM, so that readbacks and uploads can skip what's already in sync.
+// Tiles are 32x32 PSP pixels, anything beyond 512 shares the last row/column of tiles.
+// Stored as "synced" bits, so that a zero-initialized framebuffer is entirely dirty.
+struct FramebufferDirtyTiles {
+	static constexpr int TILE_SHIFT = 5;
+	static constexpr int MAX_TILES = 16;
+
+	void MarkAll() { memset(syncedRows, 0, sizeof(syncedRows)); }
+	void Mark(int x, int y, int w, int h);
+	// Only tiles entirely covered become synced. limitW/limitH should be the framebuffer size,
+	// so that tiles partially outside the framebuffer can still be synced.
+	void MarkSynced(int x, int y, int w, int h, int limitW, int limitH);
+	// Shrinks the rect to the bounding box of the dirty tiles it touches. Returns false if there are none.
+	bool ClipToDirty(int *x, int *y, int *w, int *h) const;
+
+	u16 syncedRows[MAX_TILES];
+};
+
 // We have to track VFBs and depth buffers together, since bits are shared between the color alpha channel
 // and the stencil buffer on the PSP.
 // Sometimes, virtual framebuffers need to share a Z buffer. We emulate this by copying from on to the next
@@ -129,6 +149,9 @@ struct VirtualFramebuffer {
 	// Means that the whole image has already been read back to memory - used when combining small readbacks (gameUsesSequentialCopies_).
 	bool memoryUpdated;
 
+	// Finer grained version of the above, for color only.
+	FramebufferDirtyTiles dirtyTiles;
+
 	// TODO: Fold into usageFlags?
 	bool dirtyAfterDisplay;
 	bool reallyDirtyAfterDisplay;  // takes frame skipping into account
@@ -430,11 +453,8 @@ class FramebufferManagerCommon {
 	int GetTargetStride() const { return currentRenderVfb_ ? currentRenderVfb_->fb_stride : 512; }
 	GEBufferFormat GetTargetFormat() const { return currentRenderVfb_ ? currentRenderVfb_->fb_format : displayFormat_; }
 
-	void SetColorUpdated(int skipDrawReason) {
-		if (currentRenderVfb_) {
-			SetColorUpdated(currentRenderVfb_, skipDrawReason);
-		}
-	}
+	// Called after draws to the current render target. Only the scissor rect is considered drawn.
+	void SetColorUpdated(int skipDrawReason);
 	void SetSafeSize(u16 w, u16 h);
 
 	void NotifyRenderResized(int msaaLevel);
@@ -546,7 +566,11 @@ class FramebufferManagerCommon {
 	int GetFramebufferLayers() const;
 
 	static void SetColorUpdated(VirtualFramebuffer *dstBuffer, int skipDrawReason) {
+		SetColorUpdated(dstBuffer, skipDrawReason, 0, 0, 0xFFFF, 0xFFFF);
+	}
+	static void SetColorUpdated(VirtualFramebuffer *dstBuffer, int skipDrawReason, int x, int y, int w, int h) {
 		dstBuffer->memoryUpdated = false;
+		dstBuffer->dirtyTiles.Mark(x, y, w, h);
 		dstBuffer->clutUpdatedBytes = 0;
 		dstBuffer->dirtyAfterDisplay = true;
 		dstBuffer->drawnWidth = dstBuffer->width;
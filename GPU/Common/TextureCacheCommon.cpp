@@ -33,6 +33,7 @@
 #include "Core/HDRemaster.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/System.h"
 #include "Core/HW/Display.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
@@ -870,17 +871,25 @@ void TextureCacheCommon::DecimateVideos() {
 	}
 }
 
-bool TextureCacheCommon::IsVideo(u32 texaddr) const {
+u32 TextureCacheCommon::VideoGeneration(u32 texaddr) const {
 	texaddr &= 0x3FFFFFFF;
 	for (auto &info : videos_) {
 		if (texaddr < info.addr) {
 			continue;
 		}
 		if (texaddr < info.addr + info.size) {
-			return true;
+			return info.generation;
+		}
+	}
+	return 0;
+}
+
+void TextureCacheCommon::InvalidateVideos(u32 addr, u32 size) {
+	for (auto &info : videos_) {
+		if (addr < info.addr + info.size && addr + size > info.addr) {
+			info.generation = ++videoGeneration_;
 		}
 	}
-	return false;
 }
 
 void TextureCacheCommon::HandleTextureChange(TexCacheEntry *const entry, const char *reason, bool initialMatch, bool doDelete) {
@@ -1313,11 +1322,21 @@ void TextureCacheCommon::NotifyConfigChanged() {
 	standardScaleFactor_ = scaleFactor;
 
 	replacer_.NotifyConfigChanged();
+	scaler_.NotifyConfigChanged(g_paramSFO.GetDiscID());
 }
 
 void TextureCacheCommon::NotifyWriteFormattedFromMemory(u32 addr, int size, int width, GEBufferFormat fmt) {
 	addr &= 0x3FFFFFFF;
-	videos_.push_back({ addr, (u32)size, gpuStats.numFlips });
+	// The decoder tells us about every frame it writes, so textures of the video don't need hashing.
+	for (auto &info : videos_) {
+		if (info.addr == addr) {
+			info.size = std::max(info.size, (u32)size);
+			info.flips = gpuStats.numFlips;
+			info.generation = ++videoGeneration_;
+			return;
+		}
+	}
+	videos_.push_back({ addr, (u32)size, gpuStats.numFlips, ++videoGeneration_ });
 }
 
 void TextureCacheCommon::LoadClut(u32 clutAddr, u32 loadBytes, GPURecord::Recorder *recorder) {
@@ -2177,6 +2196,8 @@ void TextureCacheCommon::ApplyTexture(bool doBind) {
 	// Okay, now actually rebuild the texture if needed.
 	if (nextNeedsRebuild_) {
 		_assert_(!entry->texturePtr);
+		entry->videoGeneration = VideoGeneration(entry->addr);
+		entry->videoCheckedFrame = gpuStats.numFlips;
 		BuildTexture(entry);
 		ForgetLastTexture();
 	}
@@ -2569,14 +2590,22 @@ void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
 bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
-	bool isVideo = IsVideo(entry->addr);
+	const u32 videoGeneration = VideoGeneration(entry->addr);
+	bool isVideo = videoGeneration != 0;
 	bool swizzled = gstate.isTextureSwizzled();
 
-	// Don't even check the texture, just assume it has changed.
-	if (isVideo && g_Config.bTextureBackoffCache) {
-		// Attempt to ensure the hash doesn't incorrectly match in if the video stops.
-		entry->fullhash = (entry->fullhash + 0xA535A535) * 11 + (entry->fullhash & 4);
-		return false;
+	if (isVideo) {
+		// A newer generation means the decoder or an invalidation wrote to it, no need to hash.
+		if (entry->videoGeneration != videoGeneration) {
+			// Attempt to ensure the hash doesn't incorrectly match in if the video stops.
+			entry->fullhash = (entry->fullhash + 0xA535A535) * 11 + (entry->fullhash & 4);
+			return false;
+		}
+		// The game can still write there itself without telling us, so trust it only until the next flip.
+		if (entry->videoCheckedFrame == gpuStats.numFlips) {
+			return true;
+		}
+		entry->videoCheckedFrame = gpuStats.numFlips;
 	}
 
 	u32 fullhash;
@@ -2661,6 +2690,9 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 	addr &= 0x3FFFFFFF;
 	const u32 addr_end = addr + size;
 
+	// Anything that writes to a video makes its textures reload, hashing or not.
+	InvalidateVideos(addr, size);
+
 	if (type == GPU_INVALIDATE_ALL) {
 		// This is an active signal from the game that something in the texture cache may have changed.
 		gstate_c.Dirty(DIRTY_TEXTURE_IMAGE);
@@ -2720,6 +2752,8 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 }
 
 void TextureCacheCommon::InvalidateAll(GPUInvalidationType /*unused*/) {
+	InvalidateVideos(0, 0xFFFFFFFF);
+
 	// If we're hashing every use, without backoff, then this isn't needed.
 	if (!g_Config.bTextureBackoffCache) {
 		return;
@@ -3033,7 +3067,9 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, s
 		int scaledW = w, scaledH = h;
 		if (plan.scaleFactor > 1) {
 			// Note that this updates w and h!
-			scaler_.ScaleAlways((u32 *)data, pixelData, w, h, &scaledW, &scaledH, plan.scaleFactor);
+			if (!scaler_.ScaleAlways((u32 *)data, pixelData, w, h, &scaledW, &scaledH, plan.scaleFactor)) {
+				entry.status |= TexCacheEntry::STATUS_TO_SCALE;
+			}
 			pixelData = (u32 *)data;
 
 			decPitch = scaledW * sizeof(u32);
@@ -199,6 +199,10 @@ struct TexCacheEntry {
 	u32 fullhash;
 	u32 cluthash;
 	u16 maxSeenV;
+	// TextureCacheCommon::VideoGeneration() of the contents, so video frames are only reloaded when they change.
+	u32 videoGeneration;
+	// gpuStats.numFlips when a video texture was last loaded or hashed, so it's hashed at most once per flip.
+	int videoCheckedFrame;
 	ReplacedTexture *replacedTexture;
 
 	TexStatus GetHashStatus() {
@@ -397,6 +401,8 @@ class TextureCacheCommon {
 		u32 addr;
 		u32 size;
 		int flips;
+		// Bumped on every decoded frame and every invalidation of the range.
+		u32 generation;
 	};
 
 	const std::vector<VideoInfo> &Videos() const {
@@ -457,7 +463,12 @@ class TextureCacheCommon {
 	virtual void BoundFramebufferTexture() {}
 
 	void DecimateVideos();
-	bool IsVideo(u32 texaddr) const;
+	bool IsVideo(u32 texaddr) const {
+		return VideoGeneration(texaddr) != 0;
+	}
+	// The generation of the latest write to the video memory around texaddr, or 0 if it's not a video.
+	u32 VideoGeneration(u32 texaddr) const;
+	void InvalidateVideos(u32 addr, u32 size);
 
 	static CheckAlphaResult CheckCLUTAlpha(const uint8_t *pixelData, GEPaletteFormat clutFmt, int w);
 
@@ -522,6 +533,7 @@ class TextureCacheCommon {
 	u32 secondCacheSizeEstimate_ = 0;
 
 	std::vector<VideoInfo> videos_;
+	u32 videoGeneration_ = 0;
 
 	AlignedVector<u32, 16> tmpTexBuf32_;
 	AlignedVector<u32, 16> tmpTexBufRearrange_;
@@ -28,6 +28,7 @@
 #include "Common/Data/Text/I18n.h"
 #include "Common/Data/Text/Parsers.h"
 #include "Common/File/VFS/DirectoryReader.h"
+#include "Common/File/VFS/PackFileReader.h"
 #include "Common/File/VFS/ZipFileReader.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/VFS/VFS.h"
@@ -43,9 +44,14 @@
 
 static const std::string INI_FILENAME = "textures.ini";
 static const std::string ZIP_FILENAME = "textures.zip";
+static const std::string PACK_FILENAME = "textures.ppack";
 static const std::string NEW_TEXTURE_DIR = "new/";
 static const int VERSION = 1;
 static const double MAX_CACHE_SIZE = 4.0;
+// How far ahead in the access log of previous sessions we preload replacements.
+static const size_t PREFETCH_LOOKAHEAD = 24;
+// Keeps the saved access log from growing forever, as games tend to have a few thousand replacements at most.
+static const size_t MAX_ACCESS_LOG_ENTRIES = 8192;
 static bool basisu_initialized = false;
 
 TextureReplacer::TextureReplacer(Draw::DrawContext *draw) {
@@ -61,6 +67,7 @@ TextureReplacer::TextureReplacer(Draw::DrawContext *draw) {
 }
 
 TextureReplacer::~TextureReplacer() {
+	SaveAccessLog();
 	for (auto iter : levelCache_) {
 		delete iter.second;
 	}
@@ -88,6 +95,8 @@ void TextureReplacer::NotifyConfigChanged() {
 	}
 
 	if (!replaceEnabled_ && wasReplaceEnabled) {
+		SaveAccessLog();
+		accessLogPath_.clear();
 		delete vfs_;
 		vfs_ = nullptr;
 		Decimate(ReplacerDecimateMode::ALL);
@@ -128,10 +137,17 @@ bool TextureReplacer::LoadIni(std::string *error, bool notify) {
 	delete vfs_;
 	vfs_ = nullptr;
 
+	Path packPath = basePath_ / PACK_FILENAME;
 	Path zipPath = basePath_ / ZIP_FILENAME;
 
-	// First, check for textures.zip, which is used to reduce IO.
-	VFSBackend *dir = ZipFileReader::Create(zipPath, "", false);
+	// First, check for a prebuilt textures.ppack, then textures.zip. Both are used to reduce IO.
+	VFSBackend *dir = nullptr;
+	if (File::Exists(packPath)) {
+		dir = PackFileReader::Create(packPath);
+	}
+	if (!dir) {
+		dir = ZipFileReader::Create(zipPath, "", false);
+	}
 	if (!dir) {
 		INFO_LOG(Log::TexReplacement, "%s wasn't a zip file - opening the directory %s instead.", zipPath.c_str(), basePath_.c_str());
 		vfsIsZip_ = false;
@@ -215,8 +231,9 @@ bool TextureReplacer::LoadIni(std::string *error, bool notify) {
 	}
 
 	if (replaceEnabled_) {
+		LoadAccessLog();
 		if (vfsIsZip_) {
-			INFO_LOG(Log::TexReplacement, "Texture pack activated from '%s'", (basePath_ / ZIP_FILENAME).c_str());
+			INFO_LOG(Log::TexReplacement, "Texture pack activated from '%s'", dir->toString().c_str());
 		} else {
 			INFO_LOG(Log::TexReplacement, "Texture pack activated from '%s'", basePath_.c_str());
 		}
@@ -594,6 +611,15 @@ ReplacedTexture *TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 		return nullptr;
 	}
 
+	ReplacedTexture *texture = LookupReplacement(cachekey, hash, w, h);
+	// Only textures that actually have a replacement are worth prefetching next time.
+	if (texture && texture->State() != ReplacementState::NOT_FOUND && g_Config.bReplacementTexturePrefetch) {
+		RecordAccess(ReplacementCacheKey(cachekey, hash), w, h);
+	}
+	return texture;
+}
+
+ReplacedTexture *TextureReplacer::LookupReplacement(u64 cachekey, u32 hash, int w, int h) {
 	ReplacementCacheKey replacementKey(cachekey, hash);
 	auto it = cache_.find(replacementKey);
 	if (it != cache_.end()) {
@@ -888,7 +914,13 @@ void TextureReplacer::Decimate(ReplacerDecimateMode mode) {
 		age = 90.0 + (1.0 - pressure) * 1710.0;
 	}
 
-	const double threshold = time_now_d() - age;
+	const double now = time_now_d();
+	if (mode == ReplacerDecimateMode::NEW_FRAME) {
+		// Don't throw away what the prefetcher expects to be needed soon.
+		KeepUpcomingAlive(now);
+	}
+
+	const double threshold = now - age;
 	size_t totalSize = 0;
 	for (auto &item : levelCache_) {
 		// During decimation, it's fine to try-lock here to avoid blocking the main thread while
@@ -908,6 +940,153 @@ void TextureReplacer::Decimate(ReplacerDecimateMode mode) {
 	lastTextureCacheSizeGB_ = totalSizeGB;
 }
 
+void TextureReplacer::LoadAccessLog() {
+	Path path = GetSysDirectory(DIRECTORY_APP_CACHE) / (gameID_ + ".texaccess");
+	if (path == accessLogPath_) {
+		return;
+	}
+	SaveAccessLog();
+
+	accessLogPath_ = path;
+	prevAccessLog_.clear();
+	prevAccessIndex_.clear();
+	accessLog_.clear();
+	accessIndex_.clear();
+	accessCursor_ = 0;
+	prefetched_.clear();
+	prefetchedBytes_ = 0;
+
+	std::string data;
+	if (!g_Config.bReplacementTexturePrefetch || !File::ReadTextFileToString(path, &data)) {
+		return;
+	}
+
+	std::vector<std::string_view> lines;
+	SplitString(data, '\n', lines);
+	for (std::string_view line : lines) {
+		if (prevAccessLog_.size() >= MAX_ACCESS_LOG_ENTRIES) {
+			break;
+		}
+		std::string str(line);
+		ReplacementAccess access{ ReplacementCacheKey(0, 0), 0, 0 };
+		unsigned long long cachekey;
+		if (sscanf(str.c_str(), "%llx %x %d %d", &cachekey, &access.key.hash, &access.w, &access.h) != 4) {
+			continue;
+		}
+		access.key.cachekey = cachekey;
+		if (prevAccessIndex_.emplace(access.key, prevAccessLog_.size()).second) {
+			prevAccessLog_.push_back(access);
+		}
+	}
+	INFO_LOG(Log::TexReplacement, "Loaded replacement access log with %d entries", (int)prevAccessLog_.size());
+}
+
+void TextureReplacer::SaveAccessLog() {
+	if (accessLogPath_.empty() || accessLog_.empty()) {
+		return;
+	}
+
+	// This session's order wins, then whatever we didn't get to from previous sessions.
+	std::string data;
+	size_t count = 0;
+	auto append = [&](const ReplacementAccess &access) {
+		// Replacements can disappear from the pack, drop those.
+		auto it = cache_.find(access.key);
+		if (count >= MAX_ACCESS_LOG_ENTRIES || (it != cache_.end() && (!it->second.texture || it->second.texture->State() == ReplacementState::NOT_FOUND))) {
+			return;
+		}
+		count++;
+		data += StringFromFormat("%016llx %08x %d %d\n", (unsigned long long)access.key.cachekey, access.key.hash, access.w, access.h);
+	};
+	for (const auto &access : accessLog_) {
+		append(access);
+	}
+	for (const auto &access : prevAccessLog_) {
+		if (accessIndex_.find(access.key) == accessIndex_.end()) {
+			append(access);
+		}
+	}
+
+	File::CreateFullPath(accessLogPath_.NavigateUp());
+	if (!File::WriteStringToFile(true, data, accessLogPath_)) {
+		WARN_LOG(Log::TexReplacement, "Failed to save replacement access log to %s", accessLogPath_.c_str());
+	}
+}
+
+void TextureReplacer::RecordAccess(const ReplacementCacheKey &key, int w, int h) {
+	if (accessLogPath_.empty() || !accessIndex_.emplace(key, accessLog_.size()).second) {
+		// Not the first time this session, nothing to learn.
+		return;
+	}
+	accessLog_.push_back(ReplacementAccess{ key, w, h });
+
+	auto prev = prevAccessIndex_.find(key);
+	if (prev != prevAccessIndex_.end()) {
+		accessCursor_ = prev->second;
+		PrefetchAfter(accessCursor_);
+	}
+}
+
+void TextureReplacer::PrefetchAfter(size_t logIndex) {
+	const size_t budget = (size_t)std::max(g_Config.iReplacementTexturePrefetchMB, 0) * 1024 * 1024;
+
+	// Anything outside the window has either been used by now, or isn't coming soon and may get decimated.
+	for (auto it = prefetched_.begin(); it != prefetched_.end(); ) {
+		if (it->second.logIndex <= logIndex || it->second.logIndex > logIndex + PREFETCH_LOOKAHEAD) {
+			prefetchedBytes_ -= it->second.bytes;
+			it = prefetched_.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	const size_t end = std::min(prevAccessLog_.size(), logIndex + 1 + PREFETCH_LOOKAHEAD);
+	for (size_t i = logIndex + 1; i < end && prefetchedBytes_ < budget; ++i) {
+		const ReplacementAccess &access = prevAccessLog_[i];
+		if (prefetched_.find(access.key) != prefetched_.end() || accessIndex_.find(access.key) != accessIndex_.end()) {
+			// Already on its way, or already used this session.
+			continue;
+		}
+		ReplacedTexture *texture = LookupReplacement(access.key.cachekey, access.key.hash, access.w, access.h);
+		if (!texture) {
+			continue;
+		}
+
+		size_t bytes = 0;
+		switch (texture->State()) {
+		case ReplacementState::UNLOADED:
+			// A budget of zero starts loading on a thread without waiting for it.
+			texture->Poll(0.0);
+			// We don't know the real size yet, guess a 2x upscale.
+			bytes = access.w * access.h * 4 * 4;
+			break;
+		case ReplacementState::PENDING:
+			bytes = access.w * access.h * 4 * 4;
+			break;
+		case ReplacementState::ACTIVE:
+			bytes = texture->GetTotalDataSize();
+			break;
+		default:
+			continue;
+		}
+		prefetched_[access.key] = ReplacementPrefetch{ i, bytes };
+		prefetchedBytes_ += bytes;
+	}
+}
+
+void TextureReplacer::KeepUpcomingAlive(double now) {
+	if (prevAccessLog_.empty()) {
+		return;
+	}
+	const size_t end = std::min(prevAccessLog_.size(), accessCursor_ + 1 + PREFETCH_LOOKAHEAD);
+	for (size_t i = accessCursor_ + 1; i < end; ++i) {
+		auto it = cache_.find(prevAccessLog_[i].key);
+		if (it != cache_.end() && it->second.texture && it->second.texture->State() == ReplacementState::ACTIVE) {
+			it->second.texture->lastUsed_ = now;
+		}
+	}
+}
+
 template <typename Key, typename Value>
 static typename std::unordered_map<Key, Value>::const_iterator LookupWildcard(const std::unordered_map<Key, Value> &map, Key &key, u64 cachekey, u32 hash, bool ignoreAddress) {
 	auto alias = map.find(key);
@@ -1034,6 +1213,60 @@ bool TextureReplacer::IniExists(const std::string &gameID) {
 	return File::Exists(generatedFilename);
 }
 
+static void CollectPackFiles(const Path &dir, const std::string &prefix, std::vector<std::string> *files) {
+	std::vector<File::FileInfo> listing;
+	File::GetFilesInDir(dir, &listing);
+	for (const auto &file : listing) {
+		if (file.name.empty() || file.name[0] == '.') {
+			continue;
+		}
+		if (file.isDirectory) {
+			// Freshly dumped textures are not part of the pack.
+			if (prefix.empty() && file.name + "/" == NEW_TEXTURE_DIR) {
+				continue;
+			}
+			CollectPackFiles(file.fullName, prefix + file.name + "/", files);
+			continue;
+		}
+
+		std::string ext = file.fullName.GetFileExtension();
+		if (equalsNoCase(ext, ".png") || equalsNoCase(ext, ".dds") || equalsNoCase(ext, ".zim") || equalsNoCase(ext, ".ktx2") || equalsNoCase(ext, ".basis") || equalsNoCase(ext, ".ini")) {
+			files->push_back(prefix + file.name);
+		}
+	}
+}
+
+bool TextureReplacer::BuildPackFile(const std::string &gameID, Path *packFilename, std::string *error) {
+	if (gameID.empty()) {
+		*error = "No game ID";
+		return false;
+	}
+
+	Path texturesDirectory = GetSysDirectory(DIRECTORY_TEXTURES) / gameID;
+	if (!File::Exists(texturesDirectory / INI_FILENAME)) {
+		*error = "Missing " + INI_FILENAME;
+		return false;
+	}
+
+	std::vector<std::string> files;
+	CollectPackFiles(texturesDirectory, "", &files);
+
+	// Write to a temporary name, so we never leave a half-written pack that would take precedence.
+	*packFilename = texturesDirectory / PACK_FILENAME;
+	Path tempFilename = texturesDirectory / (PACK_FILENAME + ".tmp");
+	double start = time_now_d();
+	if (!PackFileReader::Write(tempFilename, texturesDirectory, files, error)) {
+		return false;
+	}
+	File::Delete(*packFilename);
+	if (!File::Rename(tempFilename, *packFilename)) {
+		*error = "Failed to rename " + tempFilename.ToVisualString();
+		return false;
+	}
+	INFO_LOG(Log::TexReplacement, "Built %s from %d files in %0.2f s", packFilename->c_str(), (int)files.size(), time_now_d() - start);
+	return true;
+}
+
 bool TextureReplacer::GenerateIni(const std::string &gameID, Path &generatedFilename) {
 	if (gameID.empty())
 		return false;
@@ -77,6 +77,18 @@ namespace std {
 	};
 }
 
+// One entry in the per-game log of which replacements were needed, in order of first use.
+struct ReplacementAccess {
+	ReplacementCacheKey key;
+	int w;
+	int h;
+};
+
+struct ReplacementPrefetch {
+	size_t logIndex;
+	size_t bytes;
+};
+
 struct ReplacedTextureDecodeInfo {
 	u64 cachekey;
 	u32 hash;
@@ -122,6 +134,9 @@ class TextureReplacer {
 
 	static bool GenerateIni(const std::string &gameID, Path &generatedFilename);
 	static bool IniExists(const std::string &gameID);
+	// Packs the game's texture directory (ini files and images, except new/) into a single
+	// textures.ppack, which is preferred over textures.zip and the loose files when present.
+	static bool BuildPackFile(const std::string &gameID, Path *packFilename, std::string *error);
 
 	int GetNumTrackedTextures() const { return (int)cache_.size(); }
 	int GetNumCachedReplacedTextures() const { return (int)levelCache_.size(); }
@@ -139,6 +154,14 @@ class TextureReplacer {
 	bool LookupHashRange(u32 addr, int w, int h, int *newW, int *newH);
 	float LookupReduceHashRange(int w, int h);
 	std::string LookupHashFile(u64 cachekey, u32 hash, bool *foundAlias, bool *ignored);
+	ReplacedTexture *LookupReplacement(u64 cachekey, u32 hash, int w, int h);
+
+	// Predictive preloading, driven by the order replacements were needed in previous sessions.
+	void LoadAccessLog();
+	void SaveAccessLog();
+	void RecordAccess(const ReplacementCacheKey &key, int w, int h);
+	void PrefetchAfter(size_t logIndex);
+	void KeepUpcomingAlive(double now);
 
 	static void ScanForHashNamedFiles(VFSBackend *dir, std::map<ReplacementCacheKey, std::map<int, std::string>> &filenameMap);
 	void ComputeAliasMap(const std::map<ReplacementCacheKey, std::map<int, std::string>> &filenameMap);
@@ -177,4 +200,16 @@ class TextureReplacer {
 	// the key is either from aliases_, in which case it's a |-separated sequence of texture filenames of the levels of a texture.
 	// alternatively the key is from the generated texture filename.
 	std::unordered_map<std::string, ReplacedTexture *> levelCache_;
+
+	Path accessLogPath_;
+	// Order from previous sessions, and where we currently are in it.
+	std::vector<ReplacementAccess> prevAccessLog_;
+	std::unordered_map<ReplacementCacheKey, size_t> prevAccessIndex_;
+	size_t accessCursor_ = 0;
+	// Order in this session.
+	std::vector<ReplacementAccess> accessLog_;
+	std::unordered_map<ReplacementCacheKey, size_t> accessIndex_;
+	// Started by the prefetcher and not used yet, counted against ReplacementTexturePrefetchMB.
+	std::unordered_map<ReplacementCacheKey, ReplacementPrefetch> prefetched_;
+	size_t prefetchedBytes_ = 0;
 };
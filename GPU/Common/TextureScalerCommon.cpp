@@ -23,16 +23,21 @@
 #include "GPU/Common/TextureScalerCommon.h"
 
 #include "Core/Config.h"
+#include "Core/System.h"
 #include "Common/Common.h"
 #include "Common/Log.h"
 #include "Common/Math/SIMDHeaders.h"
 #include "Common/Thread/ParallelLoop.h"
 #include "ext/xbrz/xbrz.h"
+#include "ext/xxhash.h"
 
 // Report the time and throughput for each larger scaling operation in the log
 //#define SCALING_MEASURE_TIME
 #include "Common/TimeUtil.h"
 
+// Smaller textures are quicker to scale than to load from disk, and would just clutter the cache.
+static const int MIN_DISK_CACHE_PIXELS = 32 * 32;
+
 /////////////////////////////////////// Helper Functions (mostly math for parallelization)
 
 namespace {
@@ -557,7 +562,7 @@ bool TextureScalerCommon::IsEmptyOrFlat(const u32 *data, int pixels) {
 	return true;
 }
 
-void TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, int width, int height, int *scaledWidth, int *scaledHeight, int factor) {
+bool TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, int width, int height, int *scaledWidth, int *scaledHeight, int factor) {
 	if (IsEmptyOrFlat(src, width * height)) {
 		// This means it was a flat texture.  Vulkan wants the size up front, so we need to make it happen.
 		u32 pixel = *src;
@@ -576,9 +581,48 @@ void TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, int width, int height,
 				out[i] = pixel;
 			}
 		}
+	} else if (diskCache_.IsEnabled() && width * height >= MIN_DISK_CACHE_PIXELS) {
+		ScaledTextureKey key{};
+		key.hash = XXH3_64bits(src, width * height * sizeof(u32));
+		key.w = width;
+		key.h = height;
+		key.factor = factor;
+		key.type = g_Config.iTexScalingType;
+		key.deposterize = g_Config.bTexDeposterize;
+
+		switch (diskCache_.Load(key, out)) {
+		case ScaledTextureLoad::HIT:
+			*scaledWidth = width * factor;
+			*scaledHeight = height * factor;
+			break;
+		case ScaledTextureLoad::PENDING:
+			// Cheap stand-in at the right size until the cached result has been read.
+			ScaleBilinear(factor, src, out, width, height);
+			*scaledWidth = width * factor;
+			*scaledHeight = height * factor;
+			return false;
+		case ScaledTextureLoad::MISS:
+			ScaleInto(out, src, width, height, scaledWidth, scaledHeight, factor);
+			diskCache_.Store(key, out);
+			break;
+		}
 	} else {
 		ScaleInto(out, src, width, height, scaledWidth, scaledHeight, factor);
 	}
+	return true;
+}
+
+void TextureScalerCommon::NotifyConfigChanged(const std::string &gameID) {
+	if (!g_Config.bTexScalingDiskCache || g_Config.iTexScalingLevel == 1 || gameID.empty()) {
+		diskCache_.Shutdown();
+		return;
+	}
+
+	Path dir = GetSysDirectory(DIRECTORY_APP_CACHE) / (gameID + ".texscale");
+	u64 maxBytes = (u64)std::max(g_Config.iTexScalingDiskCacheSizeMB, 1) * 1024 * 1024;
+	if (diskCache_.Dir() != dir || diskCache_.MaxBytes() != maxBytes) {
+		diskCache_.Init(dir, maxBytes);
+	}
 }
 
 bool TextureScalerCommon::ScaleInto(u32 *outputBuf, u32 *src, int width, int height, int *scaledWidth, int *scaledHeight, int factor) {
@@ -19,6 +19,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
+#include "GPU/Common/TextureScalerDiskCache.h"
 
 static const int MIN_TEXSCALE_LINES_PER_THREAD = 4;
 
@@ -30,10 +31,14 @@ class TextureScalerCommon {
 	TextureScalerCommon();
 	~TextureScalerCommon();
 
-	void ScaleAlways(u32 *out, u32 *src, int width, int height, int *scaledWidth, int *scaledHeight, int factor);
+	// Returns false if out only holds a placeholder, and the texture should be scaled again later.
+	bool ScaleAlways(u32 *out, u32 *src, int width, int height, int *scaledWidth, int *scaledHeight, int factor);
 	bool Scale(u32 *&data, int width, int height, int *scaledWidth, int *scaledHeight, int factor);
 	bool ScaleInto(u32 *out, u32 *src, int width, int height, int *scaledWidth, int *scaledHeight, int factor);
 
+	// Sets up (or tears down) the persistent disk cache used by ScaleAlways.
+	void NotifyConfigChanged(const std::string &gameID);
+
 	enum { XBRZ = 0, HYBRID = 1, BICUBIC = 2, HYBRID_BICUBIC = 3 };
 
 protected:
@@ -51,4 +56,6 @@ class TextureScalerCommon {
 	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
 	// of course, scaling factor 5 is totally silly anyway
 	AlignedVector<u32, 16> bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
+
+	TextureScalerDiskCache diskCache_;
 };
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <zstd.h>
+
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
+#include "GPU/Common/TextureScalerDiskCache.h"
+
+static const char *const CACHE_EXTENSION = ".txs";
+static const u32 CACHE_MAGIC = 0x53545050;  // "PPTS"
+static const u32 CACHE_VERSION = 1;
+// Scaled textures compress well even at low levels, and we're competing with the game for CPU.
+static const int CACHE_ZSTD_LEVEL = 3;
+// Results nobody came back for (the texture went away) are dropped beyond this.
+static const size_t MAX_PENDING_LOADS = 32;
+
+struct ScaledTextureFileHeader {
+	u32 magic;
+	u32 version;
+	u32 scaledW;
+	u32 scaledH;
+};
+
+std::string ScaledTextureKey::Filename() const {
+	return StringFromFormat("%016llx_%dx%d_%d_%d%s%s", (unsigned long long)hash, w, h, factor, type, deposterize ? "d" : "", CACHE_EXTENSION);
+}
+
+TextureScalerDiskCache::~TextureScalerDiskCache() {
+	Shutdown();
+}
+
+void TextureScalerDiskCache::Init(const Path &dir, u64 maxBytes) {
+	Shutdown();
+
+	if (!File::Exists(dir) && !File::CreateFullPath(dir)) {
+		ERROR_LOG(Log::G3D, "Failed to create texture scaler cache directory '%s'", dir.ToVisualString().c_str());
+		return;
+	}
+
+	dir_ = dir;
+	maxBytes_ = maxBytes;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	pendingTasks_++;
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [this]() {
+		BuildIndex();
+	}));
+}
+
+void TextureScalerDiskCache::Shutdown() {
+	if (!IsEnabled()) {
+		return;
+	}
+
+	WaitForTasks();
+	if (hits_ + misses_ > 0) {
+		INFO_LOG(Log::G3D, "Texture scaler cache: %d hits, %d misses, %d files (%lld bytes)", hits_.load(), misses_.load(), (int)entries_.size(), (long long)totalBytes_);
+	}
+
+	dir_.clear();
+	maxBytes_ = 0;
+	indexed_ = false;
+	lru_.clear();
+	entries_.clear();
+	loads_.clear();
+	totalBytes_ = 0;
+	hits_ = 0;
+	misses_ = 0;
+}
+
+void TextureScalerDiskCache::WaitForTasks() {
+	std::unique_lock<std::mutex> guard(lock_);
+	tasksDone_.wait(guard, [&] { return pendingTasks_ == 0; });
+}
+
+void TextureScalerDiskCache::BuildIndex() {
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(dir_, &files, "txs:");
+
+	// Oldest first, so that inserting at the front leaves the newest most recently used.
+	std::sort(files.begin(), files.end(), [](const File::FileInfo &a, const File::FileInfo &b) {
+		return a.mtime < b.mtime;
+	});
+
+	std::lock_guard<std::mutex> guard(lock_);
+	for (const auto &file : files) {
+		if (!file.isDirectory) {
+			Insert(file.name, file.size);
+		}
+	}
+	EvictIfNeeded();
+	indexed_ = true;
+	INFO_LOG(Log::G3D, "Texture scaler cache: indexed %d files (%lld bytes) in '%s'", (int)entries_.size(), (long long)totalBytes_, dir_.ToVisualString().c_str());
+
+	pendingTasks_--;
+	tasksDone_.notify_all();
+}
+
+// Lock must be held.
+void TextureScalerDiskCache::Insert(const std::string &filename, u64 size) {
+	auto it = entries_.find(filename);
+	if (it != entries_.end()) {
+		totalBytes_ -= it->second.size;
+		lru_.erase(it->second.lruPos);
+		entries_.erase(it);
+	}
+
+	lru_.push_front(filename);
+	entries_[filename] = Entry{ size, lru_.begin() };
+	totalBytes_ += size;
+}
+
+// Lock must be held.
+void TextureScalerDiskCache::EvictIfNeeded() {
+	while (totalBytes_ > maxBytes_ && !lru_.empty()) {
+		const std::string &filename = lru_.back();
+		auto it = entries_.find(filename);
+		totalBytes_ -= it->second.size;
+		File::Delete(dir_ / filename);
+		entries_.erase(it);
+		lru_.pop_back();
+	}
+}
+
+ScaledTextureLoad TextureScalerDiskCache::Load(const ScaledTextureKey &key, u32 *out) {
+	if (!IsEnabled()) {
+		return ScaledTextureLoad::MISS;
+	}
+
+	const std::string filename = key.Filename();
+	const u32 scaledW = key.w * key.factor;
+	const u32 scaledH = key.h * key.factor;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	auto load = loads_.find(filename);
+	if (load != loads_.end()) {
+		if (load->second.empty()) {
+			return ScaledTextureLoad::PENDING;
+		}
+		memcpy(out, load->second.data(), scaledW * scaledH * sizeof(u32));
+		loads_.erase(load);
+		hits_++;
+		return ScaledTextureLoad::HIT;
+	}
+
+	auto it = indexed_ ? entries_.find(filename) : entries_.end();
+	if (it == entries_.end()) {
+		misses_++;
+		return ScaledTextureLoad::MISS;
+	}
+	// Touch it, both here and (when read) on disk for the next session.
+	lru_.splice(lru_.begin(), lru_, it->second.lruPos);
+
+	if (loads_.size() >= MAX_PENDING_LOADS) {
+		for (auto iter = loads_.begin(); iter != loads_.end(); ++iter) {
+			if (!iter->second.empty()) {
+				loads_.erase(iter);
+				break;
+			}
+		}
+	}
+	loads_[filename];
+	pendingTasks_++;
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::NORMAL, [this, filename, scaledW, scaledH]() {
+		ReadFile(filename, scaledW, scaledH);
+	}));
+	return ScaledTextureLoad::PENDING;
+}
+
+void TextureScalerDiskCache::ReadFile(const std::string &filename, u32 scaledW, u32 scaledH) {
+	const Path path = dir_ / filename;
+	std::vector<u32> pixels;
+	std::string data;
+	if (File::ReadBinaryFileToString(path, &data) && data.size() >= sizeof(ScaledTextureFileHeader)) {
+		ScaledTextureFileHeader header;
+		memcpy(&header, data.data(), sizeof(header));
+		if (header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.scaledW == scaledW && header.scaledH == scaledH) {
+			pixels.resize(scaledW * scaledH);
+			const size_t outSize = pixels.size() * sizeof(u32);
+			size_t result = ZSTD_decompress(pixels.data(), outSize, data.data() + sizeof(header), data.size() - sizeof(header));
+			if (ZSTD_isError(result) || result != outSize) {
+				WARN_LOG(Log::G3D, "Texture scaler cache: failed to decompress '%s'", filename.c_str());
+				pixels.clear();
+			} else {
+				File::ChangeMTime(path, (time_t)time_now_unix_utc());
+			}
+		} else {
+			WARN_LOG(Log::G3D, "Texture scaler cache: ignoring mismatching file '%s'", filename.c_str());
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	if (pixels.empty()) {
+		// Forget about it, so the next lookup misses and the texture gets scaled (and stored) again.
+		loads_.erase(filename);
+		auto it = entries_.find(filename);
+		if (it != entries_.end()) {
+			totalBytes_ -= it->second.size;
+			lru_.erase(it->second.lruPos);
+			entries_.erase(it);
+		}
+	} else {
+		loads_[filename] = std::move(pixels);
+	}
+	pendingTasks_--;
+	tasksDone_.notify_all();
+}
+
+void TextureScalerDiskCache::Store(const ScaledTextureKey &key, const u32 *data) {
+	if (!IsEnabled()) {
+		return;
+	}
+
+	const u32 scaledW = key.w * key.factor;
+	const u32 scaledH = key.h * key.factor;
+	std::vector<u32> pixels(data, data + scaledW * scaledH);
+	const std::string filename = key.Filename();
+
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!indexed_ || entries_.find(filename) != entries_.end()) {
+		// Either we'd race the index, or someone already wrote it (same texture at another address.)
+		return;
+	}
+
+	pendingTasks_++;
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [this, filename, scaledW, scaledH, pixels = std::move(pixels)]() {
+		const size_t srcSize = pixels.size() * sizeof(u32);
+		std::vector<u8> buffer(sizeof(ScaledTextureFileHeader) + ZSTD_compressBound(srcSize));
+		ScaledTextureFileHeader header{ CACHE_MAGIC, CACHE_VERSION, scaledW, scaledH };
+		memcpy(buffer.data(), &header, sizeof(header));
+
+		size_t compressed = ZSTD_compress(buffer.data() + sizeof(header), buffer.size() - sizeof(header), pixels.data(), srcSize, CACHE_ZSTD_LEVEL);
+		bool success = false;
+		if (!ZSTD_isError(compressed)) {
+			buffer.resize(sizeof(header) + compressed);
+			success = File::WriteDataToFile(false, buffer.data(), buffer.size(), dir_ / filename);
+		}
+
+		std::lock_guard<std::mutex> guard(lock_);
+		if (success) {
+			Insert(filename, buffer.size());
+			EvictIfNeeded();
+		} else {
+			WARN_LOG(Log::G3D, "Texture scaler cache: failed to write '%s'", filename.c_str());
+		}
+		pendingTasks_--;
+		tasksDone_.notify_all();
+	}));
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+
+// Identifies one CPU-upscaled texture. The hash covers the decoded (8888) source pixels,
+// so it naturally includes the CLUT, unlike the texture cache's own hashes.
+struct ScaledTextureKey {
+	u64 hash;
+	int w;
+	int h;
+	int factor;
+	int type;  // TextureScalerCommon::XBRZ etc.
+	bool deposterize;
+
+	std::string Filename() const;
+};
+
+enum class ScaledTextureLoad {
+	HIT,
+	// The file is being read in the background, ask again later.
+	PENDING,
+	MISS,
+};
+
+// Persistent, per-game cache of upscaled texture output. Entries are zstd compressed,
+// and the total size is bounded, evicting the least recently used files first.
+// File modification times are used to carry the LRU order over between sessions.
+class TextureScalerDiskCache {
+public:
+	~TextureScalerDiskCache();
+
+	// Indexing of existing files happens on a background task, lookups miss until it's done.
+	void Init(const Path &dir, u64 maxBytes);
+	void Shutdown();
+
+	bool IsEnabled() const { return !dir_.empty(); }
+	const Path &Dir() const { return dir_; }
+	u64 MaxBytes() const { return maxBytes_; }
+
+	// out must have room for key.w * key.factor * key.h * key.factor pixels.
+	// Files are read and decompressed on a worker, so the first lookup of a cached texture is PENDING.
+	ScaledTextureLoad Load(const ScaledTextureKey &key, u32 *out);
+	// Compresses and writes in the background, data is copied.
+	void Store(const ScaledTextureKey &key, const u32 *data);
+
+private:
+	struct Entry {
+		u64 size;
+		std::list<std::string>::iterator lruPos;
+	};
+
+	void BuildIndex();
+	void ReadFile(const std::string &filename, u32 scaledW, u32 scaledH);
+	void Insert(const std::string &filename, u64 size);
+	void EvictIfNeeded();
+	void WaitForTasks();
+
+	Path dir_;
+	u64 maxBytes_ = 0;
+
+	std::mutex lock_;
+	std::condition_variable tasksDone_;
+	int pendingTasks_ = 0;
+	bool indexed_ = false;
+
+	// Front is most recently used.
+	std::list<std::string> lru_;
+	std::unordered_map<std::string, Entry> entries_;
+	u64 totalBytes_ = 0;
+
+	// Files being read, and the decompressed results waiting for the next lookup.
+	// An empty vector means the read is still in progress.
+	std::unordered_map<std::string, std::vector<u32>> loads_;
+
+	std::atomic<int> hits_{};
+	std::atomic<int> misses_{};
+};
@@ -1003,6 +1003,24 @@ bool ShaderManagerGLES::LoadCacheFlags(File::IOFile &f, DrawEngineGLES *drawEngi
 	return true;
 }
 
+bool ShaderManagerGLES::ReadCacheIDs(File::IOFile &f, uint32_t *useFlags, std::vector<VShaderID> *vsIDs, std::vector<FShaderID> *fsIDs) {
+	CacheHeader header;
+	f.Seek(0, SEEK_SET);
+	if (!f.ReadArray(&header, 1) || header.magic != CACHE_HEADER_MAGIC || header.version != CACHE_VERSION) {
+		return false;
+	}
+	// Same sanity limits as LoadCache().
+	if (header.numFragmentShaders > 1000 || header.numVertexShaders > 1000 || header.numVertexShaders < 0 || header.numFragmentShaders < 0) {
+		return false;
+	}
+
+	*useFlags = header.useFlags;
+	vsIDs->resize(header.numVertexShaders);
+	fsIDs->resize(header.numFragmentShaders);
+	// Linked programs follow, but they're just pairs of the above.
+	return f.ReadArray(vsIDs->data(), vsIDs->size()) && f.ReadArray(fsIDs->data(), fsIDs->size());
+}
+
 bool ShaderManagerGLES::LoadCache(File::IOFile &f) {
 	// TODO: Get rid of this struct.
 	struct {
@@ -186,6 +186,8 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 	static bool LoadCacheFlags(File::IOFile &f, DrawEngineGLES *drawEngine);
 	bool LoadCache(File::IOFile &f);
 	void SaveCache(const Path &filename, DrawEngineGLES *drawEngine);
+	// Reads just the shader IDs from a cache file, without a context. Used for offline validation.
+	static bool ReadCacheIDs(File::IOFile &f, uint32_t *useFlags, std::vector<VShaderID> *vsIDs, std::vector<FShaderID> *fsIDs);
 
 private:
 	void Clear();
@@ -98,6 +98,8 @@ struct GPUStatistics {
 		numReadbacks = 0;
 		numUploads = 0;
 		numCachedUploads = 0;
+		numReadbackBytesSkipped = 0;
+		numUploadBytesSkipped = 0;
 		numDepal = 0;
 		numClears = 0;
 		numDepthCopies = 0;
@@ -147,6 +149,8 @@ struct GPUStatistics {
 	int numReadbacks;
 	int numUploads;
 	int numCachedUploads;
+	int numReadbackBytesSkipped;  // Thanks to FramebufferDirtyTiles.
+	int numUploadBytesSkipped;
 	int numDepal;
 	int numClears;
 	int numDepthCopies;
@@ -1186,6 +1186,14 @@ void GPUCommon::Execute_End(u32 op, u32 diff) {
 	}
 }
 
+void GPUCommon::AdvanceVertsSkipped(u32 vertType, int count) {
+	if ((vertType & GE_VTYPE_IDX_MASK) != GE_VTYPE_IDX_NONE) {
+		AdvanceVerts(vertType, count, 0);
+	} else {
+		AdvanceVerts(vertType, count, count * drawEngineCommon_->GetVertexDecoder(vertType)->VertexSize());
+	}
+}
+
 void GPUCommon::Execute_BoundingBox(u32 op, u32 diff) {
 	// Just resetting, nothing to check bounds for.
 	const u32 count = op & 0xFFFF;
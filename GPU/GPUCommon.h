@@ -460,6 +460,8 @@ class GPUCommon : public GPUDebugInterface {
 			gstate_c.vertexAddr += bytesRead;
 		}
 	}
+	// For draws that are skipped, so that the following ones (and bounding box tests) still read from the right place.
+	void AdvanceVertsSkipped(u32 vertType, int count);
 
 	virtual void BuildReportingInfo() = 0;
 
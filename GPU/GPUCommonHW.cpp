@@ -977,6 +977,7 @@ void GPUCommonHW::Execute_Prim(u32 op, u32 diff) {
 		if (gstate.isModeClear()) {
 			gpuStats.numClears++;
 		}
+		AdvanceVertsSkipped(gstate.vertType, count);
 		return;
 	}
 
@@ -1301,6 +1302,7 @@ void GPUCommonHW::Execute_Bezier(u32 op, u32 diff) {
 	}
 	if (gstate_c.skipDrawReason & (SKIPDRAW_SKIPFRAME | SKIPDRAW_NON_DISPLAYED_FB)) {
 		// TODO: Should this eat some cycles?  Probably yes.  Not sure if important.
+		AdvanceVertsSkipped(gstate.vertType, (op & 0xFF) * ((op >> 8) & 0xFF));
 		return;
 	}
 
@@ -1377,6 +1379,7 @@ void GPUCommonHW::Execute_Spline(u32 op, u32 diff) {
 	}
 	if (gstate_c.skipDrawReason & (SKIPDRAW_SKIPFRAME | SKIPDRAW_NON_DISPLAYED_FB)) {
 		// TODO: Should this eat some cycles?  Probably yes.  Not sure if important.
+		AdvanceVertsSkipped(gstate.vertType, (op & 0xFF) * ((op >> 8) & 0xFF));
 		return;
 	}
 
@@ -1812,6 +1815,7 @@ size_t GPUCommonHW::FormatGPUStatsCommon(char *buffer, size_t size) {
 		"FBOs active: %d (evaluations: %d, created %d)\n"
 		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB, clut %d\n"
 		"readbacks %d (%d non-block), upload %d (cached %d), depal %d\n"
+		"dirty tracking skipped: readback %d kB, upload %d kB\n"
 		"block transfers: %d\n"
 		"replacer: tracks %d references, %d unique textures\n"
 		"Cpy: depth %d, color %d, reint %d, blend %d, self %d\n"
@@ -1844,6 +1848,8 @@ size_t GPUCommonHW::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numUploads,
 		gpuStats.numCachedUploads,
 		gpuStats.numDepal,
+		gpuStats.numReadbackBytesSkipped / 1024,
+		gpuStats.numUploadBytesSkipped / 1024,
 		gpuStats.numBlockTransfers,
 		gpuStats.numReplacerTrackedTex,
 		gpuStats.numCachedReplacedTextures,
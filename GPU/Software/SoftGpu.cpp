@@ -889,6 +889,7 @@ void SoftGPU::Execute_Bezier(u32 op, u32 diff) {
 	// This also make skipping drawing very effective.
 	if (gstate_c.skipDrawReason & (SKIPDRAW_SKIPFRAME | SKIPDRAW_NON_DISPLAYED_FB)) {
 		// TODO: Should this eat some cycles?  Probably yes.  Not sure if important.
+		AdvanceVertsSkipped(gstate.vertType, (op & 0xFF) * ((op >> 8) & 0xFF));
 		return;
 	}
 
@@ -941,6 +942,7 @@ void SoftGPU::Execute_Spline(u32 op, u32 diff) {
 	// This also make skipping drawing very effective.
 	if (gstate_c.skipDrawReason & (SKIPDRAW_SKIPFRAME | SKIPDRAW_NON_DISPLAYED_FB)) {
 		// TODO: Should this eat some cycles?  Probably yes.  Not sure if important.
+		AdvanceVertsSkipped(gstate.vertType, (op & 0xFF) * ((op >> 8) & 0xFF));
 		return;
 	}
 
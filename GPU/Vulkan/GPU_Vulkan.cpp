@@ -88,6 +88,7 @@ GPU_Vulkan::GPU_Vulkan(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	if (discID.size()) {
 		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
 		shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".vkshadercache");
+		shaderManagerVulkan_->LoadPrecompiledShaders(GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".vkspirv"));
 		LoadCache(shaderCachePath_);
 	}
 
@@ -25,6 +25,7 @@
 #include "Common/MemoryUtil.h"
 
 #include "Common/StringUtils.h"
+#include "Common/File/FileUtil.h"
 #include "Common/GPU/Vulkan/VulkanContext.h"
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
@@ -34,19 +35,28 @@
 #include "GPU/Common/GeometryShaderGenerator.h"
 #include "GPU/Vulkan/ShaderManagerVulkan.h"
 #include "GPU/Vulkan/DrawEngineVulkan.h"
+#include "GPU/Vulkan/SpirvBundleVulkan.h"
 
 // Most drivers treat vkCreateShaderModule as pretty much a memcpy. What actually
 // takes time here, and makes this worthy of parallelization, is GLSLtoSPV.
 // Takes ownership over tag.
 // This always returns something, checking the return value for null is not meaningful.
-static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan, VkShaderStageFlagBits stage, const char *code, std::string *tag) {
+// If precompiled is non-null and contains SPIR-V for this exact source, that's used instead.
+static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan, VkShaderStageFlagBits stage, const char *code, std::string *tag, const SpirvShaderBundle *precompiled) {
 	auto compile = [=] {
 		PROFILE_THIS_SCOPE("shadercomp");
 
 		std::string errorMessage;
 		std::vector<uint32_t> spirv;
 
-		bool success = GLSLtoSPV(stage, code, GLSLVariant::VULKAN, spirv, &errorMessage);
+		bool success;
+		const std::vector<uint32_t> *found = precompiled ? precompiled->Find(code) : nullptr;
+		if (found) {
+			spirv = *found;
+			success = true;
+		} else {
+			success = GLSLtoSPV(stage, code, GLSLVariant::VULKAN, spirv, &errorMessage);
+		}
 
 		if (!errorMessage.empty()) {
 			if (success) {
@@ -101,11 +111,11 @@ static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan,
 	}
 }
 
-VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code)
+VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code, const SpirvShaderBundle *precompiled)
 	: vulkan_(vulkan), id_(id), flags_(flags) {
 	_assert_(!id.is_invalid());
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_FRAGMENT_BIT, source_.c_str(), new std::string(FragmentShaderDesc(id)));
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_FRAGMENT_BIT, source_.c_str(), new std::string(FragmentShaderDesc(id)), precompiled);
 	VERBOSE_LOG(Log::G3D, "Compiled fragment shader:\n%s\n", (const char *)code);
 }
 
@@ -133,11 +143,11 @@ std::string VulkanFragmentShader::GetShaderString(DebugShaderStringType type) co
 	}
 }
 
-VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform)
+VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform, const SpirvShaderBundle *precompiled)
 	: vulkan_(vulkan), useHWTransform_(useHWTransform), flags_(flags), id_(id) {
 	_assert_(!id.is_invalid());
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_VERTEX_BIT, source_.c_str(), new std::string(VertexShaderDesc(id)));
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_VERTEX_BIT, source_.c_str(), new std::string(VertexShaderDesc(id)), precompiled);
 	VERBOSE_LOG(Log::G3D, "Compiled vertex shader:\n%s\n", (const char *)code);
 }
 
@@ -165,11 +175,11 @@ std::string VulkanVertexShader::GetShaderString(DebugShaderStringType type) cons
 	}
 }
 
-VulkanGeometryShader::VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code)
+VulkanGeometryShader::VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code, const SpirvShaderBundle *precompiled)
 	: vulkan_(vulkan), id_(id) {
 	_assert_(!id.is_invalid());
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_GEOMETRY_BIT, source_.c_str(), new std::string(GeometryShaderDesc(id).c_str()));
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_GEOMETRY_BIT, source_.c_str(), new std::string(GeometryShaderDesc(id).c_str()), precompiled);
 	VERBOSE_LOG(Log::G3D, "Compiled geometry shader:\n%s\n", (const char *)code);
 }
 
@@ -302,7 +312,7 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertexType, VulkanVertexShade
 			_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
 
 			// Don't need to re-lookup anymore, now that we lock wider.
-			vs = new VulkanVertexShader(vulkan, VSID, flags, codeBuffer_, useHWTransform);
+			vs = new VulkanVertexShader(vulkan, VSID, flags, codeBuffer_, useHWTransform, &precompiled_);
 			vsCache_.Insert(VSID, vs);
 		}
 		lastVShader_ = vs;
@@ -330,7 +340,7 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertexType, VulkanVertexShade
 			_assert_msg_(success, "FS gen error: %s", genErrorString.c_str());
 			_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
 
-			fs = new VulkanFragmentShader(vulkan, FSID, flags, codeBuffer_);
+			fs = new VulkanFragmentShader(vulkan, FSID, flags, codeBuffer_, &precompiled_);
 			fsCache_.Insert(FSID, fs);
 		}
 		lastFShader_ = fs;
@@ -357,7 +367,7 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertexType, VulkanVertexShade
 				_assert_msg_(success, "GS gen error: %s", genErrorString.c_str());
 				_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "GS length error: %d", (int)strlen(codeBuffer_));
 
-				gs = new VulkanGeometryShader(vulkan, GSID, codeBuffer_);
+				gs = new VulkanGeometryShader(vulkan, GSID, codeBuffer_, &precompiled_);
 				gsCache_.Insert(GSID, gs);
 			}
 		} else {
@@ -563,7 +573,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
 		// Don't add the new shader if already compiled - though this should no longer happen.
 		if (!vsCache_.ContainsKey(id)) {
-			VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, flags, codeBuffer_, useHWTransform);
+			VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, flags, codeBuffer_, useHWTransform, &precompiled_);
 			vsCache_.Insert(id, vs);
 		}
 	}
@@ -586,7 +596,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		}
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
 		if (!fsCache_.ContainsKey(id)) {
-			VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, flags, codeBuffer_);
+			VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, flags, codeBuffer_, &precompiled_);
 			fsCache_.Insert(id, fs);
 		}
 	}
@@ -608,7 +618,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 			}
 			_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "GS length error: %d", (int)strlen(codeBuffer_));
 			if (!gsCache_.ContainsKey(id)) {
-				VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, codeBuffer_);
+				VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, codeBuffer_, &precompiled_);
 				gsCache_.Insert(id, gs);
 			}
 		}
@@ -645,3 +655,31 @@ void ShaderManagerVulkan::SaveCache(FILE *f, DrawEngineVulkan *drawEngine) {
 		NOTICE_LOG(Log::G3D, "Saved %d vertex and %d fragment shaders", header.numVertexShaders, header.numFragmentShaders);
 	}
 }
+
+bool ShaderManagerVulkan::ReadCacheIDs(FILE *f, uint32_t *useFlags, std::vector<VShaderID> *vsIDs, std::vector<FShaderID> *fsIDs, std::vector<GShaderID> *gsIDs) {
+	VulkanCacheHeader header{};
+	if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != CACHE_HEADER_MAGIC || header.version != CACHE_VERSION) {
+		return false;
+	}
+	// Sanity check, in case of corruption.
+	const u32 maxShaders = 65536;
+	if ((u32)header.numVertexShaders > maxShaders || (u32)header.numFragmentShaders > maxShaders || (u32)header.numGeometryShaders > maxShaders) {
+		return false;
+	}
+
+	*useFlags = header.useFlags;
+	vsIDs->resize(header.numVertexShaders);
+	fsIDs->resize(header.numFragmentShaders);
+	gsIDs->resize(header.numGeometryShaders);
+	// The pipeline cache follows, but we don't care about that here.
+	return fread(vsIDs->data(), sizeof(VShaderID), vsIDs->size(), f) == vsIDs->size() &&
+		fread(fsIDs->data(), sizeof(FShaderID), fsIDs->size(), f) == fsIDs->size() &&
+		fread(gsIDs->data(), sizeof(GShaderID), gsIDs->size(), f) == gsIDs->size();
+}
+
+void ShaderManagerVulkan::LoadPrecompiledShaders(const Path &filename) {
+	precompiled_.Clear();
+	if (File::Exists(filename)) {
+		precompiled_.Load(filename);
+	}
+}
@@ -28,6 +28,7 @@
 #include "GPU/Common/ShaderId.h"
 #include "GPU/Common/VertexShaderGenerator.h"
 #include "GPU/Common/FragmentShaderGenerator.h"
+#include "GPU/Vulkan/SpirvBundleVulkan.h"
 #include "GPU/Vulkan/VulkanUtil.h"
 #include "Common/Math/lin/matrix4x4.h"
 #include "GPU/Common/ShaderUniforms.h"
@@ -38,7 +39,7 @@ class VulkanPushPool;
 
 class VulkanFragmentShader {
 public:
-	VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code);
+	VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code, const SpirvShaderBundle *precompiled = nullptr);
 	~VulkanFragmentShader();
 
 	const std::string &source() const { return source_; }
@@ -61,7 +62,7 @@ class VulkanFragmentShader {
 
 class VulkanVertexShader {
 public:
-	VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform);
+	VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform, const SpirvShaderBundle *precompiled = nullptr);
 	~VulkanVertexShader();
 
 	const std::string &source() const { return source_; }
@@ -85,7 +86,7 @@ class VulkanVertexShader {
 
 class VulkanGeometryShader {
 public:
-	VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code);
+	VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code, const SpirvShaderBundle *precompiled = nullptr);
 	~VulkanGeometryShader();
 
 	const std::string &source() const { return source_; }
@@ -160,6 +161,11 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 	static bool LoadCacheFlags(FILE *f, DrawEngineVulkan *drawEngine);
 	bool LoadCache(FILE *f);
 	void SaveCache(FILE *f, DrawEngineVulkan *drawEngine);
+	// Reads just the shader IDs from a cache file, without a device. Used for offline precompilation.
+	static bool ReadCacheIDs(FILE *f, uint32_t *useFlags, std::vector<VShaderID> *vsIDs, std::vector<FShaderID> *fsIDs, std::vector<GShaderID> *gsIDs);
+
+	// Optional SPIR-V made offline from the shader cache, must be loaded before shaders are created.
+	void LoadPrecompiledShaders(const Path &filename);
 
 private:
 	void Clear();
@@ -177,6 +183,8 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 
 	char *codeBuffer_;
 
+	SpirvShaderBundle precompiled_;
+
 	uint64_t uboAlignment_;
 
 	Uniforms *uniforms_;
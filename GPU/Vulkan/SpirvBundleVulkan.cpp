@@ -0,0 +1,98 @@
+#include <cstring>
+
+#include "ext/xxhash.h"
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/Log.h"
+#include "GPU/Vulkan/SpirvBundleVulkan.h"
+
+static const u32 BUNDLE_MAGIC = 0x42535050;  // "PPSB"
+static const u32 BUNDLE_VERSION = 1;
+
+struct SpirvBundleHeader {
+	u32 magic;
+	u32 version;
+	u32 numShaders;
+};
+
+struct SpirvBundleEntry {
+	u64 sourceHash;
+	u32 numWords;
+	u32 pad;
+};
+
+u64 SpirvShaderBundle::HashSource(const char *code) {
+	return XXH3_64bits(code, strlen(code));
+}
+
+void SpirvShaderBundle::Add(const char *code, std::vector<uint32_t> &&spirv) {
+	shaders_[HashSource(code)] = std::move(spirv);
+}
+
+const std::vector<uint32_t> *SpirvShaderBundle::Find(const char *code) const {
+	if (shaders_.empty()) {
+		return nullptr;
+	}
+	auto it = shaders_.find(HashSource(code));
+	return it != shaders_.end() ? &it->second : nullptr;
+}
+
+bool SpirvShaderBundle::Load(const Path &filename) {
+	shaders_.clear();
+
+	std::string data;
+	if (!File::ReadBinaryFileToString(filename, &data)) {
+		return false;
+	}
+
+	SpirvBundleHeader header{};
+	if (data.size() < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != BUNDLE_MAGIC || header.version != BUNDLE_VERSION) {
+		WARN_LOG(Log::G3D, "SPIR-V bundle '%s' has the wrong magic or version, ignoring", filename.ToVisualString().c_str());
+		return false;
+	}
+
+	size_t pos = sizeof(header);
+	for (u32 i = 0; i < header.numShaders; i++) {
+		SpirvBundleEntry entry;
+		if (data.size() - pos < sizeof(entry)) {
+			break;
+		}
+		memcpy(&entry, data.data() + pos, sizeof(entry));
+		pos += sizeof(entry);
+
+		const size_t bytes = (size_t)entry.numWords * sizeof(uint32_t);
+		if (data.size() - pos < bytes) {
+			break;
+		}
+		std::vector<uint32_t> spirv(entry.numWords);
+		memcpy(spirv.data(), data.data() + pos, bytes);
+		pos += bytes;
+		shaders_[entry.sourceHash] = std::move(spirv);
+	}
+
+	if (shaders_.size() != header.numShaders) {
+		ERROR_LOG(Log::G3D, "SPIR-V bundle '%s' is truncated, ignoring", filename.ToVisualString().c_str());
+		shaders_.clear();
+		return false;
+	}
+
+	INFO_LOG(Log::G3D, "Loaded %d precompiled shaders from '%s'", (int)shaders_.size(), filename.ToVisualString().c_str());
+	return true;
+}
+
+bool SpirvShaderBundle::Save(const Path &filename) const {
+	std::string data;
+	SpirvBundleHeader header{ BUNDLE_MAGIC, BUNDLE_VERSION, (u32)shaders_.size() };
+	data.append((const char *)&header, sizeof(header));
+	for (const auto &iter : shaders_) {
+		SpirvBundleEntry entry{ iter.first, (u32)iter.second.size(), 0 };
+		data.append((const char *)&entry, sizeof(entry));
+		data.append((const char *)iter.second.data(), iter.second.size() * sizeof(uint32_t));
+	}
+	return File::WriteDataToFile(false, data.data(), data.size(), filename);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+class Path;
+
+// A bundle of precompiled SPIR-V, keyed by a hash of the GLSL source it was compiled from.
+// Produced offline (see PPSSPPHeadless --precompile-shaders) from a game's .vkshadercache, and
+// consulted by ShaderManagerVulkan so that GLSLtoSPV can be skipped for known shaders.
+// Since the key is the generated source itself, a bundle made with different device bugs or
+// use flags simply won't match, rather than producing wrong shaders.
+class SpirvShaderBundle {
+public:
+	static u64 HashSource(const char *code);
+
+	void Add(const char *code, std::vector<uint32_t> &&spirv);
+	// Returns nullptr if not present. Safe to call from multiple threads as long as nothing is being added.
+	const std::vector<uint32_t> *Find(const char *code) const;
+
+	bool Load(const Path &filename);
+	bool Save(const Path &filename) const;
+	void Clear() { shaders_.clear(); }
+
+	size_t size() const { return shaders_.size(); }
+	bool empty() const { return shaders_.empty(); }
+
+private:
+	std::unordered_map<u64, std::vector<uint32_t>> shaders_;
+};
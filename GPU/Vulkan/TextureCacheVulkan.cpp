@@ -774,7 +774,9 @@ void TextureCacheVulkan::LoadVulkanTextureLevel(TexCacheEntry &entry, uint8_t *w
 		uint8_t *scaleBuf = (uint8_t *)AllocateAlignedMemory(allocBytes, 16);
 		_assert_msg_(scaleBuf, "Failed to allocate %d aligned bytes for texture scaler", (int)allocBytes);
 
-		scaler_.ScaleAlways((u32 *)scaleBuf, pixelData, w, h, &w, &h, scaleFactor);
+		if (!scaler_.ScaleAlways((u32 *)scaleBuf, pixelData, w, h, &w, &h, scaleFactor)) {
+			entry.status |= TexCacheEntry::STATUS_TO_SCALE;
+		}
 		pixelData = (u32 *)writePtr;
 
 		// We always end up at 8888.  Other parts assume this.
@@ -76,7 +76,7 @@ - (void)documentPickerWasCancelled:(UIDocumentPickerViewController *)controller
 		panel.canChooseDirectories = allowDirectories;
 		switch (fileType) {
 		case BrowseFileType::BOOTABLE:
-			[panel setAllowedFileTypes:[NSArray arrayWithObjects:@"iso", @"cso", @"chd", @"pbp", @"elf", @"zip", @"ppdmp", @"prx", nil]];
+			[panel setAllowedFileTypes:[NSArray arrayWithObjects:@"iso", @"cso", @"chd", @"psz", @"pbp", @"elf", @"zip", @"ppdmp", @"prx", nil]];
 			break;
 		case BrowseFileType::IMAGE:
 			[panel setAllowedFileTypes:[NSArray arrayWithObjects:@"jpg", @"png", nil]];
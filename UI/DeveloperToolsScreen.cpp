@@ -23,6 +23,8 @@
 #include "Common/GPU/OpenGL/GLFeatures.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
 #include "GPU/Common/TextureReplacer.h"
 #include "GPU/Common/PostShader.h"
 #include "Core/MIPS/MIPSTracer.h"
@@ -98,6 +100,25 @@ void DeveloperToolsScreen::CreateTextureReplacementTab(UI::LinearLayout *list) {
 		return true;
 	});
 
+	Choice *buildTexturePack = list->Add(new Choice(dev->T("Build texture pack file (textures.ppack)")));
+	buildTexturePack->OnClick.Add([=](UI::EventParams &) {
+		std::string gameID = g_paramSFO.GetDiscID();
+		// Can take a while for big packs, so don't block the UI.
+		g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::NORMAL, [gameID]() {
+			Path packFilename;
+			std::string error;
+			if (TextureReplacer::BuildPackFile(gameID, &packFilename, &error)) {
+				g_OSD.Show(OSDType::MESSAGE_SUCCESS, packFilename.ToVisualString(), 3.0f);
+			} else {
+				g_OSD.Show(OSDType::MESSAGE_ERROR, error, 5.0f);
+			}
+		}));
+		return UI::EVENT_DONE;
+	});
+	buildTexturePack->SetEnabledFunc([] {
+		return PSP_IsInited() && TextureReplacer::IniExists(g_paramSFO.GetDiscID());
+	});
+
 	if (System_GetPropertyBool(SYSPROP_CAN_SHOW_FILE)) {
 		// Best string we have
 		list->Add(new Choice(di->T("Show in folder")))->OnClick.Add([=](UI::EventParams &) {
@@ -52,7 +52,7 @@ using namespace UI;
 static const char *REPORT_HOSTNAME = "report.ppsspp.org";
 static const int REPORT_PORT = 80;
 
-static bool scanCancelled = false;
+static std::atomic<bool> scanCancelled{};
 static bool scanAborted = false;
 
 enum class ServerAllowStatus {
@@ -259,7 +259,7 @@ static bool LoadGameList(const Path &url, std::vector<Path> &games) {
 	std::vector<File::FileInfo> files;
 	browser.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
 	browser.SetRootAlias("ms:", GetSysDirectory(DIRECTORY_MEMSTICK_ROOT));
-	browser.GetListing(files, "iso:cso:chd:pbp:elf:prx:ppdmp:", &scanCancelled);
+	browser.GetListing(files, "iso:cso:chd:psz:pbp:elf:prx:ppdmp:", &scanCancelled);
 	if (scanCancelled) {
 		return false;
 	}
@@ -558,7 +558,7 @@ static std::wstring FinalizeFilter(std::wstring filter) {
 static std::wstring MakeWindowsFilter(BrowseFileType type) {
 	switch (type) {
 	case BrowseFileType::BOOTABLE:
-		return FinalizeFilter(L"All supported file types (*.iso *.cso *.chd *.pbp *.elf *.prx *.zip *.ppdmp)|*.pbp;*.elf;*.iso;*.cso;*.chd;*.prx;*.zip;*.ppdmp|PSP ROMs (*.iso *.cso *.chd *.pbp *.elf *.prx)|*.pbp;*.elf;*.iso;*.cso;*.chd;*.prx|Homebrew/Demos installers (*.zip)|*.zip|All files (*.*)|*.*||");
+		return FinalizeFilter(L"All supported file types (*.iso *.cso *.chd *.psz *.pbp *.elf *.prx *.zip *.ppdmp)|*.pbp;*.elf;*.iso;*.cso;*.chd;*.psz;*.prx;*.zip;*.ppdmp|PSP ROMs (*.iso *.cso *.chd *.psz *.pbp *.elf *.prx)|*.pbp;*.elf;*.iso;*.cso;*.chd;*.psz;*.prx|Homebrew/Demos installers (*.zip)|*.zip|All files (*.*)|*.*||");
 	case BrowseFileType::INI:
 		return FinalizeFilter(L"Ini files (*.ini)|*.ini|All files (*.*)|*.*||");
 	case BrowseFileType::ZIP:
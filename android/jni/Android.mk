@@ -311,11 +311,13 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Common/File/VFS/VFS.cpp \
   $(SRC)/Common/File/VFS/ZipFileReader.cpp \
   $(SRC)/Common/File/VFS/DirectoryReader.cpp \
+  $(SRC)/Common/File/VFS/PackFileReader.cpp \
   $(SRC)/Common/File/DiskFree.cpp \
   $(SRC)/Common/File/Path.cpp \
   $(SRC)/Common/File/PathBrowser.cpp \
   $(SRC)/Common/File/FileUtil.cpp \
   $(SRC)/Common/File/DirListing.cpp \
+  $(SRC)/Common/File/MappedFile.cpp \
   $(SRC)/Common/File/FileDescriptor.cpp \
   $(SRC)/Common/GPU/thin3d.cpp \
   $(SRC)/Common/GPU/GPUBackendCommon.cpp \
@@ -470,6 +472,7 @@ GPU_VULKAN_FILES := \
   $(SRC)/GPU/Vulkan/GPU_Vulkan.cpp \
   $(SRC)/GPU/Vulkan/PipelineManagerVulkan.cpp \
   $(SRC)/GPU/Vulkan/ShaderManagerVulkan.cpp \
+  $(SRC)/GPU/Vulkan/SpirvBundleVulkan.cpp \
   $(SRC)/GPU/Vulkan/StateMappingVulkan.cpp \
   $(SRC)/GPU/Vulkan/TextureCacheVulkan.cpp \
   $(SRC)/GPU/Vulkan/VulkanUtil.cpp \
@@ -531,6 +534,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/GPU/Common/VertexDecoderHandwritten.cpp.arm \
   $(SRC)/GPU/Common/TextureCacheCommon.cpp.arm \
   $(SRC)/GPU/Common/TextureScalerCommon.cpp.arm \
+  $(SRC)/GPU/Common/TextureScalerDiskCache.cpp.arm \
   $(SRC)/GPU/Common/ShaderCommon.cpp \
   $(SRC)/GPU/Common/StencilCommon.cpp \
   $(SRC)/GPU/Common/SplineCommon.cpp.arm \
@@ -582,6 +586,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/HW/MemoryStick.cpp \
   $(SRC)/Core/HW/MpegDemux.cpp.arm \
   $(SRC)/Core/HW/MediaEngine.cpp.arm \
+  $(SRC)/Core/HW/VideoConvert.cpp.arm \
   $(SRC)/Core/HW/SasAudio.cpp.arm \
   $(SRC)/Core/HW/SasReverb.cpp.arm \
   $(SRC)/Core/HW/StereoResampler.cpp.arm \
@@ -604,6 +609,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/FileLoaders/DiskCachingFileLoader.cpp \
   $(SRC)/Core/FileLoaders/HTTPFileLoader.cpp \
   $(SRC)/Core/FileLoaders/LocalFileLoader.cpp \
+  $(SRC)/Core/FileLoaders/MappedFileLoader.cpp \
   $(SRC)/Core/FileLoaders/RamCachingFileLoader.cpp \
   $(SRC)/Core/FileLoaders/RetryingFileLoader.cpp \
   $(SRC)/Core/FileLoaders/ZipFileLoader.cpp \
@@ -666,6 +672,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/HLE/sceAtrac.cpp \
   $(SRC)/Core/HLE/AtracCtx.cpp \
   $(SRC)/Core/HLE/AtracCtx2.cpp \
+  $(SRC)/Core/HLE/AtracPcmCache.cpp \
   $(SRC)/Core/HLE/__sceAudio.cpp.arm \
   $(SRC)/Core/HLE/sceAudio.cpp.arm \
   $(SRC)/Core/HLE/sceAudiocodec.cpp.arm \
@@ -746,7 +753,9 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/FileSystems/ISOFileSystem.cpp \
   $(SRC)/Core/FileSystems/FileSystem.cpp \
   $(SRC)/Core/FileSystems/MetaFileSystem.cpp \
+  $(SRC)/Core/FileSystems/TracingBlockDevice.cpp \
   $(SRC)/Core/FileSystems/DirectoryFileSystem.cpp \
+  $(SRC)/Core/FileSystems/HostDirectoryCache.cpp \
   $(SRC)/Core/FileSystems/VirtualDiscFileSystem.cpp \
   $(SRC)/Core/FileSystems/tlzrc.cpp \
   $(SRC)/Core/MIPS/JitCommon/JitCommon.cpp \
@@ -757,6 +766,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/Util/MemStick.cpp \
   $(SRC)/Core/Util/PortManager.cpp \
   $(SRC)/Core/Util/GameDB.cpp \
+  $(SRC)/Core/Util/DiscConverter.cpp \
   $(SRC)/Core/Util/GameManager.cpp \
   $(SRC)/Core/Util/BlockAllocator.cpp \
   $(SRC)/Core/Util/PPGeDraw.cpp \
@@ -950,7 +960,10 @@ ifeq ($(HEADLESS),1)
   LOCAL_SRC_FILES := \
     $(SRC)/headless/Headless.cpp \
     $(SRC)/headless/HeadlessHost.cpp \
-    $(SRC)/headless/Compare.cpp
+    $(SRC)/headless/Compare.cpp \
+    $(SRC)/headless/ShaderPrecompile.cpp \
+    $(SRC)/headless/DiscTools.cpp \
+    $(SRC)/headless/Benchmarks.cpp
 
   include $(BUILD_EXECUTABLE)
 endif
@@ -994,6 +1007,13 @@ ifeq ($(UNITTEST),1)
   LOCAL_SRC_FILES := \
     $(SRC)/unittest/JitHarness.cpp \
     $(SRC)/unittest/TestIRPassSimplify.cpp \
+    $(SRC)/unittest/TestISOFileSystem.cpp \
+    $(SRC)/unittest/TestHTTPFileLoader.cpp \
+    $(SRC)/unittest/TestSasMixer.cpp \
+    $(SRC)/unittest/TestAtracDSP.cpp \
+    $(SRC)/unittest/TestVideoConvert.cpp \
+    $(SRC)/unittest/TestCoreTiming.cpp \
+    $(SRC)/unittest/TestThreadQueueList.cpp \
     $(SRC)/unittest/TestShaderGenerators.cpp \
     $(SRC)/unittest/TestSoftwareGPUJit.cpp \
     $(SRC)/unittest/TestThreadManager.cpp \
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "float_dsp.h"
 #include "atrac.h"
 
 float av_atrac_sf_table[64];
@@ -143,7 +144,29 @@ void ff_atrac_iqmf(float *inlo, float *inhi, unsigned int nIn, float *pOut,
 
     /* loop2 */
     p1 = temp;
-    for (j = (int)nIn; j != 0; j--) {
+    j = (int)nIn;
+    if (av_simd_enabled()) {
+        /* four output pairs at a time, each lane summing in the same order as below */
+        for (; j >= 4; j -= 4) {
+            vec4f s1 = vec4f::set1(0.0f);
+            vec4f s2 = vec4f::set1(0.0f);
+            vec4f even, odd, lo, hi;
+
+            for (i = 0; i < 48; i += 2) {
+                vec4f::deinterleave(vec4f::load(p1 + i), vec4f::load(p1 + i + 4), even, odd);
+                s1 = s1 + even * qmf_window[i];
+                s2 = s2 + odd * qmf_window[i+1];
+            }
+
+            vec4f::interleave(s2, s1, lo, hi);
+            lo.store(pOut);
+            hi.store(pOut + 4);
+
+            p1 += 8;
+            pOut += 8;
+        }
+    }
+    for (; j != 0; j--) {
         float s1 = 0.0;
         float s2 = 0.0;
 
@@ -108,6 +108,7 @@ typedef struct ATRAC3Context {
 
     AtracGCContext    gainc_ctx;
     FFTContext        mdct_ctx;
+    DECLARE_ALIGNED(32, float, imlt_buf)[4][MDCT_SIZE]; ///< output of imlt_x4()
 
     int block_align;
     int channels;
@@ -146,6 +147,52 @@ static void imlt(ATRAC3Context *q, float *input, float *output, int odd_band)
     vector_fmul(output, mdct_window, MDCT_SIZE);
 }
 
+/**
+ * imlt() of all four bands at once, running the IMDCTs side by side in SIMD lanes.
+ */
+static void imlt_x4(ATRAC3Context *q, float *input, float (*output)[MDCT_SIZE])
+{
+    DECLARE_ALIGNED(16, float, in4)[MDCT_SIZE / 2 * 4];
+    DECLARE_ALIGNED(16, float, out4)[MDCT_SIZE * 4];
+    int i, band;
+
+    for (band = 1; band < 4; band += 2) {
+        float *in = input + band * 256;
+        for (i = 0; i < 128; i++)
+            FFSWAP(float, in[i], in[255 - i]);
+    }
+
+    /* interleave the four spectra, one per lane */
+    for (i = 0; i < 256; i += 4) {
+        vec4f v0 = vec4f::load(input + i);
+        vec4f v1 = vec4f::load(input + 256 + i);
+        vec4f v2 = vec4f::load(input + 512 + i);
+        vec4f v3 = vec4f::load(input + 768 + i);
+        vec4f::transpose(v0, v1, v2, v3);
+        v0.store(in4 + i * 4);
+        v1.store(in4 + i * 4 + 4);
+        v2.store(in4 + i * 4 + 8);
+        v3.store(in4 + i * 4 + 12);
+    }
+
+    imdct_calc_x4(&q->mdct_ctx, out4, in4);
+
+    for (i = 0; i < MDCT_SIZE; i += 4) {
+        vec4f v0 = vec4f::load(out4 + i * 4);
+        vec4f v1 = vec4f::load(out4 + i * 4 + 4);
+        vec4f v2 = vec4f::load(out4 + i * 4 + 8);
+        vec4f v3 = vec4f::load(out4 + i * 4 + 12);
+        vec4f::transpose(v0, v1, v2, v3);
+        v0.store(&output[0][i]);
+        v1.store(&output[1][i]);
+        v2.store(&output[2][i]);
+        v3.store(&output[3][i]);
+    }
+
+    for (band = 0; band < 4; band++)
+        vector_fmul(output[band], mdct_window, MDCT_SIZE);
+}
+
 /*
  * indata descrambling, only used for data coming from the rm container
  */
@@ -616,16 +663,23 @@ static int decode_channel_sound_unit(ATRAC3Context *q, GetBitContext *gb,
         num_bands = FFMAX((last_tonal + 256) >> 8, num_bands);
 
 
+    /* With SIMD, do all the IMDCTs at once, unless most bands are empty. */
+    const bool batched = av_simd_enabled() && num_bands >= 2;
+    if (batched)
+        imlt_x4(q, snd->spectrum, q->imlt_buf);
+
     /* Reconstruct time domain samples. */
     for (band = 0; band < 4; band++) {
+        float *imdct_buf = batched ? q->imlt_buf[band] : snd->imdct_buf;
+
         /* Perform the IMDCT step without overlapping. */
-        if (band <= num_bands)
-            imlt(q, &snd->spectrum[band * 256], snd->imdct_buf, band & 1);
-        else
-            memset(snd->imdct_buf, 0, 512 * sizeof(*snd->imdct_buf));
+        if (band > num_bands)
+            memset(imdct_buf, 0, 512 * sizeof(*imdct_buf));
+        else if (!batched)
+            imlt(q, &snd->spectrum[band * 256], imdct_buf, band & 1);
 
         /* gain compensation and overlapping */
-        ff_atrac_gain_compensation(&q->gainc_ctx, snd->imdct_buf,
+        ff_atrac_gain_compensation(&q->gainc_ctx, imdct_buf,
                                    &snd->prev_frame[band * 256],
                                    &gain1->g_block[band], &gain2->g_block[band],
                                    256, &output[band * 256]);
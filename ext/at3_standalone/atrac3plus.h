@@ -39,6 +39,7 @@
 #define ATRAC3P_SUBBANDS        16  ///< number of PQF subbands
 #define ATRAC3P_SUBBAND_SAMPLES 128 ///< number of samples per subband
 #define ATRAC3P_FRAME_SAMPLES   (ATRAC3P_SUBBAND_SAMPLES * ATRAC3P_SUBBANDS)
+#define ATRAC3P_MDCT_SIZE       (ATRAC3P_SUBBAND_SAMPLES * 2) ///< IMDCT output size of a subband
 
 #define ATRAC3P_PQF_FIR_LEN     12  ///< length of the prototype FIR of the PQF
 
@@ -217,6 +218,18 @@ void ff_atrac3p_power_compensation(Atrac3pChanUnitCtx *ctx, int ch_index,
 void ff_atrac3p_imdct(FFTContext *mdct_ctx, float *pIn,
                       float *pOut, int wind_id, int sb);
 
+/**
+ * The same for four subbands at once, running the IMDCTs side by side in SIMD lanes.
+ *
+ * @param[in]   mdct_ctx   pointer to MDCT transform context
+ * @param[in]   pIn        float input of subbands sb...sb + 3
+ * @param[out]  pOut       float output, one row per subband
+ * @param[in]   wind_id    which MDCT window to apply, per subband
+ * @param[in]   sb         number of the first subband
+ */
+void ff_atrac3p_imdct_x4(FFTContext *mdct_ctx, float *pIn,
+                         float (*pOut)[ATRAC3P_MDCT_SIZE], const int *wind_id, int sb);
+
 /**
  * Subband synthesis filter based on the polyphase quadrature (pseudo-QMF)
  * filter bank.
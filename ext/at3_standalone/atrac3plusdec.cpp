@@ -49,6 +49,7 @@ struct ATRAC3PContext {
 
     DECLARE_ALIGNED(32, float, samples)[2][ATRAC3P_FRAME_SAMPLES];  ///< quantized MDCT spectrum
     DECLARE_ALIGNED(32, float, mdct_buf)[2][ATRAC3P_FRAME_SAMPLES]; ///< output of the IMDCT
+    DECLARE_ALIGNED(32, float, mdct_buf4)[4][ATRAC3P_MDCT_SIZE];  ///< output of the IMDCT of four subbands at once
     DECLARE_ALIGNED(32, float, time_buf)[2][ATRAC3P_FRAME_SAMPLES]; ///< output of the gain compensation
     DECLARE_ALIGNED(32, float, outp_buf)[2][ATRAC3P_FRAME_SAMPLES];
 
@@ -214,8 +215,7 @@ static void decode_residual_spectrum(Atrac3pChanUnitCtx *ctx,
             if (ctx->channels[ch].qu_wordlen[qu] > 0) {
                 q = av_atrac3p_sf_tab[ctx->channels[ch].qu_sf_idx[qu]] *
                     av_atrac3p_mant_tab[ctx->channels[ch].qu_wordlen[qu]];
-                for (i = 0; i < nspeclines; i++)
-                    dst[i] = src[i] * q;
+                vector_s16_to_float_fmul_scalar(dst, src, q, nspeclines);
             }
         }
 
@@ -243,20 +243,38 @@ static void decode_residual_spectrum(Atrac3pChanUnitCtx *ctx,
 static void reconstruct_frame(ATRAC3PContext *ctx, Atrac3pChanUnitCtx *ch_unit,
                               int num_channels)
 {
-    int ch, sb;
+    int ch, sb, i;
+    const bool simd = av_simd_enabled();
 
     for (ch = 0; ch < num_channels; ch++) {
         for (sb = 0; sb < ch_unit->num_subbands; sb++) {
+            float *mdct_out = &ctx->mdct_buf[ch][sb * ATRAC3P_SUBBAND_SAMPLES];
+            /* with SIMD, four subbands at a time, as long as there are four left */
+            const bool batched = simd && (sb & ~3) + 4 <= ch_unit->num_subbands;
+
             /* inverse transform and windowing */
-            ff_atrac3p_imdct(&ctx->mdct_ctx,
-                             &ctx->samples[ch][sb * ATRAC3P_SUBBAND_SAMPLES],
-                             &ctx->mdct_buf[ch][sb * ATRAC3P_SUBBAND_SAMPLES],
-                             (ch_unit->channels[ch].wnd_shape_prev[sb] << 1) +
-                             ch_unit->channels[ch].wnd_shape[sb], sb);
+            if (batched) {
+                if ((sb & 3) == 0) {
+                    int wind_id[4];
+                    for (i = 0; i < 4; i++)
+                        wind_id[i] = (ch_unit->channels[ch].wnd_shape_prev[sb + i] << 1) +
+                                     ch_unit->channels[ch].wnd_shape[sb + i];
+                    ff_atrac3p_imdct_x4(&ctx->mdct_ctx,
+                                        &ctx->samples[ch][sb * ATRAC3P_SUBBAND_SAMPLES],
+                                        ctx->mdct_buf4, wind_id, sb);
+                }
+                mdct_out = ctx->mdct_buf4[sb & 3];
+            } else {
+                ff_atrac3p_imdct(&ctx->mdct_ctx,
+                                 &ctx->samples[ch][sb * ATRAC3P_SUBBAND_SAMPLES],
+                                 mdct_out,
+                                 (ch_unit->channels[ch].wnd_shape_prev[sb] << 1) +
+                                 ch_unit->channels[ch].wnd_shape[sb], sb);
+            }
 
             /* gain compensation and overlapping */
             ff_atrac_gain_compensation(&ctx->gainc_ctx,
-                                       &ctx->mdct_buf[ch][sb * ATRAC3P_SUBBAND_SAMPLES],
+                                       mdct_out,
                                        &ch_unit->prev_buf[ch][sb * ATRAC3P_SUBBAND_SAMPLES],
                                        &ch_unit->channels[ch].gain_data_prev[sb],
                                        &ch_unit->channels[ch].gain_data[sb],
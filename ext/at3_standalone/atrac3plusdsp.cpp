@@ -25,22 +25,6 @@
  *  DSP functions for ATRAC3+ decoder.
  */
 
-#include "ppsspp_config.h"
-
-#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
-
-#include <emmintrin.h>
-
-#elif PPSSPP_ARCH(ARM_NEON)
-
-#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
-#include <arm64_neon.h>
-#else
-#include <arm_neon.h>
-#endif
-
-#endif
-
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <string.h>
@@ -100,8 +84,6 @@ static void ff_sine_window_init(float *window, int n) {
         window[i] = sinf((i + 0.5) * (M_PI / (2.0 * n)));
 }
 
-#define ATRAC3P_MDCT_SIZE (ATRAC3P_SUBBAND_SAMPLES * 2)
-
 void ff_atrac3p_init_imdct(FFTContext *mdct_ctx)
 {
     ff_sine_window_init(av_sine_64, 64);
@@ -478,22 +460,12 @@ void ff_atrac3p_power_compensation(Atrac3pChanUnitCtx *ctx, int ch_index,
         dst = &sp[av_atrac3p_qu_to_spec_pos[qu]];
         nsp = av_atrac3p_qu_to_spec_pos[qu + 1] - av_atrac3p_qu_to_spec_pos[qu];
 
-        for (i = 0; i < nsp; i++)
-            dst[i] += pwcsp[i] * qu_lev;
+        vector_fmac_scalar(dst, pwcsp, qu_lev, nsp);
     }
 }
 
-void ff_atrac3p_imdct(FFTContext *mdct_ctx, float *pIn,
-                      float *pOut, int wind_id, int sb)
+static void imdct_window(float *pOut, int wind_id)
 {
-    int i;
-
-    if (sb & 1)
-        for (i = 0; i < ATRAC3P_SUBBAND_SAMPLES / 2; i++)
-            FFSWAP(float, pIn[i], pIn[ATRAC3P_SUBBAND_SAMPLES - 1 - i]);
-
-    imdct_calc(mdct_ctx, pOut, pIn);
-
     /* Perform windowing on the output.
      * ATRAC3+ uses two different MDCT windows:
      * - The first one is just the plain sine window of size 256
@@ -513,6 +485,65 @@ void ff_atrac3p_imdct(FFTContext *mdct_ctx, float *pIn,
         vector_fmul_reverse(&pOut[128], av_sine_128, ATRAC3P_MDCT_SIZE / 2);
 }
 
+void ff_atrac3p_imdct(FFTContext *mdct_ctx, float *pIn,
+                      float *pOut, int wind_id, int sb)
+{
+    int i;
+
+    if (sb & 1)
+        for (i = 0; i < ATRAC3P_SUBBAND_SAMPLES / 2; i++)
+            FFSWAP(float, pIn[i], pIn[ATRAC3P_SUBBAND_SAMPLES - 1 - i]);
+
+    imdct_calc(mdct_ctx, pOut, pIn);
+
+    imdct_window(pOut, wind_id);
+}
+
+void ff_atrac3p_imdct_x4(FFTContext *mdct_ctx, float *pIn,
+                         float (*pOut)[ATRAC3P_MDCT_SIZE], const int *wind_id, int sb)
+{
+    DECLARE_ALIGNED(16, float, in4)[ATRAC3P_SUBBAND_SAMPLES * 4];
+    DECLARE_ALIGNED(16, float, out4)[ATRAC3P_MDCT_SIZE * 4];
+    int i, l;
+
+    for (l = 0; l < 4; l++) {
+        float *in = pIn + l * ATRAC3P_SUBBAND_SAMPLES;
+        if ((sb + l) & 1)
+            for (i = 0; i < ATRAC3P_SUBBAND_SAMPLES / 2; i++)
+                FFSWAP(float, in[i], in[ATRAC3P_SUBBAND_SAMPLES - 1 - i]);
+    }
+
+    /* interleave the four spectra, one per lane */
+    for (i = 0; i < ATRAC3P_SUBBAND_SAMPLES; i += 4) {
+        vec4f v0 = vec4f::load(pIn + i);
+        vec4f v1 = vec4f::load(pIn + ATRAC3P_SUBBAND_SAMPLES + i);
+        vec4f v2 = vec4f::load(pIn + ATRAC3P_SUBBAND_SAMPLES * 2 + i);
+        vec4f v3 = vec4f::load(pIn + ATRAC3P_SUBBAND_SAMPLES * 3 + i);
+        vec4f::transpose(v0, v1, v2, v3);
+        v0.store(in4 + i * 4);
+        v1.store(in4 + i * 4 + 4);
+        v2.store(in4 + i * 4 + 8);
+        v3.store(in4 + i * 4 + 12);
+    }
+
+    imdct_calc_x4(mdct_ctx, out4, in4);
+
+    for (i = 0; i < ATRAC3P_MDCT_SIZE; i += 4) {
+        vec4f v0 = vec4f::load(out4 + i * 4);
+        vec4f v1 = vec4f::load(out4 + i * 4 + 4);
+        vec4f v2 = vec4f::load(out4 + i * 4 + 8);
+        vec4f v3 = vec4f::load(out4 + i * 4 + 12);
+        vec4f::transpose(v0, v1, v2, v3);
+        v0.store(&pOut[0][i]);
+        v1.store(&pOut[1][i]);
+        v2.store(&pOut[2][i]);
+        v3.store(&pOut[3][i]);
+    }
+
+    for (l = 0; l < 4; l++)
+        imdct_window(pOut[l], wind_id[l]);
+}
+
 /* lookup table for fast modulo 23 op required for cyclic buffers of the IPQF */
 static const int mod23_lut[26] = {
     23,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11,
@@ -627,86 +658,90 @@ void ff_atrac3p_ipqf(FFTContext *dct_ctx, Atrac3pIPQFChannelCtx *hist,
                      const float *in, float *out)
 {
     int i, s, sb, t, pos_now, pos_next;
-    float idct_in [ATRAC3P_SUBBANDS];
-    float idct_out[ATRAC3P_SUBBANDS];
+    DECLARE_ALIGNED(16, float, idct_in) [ATRAC3P_SUBBANDS * 4];
+    DECLARE_ALIGNED(16, float, idct_out)[ATRAC3P_SUBBANDS * 4];
+    const bool simd = av_simd_enabled();
 
     memset(out, 0, ATRAC3P_FRAME_SAMPLES * sizeof(*out));
 
     for (s = 0; s < ATRAC3P_SUBBAND_SAMPLES; s++) {
-        /* pick up one sample from each subband */
-        for (sb = 0; sb < ATRAC3P_SUBBANDS; sb++)
-            idct_in[sb] = in[sb * ATRAC3P_SUBBAND_SAMPLES + s];
-
-        /* Calculate the sine and cosine part of the PQF using IDCT-IV */
-        imdct_half(dct_ctx, idct_out, idct_in);
+        const float *idct_res;
+        int stride;
+
+        if (simd) {
+            /* The IDCTs of four samples at once, one in each lane. */
+            if ((s & 3) == 0) {
+                for (sb = 0; sb < ATRAC3P_SUBBANDS; sb++)
+                    vec4f::load(&in[sb * ATRAC3P_SUBBAND_SAMPLES + s]).store(&idct_in[sb * 4]);
+                imdct_half_x4(dct_ctx, idct_out, idct_in);
+            }
+            idct_res = idct_out + (s & 3);
+            stride = 4;
+        } else {
+            /* pick up one sample from each subband */
+            for (sb = 0; sb < ATRAC3P_SUBBANDS; sb++)
+                idct_in[sb] = in[sb * ATRAC3P_SUBBAND_SAMPLES + s];
+
+            /* Calculate the sine and cosine part of the PQF using IDCT-IV */
+            imdct_half(dct_ctx, idct_out, idct_in);
+            idct_res = idct_out;
+            stride = 1;
+        }
 
         /* append the result to the history */
         const int hist_pos = hist->pos;
         for (i = 0; i < 8; i++) {
-            hist->buf1[hist_pos][i] = idct_out[i + 8];
+            hist->buf1[hist_pos][i] = idct_res[(i + 8) * stride];
         }
         for (i = 0; i < 8; i++) {
-            hist->buf2[hist_pos][i] = idct_out[7 - i];
+            hist->buf2[hist_pos][i] = idct_res[(7 - i) * stride];
         }
 
         pos_now  = hist->pos;
         pos_next = mod23_lut[pos_now + 2]; // pos_next = (pos_now + 1) % 23;
 
-        for (t = 0; t < ATRAC3P_PQF_FIR_LEN; t++) {
-            const float *buf1 = hist->buf1[pos_now];
-            const float *buf2 = hist->buf2[pos_next];
-            const float *coeffs1 = ipqf_coeffs1[t];
-            const float *coeffs2 = ipqf_coeffs2[t];
-
-            float *outp = out + s * 16;
-#if PPSSPP_ARCH(SSE2)
-            auto _mm_reverse = [](__m128 x) -> __m128 {
-                return _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 1, 2, 3));
-            };
-            _mm_storeu_ps(outp, _mm_add_ps(_mm_loadu_ps(outp), _mm_add_ps(
-                _mm_mul_ps(_mm_loadu_ps(buf1), _mm_loadu_ps(coeffs1)),
-                _mm_mul_ps(_mm_loadu_ps(buf2), _mm_loadu_ps(coeffs2)))));
-            _mm_storeu_ps(outp + 4, _mm_add_ps(_mm_loadu_ps(outp + 4), _mm_add_ps(
-                _mm_mul_ps(_mm_loadu_ps(buf1 + 4), _mm_loadu_ps(coeffs1 + 4)),
-                _mm_mul_ps(_mm_loadu_ps(buf2 + 4), _mm_loadu_ps(coeffs2 + 4)))));
-
-            _mm_storeu_ps(outp + 8, _mm_add_ps(_mm_loadu_ps(outp + 8), _mm_add_ps(
-                _mm_mul_ps(_mm_reverse(_mm_loadu_ps(buf1 + 4)), _mm_loadu_ps(coeffs1 + 8)),
-                _mm_mul_ps(_mm_reverse(_mm_loadu_ps(buf2 + 4)), _mm_loadu_ps(coeffs2 + 8)))));
-            _mm_storeu_ps(outp + 12, _mm_add_ps(_mm_loadu_ps(outp + 12), _mm_add_ps(
-                _mm_mul_ps(_mm_reverse(_mm_loadu_ps(buf1)), _mm_loadu_ps(coeffs1 + 12)),
-                _mm_mul_ps(_mm_reverse(_mm_loadu_ps(buf2)), _mm_loadu_ps(coeffs2 + 12)))));
-#elif PPSSPP_ARCH(ARM_NEON)
-            auto vreverseq_f32 = [](float32x4_t x) -> float32x4_t {
-                float32x4_t rev = vrev64q_f32(x);
-                float32x2_t high = vget_high_f32(rev); //{4,3}
-                float32x2_t low = vget_low_f32(rev); //{1,2}
-                return vcombine_f32(high, low); //{4,3,2,1}
-            };
-            vst1q_f32(outp, vaddq_f32(vld1q_f32(outp), vaddq_f32(
-                vmulq_f32(vld1q_f32(buf1), vld1q_f32(coeffs1)),
-                vmulq_f32(vld1q_f32(buf2), vld1q_f32(coeffs2)))));
-            vst1q_f32(outp + 4, vaddq_f32(vld1q_f32(outp + 4), vaddq_f32(
-                vmulq_f32(vld1q_f32(buf1 + 4), vld1q_f32(coeffs1 + 4)),
-                vmulq_f32(vld1q_f32(buf2 + 4), vld1q_f32(coeffs2 + 4)))));
-
-            vst1q_f32(outp + 8, vaddq_f32(vld1q_f32(outp + 8), vaddq_f32(
-                vmulq_f32(vreverseq_f32(vld1q_f32(buf1 + 4)), vld1q_f32(coeffs1 + 8)),
-                vmulq_f32(vreverseq_f32(vld1q_f32(buf2 + 4)), vld1q_f32(coeffs2 + 8)))));
-            vst1q_f32(outp + 12, vaddq_f32(vld1q_f32(outp + 12), vaddq_f32(
-                vmulq_f32(vreverseq_f32(vld1q_f32(buf1)), vld1q_f32(coeffs1 + 12)),
-                vmulq_f32(vreverseq_f32(vld1q_f32(buf2)), vld1q_f32(coeffs2 + 12)))));
-#else
-            for (i = 0; i < 8; i++) {
-                outp[i] += buf1[i] * coeffs1[i] + buf2[i] * coeffs2[i];
+        float *outp = out + s * 16;
+        if (simd) {
+            /* Same sums as below, but kept in registers across the taps. */
+            vec4f acc0 = vec4f::load(outp), acc1 = vec4f::load(outp + 4);
+            vec4f acc2 = vec4f::load(outp + 8), acc3 = vec4f::load(outp + 12);
+            for (t = 0; t < ATRAC3P_PQF_FIR_LEN; t++) {
+                const float *buf1 = hist->buf1[pos_now];
+                const float *buf2 = hist->buf2[pos_next];
+                const float *coeffs1 = ipqf_coeffs1[t];
+                const float *coeffs2 = ipqf_coeffs2[t];
+                const vec4f b1lo = vec4f::load(buf1), b1hi = vec4f::load(buf1 + 4);
+                const vec4f b2lo = vec4f::load(buf2), b2hi = vec4f::load(buf2 + 4);
+
+                acc0 = acc0 + (b1lo * vec4f::load(coeffs1) + b2lo * vec4f::load(coeffs2));
+                acc1 = acc1 + (b1hi * vec4f::load(coeffs1 + 4) + b2hi * vec4f::load(coeffs2 + 4));
+                acc2 = acc2 + (b1hi.reverse() * vec4f::load(coeffs1 + 8) + b2hi.reverse() * vec4f::load(coeffs2 + 8));
+                acc3 = acc3 + (b1lo.reverse() * vec4f::load(coeffs1 + 12) + b2lo.reverse() * vec4f::load(coeffs2 + 12));
+
+                pos_now  = mod23_lut[pos_next + 2]; // pos_now  = (pos_now  + 2) % 23;
+                pos_next = mod23_lut[pos_now + 2];  // pos_next = (pos_next + 2) % 23;
             }
-            for (i = 0; i < 8; i++) {
-                outp[i + 8] += buf1[7 - i] * coeffs1[i + 8] + buf2[7 - i] * coeffs2[i + 8];
+            acc0.store(outp);
+            acc1.store(outp + 4);
+            acc2.store(outp + 8);
+            acc3.store(outp + 12);
+        } else {
+            for (t = 0; t < ATRAC3P_PQF_FIR_LEN; t++) {
+                const float *buf1 = hist->buf1[pos_now];
+                const float *buf2 = hist->buf2[pos_next];
+                const float *coeffs1 = ipqf_coeffs1[t];
+                const float *coeffs2 = ipqf_coeffs2[t];
+
+                for (i = 0; i < 8; i++) {
+                    outp[i] += buf1[i] * coeffs1[i] + buf2[i] * coeffs2[i];
+                }
+                for (i = 0; i < 8; i++) {
+                    outp[i + 8] += buf1[7 - i] * coeffs1[i + 8] + buf2[7 - i] * coeffs2[i + 8];
+                }
+
+                pos_now  = mod23_lut[pos_next + 2]; // pos_now  = (pos_now  + 2) % 23;
+                pos_next = mod23_lut[pos_now + 2];  // pos_next = (pos_next + 2) % 23;
             }
-#endif
-
-            pos_now  = mod23_lut[pos_next + 2]; // pos_now  = (pos_now  + 2) % 23;
-            pos_next = mod23_lut[pos_now + 2];  // pos_next = (pos_next + 2) % 23;
         }
 
         hist->pos = mod23_lut[hist->pos]; // hist->pos = (hist->pos - 1) % 23;
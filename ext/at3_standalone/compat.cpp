@@ -1,9 +1,26 @@
 #include <cstdarg>
 #include <cstdio>
 
+#include "ppsspp_config.h"
 #include "compat.h"
 #include "Common/Log.h"
 
+static constexpr int DetectCpuFlags() {
+#if PPSSPP_ARCH(SSE2)
+	return AV_CPU_FLAG_SSE2;
+#elif PPSSPP_ARCH(ARM_NEON)
+	return AV_CPU_FLAG_NEON;
+#else
+	return 0;
+#endif
+}
+
+int av_cpu_flags = DetectCpuFlags();
+
+void av_force_cpu_flags(int flags) {
+	av_cpu_flags = flags == -1 ? DetectCpuFlags() : flags;
+}
+
 void av_log(int level, const char *fmt, ...) {
 	char buffer[512];
 	va_list vl;
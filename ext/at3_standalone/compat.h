@@ -79,3 +79,14 @@ void av_log(int level, const char *fmt, ...) av_printf_format(3, 4);
 #define AV_BSWAP16C(x) (((x) << 8 & 0xff00)  | ((x) >> 8 & 0x00ff))
 #define AV_BSWAP32C(x) (AV_BSWAP16C(x) << 16 | AV_BSWAP16C((x) >> 16))
 #define av_be2ne32(x) AV_BSWAP32C((x))
+
+// Like FFmpeg's cpu flags, selects the SIMD code paths at runtime. Only SSE2 and NEON are used,
+// and only when compiled in, where they're part of the baseline. Forcing the flags to 0 runs
+// the plain C code, which the SIMD paths match exactly (to compare and benchmark against.)
+#define AV_CPU_FLAG_SSE2 0x0010
+#define AV_CPU_FLAG_NEON (1 << 5)
+
+extern int av_cpu_flags;
+inline int av_get_cpu_flags() { return av_cpu_flags; }
+// Pass -1 to go back to the detected flags.
+void av_force_cpu_flags(int flags);
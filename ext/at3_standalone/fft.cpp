@@ -159,7 +159,7 @@ void ff_fft_end(FFTContext *s)
 // this is slightly slower for small data, but avoids store->load aliasing
 // for addresses separated by large powers of 2.
 #define BUTTERFLIES_BIG(a0,a1,a2,a3) {\
-    FFTSample r0=a0.re, i0=a0.im, r1=a1.re, i1=a1.im;\
+    FFTSampleT r0=a0.re, i0=a0.im, r1=a1.re, i1=a1.im;\
     BF(t3, t5, t5, t1);\
     BF(a2.re, a0.re, r0, t5);\
     BF(a3.im, a1.im, i1, t3);\
@@ -184,9 +184,11 @@ void ff_fft_end(FFTContext *s)
 
 /* z[0...8n-1], w[1...2n-1] */
 #define PASS(name)\
-static void name(FFTComplex *z, const FFTSample *wre, unsigned int n)\
+template <typename FFTComplexT>\
+static void name(FFTComplexT *z, const FFTSample *wre, unsigned int n)\
 {\
-    FFTDouble t1, t2, t3, t4, t5, t6;\
+    typedef decltype(z->re) FFTSampleT;\
+    FFTSampleT t1, t2, t3, t4, t5, t6;\
     int o1 = 2*n;\
     int o2 = 4*n;\
     int o3 = 6*n;\
@@ -210,7 +212,8 @@ PASS(pass)
 PASS(pass_big)
 
 #define DECL_FFT(n,n2,n4)\
-static void fft##n(FFTComplex *z)\
+template <typename FFTComplexT>\
+static void fft##n(FFTComplexT *z)\
 {\
     fft##n2(z);\
     fft##n4(z+n4*2);\
@@ -218,9 +221,12 @@ static void fft##n(FFTComplex *z)\
     pass(z,av_cos_##n,n4/2);\
 }
 
-static void fft4(FFTComplex *z)
+// These are templates so that FFTComplex4 can run four transforms at once, through the same code.
+template <typename FFTComplexT>
+static void fft4(FFTComplexT *z)
 {
-    FFTDouble t1, t2, t3, t4, t5, t6, t7, t8;
+    typedef decltype(z->re) FFTSampleT;
+    FFTSampleT t1, t2, t3, t4, t5, t6, t7, t8;
 
     BF(t3, t1, z[0].re, z[1].re);
     BF(t8, t6, z[3].re, z[2].re);
@@ -232,9 +238,11 @@ static void fft4(FFTComplex *z)
     BF(z[2].im, z[0].im, t2, t5);
 }
 
-static void fft8(FFTComplex *z)
+template <typename FFTComplexT>
+static void fft8(FFTComplexT *z)
 {
-    FFTDouble t1, t2, t3, t4, t5, t6;
+    typedef decltype(z->re) FFTSampleT;
+    FFTSampleT t1, t2, t3, t4, t5, t6;
 
     fft4(z);
 
@@ -247,9 +255,11 @@ static void fft8(FFTComplex *z)
     TRANSFORM(z[1],z[3],z[5],z[7],sqrthalf,sqrthalf);
 }
 
-static void fft16(FFTComplex *z)
+template <typename FFTComplexT>
+static void fft16(FFTComplexT *z)
 {
-    FFTDouble t1, t2, t3, t4, t5, t6;
+    typedef decltype(z->re) FFTSampleT;
+    FFTSampleT t1, t2, t3, t4, t5, t6;
     FFTSample cos_16_1 = av_cos_16[1];
     FFTSample cos_16_3 = av_cos_16[3];
 
@@ -274,10 +284,26 @@ static void (* const fft_dispatch[])(FFTComplex*) = {
     fft4, fft8, fft16, fft32, fft64, fft128, fft256, fft512, fft1024,
 };
 
+static void (* const fft_dispatch_x4[])(FFTComplex4*) = {
+    fft4, fft8, fft16, fft32, fft64, fft128, fft256, fft512, fft1024,
+};
+
 void fft_calc(FFTContext *s, FFTComplex *z) {
     fft_dispatch[s->nbits-2](z);
 }
 
+void fft_calc_x4(FFTContext *s, FFTComplex4 *z) {
+    fft_dispatch_x4[s->nbits-2](z);
+}
+
+static inline void fft_calc_t(FFTContext *s, FFTComplex *z) {
+    fft_calc(s, z);
+}
+
+static inline void fft_calc_t(FFTContext *s, FFTComplex4 *z) {
+    fft_calc_x4(s, z);
+}
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -333,20 +359,21 @@ int ff_mdct_init(FFTContext *s, int nbits, int inverse, double scale)
 	return -1;
 }
 
-/**
- * Compute the middle half of the inverse MDCT of size N = 2^nbits,
- * thus excluding the parts that can be derived by symmetry
- * @param output N/2 samples
- * @param input N/2 samples
- */
-void imdct_half(FFTContext *s, FFTSample *output, const FFTSample *input)
+static inline FFTSample load_lanes(const FFTSample *input, int i, const FFTComplex *) {
+	return input[i];
+}
+
+static inline vec4f load_lanes(const FFTSample *input, int i, const FFTComplex4 *) {
+	return vec4f::load(input + i * 4);
+}
+
+template <typename FFTComplexT>
+static void imdct_half_t(FFTContext *s, FFTComplexT *z, const FFTSample *input)
 {
 	int k, n8, n4, n2, n, j;
 	const uint16_t *revtab = s->revtab;
 	const FFTSample *tcos = s->tcos;
 	const FFTSample *tsin = s->tsin;
-	const FFTSample *in1, *in2;
-	FFTComplex *z = (FFTComplex *)output;
 
 	n = 1 << s->mdct_bits;
 	n2 = n >> 1;
@@ -354,19 +381,15 @@ void imdct_half(FFTContext *s, FFTSample *output, const FFTSample *input)
 	n8 = n >> 3;
 
 	/* pre rotation */
-	in1 = input;
-	in2 = input + n2 - 1;
 	for (k = 0; k < n4; k++) {
 		j = revtab[k];
-		CMUL(z[j].re, z[j].im, *in2, *in1, tcos[k], tsin[k]);
-		in1 += 2;
-		in2 -= 2;
+		CMUL(z[j].re, z[j].im, load_lanes(input, n2 - 1 - 2 * k, z), load_lanes(input, 2 * k, z), tcos[k], tsin[k]);
 	}
-	fft_calc(s, z);
+	fft_calc_t(s, z);
 
 	/* post rotation + reordering */
 	for (k = 0; k < n8; k++) {
-		FFTSample r0, i0, r1, i1;
+		decltype(z->re) r0, i0, r1, i1;
 		CMUL(r0, i1, z[n8 - k - 1].im, z[n8 - k - 1].re, tsin[n8 - k - 1], tcos[n8 - k - 1]);
 		CMUL(r1, i0, z[n8 + k].im, z[n8 + k].re, tsin[n8 + k], tcos[n8 + k]);
 		z[n8 - k - 1].re = r0;
@@ -376,6 +399,22 @@ void imdct_half(FFTContext *s, FFTSample *output, const FFTSample *input)
 	}
 }
 
+/**
+ * Compute the middle half of the inverse MDCT of size N = 2^nbits,
+ * thus excluding the parts that can be derived by symmetry
+ * @param output N/2 samples
+ * @param input N/2 samples
+ */
+void imdct_half(FFTContext *s, FFTSample *output, const FFTSample *input)
+{
+	imdct_half_t(s, (FFTComplex *)output, input);
+}
+
+void imdct_half_x4(FFTContext *s, FFTSample *output, const FFTSample *input)
+{
+	imdct_half_t(s, (FFTComplex4 *)output, input);
+}
+
 /**
  * Compute inverse MDCT of size N = 2^nbits
  * @param output N samples
@@ -396,6 +435,21 @@ void imdct_calc(FFTContext *s, FFTSample *output, const FFTSample *input)
 	}
 }
 
+void imdct_calc_x4(FFTContext *s, FFTSample *output, const FFTSample *input)
+{
+	int k;
+	int n = 1 << s->mdct_bits;
+	int n2 = n >> 1;
+	int n4 = n >> 2;
+
+	imdct_half_x4(s, output + n4 * 4, input);
+
+	for (k = 0; k < n4; k++) {
+		(-vec4f::load(output + (n2 - k - 1) * 4)).store(output + k * 4);
+		vec4f::load(output + (n2 + k) * 4).store(output + (n - k - 1) * 4);
+	}
+}
+
 void ff_mdct_end(FFTContext *s)
 {
 	av_freep(&s->tcos);
@@ -29,6 +29,7 @@
 #include <stdint.h>
 
 #include "compat.h"
+#include "float_dsp.h"
 
 typedef float FFTSample;
 
@@ -36,6 +37,14 @@ typedef struct FFTComplex {
 	FFTSample re, im;
 } FFTComplex;
 
+/**
+ * Four FFTComplex side by side, one transform in each lane. As an array of floats,
+ * that's element i of lane l at [i * 4 + l], and must be 16 byte aligned.
+ */
+typedef struct FFTComplex4 {
+	vec4f re, im;
+} FFTComplex4;
+
 typedef struct FFTContext FFTContext;
 
 typedef float FFTDouble;
@@ -69,6 +78,15 @@ void fft_calc(struct FFTContext *s, FFTComplex *z);
 void imdct_calc(struct FFTContext *s, FFTSample *output, const FFTSample *input);
 void imdct_half(struct FFTContext *s, FFTSample *output, const FFTSample *input);
 
+/**
+ * The same, but four transforms at once, with the data interleaved as in FFTComplex4
+ * (element i of transform l at [i * 4 + l].) Each transform gets exactly the same
+ * result as from the functions above, this just runs them in SIMD lanes.
+ */
+void fft_calc_x4(struct FFTContext *s, FFTComplex4 *z);
+void imdct_calc_x4(struct FFTContext *s, FFTSample *output, const FFTSample *input);
+void imdct_half_x4(struct FFTContext *s, FFTSample *output, const FFTSample *input);
+
 #define COSTABLE(size) \
      DECLARE_ALIGNED(32, FFTSample, av_cos_##size)[size/2]
 
@@ -18,10 +18,142 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include "ppsspp_config.h"
 #include "compat.h"
 
+#if PPSSPP_ARCH(SSE2)
+#include <emmintrin.h>
+#define AV_CPU_FLAG_SIMD AV_CPU_FLAG_SSE2
+#elif PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#define AV_CPU_FLAG_SIMD AV_CPU_FLAG_NEON
+#else
+#define AV_CPU_FLAG_SIMD 0
+#endif
+
+inline bool av_simd_enabled() {
+    return (av_get_cpu_flags() & AV_CPU_FLAG_SIMD) != 0;
+}
+
+/**
+ * Four floats, to run a loop four at a time or four transforms side by side.
+ * There's no fused multiply-add, every lane does exactly what the scalar code does,
+ * so the results are bit exact with the C versions.
+ */
+struct vec4f {
+#if PPSSPP_ARCH(SSE2)
+    __m128 v;
+
+    static vec4f load(const float *p) { return vec4f{ _mm_loadu_ps(p) }; }
+    static vec4f load_s16(const int16_t *p) {
+        __m128i x = _mm_loadl_epi64((const __m128i *)p);
+        return vec4f{ _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)) };
+    }
+    static vec4f set1(float f) { return vec4f{ _mm_set1_ps(f) }; }
+    void store(float *p) const { _mm_storeu_ps(p, v); }
+
+    vec4f operator +(vec4f o) const { return vec4f{ _mm_add_ps(v, o.v) }; }
+    vec4f operator -(vec4f o) const { return vec4f{ _mm_sub_ps(v, o.v) }; }
+    vec4f operator *(vec4f o) const { return vec4f{ _mm_mul_ps(v, o.v) }; }
+    vec4f operator -() const { return vec4f{ _mm_xor_ps(v, _mm_set1_ps(-0.0f)) }; }
+    vec4f reverse() const { return vec4f{ _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)) }; }
+
+    static void transpose(vec4f &a, vec4f &b, vec4f &c, vec4f &d) {
+        _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+    }
+    // (a0 a1 a2 a3) (b0 b1 b2 b3) <-> (a0 a2 b0 b2) (a1 a3 b1 b3)
+    static void deinterleave(vec4f a, vec4f b, vec4f &even, vec4f &odd) {
+        even.v = _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(2, 0, 2, 0));
+        odd.v = _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+    static void interleave(vec4f even, vec4f odd, vec4f &a, vec4f &b) {
+        a.v = _mm_unpacklo_ps(even.v, odd.v);
+        b.v = _mm_unpackhi_ps(even.v, odd.v);
+    }
+#elif PPSSPP_ARCH(ARM_NEON)
+    float32x4_t v;
+
+    static vec4f load(const float *p) { return vec4f{ vld1q_f32(p) }; }
+    static vec4f load_s16(const int16_t *p) { return vec4f{ vcvtq_f32_s32(vmovl_s16(vld1_s16(p))) }; }
+    static vec4f set1(float f) { return vec4f{ vdupq_n_f32(f) }; }
+    void store(float *p) const { vst1q_f32(p, v); }
+
+    vec4f operator +(vec4f o) const { return vec4f{ vaddq_f32(v, o.v) }; }
+    vec4f operator -(vec4f o) const { return vec4f{ vsubq_f32(v, o.v) }; }
+    vec4f operator *(vec4f o) const { return vec4f{ vmulq_f32(v, o.v) }; }
+    vec4f operator -() const { return vec4f{ vnegq_f32(v) }; }
+    vec4f reverse() const {
+        float32x4_t rev = vrev64q_f32(v);
+        return vec4f{ vcombine_f32(vget_high_f32(rev), vget_low_f32(rev)) };
+    }
+
+    static void transpose(vec4f &a, vec4f &b, vec4f &c, vec4f &d) {
+        float32x4x2_t ab = vtrnq_f32(a.v, b.v);
+        float32x4x2_t cd = vtrnq_f32(c.v, d.v);
+        a.v = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+        b.v = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+        c.v = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+        d.v = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+    }
+    static void deinterleave(vec4f a, vec4f b, vec4f &even, vec4f &odd) {
+        float32x4x2_t r = vuzpq_f32(a.v, b.v);
+        even.v = r.val[0];
+        odd.v = r.val[1];
+    }
+    static void interleave(vec4f even, vec4f odd, vec4f &a, vec4f &b) {
+        float32x4x2_t r = vzipq_f32(even.v, odd.v);
+        a.v = r.val[0];
+        b.v = r.val[1];
+    }
+#else
+    float v[4];
+
+    static vec4f load(const float *p) { return vec4f{ { p[0], p[1], p[2], p[3] } }; }
+    static vec4f load_s16(const int16_t *p) { return vec4f{ { (float)p[0], (float)p[1], (float)p[2], (float)p[3] } }; }
+    static vec4f set1(float f) { return vec4f{ { f, f, f, f } }; }
+    void store(float *p) const { for (int i = 0; i < 4; i++) p[i] = v[i]; }
+
+    vec4f operator +(vec4f o) const { return vec4f{ { v[0] + o.v[0], v[1] + o.v[1], v[2] + o.v[2], v[3] + o.v[3] } }; }
+    vec4f operator -(vec4f o) const { return vec4f{ { v[0] - o.v[0], v[1] - o.v[1], v[2] - o.v[2], v[3] - o.v[3] } }; }
+    vec4f operator *(vec4f o) const { return vec4f{ { v[0] * o.v[0], v[1] * o.v[1], v[2] * o.v[2], v[3] * o.v[3] } }; }
+    vec4f operator -() const { return vec4f{ { -v[0], -v[1], -v[2], -v[3] } }; }
+    vec4f reverse() const { return vec4f{ { v[3], v[2], v[1], v[0] } }; }
+
+    static void transpose(vec4f &a, vec4f &b, vec4f &c, vec4f &d) {
+        vec4f rows[4] = { a, b, c, d };
+        for (int i = 0; i < 4; i++) {
+            a.v[i] = rows[i].v[0];
+            b.v[i] = rows[i].v[1];
+            c.v[i] = rows[i].v[2];
+            d.v[i] = rows[i].v[3];
+        }
+    }
+    static void deinterleave(vec4f a, vec4f b, vec4f &even, vec4f &odd) {
+        even = vec4f{ { a.v[0], a.v[2], b.v[0], b.v[2] } };
+        odd = vec4f{ { a.v[1], a.v[3], b.v[1], b.v[3] } };
+    }
+    static void interleave(vec4f even, vec4f odd, vec4f &a, vec4f &b) {
+        a = vec4f{ { even.v[0], odd.v[0], even.v[1], odd.v[1] } };
+        b = vec4f{ { even.v[2], odd.v[2], even.v[3], odd.v[3] } };
+    }
+#endif
+
+    vec4f operator *(float f) const { return *this * set1(f); }
+};
+
 inline void vector_fmul(float * av_restrict dst, const float * av_restrict src, int len) {
-    for (int i = 0; i < len; i++)
+    int i = 0;
+    if (av_simd_enabled()) {
+        for (; i + 4 <= len; i += 4)
+            (vec4f::load(dst + i) * vec4f::load(src + i)).store(dst + i);
+    }
+    for (; i < len; i++)
         dst[i] = dst[i] * src[i];
 }
 
@@ -30,10 +162,42 @@ inline void vector_fmul(float * av_restrict dst, const float * av_restrict src,
 * destination vectors must overlap exactly or not at all.
 */
 inline void vector_fmul_scalar(float *dst, float mul, int len) {
-    for (int i = 0; i < len; i++)
+    int i = 0;
+    if (av_simd_enabled()) {
+        for (; i + 4 <= len; i += 4)
+            (vec4f::load(dst + i) * mul).store(dst + i);
+    }
+    for (; i < len; i++)
         dst[i] *= mul;
 }
 
+/**
+* Multiply a vector of floats by a scalar float and add to
+* destination vector.
+*/
+inline void vector_fmac_scalar(float * av_restrict dst, const float * av_restrict src, float mul, int len) {
+    int i = 0;
+    if (av_simd_enabled()) {
+        for (; i + 4 <= len; i += 4)
+            (vec4f::load(dst + i) + vec4f::load(src + i) * mul).store(dst + i);
+    }
+    for (; i < len; i++)
+        dst[i] += src[i] * mul;
+}
+
+/**
+* Convert a vector of int16 to floats and multiply them by a scalar float.
+*/
+inline void vector_s16_to_float_fmul_scalar(float * av_restrict dst, const int16_t * av_restrict src, float mul, int len) {
+    int i = 0;
+    if (av_simd_enabled()) {
+        for (; i + 4 <= len; i += 4)
+            (vec4f::load_s16(src + i) * mul).store(dst + i);
+    }
+    for (; i < len; i++)
+        dst[i] = src[i] * mul;
+}
+
 /**
 * Calculate the entry wise product of two vectors of floats, and store the result
 * in a vector of floats. The second vector of floats is iterated over
@@ -47,7 +211,12 @@ inline void vector_fmul_scalar(float *dst, float mul, int len) {
 *             constraints: multiple of 16
 */
 inline void vector_fmul_reverse(float * av_restrict dst, const float * av_restrict src, int len) {
+    int i = 0;
     src += len - 1;
-    for (int i = 0; i < len; i++)
+    if (av_simd_enabled()) {
+        for (; i + 4 <= len; i += 4)
+            (vec4f::load(dst + i) * vec4f::load(src - i - 3).reverse()).store(dst + i);
+    }
+    for (; i < len; i++)
         dst[i] *= src[-i];
 }
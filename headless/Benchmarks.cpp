@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+#include "Common/Net/HTTPHeaders.h"
+#include "Common/Net/HTTPServer.h"
+#include "Common/Net/Resolve.h"
+#include "Common/Net/Sinks.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "Core/CoreTiming.h"
+#include "Core/FileLoaders/HTTPFileLoader.h"
+#include "Core/MIPS/MIPS.h"
+#include "ext/at3_standalone/atrac.h"
+#include "ext/at3_standalone/atrac3plus.h"
+#include "ext/at3_standalone/compat.h"
+#include "ext/at3_standalone/fft.h"
+#include "headless/Benchmarks.h"
+
+// How long to run each measurement.
+static const double BENCH_SECONDS = 0.5;
+
+template <typename F>
+static double RunsPerSecond(F func) {
+	int runs = 0;
+	const double start = time_now_d();
+	do {
+		func();
+		runs++;
+	} while (time_now_d() - start < BENCH_SECONDS);
+	return runs / (time_now_d() - start);
+}
+
+// The synthesis part of an Atrac3+ frame, like the decoder does it: IMDCT and windowing of all
+// subbands, then the PQF. That's most of the work besides unpacking the bitstream.
+static void SynthesizeAtrac3PlusFrame(FFTContext *mdct, FFTContext *ipqfDct, Atrac3pIPQFChannelCtx *hist, float *spectrum, float *out) {
+	static float mdctBuf[ATRAC3P_FRAME_SAMPLES + ATRAC3P_SUBBAND_SAMPLES];
+	static float mdctBuf4[4][ATRAC3P_MDCT_SIZE];
+	static float timeBuf[ATRAC3P_FRAME_SAMPLES];
+	const int windIds[4] = { 0, 1, 2, 3 };
+	const bool simd = av_simd_enabled();
+	for (int sb = 0; sb < ATRAC3P_SUBBANDS; sb++) {
+		if (simd) {
+			if ((sb & 3) == 0)
+				ff_atrac3p_imdct_x4(mdct, spectrum + sb * ATRAC3P_SUBBAND_SAMPLES, mdctBuf4, windIds, sb);
+			memcpy(timeBuf + sb * ATRAC3P_SUBBAND_SAMPLES, mdctBuf4[sb & 3], ATRAC3P_SUBBAND_SAMPLES * sizeof(float));
+		} else {
+			ff_atrac3p_imdct(mdct, spectrum + sb * ATRAC3P_SUBBAND_SAMPLES, mdctBuf + sb * ATRAC3P_SUBBAND_SAMPLES, windIds[sb & 3], sb);
+			memcpy(timeBuf + sb * ATRAC3P_SUBBAND_SAMPLES, mdctBuf + sb * ATRAC3P_SUBBAND_SAMPLES, ATRAC3P_SUBBAND_SAMPLES * sizeof(float));
+		}
+	}
+	ff_atrac3p_ipqf(ipqfDct, hist, timeBuf, out);
+}
+
+// The same for Atrac3: IMDCT of the four bands, then the three QMF stages.
+static void SynthesizeAtrac3Frame(FFTContext *mdct, float *delay, float *spectrum, float *out) {
+	alignas(16) static float in4[256 * 4], out4[512 * 4];
+	static float imdctBuf[512];
+	static float temp[1070];
+	if (av_simd_enabled()) {
+		for (int i = 0; i < 256 * 4; i++)
+			in4[i] = spectrum[(i & 3) * 256 + i / 4];
+		imdct_calc_x4(mdct, out4, in4);
+	}
+	for (int band = 0; band < 4; band++) {
+		if (av_simd_enabled()) {
+			for (int i = 0; i < 256; i++)
+				out[band * 256 + i] = out4[i * 4 + band];
+		} else {
+			imdct_calc(mdct, imdctBuf, spectrum + band * 256);
+			memcpy(out + band * 256, imdctBuf, 256 * sizeof(float));
+		}
+	}
+	ff_atrac_iqmf(out, out + 256, 256, out, delay, temp);
+	ff_atrac_iqmf(out + 768, out + 512, 256, out + 512, delay + 46, temp);
+	ff_atrac_iqmf(out, out + 512, 512, out, delay + 92, temp);
+}
+
+int BenchmarkAtracDSP() {
+	FFTContext ipqfDct, mdct3Plus, mdct3;
+	ff_atrac3p_init_imdct(&mdct3Plus);
+	ff_mdct_init(&ipqfDct, 5, 1, 32.0 / 32768.0);
+	ff_mdct_init(&mdct3, 9, 1, 1.0 / 32768);
+	ff_atrac_generate_tables();
+
+	std::mt19937 rng(4321);
+	std::uniform_real_distribution<float> dist(-32768.0f, 32768.0f);
+	std::vector<float> spectrum(ATRAC3P_FRAME_SAMPLES), out(ATRAC3P_FRAME_SAMPLES);
+	for (float &f : spectrum)
+		f = dist(rng);
+	Atrac3pIPQFChannelCtx hist{};
+	float delay[46 * 3]{};
+
+	// Stereo frames: 2048 samples for Atrac3+, 1024 for Atrac3, at 44.1 kHz. Single core.
+	double rates[2][2];
+	for (int simd = 0; simd < 2; simd++) {
+		av_force_cpu_flags(simd ? -1 : 0);
+		rates[0][simd] = RunsPerSecond([&] {
+			for (int ch = 0; ch < 2; ch++)
+				SynthesizeAtrac3PlusFrame(&mdct3Plus, &ipqfDct, &hist, spectrum.data(), out.data());
+		}) * ATRAC3P_FRAME_SAMPLES / 44100.0;
+		rates[1][simd] = RunsPerSecond([&] {
+			for (int ch = 0; ch < 2; ch++)
+				SynthesizeAtrac3Frame(&mdct3, delay, spectrum.data(), out.data());
+		}) * 1024 / 44100.0;
+	}
+	av_force_cpu_flags(-1);
+
+	printf("Atrac3+ stereo synthesis, x realtime: C %0.0f, SIMD %0.0f\n", rates[0][0], rates[0][1]);
+	printf("Atrac3 stereo synthesis, x realtime: C %0.0f, SIMD %0.0f\n", rates[1][0], rates[1][1]);
+
+	ff_mdct_end(&ipqfDct);
+	ff_mdct_end(&mdct3Plus);
+	ff_mdct_end(&mdct3);
+	return 0;
+}
+
+static void IgnoreEvent(u64 userdata, int cyclesLate) {
+}
+
+int BenchmarkCoreTiming() {
+	currentMIPS = &mipsr4k;
+	CoreTiming::Init();
+	const int typeA = CoreTiming::RegisterEvent("BenchA", &IgnoreEvent);
+	const int typeB = CoreTiming::RegisterEvent("BenchB", &IgnoreEvent);
+
+	// Lots of timers being set and cancelled, like the kernel does for thread waits.
+	// Nothing runs, so none of them fire.
+	std::mt19937 rng(1234);
+	const int pending = 2000;
+	for (int i = 0; i < pending; i++)
+		CoreTiming::ScheduleEvent(1000000 + (rng() % 1000000), typeA, i);
+	const double rate = RunsPerSecond([&] {
+		for (int i = 0; i < 1000; i++) {
+			const u64 userdata = pending + (rng() % 256);
+			CoreTiming::UnscheduleEvent(typeB, userdata);
+			CoreTiming::ScheduleEvent(rng() % 2000000, typeB, userdata);
+		}
+	}) * 1000;
+	printf("Events rescheduled per second with %d pending: %0.0f\n", pending, rate);
+
+	CoreTiming::Shutdown();
+	return 0;
+}
+
+// A remote ISO server on a slow link: a delay before each response and for each new connection,
+// and a rate limit per connection.
+static const size_t HTTP_FILE_SIZE = 32 * 1024 * 1024;
+static const size_t HTTP_READ_SIZE = 1024 * 1024;
+static const int HTTP_LATENCY_MS = 20;
+// 16 KB per millisecond, about 16 MB/s per connection.
+static const size_t HTTP_SEND_CHUNK = 16 * 1024;
+
+static void WriteSlowRangeResponse(net::OutputSink *out, http::RequestHeader::Method method, const std::string &range, const std::vector<u8> &file, bool keepAlive) {
+	const char *version = keepAlive ? "HTTP/1.1" : "HTTP/1.0";
+	const char *connection = keepAlive ? "keep-alive" : "close";
+	sleep_ms(HTTP_LATENCY_MS, "bench-http-latency");
+	if (method == http::RequestHeader::HEAD) {
+		out->Printf("%s 200 OK\r\nConnection: %s\r\nContent-Length: %lld\r\nAccept-Ranges: bytes\r\n\r\n", version, connection, (s64)file.size());
+		out->Flush();
+		return;
+	}
+
+	s64 begin = 0, last = 0;
+	if (sscanf(range.c_str(), "bytes=%lld-%lld", &begin, &last) != 2 || begin > last || last >= (s64)file.size()) {
+		out->Printf("%s 416 Range Not Satisfiable\r\nConnection: %s\r\nContent-Length: 0\r\n\r\n", version, connection);
+		out->Flush();
+		return;
+	}
+
+	out->Printf("%s 206 Partial Content\r\nConnection: %s\r\nContent-Length: %lld\r\nContent-Range: bytes %lld-%lld/%lld\r\n\r\n", version, connection, last - begin + 1, begin, last, (s64)file.size());
+	for (s64 pos = begin; pos <= last; pos += HTTP_SEND_CHUNK) {
+		out->Push((const char *)&file[pos], (size_t)std::min((s64)HTTP_SEND_CHUNK, last + 1 - pos));
+		out->Flush();
+		sleep_ms(1, "bench-http-rate");
+	}
+}
+
+static void SlowRangeHandler(const http::ServerRequest &request, const std::vector<u8> &file, bool keepAlive) {
+	// The handshake of the new connection.
+	sleep_ms(HTTP_LATENCY_MS, "bench-http-connect");
+	std::string range;
+	request.GetHeader("range", &range);
+	WriteSlowRangeResponse(request.Out(), request.Method(), range, file, keepAlive);
+
+	// http::Server closes after one request, so keep answering here until the client hangs up.
+	while (keepAlive) {
+		http::RequestHeader header;
+		header.ParseHeaders(request.In());
+		if (!header.ok) {
+			break;
+		}
+		range.clear();
+		header.GetOther("range", &range);
+		WriteSlowRangeResponse(request.Out(), header.method, range, file, keepAlive);
+	}
+}
+
+static double ReadMBPerSecond(const Path &url, bool freshLoaders) {
+	std::vector<u8> buffer(HTTP_READ_SIZE);
+	std::unique_ptr<HTTPFileLoader> loader;
+	double readTime = 0.0;
+	for (size_t pos = 0; pos < HTTP_FILE_SIZE; pos += HTTP_READ_SIZE) {
+		if (!loader || freshLoaders) {
+			loader.reset(new HTTPFileLoader(url));
+			// Not timed: the HEAD request of the new loader.
+			loader->FileSize();
+		}
+		const double start = time_now_d();
+		if (loader->ReadAt(pos, HTTP_READ_SIZE, buffer.data()) != HTTP_READ_SIZE) {
+			return 0.0;
+		}
+		readTime += time_now_d() - start;
+	}
+	return HTTP_FILE_SIZE / (1024.0 * 1024.0) / readTime;
+}
+
+int BenchmarkHTTPFileLoader() {
+	net::Init();
+
+	std::vector<u8> file(HTTP_FILE_SIZE);
+	for (size_t i = 0; i < file.size(); ++i) {
+		file[i] = (u8)(i * 7 + (i >> 12));
+	}
+
+	// A new loader hasn't measured the link yet, so it reads each range with one request. One that's
+	// kept around splits reads into parallel ranges when that pays off for the latency it measured,
+	// which includes the handshakes when the server closes every connection.
+	double rates[3]{};
+	for (int mode = 0; mode < 3; mode++) {
+		const bool keepAlive = mode != 1;
+		http::Server server(new NewThreadExecutor());
+		server.SetFallbackHandler([&](const http::ServerRequest &request) {
+			SlowRangeHandler(request, file, keepAlive);
+		});
+		if (!server.Listen(0, "bench")) {
+			fprintf(stderr, "Unable to listen on localhost\n");
+			return 1;
+		}
+		std::atomic<bool> stop{};
+		std::thread serverThread([&] {
+			while (!stop) {
+				server.RunSlice(0.1);
+			}
+		});
+
+		rates[mode] = ReadMBPerSecond(Path(StringFromFormat("http://127.0.0.1:%d/file.bin", server.Port())), mode == 0);
+
+		stop = true;
+		serverThread.join();
+		server.Stop();
+	}
+
+	printf("HTTP reads of %d KB with %d ms latency, MB/s: single requests %0.1f, connection close %0.1f, keep-alive %0.1f\n",
+		(int)(HTTP_READ_SIZE / 1024), HTTP_LATENCY_MS, rates[0], rates[1], rates[2]);
+	return 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Timings of single components, which are too machine dependent for the unit tests (those check
+// that the results are right.) Each prints its results and returns a process exit code.
+
+// Realtime multiples of Atrac3 and Atrac3+ synthesis, with the SIMD paths and the C code.
+int BenchmarkAtracDSP();
+
+// Unscheduling and scheduling events with many others pending, like thread waits with timeouts.
+int BenchmarkCoreTiming();
+
+// HTTPFileLoader reads from a local server with added latency: single and parallel range requests,
+// and new or kept-alive connections.
+int BenchmarkHTTPFileLoader();
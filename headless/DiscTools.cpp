@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "Core/FileSystems/BlockDevices.h"
+#include "Core/FileSystems/FileSystem.h"
+#include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/Loaders.h"
+#include "headless/DiscTools.h"
+
+// Roughly what games do when streaming.
+static const int BENCH_SEQUENTIAL_BLOCKS = 32;
+static const int BENCH_RANDOM_READS = 4096;
+// How long to time each kind of path lookup.
+static const double BENCH_LOOKUP_SECONDS = 0.1;
+
+int ConvertDiscImage(const Path &input, const Path &output, const PSZOptions &options) {
+	std::unique_ptr<FileLoader> loader(ConstructFileLoader(input));
+	std::string error;
+	std::unique_ptr<BlockDevice> device(ConstructBlockDevice(loader.get(), &error));
+	if (!device) {
+		fprintf(stderr, "Unable to open %s: %s\n", input.c_str(), error.c_str());
+		return 1;
+	}
+
+	const Path outFile = output.empty() ? input.WithReplacedExtension(".psz") : output;
+	if (outFile == input) {
+		fprintf(stderr, "Output would overwrite the input\n");
+		return 1;
+	}
+
+	double start = time_now_d();
+	int lastPercent = -1;
+	bool success = ConvertToPSZ(device.get(), outFile, options, &error, [&](float progress) {
+		int percent = (int)(progress * 100.0f);
+		if (percent / 10 != lastPercent / 10) {
+			printf("%d%%\n", percent);
+			lastPercent = percent;
+		}
+	});
+	if (!success) {
+		fprintf(stderr, "Failed to convert %s: %s\n", input.c_str(), error.c_str());
+		return 1;
+	}
+
+	const u64 inSize = File::GetFileSize(input);
+	const u64 outSize = File::GetFileSize(outFile);
+	printf("Wrote %s in %0.2f seconds: %lld bytes (%0.1f%% of the uncompressed image, %0.1f%% of the input)\n", outFile.c_str(), time_now_d() - start,
+		(long long)outSize, 100.0 * outSize / std::max(device->GetUncompressedSize(), (u64)1), 100.0 * outSize / std::max(inSize, (u64)1));
+	return 0;
+}
+
+static bool ReadISOFile(IFileSystem *fs, const char *filename, u64 *bytes) {
+	PSPFileInfo info = fs->GetFileInfo(filename);
+	if (!info.exists) {
+		return false;
+	}
+	int handle = fs->OpenFile(filename, FILEACCESS_READ);
+	if (handle < 0) {
+		return false;
+	}
+	std::vector<u8> data((size_t)info.size);
+	*bytes += fs->ReadFile(handle, data.data(), info.size);
+	fs->CloseFile(handle);
+	return true;
+}
+
+static void ListISOFiles(IFileSystem *fs, const std::string &dir, std::vector<PSPFileInfo> *files, std::vector<std::string> *paths) {
+	for (const PSPFileInfo &info : fs->GetDirListing(dir)) {
+		const std::string path = dir + "/" + info.name;
+		if (info.type == FILETYPE_DIRECTORY) {
+			ListISOFiles(fs, path, files, paths);
+		} else {
+			files->push_back(info);
+			paths->push_back(path);
+		}
+	}
+}
+
+static double LookupsPerSecond(IFileSystem *fs, const std::vector<std::string> &paths) {
+	int total = 0;
+	const double start = time_now_d();
+	do {
+		for (const std::string &path : paths) {
+			fs->GetFileInfo(path);
+		}
+		total += (int)paths.size();
+	} while (time_now_d() - start < BENCH_LOOKUP_SECONDS);
+	return total / (time_now_d() - start);
+}
+
+static int BenchmarkDiscImage(const Path &file) {
+	std::string error;
+
+	// "Load": what booting needs, open the image, parse the filesystem, read the metadata and executable.
+	double start = time_now_d();
+	std::unique_ptr<FileLoader> loader(ConstructFileLoader(file));
+	BlockDevice *device = ConstructBlockDevice(loader.get(), &error);
+	if (!device) {
+		fprintf(stderr, "Unable to open %s: %s\n", file.c_str(), error.c_str());
+		return 1;
+	}
+	const u32 numBlocks = device->GetNumBlocks();
+	u64 loadBytes = 0;
+	{
+		SequentialHandleAllocator handles;
+		ISOFileSystem umd(&handles, device);
+		ReadISOFile(&umd, "/PSP_GAME/PARAM.SFO", &loadBytes);
+		if (!ReadISOFile(&umd, "/PSP_GAME/SYSDIR/EBOOT.BIN", &loadBytes)) {
+			ReadISOFile(&umd, "/PSP_GAME/SYSDIR/BOOT.BIN", &loadBytes);
+		}
+		// ISOFileSystem owns the device.
+	}
+	const double loadTime = time_now_d() - start;
+
+	// Sequential, in a new device so nothing is cached.
+	device = ConstructBlockDevice(loader.get(), &error);
+	if (!device) {
+		fprintf(stderr, "Unable to reopen %s: %s\n", file.c_str(), error.c_str());
+		return 1;
+	}
+	std::vector<u8> buffer(BENCH_SEQUENTIAL_BLOCKS * device->GetBlockSize());
+	start = time_now_d();
+	for (u32 block = 0; block < numBlocks; block += BENCH_SEQUENTIAL_BLOCKS) {
+		const int count = (int)std::min((u32)BENCH_SEQUENTIAL_BLOCKS, numBlocks - block);
+		device->ReadBlocks(block, count, buffer.data());
+	}
+	const double sequentialTime = time_now_d() - start;
+
+	// Random single blocks, like seeking around in a big archive file.
+	u32 seed = 0x12345678;
+	start = time_now_d();
+	for (int i = 0; i < BENCH_RANDOM_READS && numBlocks > 0; ++i) {
+		seed = seed * 1664525 + 1013904223;
+		device->ReadBlock((seed >> 8) % numBlocks, buffer.data());
+	}
+	const double randomTime = time_now_d() - start;
+
+	// Path lookups, like games opening their files: every file in the image, in lowercase too,
+	// with an extension that doesn't exist, and as sce_lbn paths to its sectors.
+	std::vector<PSPFileInfo> files;
+	std::vector<std::string> paths, lowerPaths, missingPaths, lbnPaths;
+	double lookupRates[4]{};
+	{
+		SequentialHandleAllocator handles;
+		ISOFileSystem umd(&handles, device);
+		ListISOFiles(&umd, "", &files, &paths);
+		for (size_t i = 0; i < files.size(); i++) {
+			lowerPaths.push_back(paths[i]);
+			for (char &c : lowerPaths.back())
+				c = tolower(c);
+			missingPaths.push_back(paths[i] + ".TXT");
+			lbnPaths.push_back(StringFromFormat("/sce_lbn0x%x_size0x%x", files[i].startSector, (u32)files[i].size));
+		}
+		if (!files.empty()) {
+			lookupRates[0] = LookupsPerSecond(&umd, paths);
+			lookupRates[1] = LookupsPerSecond(&umd, lowerPaths);
+			lookupRates[2] = LookupsPerSecond(&umd, missingPaths);
+			lookupRates[3] = LookupsPerSecond(&umd, lbnPaths);
+		}
+		// ISOFileSystem owns the device.
+	}
+
+	const double mb = (double)numBlocks * 2048.0 / (1024.0 * 1024.0);
+	printf("%s\n", file.c_str());
+	printf("  size: %lld bytes (%0.1f%%)\n", (long long)loader->FileSize(), 100.0 * loader->FileSize() / std::max((double)numBlocks * 2048.0, 1.0));
+	printf("  load: %0.2f ms (%lld bytes)\n", loadTime * 1000.0, (long long)loadBytes);
+	printf("  sequential: %0.2f s, %0.1f MB/s\n", sequentialTime, mb / std::max(sequentialTime, 0.000001));
+	printf("  random: %d reads in %0.2f s, %0.0f reads/s\n", BENCH_RANDOM_READS, randomTime, BENCH_RANDOM_READS / std::max(randomTime, 0.000001));
+	printf("  lookups (%d files), per second: hit %0.0f, hit lowercase %0.0f, missing %0.0f, lbn %0.0f\n", (int)files.size(),
+		lookupRates[0], lookupRates[1], lookupRates[2], lookupRates[3]);
+	return 0;
+}
+
+int BenchmarkDiscImages(const std::vector<Path> &files) {
+	int result = 0;
+	for (const Path &file : files) {
+		result |= BenchmarkDiscImage(file);
+	}
+	return result;
+}
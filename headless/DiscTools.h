@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/File/Path.h"
+#include "Core/Util/DiscConverter.h"
+
+// Converts a disc image (ISO, CSO, CHD, ...) to .psz. An empty output path writes it next to
+// the input. Returns a process exit code.
+int ConvertDiscImage(const Path &input, const Path &output, const PSZOptions &options);
+
+// Times opening and reading each disc image, to compare formats (like a .cso and a .psz of the
+// same game.) Returns a process exit code.
+int BenchmarkDiscImages(const std::vector<Path> &files);
@@ -42,13 +42,18 @@
 #include "Core/System.h"
 #include "Core/WebServer.h"
 #include "Core/HLE/sceUtility.h"
+#include "Core/HW/Display.h"
 #include "Core/SaveState.h"
+#include "GPU/GPU.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "Common/Log.h"
 #include "Common/Log/LogManager.h"
 
 #include "Compare.h"
 #include "HeadlessHost.h"
+#include "DiscTools.h"
+#include "Benchmarks.h"
+#include "ShaderPrecompile.h"
 #if defined(_WIN32)
 #include "WindowsHeadlessHost.h"
 #elif defined(SDL)
@@ -150,6 +155,21 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
 	fprintf(stderr, "  --bench               run multiple times and output speed\n");
+	fprintf(stderr, "  --turbo               don't draw or output audio, just run as fast as possible\n");
+	fprintf(stderr, "                        and report the emulated frames per second (not with --screenshot)\n");
+	fprintf(stderr, "  --precompile-shaders=FILE\n");
+	fprintf(stderr, "                        compile all shaders in a shader cache file and exit\n");
+	fprintf(stderr, "  --precompile-output=FILE\n");
+	fprintf(stderr, "                        where to write the SPIR-V (default: next to the cache)\n");
+	fprintf(stderr, "  --convert-disc=FILE   convert an ISO/CSO/CHD to a seekable zstd image (.psz) and exit\n");
+	fprintf(stderr, "  --convert-output=FILE where to write the .psz (default: next to the input)\n");
+	fprintf(stderr, "  --psz-frame-size=N    uncompressed bytes per frame, multiple of 2048 (default 32768)\n");
+	fprintf(stderr, "  --psz-level=N         zstd compression level (default 12)\n");
+	fprintf(stderr, "  --psz-dict            train a dictionary on the image\n");
+	fprintf(stderr, "  --bench-disc=FILE     time loading and reading a disc image, can be repeated\n");
+	fprintf(stderr, "  --bench-atrac         time Atrac3/3+ synthesis, C and SIMD, and exit\n");
+	fprintf(stderr, "  --bench-coretiming    time rescheduling events with many pending, and exit\n");
+	fprintf(stderr, "  --bench-http          time remote ISO reads over a slow local server, and exit\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -175,6 +195,7 @@ struct AutoTestOptions {
 	bool compare : 1;
 	bool verbose : 1;
 	bool bench : 1;
+	bool turbo : 1;
 };
 
 bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt) {
@@ -196,7 +217,8 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 
 	TeamCityPrint("testStarted name='%s' captureStandardOutput='true'", currentTestName.c_str());
 
-	if (opt.compare)
+	// Nothing is drawn in turbo mode, so only the text output can be compared.
+	if (opt.compare && !opt.turbo)
 		headlessHost->SetComparisonScreenshot(ExpectedScreenshotFromFilename(coreParameter.fileToStart), opt.maxScreenshotError);
 
 	std::string error_string;
@@ -224,7 +246,8 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 	}
 
 	bool passed = true;
-	double deadline = time_now_d() + opt.timeout;
+	const double startTime = time_now_d();
+	double deadline = startTime + opt.timeout;
 	coreState = coreParameter.startBreak ? CORE_STEPPING_CPU : CORE_RUNNING_CPU;
 	while (coreState == CORE_RUNNING_CPU || coreState == CORE_STEPPING_CPU)
 	{
@@ -262,6 +285,14 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 		gpu->EndHostFrame();
 	}
 
+	if (opt.turbo) {
+		const double elapsed = time_now_d() - startTime;
+		const int vblanks = __DisplayGetNumVblanks();
+		// Nothing is presented, so count the frames the game finished instead.
+		const int flips = gpuStats.numFlips;
+		printf("  %s - %d vblanks, %d flips in %0.2f seconds: %0.1f emulated vblanks/s, %0.1f emulated frames/s\n", currentTestName.c_str(), vblanks, flips, elapsed, vblanks / elapsed, flips / elapsed);
+	}
+
 	if (draw) {
 		draw->BindFramebufferAsRenderTarget(nullptr, { Draw::RPAction::CLEAR, Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE }, "Headless");
 		// Vulkan may get angry if we don't do a final present.
@@ -368,6 +399,15 @@ int main(int argc, const char* argv[])
 	const char *mountIso = nullptr;
 	const char *mountRoot = nullptr;
 	const char *screenshotFilename = nullptr;
+	const char *precompileShaders = nullptr;
+	const char *precompileOutput = nullptr;
+	const char *convertDisc = nullptr;
+	const char *convertOutput = nullptr;
+	PSZOptions pszOptions;
+	std::vector<Path> benchDiscs;
+	bool benchAtrac = false;
+	bool benchCoreTiming = false;
+	bool benchHTTP = false;
 
 	for (int i = 1; i < argc; i++)
 	{
@@ -399,6 +439,8 @@ int main(int argc, const char* argv[])
 			testOptions.compare = true;
 		else if (!strcmp(argv[i], "--bench"))
 			testOptions.bench = true;
+		else if (!strcmp(argv[i], "--turbo"))
+			testOptions.turbo = true;
 		else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
 			testOptions.verbose = true;
 		else if (!strcmp(argv[i], "--old-atrac"))
@@ -437,6 +479,28 @@ int main(int argc, const char* argv[])
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
 			stateToLoad = argv[i] + strlen("--state=");
+		else if (!strncmp(argv[i], "--precompile-shaders=", strlen("--precompile-shaders=")) && strlen(argv[i]) > strlen("--precompile-shaders="))
+			precompileShaders = argv[i] + strlen("--precompile-shaders=");
+		else if (!strncmp(argv[i], "--precompile-output=", strlen("--precompile-output=")) && strlen(argv[i]) > strlen("--precompile-output="))
+			precompileOutput = argv[i] + strlen("--precompile-output=");
+		else if (!strncmp(argv[i], "--convert-disc=", strlen("--convert-disc=")) && strlen(argv[i]) > strlen("--convert-disc="))
+			convertDisc = argv[i] + strlen("--convert-disc=");
+		else if (!strncmp(argv[i], "--convert-output=", strlen("--convert-output=")) && strlen(argv[i]) > strlen("--convert-output="))
+			convertOutput = argv[i] + strlen("--convert-output=");
+		else if (!strncmp(argv[i], "--psz-frame-size=", strlen("--psz-frame-size=")) && strlen(argv[i]) > strlen("--psz-frame-size="))
+			pszOptions.frameSize = (u32)atoi(argv[i] + strlen("--psz-frame-size="));
+		else if (!strncmp(argv[i], "--psz-level=", strlen("--psz-level=")) && strlen(argv[i]) > strlen("--psz-level="))
+			pszOptions.level = atoi(argv[i] + strlen("--psz-level="));
+		else if (!strcmp(argv[i], "--psz-dict"))
+			pszOptions.dictionary = true;
+		else if (!strncmp(argv[i], "--bench-disc=", strlen("--bench-disc=")) && strlen(argv[i]) > strlen("--bench-disc="))
+			benchDiscs.push_back(Path(std::string(argv[i] + strlen("--bench-disc="))));
+		else if (!strcmp(argv[i], "--bench-atrac"))
+			benchAtrac = true;
+		else if (!strcmp(argv[i], "--bench-coretiming"))
+			benchCoreTiming = true;
+		else if (!strcmp(argv[i], "--bench-http"))
+			benchHTTP = true;
 		else if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
 			return printUsage(argv[0], NULL);
 		else if (!strcmp(argv[i], "--ignore")) {
@@ -448,6 +512,9 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	if (testOptions.turbo && screenshotFilename)
+		return printUsage(argv[0], "--turbo doesn't draw, so there's nothing to compare with --screenshot");
+
 	if (testFilenames.size() == 1 && testFilenames[0][0] == '@')
 		testFilenames = ReadFromListFile(testFilenames[0].substr(1));
 
@@ -461,6 +528,38 @@ int main(int argc, const char* argv[])
 		testFilenames.end()
 	);
 
+	if (benchAtrac || benchCoreTiming || benchHTTP) {
+		int result = 0;
+		if (benchAtrac)
+			result |= BenchmarkAtracDSP();
+		if (benchCoreTiming)
+			result |= BenchmarkCoreTiming();
+		if (benchHTTP)
+			result |= BenchmarkHTTPFileLoader();
+		return result;
+	}
+
+	if (convertDisc || !benchDiscs.empty()) {
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+		// Config isn't loaded here, match the default so CSO is measured the way it normally runs.
+		g_Config.bParallelCSODecompression = true;
+		int result = 0;
+		if (convertDisc)
+			result = ConvertDiscImage(Path(std::string(convertDisc)), convertOutput ? Path(std::string(convertOutput)) : Path(), pszOptions);
+		if (result == 0 && !benchDiscs.empty())
+			result = BenchmarkDiscImages(benchDiscs);
+		g_threadManager.Teardown();
+		return result;
+	}
+
+	if (precompileShaders) {
+		// Doesn't need a GPU or the emulator at all, just the shader generators and glslang.
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+		int result = PrecompileShaderCache(Path(std::string(precompileShaders)), precompileOutput ? Path(std::string(precompileOutput)) : Path());
+		g_threadManager.Teardown();
+		return result;
+	}
+
 	if (testFilenames.empty())
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
 
@@ -502,6 +601,7 @@ int main(int argc, const char* argv[])
 	coreParameter.pixelWidth = 480;
 	coreParameter.pixelHeight = 272;
 	coreParameter.fastForward = true;
+	coreParameter.turbo = testOptions.turbo;
 
 	g_Config.iDumpFileTypes = 0;
 	g_Config.bEnableSound = false;
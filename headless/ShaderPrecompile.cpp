@@ -0,0 +1,135 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Common/File/FileUtil.h"
+#include "Common/GPU/Shader.h"
+#include "Common/GPU/thin3d.h"
+#include "Common/GPU/Vulkan/VulkanContext.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
+#include "GPU/GPUState.h"
+#include "GPU/Common/FragmentShaderGenerator.h"
+#include "GPU/Common/GeometryShaderGenerator.h"
+#include "GPU/Common/ShaderId.h"
+#include "GPU/Common/VertexShaderGenerator.h"
+#include "GPU/GLES/ShaderManagerGLES.h"
+#include "GPU/Vulkan/ShaderManagerVulkan.h"
+#include "GPU/Vulkan/SpirvBundleVulkan.h"
+#include "headless/ShaderPrecompile.h"
+
+static constexpr size_t CODE_BUFFER_SIZE = 32768;
+
+struct PrecompileJob {
+	VkShaderStageFlagBits stage;
+	std::string desc;
+	std::string code;
+	std::vector<uint32_t> spirv;
+	std::string error;
+	bool success = false;
+};
+
+int PrecompileShaderCache(const Path &cacheFile, const Path &outFile) {
+	uint32_t useFlags = 0;
+	std::vector<VShaderID> vsIDs;
+	std::vector<FShaderID> fsIDs;
+	std::vector<GShaderID> gsIDs;
+
+	bool vulkan = false;
+	FILE *f = File::OpenCFile(cacheFile, "rb");
+	if (!f) {
+		fprintf(stderr, "Unable to open shader cache %s\n", cacheFile.c_str());
+		return 1;
+	}
+	vulkan = ShaderManagerVulkan::ReadCacheIDs(f, &useFlags, &vsIDs, &fsIDs, &gsIDs);
+	fclose(f);
+	if (!vulkan) {
+		File::IOFile file(cacheFile, "rb");
+		if (!ShaderManagerGLES::ReadCacheIDs(file, &useFlags, &vsIDs, &fsIDs)) {
+			fprintf(stderr, "%s is not a Vulkan or GL shader cache of the current version\n", cacheFile.c_str());
+			return 1;
+		}
+		gsIDs.clear();
+	}
+
+	// The generators look at the use flags, so match the run that recorded the cache.
+	// We don't know the device's bugs, so assume none - the runtime lookup is by source, so any
+	// shader that comes out different on the actual device just gets compiled as usual.
+	gstate_c.SetUseFlags(useFlags);
+	ShaderLanguageDesc compat(vulkan ? GLSL_VULKAN : GLSL_3xx);
+	Draw::Bugs bugs;
+	const GLSLVariant variant = vulkan ? GLSLVariant::VULKAN : GLSLVariant::GLES300;
+
+	std::vector<PrecompileJob> jobs;
+	char *codeBuffer = new char[CODE_BUFFER_SIZE];
+	int genFailed = 0;
+	for (const VShaderID &id : vsIDs) {
+		std::string genError;
+		uint32_t attributeMask = 0;
+		uint64_t uniformMask = 0;
+		VertexShaderFlags flags;
+		if (!GenerateVertexShader(id, codeBuffer, compat, bugs, &attributeMask, &uniformMask, &flags, &genError)) {
+			fprintf(stderr, "Failed to generate vertex shader %s: %s\n", VertexShaderDesc(id).c_str(), genError.c_str());
+			genFailed++;
+			continue;
+		}
+		jobs.push_back(PrecompileJob{ VK_SHADER_STAGE_VERTEX_BIT, VertexShaderDesc(id), codeBuffer });
+	}
+	for (const FShaderID &id : fsIDs) {
+		std::string genError;
+		uint64_t uniformMask = 0;
+		FragmentShaderFlags flags;
+		if (!GenerateFragmentShader(id, codeBuffer, compat, bugs, &uniformMask, &flags, &genError)) {
+			fprintf(stderr, "Failed to generate fragment shader %s: %s\n", FragmentShaderDesc(id).c_str(), genError.c_str());
+			genFailed++;
+			continue;
+		}
+		jobs.push_back(PrecompileJob{ VK_SHADER_STAGE_FRAGMENT_BIT, FragmentShaderDesc(id), codeBuffer });
+	}
+	for (const GShaderID &id : gsIDs) {
+		std::string genError;
+		if (!GenerateGeometryShader(id, codeBuffer, compat, bugs, &genError)) {
+			fprintf(stderr, "Failed to generate geometry shader %s: %s\n", GeometryShaderDesc(id).c_str(), genError.c_str());
+			genFailed++;
+			continue;
+		}
+		jobs.push_back(PrecompileJob{ VK_SHADER_STAGE_GEOMETRY_BIT, GeometryShaderDesc(id), codeBuffer });
+	}
+	delete[] codeBuffer;
+
+	// Generation is cheap, glslang is what takes time.
+	init_glslang();
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (int i = lower; i < upper; i++) {
+			PrecompileJob &job = jobs[i];
+			job.success = GLSLtoSPV(job.stage, job.code.c_str(), variant, job.spirv, &job.error);
+		}
+	}, 0, (int)jobs.size(), 1);
+	finalize_glslang();
+
+	int compileFailed = 0;
+	SpirvShaderBundle bundle;
+	for (PrecompileJob &job : jobs) {
+		if (!job.success) {
+			fprintf(stderr, "Failed to compile %s:\n%s\n%s\n", job.desc.c_str(), job.error.c_str(), LineNumberString(job.code).c_str());
+			compileFailed++;
+		} else if (vulkan) {
+			bundle.Add(job.code.c_str(), std::move(job.spirv));
+		}
+	}
+
+	printf("%s: %d vertex, %d fragment, %d geometry shaders. %d failed to generate, %d failed to compile.\n", cacheFile.c_str(),
+		(int)vsIDs.size(), (int)fsIDs.size(), (int)gsIDs.size(), genFailed, compileFailed);
+
+	if (vulkan) {
+		const Path bundleFile = outFile.empty() ? cacheFile.WithReplacedExtension(".vkshadercache", ".vkspirv") : outFile;
+		if (bundleFile == cacheFile || !bundle.Save(bundleFile)) {
+			fprintf(stderr, "Failed to write %s\n", bundleFile.c_str());
+			return 1;
+		}
+		printf("Wrote %d precompiled shaders to %s\n", (int)bundle.size(), bundleFile.c_str());
+	}
+
+	return genFailed + compileFailed == 0 ? 0 : 1;
+}
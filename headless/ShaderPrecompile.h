@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Common/File/Path.h"
+
+// Generates every shader recorded in a shader cache file (.vkshadercache or .glshadercache)
+// and compiles it with glslang, without needing a GPU.
+// For Vulkan caches, the SPIR-V is written to outFile (default: next to the cache, as .vkspirv)
+// which the Vulkan backend picks up from the cache directory. GL caches are only validated.
+// Returns a process exit code, non-zero if anything failed to generate or compile.
+int PrecompileShaderCache(const Path &cacheFile, const Path &outFile);
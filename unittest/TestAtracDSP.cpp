@@ -0,0 +1,163 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "ppsspp_config.h"
+#include "Common/CommonTypes.h"
+#include "ext/at3_standalone/atrac.h"
+#include "ext/at3_standalone/atrac3plus.h"
+#include "ext/at3_standalone/compat.h"
+#include "ext/at3_standalone/fft.h"
+
+#include "UnitTest.h"
+
+// The SIMD paths of the Atrac3/3+ decoder against the C code, which av_force_cpu_flags(0) switches to.
+static bool SameOutput(const float *simd, const float *ref, size_t count, const char *what) {
+#if PPSSPP_ARCH(SSE2)
+	// Nothing fuses multiply-adds on x86, so the results have to be exactly the same.
+	if (memcmp(simd, ref, count * sizeof(float)) == 0)
+		return true;
+#else
+	// The compiler may use fused multiply-adds in the C code here, so just check for rounding differences.
+	float peak = 0.0f, diff = 0.0f;
+	for (size_t i = 0; i < count; i++) {
+		peak = std::max(peak, fabsf(ref[i]));
+		diff = std::max(diff, fabsf(simd[i] - ref[i]));
+	}
+	if (diff <= peak * 1e-5f)
+		return true;
+#endif
+	for (size_t i = 0; i < count; i++) {
+		if (memcmp(&simd[i], &ref[i], sizeof(float)) != 0) {
+			printf("%s mismatch at %d: %0.9g != %0.9g\n", what, (int)i, simd[i], ref[i]);
+			break;
+		}
+	}
+	return false;
+}
+
+static bool CheckIMDCT(FFTContext *mdct, std::mt19937 &rng, float range) {
+	const int n = 1 << mdct->mdct_bits;
+	std::uniform_real_distribution<float> dist(-range, range);
+
+	// Up to the 512 point IMDCT of Atrac3.
+	alignas(16) static float in4[256 * 4], out4[512 * 4];
+	std::vector<float> in(n / 2), out(n);
+	for (int i = 0; i < n / 2 * 4; i++)
+		in4[i] = dist(rng);
+	// Silence and a single impulse in two of the lanes.
+	for (int i = 0; i < n / 2; i++) {
+		in4[i * 4 + 1] = 0.0f;
+		in4[i * 4 + 2] = i == 3 ? range : 0.0f;
+	}
+
+	for (int half = 0; half < 2; half++) {
+		if (half)
+			imdct_half_x4(mdct, out4, in4);
+		else
+			imdct_calc_x4(mdct, out4, in4);
+		const int count = half ? n / 2 : n;
+		for (int l = 0; l < 4; l++) {
+			for (int i = 0; i < n / 2; i++)
+				in[i] = in4[i * 4 + l];
+			if (half)
+				imdct_half(mdct, out.data(), in.data());
+			else
+				imdct_calc(mdct, out.data(), in.data());
+			std::vector<float> lane(count);
+			for (int i = 0; i < count; i++)
+				lane[i] = out4[i * 4 + l];
+			if (!SameOutput(lane.data(), out.data(), count, half ? "imdct_half_x4" : "imdct_calc_x4"))
+				return false;
+		}
+	}
+	return true;
+}
+
+// The synthesis part of an Atrac3+ frame: IMDCT and windowing of all subbands, then the PQF.
+static void SynthesizeAtrac3PlusFrame(FFTContext *mdct, FFTContext *ipqfDct, Atrac3pIPQFChannelCtx *hist, float *spectrum, float *out) {
+	static float mdctBuf[ATRAC3P_FRAME_SAMPLES + ATRAC3P_SUBBAND_SAMPLES];
+	static float mdctBuf4[4][ATRAC3P_MDCT_SIZE];
+	static float timeBuf[ATRAC3P_FRAME_SAMPLES];
+	const int windIds[4] = { 0, 1, 2, 3 };
+	const bool simd = av_simd_enabled();
+	for (int sb = 0; sb < ATRAC3P_SUBBANDS; sb++) {
+		if (simd) {
+			if ((sb & 3) == 0)
+				ff_atrac3p_imdct_x4(mdct, spectrum + sb * ATRAC3P_SUBBAND_SAMPLES, mdctBuf4, windIds, sb);
+			memcpy(timeBuf + sb * ATRAC3P_SUBBAND_SAMPLES, mdctBuf4[sb & 3], ATRAC3P_SUBBAND_SAMPLES * sizeof(float));
+		} else {
+			ff_atrac3p_imdct(mdct, spectrum + sb * ATRAC3P_SUBBAND_SAMPLES, mdctBuf + sb * ATRAC3P_SUBBAND_SAMPLES, windIds[sb & 3], sb);
+			memcpy(timeBuf + sb * ATRAC3P_SUBBAND_SAMPLES, mdctBuf + sb * ATRAC3P_SUBBAND_SAMPLES, ATRAC3P_SUBBAND_SAMPLES * sizeof(float));
+		}
+	}
+	ff_atrac3p_ipqf(ipqfDct, hist, timeBuf, out);
+}
+
+// The same for Atrac3: IMDCT of the four bands, then the three QMF stages.
+static void SynthesizeAtrac3Frame(FFTContext *mdct, float *delay, float *spectrum, float *out) {
+	alignas(16) static float in4[256 * 4], out4[512 * 4];
+	static float imdctBuf[512];
+	static float temp[1070];
+	// Like the decoder, all four bands at once with SIMD (windowing left out.)
+	if (av_simd_enabled()) {
+		for (int i = 0; i < 256 * 4; i++)
+			in4[i] = spectrum[(i & 3) * 256 + i / 4];
+		imdct_calc_x4(mdct, out4, in4);
+	}
+	for (int band = 0; band < 4; band++) {
+		if (av_simd_enabled()) {
+			for (int i = 0; i < 256; i++)
+				out[band * 256 + i] = out4[i * 4 + band];
+		} else {
+			imdct_calc(mdct, imdctBuf, spectrum + band * 256);
+			memcpy(out + band * 256, imdctBuf, 256 * sizeof(float));
+		}
+	}
+	ff_atrac_iqmf(out, out + 256, 256, out, delay, temp);
+	ff_atrac_iqmf(out + 768, out + 512, 256, out + 512, delay + 46, temp);
+	ff_atrac_iqmf(out, out + 512, 512, out, delay + 92, temp);
+}
+
+bool TestAtracDSP() {
+	std::mt19937 rng(4321);
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+	FFTContext ipqfDct, mdct3Plus, mdct3;
+	ff_atrac3p_init_imdct(&mdct3Plus);
+	ff_mdct_init(&ipqfDct, 5, 1, 32.0 / 32768.0);
+	ff_mdct_init(&mdct3, 9, 1, 1.0 / 32768);
+	ff_atrac_generate_tables();
+
+	bool success = CheckIMDCT(&ipqfDct, rng, 32768.0f) && CheckIMDCT(&mdct3Plus, rng, 32768.0f) && CheckIMDCT(&mdct3, rng, 32768.0f);
+
+	// Whole frames, several in a row so the filter histories matter too.
+	std::vector<float> spectrum(ATRAC3P_FRAME_SAMPLES), spectrumRef(ATRAC3P_FRAME_SAMPLES);
+	std::vector<float> out(ATRAC3P_FRAME_SAMPLES), outRef(ATRAC3P_FRAME_SAMPLES);
+	Atrac3pIPQFChannelCtx hist{}, histRef{};
+	float delay[46 * 3]{}, delayRef[46 * 3]{};
+	for (int frame = 0; frame < 8 && success; frame++) {
+		for (size_t i = 0; i < spectrum.size(); i++)
+			spectrum[i] = spectrumRef[i] = dist(rng) * 8192.0f;
+
+		av_force_cpu_flags(0);
+		SynthesizeAtrac3PlusFrame(&mdct3Plus, &ipqfDct, &histRef, spectrumRef.data(), outRef.data());
+		av_force_cpu_flags(-1);
+		SynthesizeAtrac3PlusFrame(&mdct3Plus, &ipqfDct, &hist, spectrum.data(), out.data());
+		success = SameOutput(out.data(), outRef.data(), ATRAC3P_FRAME_SAMPLES, "Atrac3+ frame");
+
+		for (size_t i = 0; i < 1024; i++)
+			spectrum[i] = spectrumRef[i] = dist(rng) * 32768.0f;
+		av_force_cpu_flags(0);
+		SynthesizeAtrac3Frame(&mdct3, delayRef, spectrumRef.data(), outRef.data());
+		av_force_cpu_flags(-1);
+		SynthesizeAtrac3Frame(&mdct3, delay, spectrum.data(), out.data());
+		success = success && SameOutput(out.data(), outRef.data(), 1024, "Atrac3 frame");
+	}
+
+	ff_mdct_end(&ipqfDct);
+	ff_mdct_end(&mdct3Plus);
+	ff_mdct_end(&mdct3);
+	return success;
+}
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Serialize/SerializeList.h"
+#include "Core/CoreTiming.h"
+#include "Core/MIPS/MIPS.h"
+
+#include "UnitTest.h"
+
+static std::vector<u64> firedEvents;
+static int rescheduleType = -1;
+
+static void RecordCallback(u64 userdata, int cyclesLate) {
+	firedEvents.push_back(userdata);
+}
+
+// Schedules another event at the same time, which has to run after the ones already there.
+static void RescheduleCallback(u64 userdata, int cyclesLate) {
+	firedEvents.push_back(userdata);
+	if (userdata < 1000000)
+		CoreTiming::ScheduleEvent(-cyclesLate, rescheduleType, userdata + 1000000);
+}
+
+static void RunCycles(int cycles) {
+	while (cycles > 0) {
+		const int step = std::min(cycles, std::max(currentMIPS->downcount, 1));
+		currentMIPS->downcount -= step;
+		cycles -= step;
+		CoreTiming::Advance();
+	}
+}
+
+struct CoreTimingState {
+	void DoState(PointerWrap &p) {
+		CoreTiming::DoState(p);
+	}
+};
+
+static LinkedListItem<CoreTiming::BaseEvent> *NewOldEvent() {
+	return new LinkedListItem<CoreTiming::BaseEvent>();
+}
+
+static void FreeOldEvent(LinkedListItem<CoreTiming::BaseEvent> *ev) {
+	delete ev;
+}
+
+static void OldEvent_DoState(PointerWrap &p, CoreTiming::BaseEvent *ev) {
+	Do(p, ev->time);
+	Do(p, ev->userdata);
+	Do(p, ev->type);
+}
+
+// What CoreTiming::DoState() used to save, when the queue was a linked list.
+struct OldCoreTimingState {
+	int numEventTypes = 0;
+	std::vector<LinkedListItem<CoreTiming::BaseEvent>> events;
+	int cpuHz = 0;
+	int slicelength = 0;
+	s64 globalTimer = 0;
+	s64 idledCycles = 0;
+	s64 lastGlobalTimeTicks = 0;
+	s64 lastGlobalTimeUs = 0;
+
+	void DoState(PointerWrap &p) {
+		auto s = p.Section("CoreTiming", 1, 3);
+		Do(p, numEventTypes);
+		for (size_t i = 0; i < events.size(); i++)
+			events[i].next = i + 1 < events.size() ? &events[i + 1] : nullptr;
+		LinkedListItem<CoreTiming::BaseEvent> *first = events.empty() ? nullptr : &events[0];
+		DoLinkedList<CoreTiming::BaseEvent, NewOldEvent, FreeOldEvent, OldEvent_DoState>(p, first);
+		DoIgnoreUnusedLinkedList(p);
+		Do(p, cpuHz);
+		Do(p, slicelength);
+		Do(p, globalTimer);
+		Do(p, idledCycles);
+		Do(p, lastGlobalTimeTicks);
+		Do(p, lastGlobalTimeUs);
+	}
+};
+
+// The event queue, against a plain list sorted by time and then scheduling order.
+bool TestCoreTiming() {
+	struct RefEvent {
+		s64 time;
+		u64 seq;
+		int type;
+		u64 userdata;
+	};
+
+	currentMIPS = &mipsr4k;
+	CoreTiming::Init();
+	int typeA = CoreTiming::RegisterEvent("TestA", &RecordCallback);
+	int typeB = CoreTiming::RegisterEvent("TestB", &RecordCallback);
+	rescheduleType = CoreTiming::RegisterEvent("TestReschedule", &RescheduleCallback);
+
+	std::mt19937 rng(1234);
+	std::vector<RefEvent> ref;
+	u64 seq = 0;
+	u64 nextUserdata = 0;
+	firedEvents.clear();
+	for (int round = 0; round < 20; round++) {
+		for (int i = 0; i < 200; i++) {
+			const int type = rng() % 3 == 0 ? typeB : typeA;
+			// Few distinct times and userdata values, so there are plenty of ties and duplicates.
+			const s64 cycles = (s64)(rng() % 64) * 1000;
+			const u64 userdata = rng() % 4 == 0 ? rng() % 8 : 100 + nextUserdata++;
+			CoreTiming::ScheduleEvent(cycles, type, userdata);
+			ref.push_back(RefEvent{ (s64)CoreTiming::GetTicks() + cycles, seq++, type, userdata });
+		}
+
+		for (int i = 0; i < 10; i++) {
+			const int type = rng() % 2 == 0 ? typeA : typeB;
+			const u64 userdata = rng() % 8;
+			// All of them go, the time left is the one that would have run last.
+			s64 expected = 0;
+			const RefEvent *last = nullptr;
+			for (const RefEvent &ev : ref) {
+				if (ev.type == type && ev.userdata == userdata && (!last || ev.time > last->time || (ev.time == last->time && ev.seq > last->seq)))
+					last = &ev;
+			}
+			if (last)
+				expected = last->time - (s64)CoreTiming::GetTicks();
+			ref.erase(std::remove_if(ref.begin(), ref.end(), [&](const RefEvent &ev) {
+				return ev.type == type && ev.userdata == userdata;
+			}), ref.end());
+			const s64 cyclesLeft = CoreTiming::UnscheduleEvent(type, userdata);
+			EXPECT_EQ_INT(cyclesLeft, expected);
+		}
+
+		std::stable_sort(ref.begin(), ref.end(), [](const RefEvent &a, const RefEvent &b) {
+			return a.time < b.time;
+		});
+		std::vector<CoreTiming::BaseEvent> scheduled = CoreTiming::GetScheduledEvents();
+		EXPECT_EQ_INT(scheduled.size(), ref.size());
+		for (size_t i = 0; i < ref.size(); i++) {
+			EXPECT_EQ_INT(scheduled[i].time, ref[i].time);
+			EXPECT_EQ_INT(scheduled[i].type, ref[i].type);
+			EXPECT_EQ_INT(scheduled[i].userdata, ref[i].userdata);
+		}
+
+		// Run part of them.
+		const s64 until = (s64)CoreTiming::GetTicks() + (rng() % 40 + 1) * 1000;
+		std::vector<u64> expectedFired;
+		while (!ref.empty() && ref.front().time <= until) {
+			expectedFired.push_back(ref.front().userdata);
+			ref.erase(ref.begin());
+		}
+		firedEvents.clear();
+		RunCycles((int)(until - (s64)CoreTiming::GetTicks()));
+		EXPECT_TRUE(firedEvents == expectedFired);
+	}
+
+	// Save states have the layout of the old linked list, with events at the same time in order.
+	OldCoreTimingState oldCoreTiming;
+	// Event types are numbered in registration order.
+	oldCoreTiming.numEventTypes = rescheduleType + 1;
+	for (const RefEvent &ev : ref) {
+		LinkedListItem<CoreTiming::BaseEvent> item{};
+		item.time = ev.time;
+		item.userdata = ev.userdata;
+		item.type = ev.type;
+		oldCoreTiming.events.push_back(item);
+	}
+	oldCoreTiming.cpuHz = CPU_HZ;
+	oldCoreTiming.slicelength = CoreTiming::slicelength;
+	oldCoreTiming.globalTimer = (s64)CoreTiming::GetTicks() - CoreTiming::slicelength + currentMIPS->downcount;
+	oldCoreTiming.idledCycles = (s64)CoreTiming::GetIdleTicks();
+	std::vector<u8> oldState;
+	EXPECT_TRUE(CChunkFileReader::MeasureAndSavePtr(oldCoreTiming, &oldState) == CChunkFileReader::ERROR_NONE);
+
+	// Like the modules do, every pass through DoState() has to register the events again.
+	CoreTimingState coreTiming;
+	auto restoreEvents = [&]() {
+		CoreTiming::RestoreRegisterEvent(typeA, "TestA", &RecordCallback);
+		CoreTiming::RestoreRegisterEvent(typeB, "TestB", &RecordCallback);
+		CoreTiming::RestoreRegisterEvent(rescheduleType, "TestReschedule", &RescheduleCallback);
+	};
+	std::vector<u8> state;
+	EXPECT_TRUE(CChunkFileReader::MeasureAndSavePtr(coreTiming, &state) == CChunkFileReader::ERROR_NONE);
+	restoreEvents();
+	EXPECT_TRUE(state == oldState);
+
+	// Loading it brings back the same queue, and saving that again gives the same state.
+	CoreTiming::ClearPendingEvents();
+	std::string errorString;
+	EXPECT_TRUE(CChunkFileReader::LoadPtr(oldState.data(), coreTiming, &errorString) == CChunkFileReader::ERROR_NONE);
+	restoreEvents();
+	std::vector<CoreTiming::BaseEvent> loaded = CoreTiming::GetScheduledEvents();
+	EXPECT_EQ_INT(loaded.size(), ref.size());
+	for (size_t i = 0; i < ref.size(); i++) {
+		EXPECT_EQ_INT(loaded[i].time, ref[i].time);
+		EXPECT_EQ_INT(loaded[i].type, ref[i].type);
+		EXPECT_EQ_INT(loaded[i].userdata, ref[i].userdata);
+	}
+	state.clear();
+	EXPECT_TRUE(CChunkFileReader::MeasureAndSavePtr(coreTiming, &state) == CChunkFileReader::ERROR_NONE);
+	restoreEvents();
+	EXPECT_TRUE(state == oldState);
+
+	// And they still run in that order.
+	std::vector<u64> expectedFired;
+	for (const RefEvent &ev : ref) {
+		if (ev.time <= (s64)CoreTiming::GetTicks() + 8000)
+			expectedFired.push_back(ev.userdata);
+	}
+	firedEvents.clear();
+	RunCycles(8000);
+	EXPECT_TRUE(firedEvents == expectedFired);
+
+	EXPECT_TRUE(CoreTiming::IsScheduled(typeB));
+	CoreTiming::RemoveEvent(typeB);
+	EXPECT_TRUE(!CoreTiming::IsScheduled(typeB));
+	EXPECT_TRUE(CoreTiming::IsScheduled(typeA));
+	CoreTiming::ClearPendingEvents();
+	EXPECT_TRUE(!CoreTiming::IsScheduled(typeA));
+
+	// Events scheduled from callbacks for the current time run in the same Advance, after the rest.
+	CoreTiming::ScheduleEvent(1000, rescheduleType, 1);
+	CoreTiming::ScheduleEvent(1000, rescheduleType, 2);
+	firedEvents.clear();
+	RunCycles(1000);
+	const std::vector<u64> expectedRescheduled = { 1, 2, 1000001, 1000002 };
+	EXPECT_TRUE(firedEvents == expectedRescheduled);
+
+	CoreTiming::Shutdown();
+	return true;
+}
@@ -0,0 +1,137 @@
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+#include "Common/Net/HTTPHeaders.h"
+#include "Common/Net/HTTPServer.h"
+#include "Common/Net/Resolve.h"
+#include "Common/Net/Sinks.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "Core/FileLoaders/HTTPFileLoader.h"
+
+#include "UnitTest.h"
+
+// Serves a generated file on localhost, like the remote ISO server does. Either one request per
+// connection like http::Server normally does, or HTTP/1.1 keep-alive, so connections get reused.
+static const size_t FILE_SIZE = 8 * 1024 * 1024;
+// Pauses a little every so often, so that the loader measures a transfer rate and splits reads.
+static const size_t SEND_CHUNK = 256 * 1024;
+
+struct RangeServerStats {
+	std::atomic<int> connections{};
+	std::atomic<int> requests{};
+};
+
+static void WriteRangeResponse(net::OutputSink *out, http::RequestHeader::Method method, const std::string &range, const std::vector<u8> &file, bool keepAlive) {
+	const char *version = keepAlive ? "HTTP/1.1" : "HTTP/1.0";
+	const char *connection = keepAlive ? "keep-alive" : "close";
+	if (method == http::RequestHeader::HEAD) {
+		out->Printf("%s 200 OK\r\nConnection: %s\r\nContent-Length: %lld\r\nAccept-Ranges: bytes\r\n\r\n", version, connection, (s64)file.size());
+		out->Flush();
+		return;
+	}
+
+	s64 begin = 0, last = 0;
+	if (sscanf(range.c_str(), "bytes=%lld-%lld", &begin, &last) != 2 || begin > last || last >= (s64)file.size()) {
+		out->Printf("%s 416 Range Not Satisfiable\r\nConnection: %s\r\nContent-Length: 0\r\n\r\n", version, connection);
+		out->Flush();
+		return;
+	}
+
+	out->Printf("%s 206 Partial Content\r\nConnection: %s\r\nContent-Length: %lld\r\nContent-Range: bytes %lld-%lld/%lld\r\n\r\n", version, connection, last - begin + 1, begin, last, (s64)file.size());
+	for (s64 pos = begin; pos <= last; pos += SEND_CHUNK) {
+		out->Push((const char *)&file[pos], (size_t)std::min((s64)SEND_CHUNK, last + 1 - pos));
+		out->Flush();
+		sleep_ms(1, "http-test-rate");
+	}
+}
+
+static void RangeHandler(const http::ServerRequest &request, const std::vector<u8> &file, bool keepAlive, RangeServerStats &stats) {
+	stats.connections++;
+	stats.requests++;
+	std::string range;
+	request.GetHeader("range", &range);
+	WriteRangeResponse(request.Out(), request.Method(), range, file, keepAlive);
+
+	// http::Server closes after one request, so keep answering here until the client hangs up.
+	while (keepAlive) {
+		http::RequestHeader header;
+		header.ParseHeaders(request.In());
+		if (!header.ok) {
+			break;
+		}
+		stats.requests++;
+		range.clear();
+		header.GetOther("range", &range);
+		WriteRangeResponse(request.Out(), header.method, range, file, keepAlive);
+	}
+}
+
+static bool CheckReads(HTTPFileLoader &loader, const std::vector<u8> &file) {
+	EXPECT_TRUE(loader.Exists());
+	EXPECT_EQ_INT(loader.FileSize(), (s64)file.size());
+
+	std::vector<u8> buffer(2 * 1024 * 1024);
+	const s64 offsets[] = { 0, 12345, 3 * 1024 * 1024 + 7, (s64)file.size() - 1000 };
+	const size_t sizes[] = { 1, 2048, 65536 + 3, 1024 * 1024, 2 * 1024 * 1024 };
+	for (s64 offset : offsets) {
+		for (size_t size : sizes) {
+			const size_t expected = (size_t)std::min((s64)size, (s64)file.size() - offset);
+			EXPECT_EQ_INT(loader.ReadAt(offset, size, buffer.data()), expected);
+			EXPECT_TRUE(memcmp(buffer.data(), &file[offset], expected) == 0);
+		}
+	}
+	EXPECT_EQ_INT(loader.ReadAt(file.size(), 100, buffer.data()), 0);
+	return true;
+}
+
+bool TestHTTPFileLoader() {
+	net::Init();
+
+	std::vector<u8> file(FILE_SIZE);
+	for (size_t i = 0; i < file.size(); ++i) {
+		file[i] = (u8)(i * 7 + (i >> 12));
+	}
+
+	bool success = true;
+	for (bool keepAlive : { false, true }) {
+		RangeServerStats stats;
+		http::Server server(new NewThreadExecutor());
+		server.SetFallbackHandler([&](const http::ServerRequest &request) {
+			RangeHandler(request, file, keepAlive, stats);
+		});
+		if (!server.Listen(0, "unittest")) {
+			printf("Unable to listen on localhost, skipping\n");
+			return true;
+		}
+		std::atomic<bool> stop{};
+		std::thread serverThread([&] {
+			while (!stop) {
+				server.RunSlice(0.1);
+			}
+		});
+
+		const Path url(StringFromFormat("http://127.0.0.1:%d/file.bin", server.Port()));
+		{
+			HTTPFileLoader loader(url);
+			success = CheckReads(loader, file);
+		}
+
+		stop = true;
+		serverThread.join();
+		server.Stop();
+		if (!success) {
+			break;
+		}
+		if (keepAlive) {
+			EXPECT_TRUE(stats.connections < stats.requests);
+		} else {
+			EXPECT_EQ_INT(stats.connections, stats.requests);
+		}
+	}
+	return success;
+}
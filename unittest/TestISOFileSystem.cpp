@@ -0,0 +1,217 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/StringUtils.h"
+#include "Core/FileSystems/BlockDevices.h"
+#include "Core/FileSystems/ISOFileSystem.h"
+
+#include "UnitTest.h"
+
+// A synthetic ISO 9660 image in memory, so we can test path lookups on a big tree
+// without shipping an image. File contents aren't there, all files point at the same sector.
+class MemoryBlockDevice : public BlockDevice {
+public:
+	MemoryBlockDevice(std::vector<u8> &&data) : BlockDevice(nullptr), data_(std::move(data)) {}
+
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override {
+		if ((size_t)(blockNumber + 1) * 2048 > data_.size())
+			return false;
+		memcpy(outPtr, &data_[blockNumber * 2048], 2048);
+		return true;
+	}
+	u32 GetNumBlocks() const override { return (u32)(data_.size() / 2048); }
+	bool IsDisc() const override { return true; }
+
+private:
+	std::vector<u8> data_;
+};
+
+struct ImageNode {
+	std::string name;
+	bool isDirectory;
+	std::vector<ImageNode> children;
+	u32 sector = 0;
+	u32 size = 0;
+};
+
+static const u32 FILE_SECTOR = 18;
+static const u32 FILE_SIZE = 100;
+
+static int RecordSize(const std::string &name) {
+	return (33 + (int)name.size() + 1) & ~1;
+}
+
+static void PutLEBE32(u8 *p, u32 v) {
+	for (int i = 0; i < 4; i++) {
+		p[i] = (u8)(v >> (i * 8));
+		p[7 - i] = (u8)(v >> (i * 8));
+	}
+}
+
+static void WriteRecord(u8 *p, const std::string &name, u32 sector, u32 size, bool isDirectory) {
+	p[0] = (u8)RecordSize(name);
+	PutLEBE32(p + 2, sector);
+	PutLEBE32(p + 10, size);
+	p[25] = isDirectory ? 2 : 0;
+	p[32] = (u8)name.size();
+	memcpy(p + 33, name.data(), name.size());
+}
+
+// Appends a record to a directory, moving to the next sector if it doesn't fit, like mastering tools do.
+static void PutRecord(std::vector<u8> &image, u32 dirSector, int &offset, const std::string &name, u32 sector, u32 size, bool isDirectory) {
+	const int len = RecordSize(name);
+	if (offset % 2048 + len > 2048)
+		offset = (offset + 2047) & ~2047;
+	WriteRecord(&image[dirSector * 2048 + offset], name, sector, size, isDirectory);
+	offset += len;
+}
+
+static u32 DirectorySize(const ImageNode &dir) {
+	// "." and ".." are single byte names.
+	int offset = RecordSize(std::string(1, '\x00')) * 2;
+	for (const ImageNode &child : dir.children) {
+		const int len = RecordSize(child.name);
+		if (offset % 2048 + len > 2048)
+			offset = (offset + 2047) & ~2047;
+		offset += len;
+	}
+	return (offset + 2047) & ~2047;
+}
+
+static void LayoutDirectories(ImageNode &dir, u32 &nextSector) {
+	dir.size = DirectorySize(dir);
+	dir.sector = nextSector;
+	nextSector += dir.size / 2048;
+	for (ImageNode &child : dir.children) {
+		if (child.isDirectory) {
+			LayoutDirectories(child, nextSector);
+		} else {
+			child.sector = FILE_SECTOR;
+			if (child.size == 0)
+				child.size = FILE_SIZE;
+		}
+	}
+}
+
+static void WriteDirectories(std::vector<u8> &image, const ImageNode &dir, const ImageNode &parent) {
+	int offset = 0;
+	PutRecord(image, dir.sector, offset, std::string(1, '\x00'), dir.sector, dir.size, true);
+	PutRecord(image, dir.sector, offset, std::string(1, '\x01'), parent.sector, parent.size, true);
+	for (const ImageNode &child : dir.children) {
+		PutRecord(image, dir.sector, offset, child.name, child.sector, child.size, child.isDirectory);
+		if (child.isDirectory)
+			WriteDirectories(image, child, dir);
+	}
+}
+
+static ISOFileSystem *BuildISO(ImageNode &root) {
+	u32 numSectors = 20;
+	LayoutDirectories(root, numSectors);
+	std::vector<u8> image(numSectors * 2048);
+
+	// Primary volume descriptor, we only need the signature and the root record.
+	u8 *desc = &image[16 * 2048];
+	desc[0] = 1;
+	memcpy(desc + 1, "CD001", 5);
+	WriteRecord(desc + 156, std::string(1, '\x00'), root.sector, root.size, true);
+
+	WriteDirectories(image, root, root);
+	return new ISOFileSystem(nullptr, new MemoryBlockDevice(std::move(image)));
+}
+
+static ISOFileSystem *BuildBigISO(int numDirs, int numSubDirs, int numFiles, std::vector<std::string> *filePaths) {
+	ImageNode root{ "", true };
+	for (int d = 0; d < numDirs; d++) {
+		ImageNode dir{ StringFromFormat("DIR%02d", d), true };
+		for (int s = 0; s < numSubDirs; s++) {
+			ImageNode sub{ StringFromFormat("SUB%d", s), true };
+			for (int f = 0; f < numFiles; f++) {
+				sub.children.push_back(ImageNode{ StringFromFormat("FILE%04d.BIN", f), false });
+				filePaths->push_back("/" + dir.name + "/" + sub.name + "/" + sub.children.back().name);
+			}
+			dir.children.push_back(sub);
+		}
+		root.children.push_back(dir);
+	}
+	return BuildISO(root);
+}
+
+// Names that only differ in case. The index has to agree with WalkPath, which prefers exact matches.
+static bool TestISOCaseCollisions() {
+	ImageNode root{ "", true };
+	ImageNode lowerDir{ "Data", true };
+	lowerDir.children.push_back(ImageNode{ "A.BIN", false });
+	ImageNode upperDir{ "DATA", true };
+	upperDir.children.push_back(ImageNode{ "B.BIN", false });
+	root.children.push_back(lowerDir);
+	root.children.push_back(upperDir);
+	root.children.push_back(ImageNode{ "x.bin", false, {}, 0, 1 });
+	root.children.push_back(ImageNode{ "X.BIN", false, {}, 0, 2 });
+	ISOFileSystem *iso = BuildISO(root);
+
+	// Twice, the second time the directories have been read and indexed.
+	for (int i = 0; i < 2; i++) {
+		EXPECT_EQ_INT(iso->GetFileInfo("/x.bin").size, 1);
+		EXPECT_EQ_INT(iso->GetFileInfo("/X.BIN").size, 2);
+		EXPECT_EQ_INT(iso->GetFileInfo("/X.bin").size, 1);
+		EXPECT_TRUE(iso->GetFileInfo("/Data/A.BIN").exists);
+		EXPECT_TRUE(iso->GetFileInfo("/DATA/B.BIN").exists);
+		EXPECT_FALSE(iso->GetFileInfo("/Data/B.BIN").exists);
+		EXPECT_FALSE(iso->GetFileInfo("/DATA/A.BIN").exists);
+		EXPECT_TRUE(iso->GetFileInfo("/data/a.bin").exists);
+		EXPECT_FALSE(iso->GetFileInfo("/data/b.bin").exists);
+	}
+
+	delete iso;
+	return true;
+}
+
+bool TestISOFileSystem() {
+	std::vector<std::string> filePaths;
+	ISOFileSystem *iso = BuildBigISO(32, 8, 32, &filePaths);
+
+	PSPFileInfo info = iso->GetFileInfo("/DIR03/SUB5/FILE0012.BIN");
+	EXPECT_TRUE(info.exists);
+	EXPECT_EQ_INT(info.size, FILE_SIZE);
+	EXPECT_EQ_INT(info.startSector, FILE_SECTOR);
+	EXPECT_TRUE(iso->GetFileInfo("/dir03/Sub5/file0012.bin").exists);
+	EXPECT_TRUE(iso->GetFileInfo("DIR31/SUB7/FILE0031.BIN").exists);
+	EXPECT_FALSE(iso->GetFileInfo("/DIR03/SUB5/FILE0032.BIN").exists);
+	EXPECT_FALSE(iso->GetFileInfo("/DIR32/SUB0/FILE0000.BIN").exists);
+	EXPECT_FALSE(iso->GetFileInfo("/DIR03/SUB5/FILE0012.BIN/X").exists);
+	EXPECT_TRUE(iso->GetFileInfo("/DIR03/SUB5/../SUB6/FILE0001.BIN").exists);
+	EXPECT_TRUE(iso->GetFileInfo("./DIR04/").type == FILETYPE_DIRECTORY);
+	EXPECT_EQ_INT((int)iso->GetDirListing("/DIR04/SUB1").size(), 32);
+
+	for (int i = 0; i < 2; i++) {
+		info = iso->GetFileInfo("/sce_lbn0x10_size0x800");
+		EXPECT_TRUE(info.exists);
+		EXPECT_EQ_INT(info.startSector, 0x10);
+		EXPECT_EQ_INT(info.size, 0x800);
+	}
+
+	int found = 0;
+	for (const std::string &path : filePaths) {
+		found += iso->GetFileInfo(path).exists ? 1 : 0;
+	}
+	EXPECT_EQ_INT(found, (int)filePaths.size());
+
+	for (std::string path : filePaths) {
+		for (char &c : path)
+			c = tolower(c);
+		found -= iso->GetFileInfo(path).exists ? 1 : 0;
+		EXPECT_FALSE(iso->GetFileInfo(path.substr(0, path.size() - 4) + ".txt").exists);
+	}
+	EXPECT_EQ_INT(found, 0);
+
+	for (int i = 0; i < 64; i++) {
+		info = iso->GetFileInfo(StringFromFormat("/sce_lbn0x%x_size0x%x", i * 64, 0x8000));
+		EXPECT_EQ_INT(info.startSector, i * 64);
+		EXPECT_EQ_INT(info.size, 0x8000);
+	}
+
+	delete iso;
+	return TestISOCaseCollisions();
+}
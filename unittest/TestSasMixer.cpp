@@ -0,0 +1,95 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/HW/SasAudio.h"
+
+#include "UnitTest.h"
+
+// The plain per-sample loop SasInstance::MixVoice used to run, to check the SIMD path against.
+static void MixReference(int *mixBuffer, int *sendBuffer, const s16 *src, u32 sampleFrac, int pitch, bool interpolate, const int *envelope, int count, int volumeLeft, int volumeRight, int effectLeft, int effectRight) {
+	for (int i = 0; i < count; i++) {
+		const s16 *s = src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+		int sample = s[0];
+		if (interpolate) {
+			int f = sampleFrac & PSP_SAS_PITCH_MASK;
+			sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+		}
+		sampleFrac += pitch;
+		sample = ((sample * envelope[i]) + (1 << 14)) >> 15;
+		mixBuffer[i * 2] += (sample * volumeLeft) >> 12;
+		mixBuffer[i * 2 + 1] += (sample * volumeRight) >> 12;
+		sendBuffer[i * 2] += sample * effectLeft >> 12;
+		sendBuffer[i * 2 + 1] += sample * effectRight >> 12;
+	}
+}
+
+struct MixCase {
+	u32 sampleFrac;
+	int pitch;
+	int count;
+	int volumes[4];
+};
+
+bool TestSasMixer() {
+	std::mt19937 rng(1234);
+	auto random = [&](int lo, int hi) {
+		return std::uniform_int_distribution<int>(lo, hi)(rng);
+	};
+
+	std::vector<s16> src(PSP_SAS_MAX_GRAIN * 4 + 2 + 16);
+	for (s16 &s : src) {
+		s = (s16)random(-32768, 32767);
+	}
+	// Mostly full scale, but also the edges.
+	src[3] = -32768;
+	src[4] = 32767;
+
+	std::vector<int> envelope(PSP_SAS_MAX_GRAIN);
+	std::vector<int> mix(PSP_SAS_MAX_GRAIN * 2), send(PSP_SAS_MAX_GRAIN * 2);
+	std::vector<int> mixRef(PSP_SAS_MAX_GRAIN * 2), sendRef(PSP_SAS_MAX_GRAIN * 2);
+
+	std::vector<MixCase> cases;
+	const int pitches[] = { PSP_SAS_PITCH_BASE, PSP_SAS_PITCH_BASE / 2, PSP_SAS_PITCH_BASE * 2, PSP_SAS_PITCH_MAX, 1, 0x0C3F };
+	for (int pitch : pitches) {
+		cases.push_back(MixCase{ 0, pitch, 256, { PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX } });
+		cases.push_back(MixCase{ 0x7FF, pitch, 255, { -PSP_SAS_VOL_MAX, 0x800, 0, -1 } });
+	}
+	for (int i = 0; i < 200; i++) {
+		const int pitch = random(PSP_SAS_PITCH_MIN, PSP_SAS_PITCH_MAX);
+		const int count = random(1, PSP_SAS_MAX_GRAIN);
+		// Stay within the buffer, like MixVoice does.
+		const u32 maxFrac = (u32)(src.size() - 2) * PSP_SAS_PITCH_BASE - (u32)pitch * count;
+		const u32 sampleFrac = (u32)random(0, std::min((int)maxFrac, PSP_SAS_PITCH_BASE * 64));
+		cases.push_back(MixCase{ sampleFrac, pitch, count, {
+			random(-PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX), random(-PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX),
+			random(-PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX), random(-PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX) } });
+	}
+
+	for (const MixCase &c : cases) {
+		for (int i = 0; i < c.count; i++) {
+			// The rounded height of the envelope, including the top (1 << 15) and a ramp.
+			envelope[i] = (i & 7) == 0 ? 1 << 15 : ((i & 7) == 1 ? i * 16 : random(0, 1 << 15));
+		}
+		for (size_t i = 0; i < mix.size(); i++) {
+			mix[i] = mixRef[i] = random(-0x10000, 0x10000);
+			send[i] = sendRef[i] = random(-0x10000, 0x10000);
+		}
+
+		for (bool interpolate : { false, true }) {
+			// Without interpolation, MixVoice only uses whole sample positions at the base pitch.
+			if (!interpolate && (c.pitch != PSP_SAS_PITCH_BASE || (c.sampleFrac & PSP_SAS_PITCH_MASK) != 0)) {
+				continue;
+			}
+			SasMixResampledSamples(mix.data(), send.data(), src.data(), c.sampleFrac, c.pitch, interpolate, envelope.data(), c.count, c.volumes[0], c.volumes[1], c.volumes[2], c.volumes[3]);
+			MixReference(mixRef.data(), sendRef.data(), src.data(), c.sampleFrac, c.pitch, interpolate, envelope.data(), c.count, c.volumes[0], c.volumes[1], c.volumes[2], c.volumes[3]);
+			if (mix != mixRef || send != sendRef) {
+				printf("SAS mix mismatch: frac %08x pitch %04x count %d interpolate %d\n", c.sampleFrac, c.pitch, c.count, interpolate ? 1 : 0);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Serialize/Serializer.h"
+#include "Core/HLE/ThreadQueueList.h"
+
+#include "UnitTest.h"
+
+// Checks the ready queue against simple per-priority deques.
+static bool CheckSameQueues(const ThreadQueueList &list, const std::vector<std::deque<SceUID>> &ref, const std::vector<SceUID> &uids) {
+	int best = -1;
+	for (int prio = 0; prio < ThreadQueueList::NUM_QUEUES; prio++) {
+		EXPECT_EQ_INT(list.empty(prio), ref[prio].empty());
+		if (best == -1 && !ref[prio].empty())
+			best = prio;
+		for (SceUID uid : ref[prio]) {
+			EXPECT_EQ_INT(list.contains(uid), prio);
+		}
+	}
+	EXPECT_EQ_INT(list.peek_first(), best == -1 ? 0 : ref[best].front());
+
+	for (SceUID uid : uids) {
+		bool queued = false;
+		for (const auto &q : ref) {
+			for (SceUID other : q)
+				queued = queued || other == uid;
+		}
+		if (!queued)
+			EXPECT_EQ_INT(list.contains(uid), -1);
+	}
+	return true;
+}
+
+static int RefBestPriority(const std::vector<std::deque<SceUID>> &ref) {
+	for (int prio = 0; prio < (int)ref.size(); prio++) {
+		if (!ref[prio].empty())
+			return prio;
+	}
+	return -1;
+}
+
+bool TestThreadQueueList() {
+	// Big, so keep it off the stack.
+	std::unique_ptr<ThreadQueueList> list(new ThreadQueueList());
+	std::vector<std::deque<SceUID>> ref(ThreadQueueList::NUM_QUEUES);
+	std::vector<SceUID> uids;
+	for (int i = 0; i < 200; i++)
+		uids.push_back(KernelObjectPool::handleOffset + (i * 37) % KernelObjectPool::maxCount);
+
+	std::mt19937 rng(4321);
+	auto findQueued = [&](SceUID uid) -> int {
+		for (int prio = 0; prio < (int)ref.size(); prio++) {
+			for (SceUID other : ref[prio]) {
+				if (other == uid)
+					return prio;
+			}
+		}
+		return -1;
+	};
+
+	for (int i = 0; i < 20000; i++) {
+		const SceUID uid = uids[rng() % uids.size()];
+		// Mostly a few levels, like real games, so queues get long.
+		const u32 prio = rng() % 4 == 0 ? rng() % ThreadQueueList::NUM_QUEUES : 0x20 + rng() % 4;
+		const int queuedPrio = findQueued(uid);
+		switch (rng() % 7) {
+		case 0:
+		case 1:
+			if (queuedPrio == -1) {
+				list->prepare(prio);
+				list->push_back(prio, uid);
+				ref[prio].push_back(uid);
+			}
+			break;
+		case 2:
+			if (queuedPrio == -1) {
+				list->prepare(prio);
+				list->push_front(prio, uid);
+				ref[prio].push_front(uid);
+			}
+			break;
+		case 3:
+			// Sometimes with the wrong priority, which does nothing.
+			if (queuedPrio != -1 && rng() % 4 != 0) {
+				list->remove(queuedPrio, uid);
+				ref[queuedPrio].erase(std::find(ref[queuedPrio].begin(), ref[queuedPrio].end(), uid));
+			} else if (queuedPrio != (int)prio) {
+				list->remove(prio, uid);
+			}
+			break;
+		case 4:
+			list->rotate(prio);
+			if (ref[prio].size() > 1) {
+				ref[prio].push_back(ref[prio].front());
+				ref[prio].pop_front();
+			}
+			break;
+		case 5:
+		{
+			const int best = RefBestPriority(ref);
+			if (best != -1) {
+				EXPECT_EQ_INT(list->pop_first(), ref[best].front());
+				ref[best].pop_front();
+			}
+			break;
+		}
+		case 6:
+		{
+			const int best = RefBestPriority(ref);
+			SceUID expected = 0;
+			if (best != -1 && best < (int)prio) {
+				expected = ref[best].front();
+				ref[best].pop_front();
+			}
+			EXPECT_EQ_INT(list->pop_first_better(prio), expected);
+			break;
+		}
+		}
+
+		if (i % 97 == 0) {
+			if (!CheckSameQueues(*list, ref, uids))
+				return false;
+		}
+
+		// Round trip through a save state now and then.
+		if (i % 1000 == 999) {
+			std::vector<u8> state;
+			EXPECT_TRUE(CChunkFileReader::MeasureAndSavePtr(*list, &state) == CChunkFileReader::ERROR_NONE);
+			std::unique_ptr<ThreadQueueList> loaded(new ThreadQueueList());
+			std::string errorString;
+			EXPECT_TRUE(CChunkFileReader::LoadPtr(state.data(), *loaded, &errorString) == CChunkFileReader::ERROR_NONE);
+			list = std::move(loaded);
+			if (!CheckSameQueues(*list, ref, uids))
+				return false;
+		}
+	}
+
+	// What the scheduler does with a bunch of threads at a few priorities: the best ready thread runs,
+	// then it either yields to its priority level, or waits and something else gets woken up.
+	list->clear();
+	const int numThreads = 64;
+	for (int i = 0; i < numThreads; i++) {
+		list->prepare(0x20 + i % 4);
+		list->push_back(0x20 + i % 4, KernelObjectPool::handleOffset + i);
+	}
+	std::vector<SceUID> waiting;
+	for (int i = 0; i < 20000; i++) {
+		const SceUID current = list->pop_first();
+		const int action = rng() % 3;
+		if (action == 0 && list->peek_first() != 0) {
+			// Waits, as long as there's something else to run.
+			waiting.push_back(current);
+		} else if (action == 1 && !waiting.empty()) {
+			// Waits, and wakes up someone else.
+			const size_t index = rng() % waiting.size();
+			const SceUID woken = waiting[index];
+			waiting[index] = current;
+			list->push_back(0x20 + (woken - KernelObjectPool::handleOffset) % 4, woken);
+		} else {
+			// Yields.
+			list->push_back(0x20 + (current - KernelObjectPool::handleOffset) % 4, current);
+		}
+		// Something else (an interrupt, a semaphore) wakes up a thread now and then.
+		if (!waiting.empty() && rng() % 3 == 0) {
+			const SceUID woken = waiting.back();
+			waiting.pop_back();
+			list->push_back(0x20 + (woken - KernelObjectPool::handleOffset) % 4, woken);
+		}
+		// A priority change somewhere in the queue.
+		const SceUID other = KernelObjectPool::handleOffset + rng() % numThreads;
+		const u32 otherPrio = 0x20 + (other - KernelObjectPool::handleOffset) % 4;
+		if (list->contains(other) == (int)otherPrio) {
+			list->remove(otherPrio, other);
+			list->push_back(otherPrio, other);
+		}
+	}
+
+	// Every thread is still either queued at its own priority or waiting, and only once.
+	for (int i = 0; i < numThreads; i++) {
+		const SceUID uid = KernelObjectPool::handleOffset + i;
+		const bool isWaiting = std::find(waiting.begin(), waiting.end(), uid) != waiting.end();
+		EXPECT_EQ_INT(list->contains(uid), isWaiting ? -1 : 0x20 + i % 4);
+	}
+	int queued = 0;
+	while (list->pop_first() != 0)
+		queued++;
+	EXPECT_EQ_INT(queued + (int)waiting.size(), numThreads);
+
+	return true;
+}
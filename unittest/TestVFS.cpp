@@ -1,7 +1,9 @@
+#include <cstring>
 #include <thread>
 #include <vector>
 
 #include "Common/Log.h"
+#include "Common/File/VFS/PackFileReader.h"
 #include "Common/File/VFS/ZipFileReader.h"
 
 #include "UnitTest.h"
@@ -87,8 +89,73 @@ bool TestZipFile() {
 	return true;
 }
 
+bool TestPackFile() {
+	Path baseDir = File::GetCurDirectory() / "packtest_tmp";
+	File::DeleteDirRecursively(baseDir);
+	File::CreateFullPath(baseDir / "sub/deeper");
+	EXPECT_TRUE(File::WriteStringToFile(false, "ini contents", baseDir / "textures.ini"));
+	EXPECT_TRUE(File::WriteStringToFile(false, "root", baseDir / "0000000012345678.png"));
+	EXPECT_TRUE(File::WriteStringToFile(false, "in sub", baseDir / "sub/A.png"));
+	EXPECT_TRUE(File::WriteStringToFile(false, "deeper", baseDir / "sub/deeper/b.dds"));
+	EXPECT_TRUE(File::WriteStringToFile(false, "sorts after sub/", baseDir / "sub.png"));
+
+	std::vector<std::string> files = { "textures.ini", "0000000012345678.png", "sub/A.png", "sub/deeper/b.dds", "sub.png" };
+	Path packPath = baseDir / "test.ppack";
+	std::string error;
+	EXPECT_TRUE(PackFileReader::Write(packPath, baseDir, files, &error));
+
+	PackFileReader *pack = PackFileReader::Create(packPath);
+	EXPECT_TRUE(pack != nullptr);
+	EXPECT_EQ_INT((int)pack->NumFiles(), 5);
+
+	std::vector<File::FileInfo> listing;
+	EXPECT_TRUE(pack->GetFileListing("", &listing, nullptr));
+	EXPECT_EQ_INT(listing.size(), 4);
+	EXPECT_TRUE(CheckContainsDir(listing, "sub"));
+	EXPECT_TRUE(CheckContainsFile(listing, "sub.png"));
+	EXPECT_TRUE(CheckContainsFile(listing, "textures.ini"));
+	EXPECT_TRUE(pack->GetFileListing("sub", &listing, nullptr));
+	EXPECT_EQ_INT(listing.size(), 2);
+	EXPECT_TRUE(CheckContainsDir(listing, "deeper"));
+	EXPECT_TRUE(CheckContainsFile(listing, "a.png"));
+	EXPECT_TRUE(pack->GetFileListing("", &listing, "ini"));
+	EXPECT_EQ_INT(listing.size(), 2);
+	EXPECT_FALSE(pack->GetFileListing("nope", &listing, nullptr));
+
+	// Lookups are case insensitive, like in zips.
+	size_t size = 0;
+	uint8_t *data = pack->ReadFile("SUB/a.png", &size);
+	EXPECT_TRUE(data != nullptr);
+	EXPECT_EQ_INT((int)size, 6);
+	EXPECT_TRUE(memcmp(data, "in sub", 6) == 0);
+	delete[] data;
+	EXPECT_TRUE(pack->ReadFile("sub/missing.png", &size) == nullptr);
+
+	VFSFileReference *ref = pack->GetFile("sub/deeper/b.dds");
+	EXPECT_TRUE(ref != nullptr);
+	VFSOpenFile *openFile = pack->OpenFileForRead(ref, &size);
+	EXPECT_EQ_INT((int)size, 6);
+	char buf[8]{};
+	EXPECT_EQ_INT((int)pack->Read(openFile, buf, 4), 4);
+	EXPECT_EQ_INT((int)pack->Read(openFile, buf + 4, 4), 2);
+	EXPECT_TRUE(memcmp(buf, "deeper", 6) == 0);
+	pack->CloseFile(openFile);
+	pack->ReleaseFile(ref);
+
+	File::FileInfo info;
+	EXPECT_TRUE(pack->GetFileInfo("sub/deeper", &info));
+	EXPECT_TRUE(info.isDirectory);
+	EXPECT_FALSE(pack->GetFileInfo("sub/deep", &info));
+
+	delete pack;
+	File::DeleteDirRecursively(baseDir);
+	return true;
+}
+
 bool TestVFS() {
 	if (!TestZipFile())
 		return false;
+	if (!TestPackFile())
+		return false;
 	return true;
 }
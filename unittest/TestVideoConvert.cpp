@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/HW/VideoConvert.h"
+#include "GPU/ge_constants.h"
+
+#include "UnitTest.h"
+
+// The video conversion MediaEngine uses instead of swscale, against floating point BT.601.
+bool TestVideoConvert() {
+	// Odd sizes, so the scalar tails and the last chroma sample are covered too.
+	const int width = 483, height = 273;
+	const int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	std::mt19937 rng(5678);
+	std::vector<u8> yPlane(width * height), uPlane(chromaWidth * chromaHeight), vPlane(chromaWidth * chromaHeight);
+	for (u8 &v : yPlane)
+		v = (u8)rng();
+	for (u8 &v : uPlane)
+		v = (u8)rng();
+	for (u8 &v : vPlane)
+		v = (u8)rng();
+	// The extremes, outside the limited range.
+	yPlane[0] = 0;
+	yPlane[1] = 255;
+	uPlane[0] = 255;
+	vPlane[0] = 0;
+
+	const u8 *src[3] = { yPlane.data(), uPlane.data(), vPlane.data() };
+	const int srcStride[3] = { width, chromaWidth, chromaWidth };
+	std::vector<u8> rgba(width * height * 4);
+	// In two parts, like it's split across threads.
+	ConvertYUV420ToPSP(rgba.data(), width * 4, src, srcStride, width, 0, 101, GE_CMODE_32BIT_ABGR8888);
+	ConvertYUV420ToPSP(rgba.data(), width * 4, src, srcStride, width, 101, height, GE_CMODE_32BIT_ABGR8888);
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			const double l = (yPlane[y * width + x] - 16) * 255.0 / 219.0;
+			const double u = (uPlane[(y / 2) * chromaWidth + x / 2] - 128) * 255.0 / 224.0;
+			const double v = (vPlane[(y / 2) * chromaWidth + x / 2] - 128) * 255.0 / 224.0;
+			const double expected[3] = { l + 1.402 * v, l - 0.344136 * u - 0.714136 * v, l + 1.772 * u };
+			const u8 *pixel = &rgba[(y * width + x) * 4];
+			for (int c = 0; c < 3; c++) {
+				const int e = (int)lrint(std::clamp(expected[c], 0.0, 255.0));
+				if (abs(pixel[c] - e) > 1) {
+					printf("Video convert mismatch at %d,%d channel %d: %d != %d\n", x, y, c, pixel[c], e);
+					return false;
+				}
+			}
+			EXPECT_EQ_INT(pixel[3], 255);
+		}
+	}
+
+	// The 16-bit formats are the same colors, dithered and truncated.
+	const int formats[3] = { GE_CMODE_16BIT_BGR5650, GE_CMODE_16BIT_ABGR5551, GE_CMODE_16BIT_ABGR4444 };
+	const int bits[3][3] = { { 5, 6, 5 }, { 5, 5, 5 }, { 4, 4, 4 } };
+	std::vector<u16> out16(width * height);
+	for (int f = 0; f < 3; f++) {
+		ConvertYUV420ToPSP((u8 *)out16.data(), width * 2, src, srcStride, width, 0, height, formats[f]);
+		for (int i = 0; i < width * height; i++) {
+			int shift = 0;
+			for (int c = 0; c < 3; c++) {
+				const int value = (out16[i] >> shift) & ((1 << bits[f][c]) - 1);
+				// The dither can round up by one step at most.
+				const int truncated = rgba[i * 4 + c] >> (8 - bits[f][c]);
+				if (value != truncated && value != truncated + 1) {
+					printf("Video convert mismatch in format %d at %d channel %d: %d vs %d\n", formats[f], i, c, value, truncated);
+					return false;
+				}
+				shift += bits[f][c];
+			}
+			EXPECT_EQ_INT(out16[i] >> shift, 0);
+		}
+	}
+
+	return true;
+}
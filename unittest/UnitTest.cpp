@@ -1250,6 +1250,13 @@ bool TestSoftwareGPUJit();
 bool TestIRPassSimplify();
 bool TestThreadManager();
 bool TestVFS();
+bool TestISOFileSystem();
+bool TestHTTPFileLoader();
+bool TestSasMixer();
+bool TestAtracDSP();
+bool TestVideoConvert();
+bool TestCoreTiming();
+bool TestThreadQueueList();
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -1277,6 +1284,13 @@ TestItem availableTests[] = {
 	TEST_ITEM(Jit),
 	TEST_ITEM(VFPUMatrixTranspose),
 	TEST_ITEM(ParseLBN),
+	TEST_ITEM(ISOFileSystem),
+	TEST_ITEM(HTTPFileLoader),
+	TEST_ITEM(SasMixer),
+	TEST_ITEM(AtracDSP),
+	TEST_ITEM(VideoConvert),
+	TEST_ITEM(CoreTiming),
+	TEST_ITEM(ThreadQueueList),
 	TEST_ITEM(QuickTexHash),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(MemMap),